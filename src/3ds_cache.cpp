@@ -18,92 +18,75 @@
 #ifdef _3DS
 #include <3ds.h>
 #endif
-#include <string.h>
-#include <stdio.h>
+#include <vector>
 #include "3ds_cache.h"
+#include "sound_cache.h"
 #include "output.h"
 
-uint32_t FREE_CACHE = CACHE_DIM; // 4 bytes
-uint8_t ENTRIES = 0; // 1 byte
-int LAST_ENTRY = -1; // 4 bytes
-char soundtable[MAX_SOUNDS][32];
-DecodedSound decodedtable[MAX_SOUNDS];
-uint8_t* soundCache;
-bool FULLED = false; // 1 byte
+namespace {
+	uint8_t* soundCache = NULL;
+	SoundCache* cache = NULL;
+	std::vector<DecodedSound> decodedtable;
+}
 
 void initCache(){
 	#ifndef NO_DEBUG
-	u32 cache_size = CACHE_DIM + 10 + (MAX_SOUNDS<<5) + sizeof(DecodedSound) * MAX_SOUNDS; 
-	Output::Debug("Initializing sound cache (Dim: %i bytes, Max Sounds: %i)",cache_size,MAX_SOUNDS);
+	Output::Debug("Initializing sound cache (Dim: %i bytes, Max Sounds: %i)",CACHE_DIM,MAX_SOUNDS);
 	#endif
 	#ifdef _3DS
 	soundCache = (uint8_t*)linearAlloc(CACHE_DIM);
 	#endif
+	cache = new SoundCache(soundCache, soundCache ? CACHE_DIM : 0, MAX_SOUNDS);
+	decodedtable.resize(MAX_SOUNDS);
 }
 void freeCache(){
+	#ifndef NO_DEBUG
+	SoundCache::Stats stats = cache->GetStats();
+	Output::Debug("Sound cache: %u hits, %u misses, %u evictions",stats.hits,stats.misses,stats.evictions);
+	#endif
+	delete cache;
+	cache = NULL;
 	#ifdef _3DS
 	linearFree(soundCache);
 	#endif
+	soundCache = NULL;
 }
 
-int lookCache(const char* file){
-	for (int i=0;i<ENTRIES;i++){
-		if (strcmp(soundtable[i],file) == 0) return i;
-	}
-	return -1;
+int lookCache(const char* file, DecodedSound* Sound){
+	int id = cache->Find(file);
+	if (id >= 0) *Sound = decodedtable[id];
+	return id;
 }
 
-void allocCache(DecodedSound* Sound){
+bool hasCache(const char* file){
+	return cache->Contains(file);
+}
 
-	// Calculate cache offset where to store the sound
-	int offset = FREE_CACHE - Sound->audiobuf_size;
-	if (offset >= 0){
-		
-		// Check if cache had been fulled at least once
-		if (FULLED){
-		
-			// Store the sound in "normal" storage mode
-			LAST_ENTRY++;
-			if (LAST_ENTRY == ENTRIES) ENTRIES++;
-			FREE_CACHE = offset;
-			Sound->audiobuf = soundCache + offset;
-			
-			// Stub all the invalid entries due to offsets differences
-			int i = LAST_ENTRY + 1;
-			while (decodedtable[i].audiobuf < (Sound->audiobuf + Sound->audiobuf_size)){
-				sprintf(soundtable[i],"%s","::::"); // A file with : in filename can't exist so we use that fake filename
-				i++;
-				if (i == ENTRIES) break;
-			}
-			
-		}else{
-			
-			// Store the sound in "fast" storage mode
-			Sound->audiobuf = soundCache + offset;
-			LAST_ENTRY++;
-			ENTRIES++;
-			FREE_CACHE = offset;
-			
-		}
-	}else{
-		
-		// Cache is full, so we reset to "normal" storage mode
-		FREE_CACHE = CACHE_DIM;
-		FULLED = true;
-		LAST_ENTRY = 0;
-		offset = FREE_CACHE - Sound->audiobuf_size;
-		FREE_CACHE = offset;
-		Sound->audiobuf = soundCache + offset;
-		
-		// Stub all the invalid entries due to offsets differences
-		int i = 1;
-		while (decodedtable[i].audiobuf < (Sound->audiobuf + Sound->audiobuf_size)){
-			sprintf(soundtable[i],"%s","::::"); // A file with : in filename can't exist so we use that fake filename
-			i++;
-			if (i == ENTRIES) break;
-		}
-		
+int allocCache(DecodedSound* Sound){
+	int id = cache->Allocate(Sound->audiobuf_size);
+	if (id < 0){
+		Output::Warning("Sound of %u bytes doesn't fit in the sound cache", (unsigned)Sound->audiobuf_size);
+		Sound->audiobuf = NULL;
+		return -1;
 	}
-	memcpy(&decodedtable[ENTRIES-1],Sound,sizeof(DecodedSound));
+	Sound->audiobuf = cache->GetBuffer(id);
+	return id;
+}
+
+void publishCache(int id, const char* file, DecodedSound* Sound){
+	decodedtable[id] = *Sound;
+	cache->Publish(id, file);
 }
-#endif
\ No newline at end of file
+
+void dropCache(int id){
+	cache->Remove(id);
+}
+
+void pinCache(int id){
+	cache->Pin(id);
+}
+
+void unpinCache(int id){
+	cache->Unpin(id);
+}
+#endif
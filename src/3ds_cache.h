@@ -22,19 +22,28 @@
 #include "3ds_decoder.h"
 #endif
 
-#define MAX_SOUNDS 32 // Max number of storable sounds
+#define MAX_SOUNDS 256 // Max number of storable sounds
 #define CACHE_DIM 6291456 // Dimension of the cache
 
-extern uint32_t FREE_CACHE;
-extern uint8_t ENTRIES;
-extern int LAST_ENTRY;
-extern char soundtable[MAX_SOUNDS][32];
-extern DecodedSound decodedtable[MAX_SOUNDS];
-extern uint8_t* soundCache;
-extern bool FULLED;
-
 void initCache();
 void freeCache();
-int lookCache(const char* file);
-void allocCache(DecodedSound* Sound);
-#endif
\ No newline at end of file
+
+// Returns the cache id of a sound and copies its info, -1 if not cached
+int lookCache(const char* file, DecodedSound* Sound);
+
+// Checks if a sound is cached without using it
+bool hasCache(const char* file);
+
+// Allocates the audiobuffer of a sound being decoded, returns its cache id
+int allocCache(DecodedSound* Sound);
+
+// Makes a decoded sound available under its name
+void publishCache(int id, const char* file, DecodedSound* Sound);
+
+// Drops a sound which failed to decode
+void dropCache(int id);
+
+// Protects a playing sound from eviction
+void pinCache(int id);
+void unpinCache(int id);
+#endif
@@ -17,6 +17,7 @@
 #include "system.h"
 #include "output.h"
 #include "filefinder.h"
+#include "audio_ringbuffer.h"
 #include <ogg/ogg.h>
 #include <tremor/ivorbiscodec.h>
 #include <tremor/ivorbisfile.h>
@@ -42,18 +43,52 @@ extern DecodedMusic* BGM;
 	+-----------------------------------------------------+
 */
 
-int DecodeOgg(FILE* stream, DecodedSound* Sound){
+// Sounds decoded by the workers of AsyncDecoder (error is set) are kept in
+// malloc memory until SE_Play imports them, their errors are reported by
+// the main thread
+static int Fail(std::string* error, std::string const& msg){
+	if (error) *error = msg;
+	else Output::Warning("%s", msg.c_str());
+	return -1;
+}
+
+static int AllocSound(DecodedSound* Sound, std::string* error){
+	if (error){
+		Sound->audiobuf = (u8*)malloc(Sound->audiobuf_size);
+		return Sound->audiobuf ? 0 : Fail(error, "Not enough memory to decode the sound");
+	}
+	#ifdef USE_CACHE
+	return allocCache(Sound);
+	#else
+	Sound->audiobuf = (u8*)linearAlloc(Sound->audiobuf_size);
+	return 0;
+	#endif
+}
+
+static void FreeSound(DecodedSound* Sound, int id, std::string* error){
+	if (error){
+		free(Sound->audiobuf);
+		return;
+	}
+	#ifdef USE_CACHE
+	dropCache(id);
+	#else
+	linearFree(Sound->audiobuf);
+	#endif
+}
+
+int DecodeOgg(FILE* stream, DecodedSound* Sound, std::string* error){
 	
 	// Passing filestream to libogg
 	int eof=0;
 	OggVorbis_File* vf = (OggVorbis_File*)malloc(sizeof(OggVorbis_File));
-	static int current_section;
+	int current_section;
 	fseek(stream, 0, SEEK_SET);
 	if(ov_open(stream, vf, NULL, 0) != 0)
 	{
 		fclose(stream);
-		Output::Warning("Corrupt ogg file");
-		return -1;
+		free(vf);
+		return Fail(error, "Corrupt ogg file");
 	}
 	
 	// Grabbing info from the header
@@ -67,21 +102,24 @@ int DecodeOgg(FILE* stream, DecodedSound* Sound){
 	Sound->bytepersample = audiotype<<1;
 	
 	// Preparing PCM16 audiobuffer
-	#ifdef USE_CACHE
-	allocCache(Sound);
-	#else
-	Sound->audiobuf = (u8*)linearAlloc(Sound->audiobuf_size);
-	#endif
+	int cache_id = AllocSound(Sound, error);
+	if (cache_id < 0){
+		ov_clear(vf);
+		free(vf);
+		return -1;
+	}
 	
 	if (isDSP) audiotype = 1; // We trick the decoder since DSP supports native stereo playback
 	
 	// Decoding Vorbis buffer
 	int i = 0;
+	bool failed = false;
 	if (audiotype == 1){ // Mono file
 		while(!eof){
 			long ret=ov_read(vf,(char*)&Sound->audiobuf[i],OGG_BUFSIZE,&current_section);
 			if (ret == 0) eof=1;
-			else i = i + ret;
+			else if (ret < 0 && ret != OV_HOLE) { failed = true; eof = 1; }
+			else if (ret > 0) i = i + ret;
 		}
 	}else{ // Stereo file
 		char pcmout[OGG_BUFSIZE];
@@ -92,7 +130,8 @@ int DecodeOgg(FILE* stream, DecodedSound* Sound){
 		while(!eof){
 			long ret=ov_read(vf,pcmout,OGG_BUFSIZE,&current_section);
 			if (ret == 0) eof=1;
-			else{
+			else if (ret < 0 && ret != OV_HOLE) { failed = true; eof = 1; }
+			else if (ret > 0){
 				for (u32 i=0;i<ret;i=i+4){
 					memcpy(&left_channel[z],&pcmout[i],2);
 					memcpy(&right_channel[z],&pcmout[i+2],2);
@@ -103,19 +142,21 @@ int DecodeOgg(FILE* stream, DecodedSound* Sound){
 	}
 	
 	ov_clear(vf);
-	#ifdef USE_CACHE
-	return LAST_ENTRY;
-	#else
-	return 0;
-	#endif
+	free(vf);
+	if (failed){
+		FreeSound(Sound, cache_id, error);
+		return Fail(error, "Corrupt ogg file");
+	}
+	
+	return cache_id;
 	
 }
 
-int DecodeWav(FILE* stream, DecodedSound* Sound){
+int DecodeWav(FILE* stream, DecodedSound* Sound, std::string* error){
 	
 	// Grabbing info from the header
 	u16 audiotype;
-	u32 chunk;
+	u32 chunk = 0;
 	u32 jump;
 	u16 bytepersample;
 	fseek(stream, 16, SEEK_SET);
@@ -138,8 +179,10 @@ int DecodeWav(FILE* stream, DecodedSound* Sound){
 	// Skipping to audiobuffer start
 	while (chunk != 0x61746164){
 		fseek(stream, jump, SEEK_CUR);
-		fread(&chunk, 4, 1, stream);
-		fread(&jump, 4, 1, stream);
+		if (fread(&chunk, 4, 1, stream) != 1 || fread(&jump, 4, 1, stream) != 1){
+			fclose(stream);
+			return Fail(error, "Corrupt wav file");
+		}
 	}
 	
 	// Getting audiobuffer size
@@ -148,62 +191,76 @@ int DecodeWav(FILE* stream, DecodedSound* Sound){
 	int end = ftell(stream);
 	Sound->audiobuf_size = end - start;
 	fseek(stream, start, SEEK_SET);
-	#ifdef USE_CACHE
-	allocCache(Sound);
-	#else
-	Sound->audiobuf = (u8*)linearAlloc(Sound->audiobuf_size);
-	#endif
+	int cache_id = AllocSound(Sound, error);
+	if (cache_id < 0){
+		fclose(stream);
+		return -1;
+	}
 	
 	if (isDSP) audiotype = 1; // We trick the decoder since DSP supports native stereo playback
 	
+	bool failed = false;
+	
 	// Mono file
-	if (audiotype == 1) fread(Sound->audiobuf, Sound->audiobuf_size, 1, stream);	
+	if (audiotype == 1) failed = fread(Sound->audiobuf, Sound->audiobuf_size, 1, stream) != 1;
 	
 	// Stereo file
 	else{
 		u32 chn_size = Sound->audiobuf_size>>1;
 		u16 byteperchannel = bytepersample>>1;
-		u8* tmp_buf = (u8*)linearAlloc(Sound->audiobuf_size);
-		fread(tmp_buf, Sound->audiobuf_size, 1, stream);
+		u8* tmp_buf = (u8*)malloc(Sound->audiobuf_size);
+		failed = fread(tmp_buf, Sound->audiobuf_size, 1, stream) != 1;
 		int z = 0;
 		for (u32 i=0;i<chn_size;i=i+bytepersample){
 			memcpy(&Sound->audiobuf[z], &tmp_buf[i], byteperchannel);
 			memcpy(&Sound->audiobuf[z+chn_size], &tmp_buf[i+2], byteperchannel);
 			z=z+2;
 		}
-		linearFree(tmp_buf);
+		free(tmp_buf);
 	}
 	
 	fclose(stream);
-	#ifdef USE_CACHE
-	return LAST_ENTRY;
-	#else
-	return 0;
-	#endif
+	if (failed){
+		FreeSound(Sound, cache_id, error);
+		return Fail(error, "Corrupt wav file");
+	}
+	
+	return cache_id;
 }
 
-int DecodeSound(std::string const& filename, DecodedSound* Sound){
+int DecodeSound(std::string const& filename, DecodedSound* Sound, std::string* error){
 	
 	// Opening file
 	FILE* stream = FileFinder::fopenUTF8(filename, "rb");
 	if (!stream) {
-		Output::Warning("Couldn't open sound file %s", filename.c_str());
-		return -1;
+		return Fail(error, "Couldn't open sound file " + filename);
 	}
 	
 	// Reading and parsing the magic
-	u32 magic;
+	u32 magic = 0;
 	fread(&magic, 4, 1, stream);
-	if (magic == 0x46464952) return DecodeWav(stream, Sound);
-	else if (magic == 0x5367674F) return DecodeOgg(stream, Sound);
+	if (magic == 0x46464952) return DecodeWav(stream, Sound, error);
+	else if (magic == 0x5367674F) return DecodeOgg(stream, Sound, error);
 	else{
 		fclose(stream);
-		Output::Warning("Unsupported sound format (%s)", filename.c_str());
-		return -1;
+		return Fail(error, "Unsupported sound format (" + filename + ")");
 	}
 	
 }
 
+int ImportSound(DecodedSound* Decoded, DecodedSound* Sound){
+	*Sound = *Decoded;
+	int id = AllocSound(Sound, NULL);
+	if (id < 0) return -1;
+	memcpy(Sound->audiobuf, Decoded->audiobuf, Sound->audiobuf_size);
+	return id;
+}
+
+void FreeDecodedSound(DecodedSound* Decoded){
+	free(Decoded->audiobuf);
+	delete Decoded;
+}
+
 /*	
 	+-----------------------------------------------------+
 	|                                                     |
@@ -213,82 +270,61 @@ int DecodeSound(std::string const& filename, DecodedSound* Sound){
 */
 
 
-void UpdateOggStream(){	
+// Remembers where the music ended for BGM_PlayedOnce
+static void MarkStreamEnd(DecodedMusic* Sound){
+	if (Sound->eof_idx == 0xFFFFFFFF) Sound->eof_idx = Sound->stream_pos / (Sound->audiobuf_size>>1) + 1;
+}
+
+void DecodeOggStream(AudioRingBuffer* ring){
 	DecodedMusic* Sound = BGM;
 	OggVorbis_File* vf = (OggVorbis_File*)Sound->handle;
-	Sound->block_idx++;	
-	u32 half_buf = Sound->audiobuf_size>>1;
-	int bytesRead = 0;
 	int current_section;
-	int half_check = (Sound->block_idx)%2;
-	if ((!Sound->isStereo) || isDSP){ // Mono file
-		int i = half_check * half_buf;
-		while(bytesRead < half_buf){
-			long ret=ov_read(vf,(char*)&Sound->audiobuf[i+bytesRead],OGG_BUFSIZE,&current_section);
-			if (ret == 0){ // EoF
-				if (Sound->eof_idx == 0xFFFFFFFF) Sound->eof_idx = Sound->block_idx + 1;
-				ov_pcm_seek(vf,0);
-			}else bytesRead = bytesRead + ret;
-		}
-	}else{ // Stereo file
+	bool rewound = false;
+	
+	// Interleaved samples go to the ring as decoded, the consumer splits them
+	while (ring->GetFree() >= OGG_BUFSIZE){
 		char pcmout[OGG_BUFSIZE];
-		u8* left_channel = Sound->audiobuf;
-		u8* right_channel = &Sound->audiobuf[half_buf];
-		int z = half_check * (half_buf>>1);
-		while(bytesRead < half_buf){
-			long ret=ov_read(vf,pcmout,OGG_BUFSIZE,&current_section);
-			if (ret == 0){ // EoF
-				if (Sound->eof_idx == 0xFFFFFFFF) Sound->eof_idx = Sound->block_idx + 1;
-				ov_pcm_seek(vf,0);
-			}else{
-				for (u32 i=0;i<ret;i=i+4){
-					memcpy(&left_channel[z],&pcmout[i],2);
-					memcpy(&right_channel[z],&pcmout[i+2],2);
-					z = z + 2;
-				}
-				bytesRead = bytesRead + ret;
-			}
-		}
+		size_t region;
+		u8* dst = ring->GetWriteRegion(region);
+		bool direct = region >= OGG_BUFSIZE;
+		long ret=ov_read(vf,direct ? (char*)dst : pcmout,OGG_BUFSIZE,&current_section);
+		if (ret == 0){ // EoF
+			if (rewound) return; // Empty stream
+			MarkStreamEnd(Sound);
+			ov_pcm_seek(vf,0);
+			rewound = true;
+		}else if (ret > 0){
+			if (direct) ring->CommitWrite(ret);
+			else ring->Write(pcmout, ret);
+			Sound->stream_pos += ret;
+			rewound = false;
+		}else return;
 	}
 	
 }
 
-void UpdateWavStream(){
+void DecodeWavStream(AudioRingBuffer* ring){
 	DecodedMusic* Sound = BGM;
-	Sound->block_idx++;	
-	u32 half_buf = Sound->audiobuf_size>>1;
-	int bytesRead;
-	int half_check = (Sound->block_idx)%2;
-	
-	// Mono file
-	if ((!Sound->isStereo) || isDSP){
-		bytesRead = fread(Sound->audiobuf+(half_check*half_buf), 1, half_buf, Sound->handle);	
-		if (bytesRead != half_buf){ // EoF
-			if (Sound->eof_idx == 0xFFFFFFFF) Sound->eof_idx = Sound->block_idx + 1;
-			fseek(Sound->handle, Sound->audiobuf_offs, SEEK_SET);
-			fread(Sound->audiobuf+(half_check*half_buf), 1, half_buf, Sound->handle);	
-		}
-		
-	// Stereo file
-	}else{
-		u8* left_channel = Sound->audiobuf;
-		u8* right_channel = Sound->audiobuf + half_buf;
-		u32 half_chn_size = half_buf>>1;
-		u16 byteperchannel = Sound->bytepersample>>1;
-		u32 z = half_chn_size * half_check;
-		u8* tmp_buf = (u8*)linearAlloc(half_buf);
-		bytesRead = fread(tmp_buf, 1, half_buf, Sound->handle);
-		if (bytesRead != half_buf){ // EoF
-			if (Sound->eof_idx == 0xFFFFFFFF) Sound->eof_idx = Sound->block_idx + 1;
+	bool rewound = false;
+	
+	// Reading straight into the ring, the consumer needs whole stereo frames
+	u32 frame_size = (Sound->isStereo && !isDSP) ? Sound->bytepersample : 1;
+	for (;;){
+		size_t region;
+		u8* dst = ring->GetWriteRegion(region);
+		region -= region % frame_size;
+		if (region == 0) break;
+		size_t bytesRead = fread(dst, 1, region, Sound->handle);
+		bytesRead -= bytesRead % frame_size;
+		ring->CommitWrite(bytesRead);
+		Sound->stream_pos += bytesRead;
+		if (bytesRead > 0) rewound = false;
+		if (bytesRead != region){ // EoF
+			if (rewound) break; // Empty stream
+			MarkStreamEnd(Sound);
 			fseek(Sound->handle, Sound->audiobuf_offs, SEEK_SET);
-			fread(tmp_buf, 1, half_buf, Sound->handle);
-		}
-		for (u32 i=0;i<half_buf;i=i+Sound->bytepersample){
-			memcpy(&left_channel[z],&tmp_buf[i],2);
-			memcpy(&right_channel[z],&tmp_buf[i+2],2);
-			z = z + 2;	
+			rewound = true;
 		}
-		linearFree(tmp_buf);
 	}
 	
 }
@@ -371,7 +407,8 @@ int OpenWav(FILE* stream, DecodedMusic* Sound){
 		Sound->handle = NULL;
 	}
 	Sound->eof_idx = 0xFFFFFFFF;
-	Sound->updateCallback = UpdateWavStream;
+	Sound->stream_pos = Sound->audiobuf_size;
+	Sound->decodeCallback = DecodeWavStream;
 	Sound->closeCallback = CloseWav;
 	
 	return res;
@@ -451,7 +488,8 @@ int OpenOgg(FILE* stream, DecodedMusic* Sound){
 		Sound->handle = NULL;
 	}
 	Sound->eof_idx = 0xFFFFFFFF;
-	Sound->updateCallback = UpdateOggStream;
+	Sound->stream_pos = Sound->audiobuf_size;
+	Sound->decodeCallback = DecodeOggStream;
 	Sound->closeCallback = CloseOgg;
 	
 	return res;
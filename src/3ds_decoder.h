@@ -18,6 +18,8 @@
 #define BGM_BUFSIZE 786432 // Max dimension of BGM buffer size
 #define OGG_BUFSIZE 2048 // Max dimension of PCM16 decoded block by libogg
 
+class AudioRingBuffer;
+
 struct DecodedSound{
 	bool isStereo;
 	u8* audiobuf;
@@ -40,12 +42,22 @@ struct DecodedMusic{
 	u64 starttick;
 	u32 block_idx;
 	u32 eof_idx;
+	u64 stream_pos; // Bytes decoded so far, including the initial audiobuffer
 	bool isPlaying;
 	int fade_val;
 	float vol;
-	void (*updateCallback)();
+	void (*decodeCallback)(AudioRingBuffer* ring); // Decodes ahead until the ring is full
 	void (*closeCallback)();
 };
 
-int DecodeSound(std::string const& filename, DecodedSound* Sound);
+// Decodes a sound, returns its cache id (0 without the cache) or -1. With
+// error set the sound is decoded for a worker thread: its audiobuffer is
+// allocated with malloc and failures are stored instead of logged
+int DecodeSound(std::string const& filename, DecodedSound* Sound, std::string* error = NULL);
+
+// Copies a sound decoded by a worker into the cache or linear memory
+int ImportSound(DecodedSound* Decoded, DecodedSound* Sound);
+
+// Frees a sound decoded by a worker, allocated with new
+void FreeDecodedSound(DecodedSound* Decoded);
 int DecodeMusic(std::string const& filename, DecodedMusic* Sound);
\ No newline at end of file
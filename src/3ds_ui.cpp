@@ -26,6 +26,7 @@
 #include "output.h"
 #include "player.h"
 #include "bitmap.h"
+#include "texture_swizzle.h"
 #include <iostream>
 #include <sys/iosupport.h>
 
@@ -177,6 +178,7 @@ void CtrUi::ProcessEvents() {
 	keys[Input::Keys::UP] = (input & KEY_DUP);
 	keys[Input::Keys::DOWN] = (input & KEY_DDOWN);
 	keys[Input::Keys::F2] = (input & KEY_L);
+	keys[Input::Keys::F6] = (input & KEY_ZL); // Toggles the profiler
 	
 	//Fullscreen mode support
 	bool old_state = trigger_state;
@@ -229,10 +231,31 @@ void CtrUi::ProcessEvents() {
 }
 
 void CtrUi::UpdateDisplay() {
-	main_texture->tiled = 0;
-	sf2d_fill_texture_from_RGBA8(main_texture, main_surface->pixels(),
-	                                             main_surface->GetWidth(), main_surface->GetHeight()
-	                            );
+	// Swizzle the changed tiles straight into the texture instead of
+	// letting sf2d convert the whole surface
+	TextureSwizzle::Texture texture = {
+		(uint32_t*)main_texture->data, main_texture->pow2_w, main_texture->pow2_h
+	};
+	TextureSwizzle::Image image = {
+		(const uint8_t*)main_surface->pixels(), main_surface->pitch(),
+		main_surface->GetWidth(), main_surface->GetHeight()
+	};
+
+	if (dirty_all) {
+		TextureSwizzle::SwizzleImage(texture, image);
+		GSPGPU_FlushDataCache(main_texture->data, texture.width * texture.height * 4);
+	} else {
+		for (const Rect& rect : dirty_rects) {
+			if (TextureSwizzle::SwizzleRect(texture, image, rect.x, rect.y, rect.width, rect.height) > 0) {
+				uint32_t offset, size;
+				TextureSwizzle::GetRowBytes(texture, rect.y, rect.height, offset, size);
+				GSPGPU_FlushDataCache((u8*)main_texture->data + offset, size);
+			}
+		}
+	}
+	main_texture->tiled = 1;
+	ResetDirtyRects();
+
 	sf2d_start_frame(GFX_TOP, GFX_LEFT);
 	if (!fullscreen) sf2d_draw_texture(main_texture, 40, 0);
 	else sf2d_draw_texture_scale(main_texture, 0, 0, 1.25, 1.0);
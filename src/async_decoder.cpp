@@ -0,0 +1,561 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "async_decoder.h"
+#include "async_handler.h"
+#include "audio.h"
+#include "filefinder.h"
+#include "image_bmp.h"
+#include "image_png.h"
+#include "image_xyz.h"
+#include "output.h"
+
+#if defined(_3DS)
+#  include <3ds.h>
+#elif !defined(EMSCRIPTEN)
+#  define USE_STD_THREAD
+#  include <condition_variable>
+#  include <mutex>
+#  include <system_error>
+#  include <thread>
+#endif
+
+#if defined(_3DS) || defined(USE_STD_THREAD)
+#  define HAVE_DECODER_THREADS
+#endif
+
+namespace {
+	/** How the transparency setting changes the decoded pixels. */
+	enum Keying {
+		/** Both settings give the same pixels. */
+		KeyingNone,
+		/** Decoded transparent, the opaque pixels only differ in alpha, which is full. */
+		KeyingAlpha,
+		/** Decoded for one setting only. */
+		KeyingExact
+	};
+
+	struct Job {
+		FileRequestAsync* request;
+		std::string path;
+		bool is_sound;
+		bool transparent;
+		bool success;
+		std::string error;
+		Keying keying;
+		int width;
+		int height;
+		void* pixels;
+		AudioInterface* audio;
+		void* sound;
+	};
+
+	struct DecodedImage {
+		bool transparent;
+		Keying keying;
+		int width;
+		int height;
+		void* pixels;
+		int age;
+	};
+
+	struct DecodedAudio {
+		AudioInterface* audio;
+		void* sound;
+		int age;
+	};
+
+	std::map<std::string, DecodedImage> decoded_images;
+	std::map<std::string, DecodedAudio> decoded_sounds;
+
+	// Files nobody asked for within this many frames are freed again
+	const int max_decoded_age = 60;
+
+#ifdef HAVE_DECODER_THREADS
+	const int worker_count = 2;
+	bool workers_started = false;
+	volatile bool workers_quit = false;
+
+	std::deque<Job> pending_jobs;
+	std::deque<Job> finished_jobs;
+
+	inline uint32_t ReadBE32(const uint8_t* data) {
+		return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+	}
+
+	// Paletted and gray PNGs are keyed like XYZ and BMP, unless a tRNS
+	// chunk gives them alpha which the opaque decode keeps
+	Keying GetPNGKeying(FILE* stream) {
+		uint8_t chunk[8];
+		uint8_t header[13];
+
+		fseek(stream, 8, SEEK_SET);
+		if (fread(chunk, 1, 8, stream) != 8 || memcmp(chunk + 4, "IHDR", 4) != 0 ||
+			fread(header, 1, 13, stream) != 13) {
+			return KeyingExact;
+		}
+
+		int const color_type = header[9];
+		if (color_type != 0 && color_type != 3) {
+			return KeyingNone;
+		}
+
+		fseek(stream, 4, SEEK_CUR);
+		while (fread(chunk, 1, 8, stream) == 8) {
+			if (memcmp(chunk + 4, "tRNS", 4) == 0) {
+				return KeyingExact;
+			}
+			if (memcmp(chunk + 4, "IDAT", 4) == 0 || memcmp(chunk + 4, "IEND", 4) == 0) {
+				return KeyingAlpha;
+			}
+			fseek(stream, ReadBE32(chunk) + 4, SEEK_CUR);
+		}
+
+		return KeyingExact;
+	}
+
+	void DecodeImage(Job& job) {
+		job.success = false;
+
+		FILE* stream = FileFinder::fopenUTF8(job.path, "rb");
+		if (!stream) {
+			return;
+		}
+
+		char data[4];
+		size_t bytes = fread(&data, 1, 4, stream);
+
+		// Keyed formats are decoded transparent, Take derives the opaque
+		// pixels. Errors are stored in the job and reported by the main
+		// thread, unknown formats are left to the Cache
+		if (bytes >= 4 && strncmp((char*)data, "XYZ1", 4) == 0) {
+			job.keying = KeyingAlpha;
+			job.transparent = true;
+			fseek(stream, 0, SEEK_SET);
+			job.success = ImageXYZ::ReadXYZ(stream, job.transparent, job.width, job.height, job.pixels, &job.error);
+		} else if (bytes > 2 && strncmp((char*)data, "BM", 2) == 0) {
+			job.keying = KeyingAlpha;
+			job.transparent = true;
+			fseek(stream, 0, SEEK_SET);
+			job.success = ImageBMP::ReadBMP(stream, job.transparent, job.width, job.height, job.pixels, &job.error);
+		} else if (bytes >= 4 && strncmp((char*)(data + 1), "PNG", 3) == 0) {
+			job.keying = GetPNGKeying(stream);
+			job.transparent = job.transparent || job.keying == KeyingAlpha;
+			fseek(stream, 0, SEEK_SET);
+			job.success = ImagePNG::ReadPNG(stream, (void*)NULL, job.transparent, job.width, job.height, job.pixels, &job.error);
+		}
+
+		fclose(stream);
+	}
+
+	void RunJob(Job& job) {
+		if (job.is_sound) {
+			job.sound = job.audio->SE_Decode(job.path, job.error);
+			job.success = job.sound != NULL;
+		} else {
+			DecodeImage(job);
+		}
+	}
+
+	void FreeJob(Job& job) {
+		free(job.pixels);
+		if (job.sound) {
+			job.audio->SE_Free(job.sound);
+		}
+	}
+
+	// Thread layer, the queues are shared by the workers and the main thread
+#ifdef _3DS
+	Thread workers[worker_count];
+
+	// Signalled when a job is queued or the workers quit
+	Handle jobs_event;
+	LightLock queue_lock;
+
+	// Waits for a job, false when the workers quit
+	bool NextJob(Job& job) {
+		for (;;) {
+			svcWaitSynchronization(jobs_event, U64_MAX);
+			if (workers_quit) {
+				// Wake the next worker, the event resets on every wakeup
+				svcSignalEvent(jobs_event);
+				return false;
+			}
+
+			bool has_job = false;
+
+			LightLock_Lock(&queue_lock);
+			if (!pending_jobs.empty()) {
+				job = pending_jobs.front();
+				pending_jobs.pop_front();
+				has_job = true;
+			}
+			if (!pending_jobs.empty()) {
+				svcSignalEvent(jobs_event);
+			}
+			LightLock_Unlock(&queue_lock);
+
+			if (has_job) {
+				return true;
+			}
+		}
+	}
+
+	void PushJob(Job const& job) {
+		LightLock_Lock(&queue_lock);
+		pending_jobs.push_back(job);
+		LightLock_Unlock(&queue_lock);
+		svcSignalEvent(jobs_event);
+	}
+
+	void FinishJob(Job const& job) {
+		LightLock_Lock(&queue_lock);
+		finished_jobs.push_back(job);
+		LightLock_Unlock(&queue_lock);
+	}
+
+	void TakeFinishedJobs(std::deque<Job>& jobs) {
+		LightLock_Lock(&queue_lock);
+		jobs.swap(finished_jobs);
+		LightLock_Unlock(&queue_lock);
+	}
+
+	void WorkerThread(void*);
+
+	void StopThreads(int count) {
+		workers_quit = true;
+		svcSignalEvent(jobs_event);
+		for (int i = 0; i < count; ++i) {
+			threadJoin(workers[i], U64_MAX);
+			threadFree(workers[i]);
+		}
+		svcCloseHandle(jobs_event);
+	}
+
+	bool StartThreads() {
+		LightLock_Init(&queue_lock);
+
+		if (svcCreateEvent(&jobs_event, 0) != 0) { // One shot
+			return false;
+		}
+
+		// One worker on the system core, one on the application core with
+		// lowest priority, so it only runs while the main thread sleeps
+		for (int i = 0; i < worker_count; ++i) {
+			workers[i] = threadCreate(WorkerThread, NULL, 64 * 1024, 0x3F, i == 0 ? 1 : -2, false);
+			if (!workers[i]) {
+				StopThreads(i);
+				return false;
+			}
+		}
+
+		return true;
+	}
+#else
+	std::thread workers[worker_count];
+
+	// Notified when a job is queued or the workers quit
+	std::condition_variable jobs_cond;
+	std::mutex queue_lock;
+
+	// Waits for a job, false when the workers quit
+	bool NextJob(Job& job) {
+		std::unique_lock<std::mutex> lock(queue_lock);
+		while (!workers_quit && pending_jobs.empty()) {
+			jobs_cond.wait(lock);
+		}
+		if (workers_quit) {
+			return false;
+		}
+
+		job = pending_jobs.front();
+		pending_jobs.pop_front();
+		return true;
+	}
+
+	void PushJob(Job const& job) {
+		{
+			std::lock_guard<std::mutex> lock(queue_lock);
+			pending_jobs.push_back(job);
+		}
+		jobs_cond.notify_one();
+	}
+
+	void FinishJob(Job const& job) {
+		std::lock_guard<std::mutex> lock(queue_lock);
+		finished_jobs.push_back(job);
+	}
+
+	void TakeFinishedJobs(std::deque<Job>& jobs) {
+		std::lock_guard<std::mutex> lock(queue_lock);
+		jobs.swap(finished_jobs);
+	}
+
+	void WorkerThread(void*);
+
+	void StopThreads(int count) {
+		{
+			std::lock_guard<std::mutex> lock(queue_lock);
+			workers_quit = true;
+		}
+		jobs_cond.notify_all();
+		for (int i = 0; i < count; ++i) {
+			workers[i].join();
+		}
+	}
+
+	bool StartThreads() {
+		for (int i = 0; i < worker_count; ++i) {
+			try {
+				workers[i] = std::thread(WorkerThread, (void*)NULL);
+			} catch (const std::system_error&) {
+				StopThreads(i);
+				return false;
+			}
+		}
+
+		return true;
+	}
+#endif
+
+	void WorkerThread(void*) {
+		Job job;
+		while (NextJob(job)) {
+			RunJob(job);
+			FinishJob(job);
+		}
+	}
+
+	bool StartWorkers() {
+		if (workers_started) {
+			return true;
+		}
+
+		workers_quit = false;
+		if (!StartThreads()) {
+			return false;
+		}
+
+		workers_started = true;
+		return true;
+	}
+
+	bool QueueJob(Job& job) {
+		if (!StartWorkers()) {
+			return false;
+		}
+
+		job.success = false;
+		job.keying = KeyingExact;
+		job.width = 0;
+		job.height = 0;
+		job.pixels = NULL;
+		job.sound = NULL;
+
+		PushJob(job);
+		return true;
+	}
+#endif
+
+	// Opaque pixels of an image decoded transparent with KeyingAlpha
+	void RemoveKeying(DecodedImage& image) {
+		uint8_t* alpha = (uint8_t*)image.pixels + 3;
+		for (int i = 0; i < image.width * image.height; ++i, alpha += 4) {
+			*alpha = 255;
+		}
+		image.transparent = false;
+	}
+}
+
+bool AsyncDecoder::Enqueue(FileRequestAsync* request, const std::string& path, bool transparent) {
+#ifdef HAVE_DECODER_THREADS
+	Job job;
+	job.request = request;
+	job.path = path;
+	job.is_sound = false;
+	job.transparent = transparent;
+	job.audio = NULL;
+
+	return QueueJob(job);
+#else
+	(void)request;
+	(void)path;
+	(void)transparent;
+	return false;
+#endif
+}
+
+bool AsyncDecoder::EnqueueSound(FileRequestAsync* request, const std::string& path) {
+#ifdef HAVE_DECODER_THREADS
+	Job job;
+	job.request = request;
+	job.path = path;
+	job.is_sound = true;
+	job.transparent = false;
+	job.audio = &Audio();
+
+	return QueueJob(job);
+#else
+	(void)request;
+	(void)path;
+	return false;
+#endif
+}
+
+void AsyncDecoder::Update() {
+	std::map<std::string, DecodedImage>::iterator it = decoded_images.begin();
+	while (it != decoded_images.end()) {
+		if (++it->second.age > max_decoded_age) {
+			free(it->second.pixels);
+			decoded_images.erase(it++);
+		} else {
+			++it;
+		}
+	}
+
+	std::map<std::string, DecodedAudio>::iterator sound_it = decoded_sounds.begin();
+	while (sound_it != decoded_sounds.end()) {
+		if (++sound_it->second.age > max_decoded_age) {
+			sound_it->second.audio->SE_Free(sound_it->second.sound);
+			decoded_sounds.erase(sound_it++);
+		} else {
+			++sound_it;
+		}
+	}
+
+#ifdef HAVE_DECODER_THREADS
+	if (!workers_started) {
+		return;
+	}
+
+	std::deque<Job> jobs;
+	TakeFinishedJobs(jobs);
+
+	for (Job& job : jobs) {
+		if (!job.success && !job.error.empty()) {
+			if (job.is_sound) {
+				Output::Warning("Couldn't load %s.\n%s", job.path.c_str(), job.error.c_str());
+			} else {
+				Output::Error("%s\n%s", job.error.c_str(), job.path.c_str());
+			}
+		}
+
+		if (job.success && job.is_sound) {
+			sound_it = decoded_sounds.find(job.path);
+			if (sound_it != decoded_sounds.end()) {
+				sound_it->second.audio->SE_Free(sound_it->second.sound);
+			}
+
+			DecodedAudio& sound = decoded_sounds[job.path];
+			sound.audio = job.audio;
+			sound.sound = job.sound;
+			sound.age = 0;
+		} else if (job.success) {
+			it = decoded_images.find(job.path);
+			if (it != decoded_images.end()) {
+				free(it->second.pixels);
+			}
+
+			DecodedImage& image = decoded_images[job.path];
+			image.transparent = job.transparent;
+			image.keying = job.keying;
+			image.width = job.width;
+			image.height = job.height;
+			image.pixels = job.pixels;
+			image.age = 0;
+		}
+
+		// Listeners load the file through the Cache or the audio backend
+		// which pick up the decoded data, unknown formats are handled there
+		job.request->DownloadDone(true);
+	}
+#endif
+}
+
+bool AsyncDecoder::Take(const std::string& path, bool transparent, int& width, int& height, void*& pixels) {
+	std::map<std::string, DecodedImage>::iterator it = decoded_images.find(path);
+
+	if (it == decoded_images.end()) {
+		return false;
+	}
+
+	DecodedImage& image = it->second;
+	if (image.transparent != transparent) {
+		if (image.keying == KeyingExact || (image.keying == KeyingAlpha && transparent)) {
+			// Decoded for the other setting, the file is read again
+			return false;
+		}
+		if (image.keying == KeyingAlpha) {
+			RemoveKeying(image);
+		}
+	}
+
+	width = image.width;
+	height = image.height;
+	pixels = image.pixels;
+	decoded_images.erase(it);
+
+	return true;
+}
+
+void* AsyncDecoder::TakeSound(const std::string& path) {
+	std::map<std::string, DecodedAudio>::iterator it = decoded_sounds.find(path);
+
+	if (it == decoded_sounds.end()) {
+		return NULL;
+	}
+
+	void* sound = it->second.sound;
+	decoded_sounds.erase(it);
+
+	return sound;
+}
+
+void AsyncDecoder::Quit() {
+#ifdef HAVE_DECODER_THREADS
+	if (workers_started) {
+		StopThreads(worker_count);
+		workers_started = false;
+
+		for (Job& job : finished_jobs) {
+			FreeJob(job);
+		}
+		pending_jobs.clear();
+		finished_jobs.clear();
+	}
+#endif
+
+	std::map<std::string, DecodedImage>::iterator it;
+	for (it = decoded_images.begin(); it != decoded_images.end(); ++it) {
+		free(it->second.pixels);
+	}
+	decoded_images.clear();
+
+	std::map<std::string, DecodedAudio>::iterator sound_it;
+	for (sound_it = decoded_sounds.begin(); sound_it != decoded_sounds.end(); ++sound_it) {
+		sound_it->second.audio->SE_Free(sound_it->second.sound);
+	}
+	decoded_sounds.clear();
+}
@@ -0,0 +1,93 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_ASYNC_DECODER_H_
+#define _EASYRPG_ASYNC_DECODER_H_
+
+// Headers
+#include <string>
+
+class FileRequestAsync;
+
+/**
+ * AsyncDecoder namespace.
+ * Worker threads that read and decode images (PNG, XYZ, BMP) and sound
+ * effects for FileRequestAsync on native builds. They run on libctru
+ * threads on the 3DS and on std::thread elsewhere. The workers never touch
+ * the requests, results are handed back to the main thread in Update.
+ */
+namespace AsyncDecoder {
+	/**
+	 * Queues an image for decoding.
+	 * The image is kept in a form that serves both transparency settings
+	 * when the format allows it, so Take doesn't need to decode it again
+	 * when the image is loaded with the other setting.
+	 *
+	 * @param request request that is finished when the image is decoded.
+	 * @param path resolved path of the image file.
+	 * @param transparent transparency the image will likely be loaded with.
+	 * @return false when no workers are available, the request must be
+	 *         finished synchronously then.
+	 */
+	bool Enqueue(FileRequestAsync* request, const std::string& path, bool transparent);
+
+	/**
+	 * Queues a sound effect for decoding by AudioInterface::SE_Decode of the
+	 * current audio backend.
+	 *
+	 * @param request request that is finished when the sound is decoded.
+	 * @param path resolved path of the sound file.
+	 * @return false when no workers are available.
+	 */
+	bool EnqueueSound(FileRequestAsync* request, const std::string& path);
+
+	/**
+	 * Synchronization point with the workers, called once per frame by the
+	 * main loop. Finishes the requests of all decoded files, so their
+	 * listeners run on the main thread.
+	 */
+	void Update();
+
+	/**
+	 * Takes a decoded image.
+	 * The caller owns the pixels afterwards.
+	 *
+	 * @param path path of the image file.
+	 * @param transparent transparency the image is loaded with.
+	 * @param width image width.
+	 * @param height image height.
+	 * @param pixels RGBA pixels allocated with malloc.
+	 * @return false when no decoded image is available.
+	 */
+	bool Take(const std::string& path, bool transparent, int& width, int& height, void*& pixels);
+
+	/**
+	 * Takes a decoded sound effect.
+	 * The caller owns the sound afterwards.
+	 *
+	 * @param path path of the sound file.
+	 * @return sound of AudioInterface::SE_Decode, NULL when none is available.
+	 */
+	void* TakeSound(const std::string& path);
+
+	/**
+	 * Stops the workers and frees all unclaimed images and sounds.
+	 */
+	void Quit();
+}
+
+#endif
@@ -22,7 +22,10 @@
 #  include <emscripten.h>
 #endif
 
+#include "async_decoder.h"
 #include "async_handler.h"
+#include "audio.h"
+#include "cache.h"
 #include "filefinder.h"
 #include "memory_management.h"
 #include "output.h"
@@ -102,6 +105,10 @@ bool AsyncHandler::IsImportantFilePending() {
 	return false;
 }
 
+void AsyncHandler::Update() {
+	AsyncDecoder::Update();
+}
+
 FileRequestAsync::FileRequestAsync(const std::string& folder_name, const std::string& file_name) :
 	directory(folder_name),
 	file(file_name) {
@@ -165,6 +172,21 @@ void FileRequestAsync::Start() {
 #  ifdef EM_GAME_URL
 #    warning EM_GAME_URL set and not an Emscripten build!
 #  endif
+	// Decode images and sound effects in the background, the workers
+	// finish the request
+	bool transparent;
+	if (Cache::GetDirectoryTransparency(directory, transparent)) {
+		std::string image_path = FileFinder::FindImage(directory, file);
+		if (!image_path.empty() && AsyncDecoder::Enqueue(this, image_path, transparent)) {
+			return;
+		}
+	} else if (directory == "Sound" && !Audio().SE_IsCached(file)) {
+		std::string sound_path = FileFinder::FindSound(file);
+		if (!sound_path.empty() && AsyncDecoder::EnqueueSound(this, sound_path)) {
+			return;
+		}
+	}
+
 	// add comment for fake download testing
 	DownloadDone(true);
 #endif
@@ -28,6 +28,8 @@ struct FileRequestResult;
 /**
  * AsyncHandler supports asynchronous file requests for platforms that don't
  * support synchronous IO (e.g. Emscripten).
+ * On native builds images are decoded by background workers when available
+ * (see AsyncDecoder), other files finish immediately.
  */
 namespace AsyncHandler {
 	/**
@@ -61,6 +63,13 @@ namespace AsyncHandler {
 	 * @return If any file with important-flag is pending.
 	 */
 	bool IsImportantFilePending();
+
+	/**
+	 * Finishes requests completed by background workers since the last
+	 * call. Called once per frame by the main loop, so all request
+	 * listeners are invoked on the main thread.
+	 */
+	void Update();
 }
 
 using FileRequestBinding = std::shared_ptr<int>;
@@ -146,6 +146,33 @@ struct AudioInterface : boost::noncopyable {
 	 * Stops the currently playing sound effect.
 	 */
 	virtual void SE_Stop() = 0;
+
+	/**
+	 * Checks if SE_Play has a sound effect without decoding it, it is not
+	 * decoded ahead then.
+	 *
+	 * @param file sound effect.
+	 * @return whether the sound is cached.
+	 */
+	virtual bool SE_IsCached(std::string const& /* file */) { return false; }
+
+	/**
+	 * Decodes a sound effect ahead of SE_Play, which takes it from
+	 * AsyncDecoder::TakeSound. Called on a worker thread, so it must not
+	 * touch the playback state.
+	 *
+	 * @param path resolved path of the sound file.
+	 * @param error receives the reason when decoding fails.
+	 * @return decoded sound, NULL on failure or when SE_Play decodes itself.
+	 */
+	virtual void* SE_Decode(std::string const& /* path */, std::string& /* error */) { return NULL; }
+
+	/**
+	 * Frees a sound of SE_Decode that was never played.
+	 *
+	 * @param sound decoded sound.
+	 */
+	virtual void SE_Free(void* /* sound */) {}
 };
 
 struct EmptyAudio : public AudioInterface {
@@ -16,13 +16,16 @@
  */
  
 #include "system.h"
+#include "async_decoder.h"
 #include "audio_3ds.h"
+#include "audio_ringbuffer.h"
 #include "filefinder.h"
 #include "output.h"
 
 #if defined(_3DS) && defined(SUPPORT_AUDIO)
 #include <stdio.h>
 #include <cstdlib>
+#include <cstring>
 #ifdef USE_CACHE
 #include "3ds_cache.h"
 #else
@@ -33,12 +36,77 @@
 volatile bool termStream = false;
 DecodedMusic* BGM = NULL;
 LightLock BGM_Mutex;
+
+// BGM decoder thread, fills the ring the streaming thread copies from
+volatile bool termDecode = false;
+AudioRingBuffer* BGM_Ring = NULL;
+// Held while decoding, the streaming thread never takes it. BGM and
+// BGM_Ring are only replaced while holding it and BGM_Mutex.
+LightLock BGM_DecodeMutex;
+Handle decodeEvent;
+Thread decodeThreadHandle;
+u32 BGM_Underruns = 0;
+
+static void decodeThread(void* arg){
+	for(;;) {
+		
+		// Sleeping until the streaming thread consumed a block
+		svcWaitSynchronization(decodeEvent, U64_MAX);
+		if (termDecode) break;
+		
+		LightLock_Lock(&BGM_DecodeMutex);
+		if (BGM != NULL && BGM->handle != NULL && BGM_Ring != NULL) BGM->decodeCallback(BGM_Ring);
+		LightLock_Unlock(&BGM_DecodeMutex);
+		
+	}
+}
+
+// Writes a refilled region back to memory for the audio hardware
+static void flushBlock(u8* data, u32 size){
+	if (isDSP) DSP_FlushDataCache(data, size);
+	else GSPGPU_FlushDataCache(data, size);
+}
+
+// Copies the next block from the ring into the free half of the audiobuffer
+static void refillBlock(){
+	BGM->block_idx++;
+	u32 half_buf = BGM->audiobuf_size>>1;
+	int half_check = (BGM->block_idx)%2;
+	
+	if ((!BGM->isStereo) || isDSP){ // Mono file
+		u8* dst = BGM->audiobuf + half_check * half_buf;
+		u32 got = BGM_Ring->Read(dst, half_buf);
+		if (got < half_buf){
+			memset(dst + got, 0, half_buf - got);
+			BGM_Underruns++;
+		}
+		flushBlock(dst, half_buf);
+	}else{ // Stereo file
+		u32 half_chn_size = half_buf>>1;
+		u16 byteperchannel = BGM->bytepersample>>1;
+		u32 frames = half_chn_size / byteperchannel;
+		u8* left_channel = BGM->audiobuf + half_check * half_chn_size;
+		u8* right_channel = BGM->audiobuf + half_buf + half_check * half_chn_size;
+		u32 got = BGM_Ring->ReadDeinterleaved(left_channel, right_channel, frames, byteperchannel);
+		if (got < frames){
+			memset(left_channel + got * byteperchannel, 0, (frames - got) * byteperchannel);
+			memset(right_channel + got * byteperchannel, 0, (frames - got) * byteperchannel);
+			BGM_Underruns++;
+		}
+		flushBlock(left_channel, half_chn_size);
+		flushBlock(right_channel, half_chn_size);
+	}
+	
+	svcSignalEvent(decodeEvent);
+}
+
 static void streamThread(void* arg){
 	
 	for(;;) {
 		
-		// Looks like if we delete this, thread will crash
-		svcSleepThread(10000);
+		// Decoding happens in decodeThread, this only has to catch block
+		// boundaries and fades in time
+		svcSleepThread(2000000);
 		
 		// A pretty bad way to close thread
 		if(termStream){
@@ -90,10 +158,10 @@ static void streamThread(void* arg){
 		}
 		
 		// Audio streaming feature
-		if (BGM->handle != NULL){
-			u32 block_mem = BGM->audiobuf_size>>1;
-			u32 curPos = BGM->samplerate * BGM->bytepersample * (delta / 1000);
-			if (curPos > block_mem * BGM->block_idx) BGM->updateCallback();
+		if (BGM->handle != NULL && BGM_Ring != NULL){
+			u64 block_mem = BGM->audiobuf_size>>1;
+			u64 curPos = (u64)BGM->samplerate * BGM->bytepersample * delta / 1000;
+			if (curPos > block_mem * BGM->block_idx) refillBlock();
 		}
 		
 		LightLock_Unlock(&BGM_Mutex);
@@ -146,6 +214,9 @@ CtrAudio::CtrAudio() :
 	
 	for (int i=0;i<num_channels;i++){
 		audiobuffers[i] = NULL;
+		#ifdef USE_CACHE
+		cache_ids[i] = -1;
+		#endif
 	}
 	
 	#ifndef NO_DEBUG
@@ -154,8 +225,13 @@ CtrAudio::CtrAudio() :
 	
 	// Starting a secondary thread on SYSCORE for BGM streaming
 	LightLock_Init(&BGM_Mutex);
+	LightLock_Init(&BGM_DecodeMutex);
 	threadCreate(streamThread, NULL, 32768, 0x18, 1, true);
 	
+	// The decoder runs below the streaming thread, it has a ring of data ahead
+	svcCreateEvent(&decodeEvent, 0); // One shot
+	decodeThreadHandle = threadCreate(decodeThread, NULL, 32768, 0x19, 1, false);
+	
 	#ifdef USE_CACHE
 	initCache();
 	#endif
@@ -171,11 +247,25 @@ CtrAudio::~CtrAudio() {
 	// Closing BGM streaming thread
 	termStream = true;
 	while (termStream){} // Wait for thread exiting...
+	
+	// Closing BGM decoder thread
+	termDecode = true;
+	svcSignalEvent(decodeEvent);
+	threadJoin(decodeThreadHandle, U64_MAX);
+	threadFree(decodeThreadHandle);
+	svcCloseHandle(decodeEvent);
+	
 	if (BGM != NULL){
 		linearFree(BGM->audiobuf);
 		BGM->closeCallback();
 		free(BGM);
 	}
+	delete BGM_Ring;
+	BGM_Ring = NULL;
+	
+	#ifndef NO_DEBUG
+	Output::Debug("BGM stream underruns: %u", (unsigned)BGM_Underruns);
+	#endif
 	
 	if (isDSP) ndspExit();
 	else csndExit();	
@@ -193,12 +283,17 @@ void CtrAudio::BGM_Play(std::string const& file, int volume, int /* pitch */, in
 	// If a BGM is currently playing, we kill it
 	BGM_Stop();
 	if (BGM != NULL){
+		// Waits for a running decode to finish
+		LightLock_Lock(&BGM_DecodeMutex);
 		LightLock_Lock(&BGM_Mutex);
 		linearFree(BGM->audiobuf);
 		BGM->closeCallback();
 		free(BGM);
 		BGM = NULL;
+		delete BGM_Ring;
+		BGM_Ring = NULL;
 		LightLock_Unlock(&BGM_Mutex);
+		LightLock_Unlock(&BGM_DecodeMutex);
 	}
 	
 	// Searching for the file
@@ -214,8 +309,20 @@ void CtrAudio::BGM_Play(std::string const& file, int volume, int /* pitch */, in
 	if (res < 0){
 		free(myFile);
 		return;
-	}else BGM = myFile;
+	}
+	
+	// Room for the decoder to stay a full audiobuffer ahead
+	AudioRingBuffer* ring = NULL;
+	if (myFile->handle != NULL) ring = new AudioRingBuffer(myFile->audiobuf_size);
+	
+	LightLock_Lock(&BGM_DecodeMutex);
+	LightLock_Lock(&BGM_Mutex);
+	BGM = myFile;
+	BGM_Ring = ring;
 	BGM->starttick = 0;
+	LightLock_Unlock(&BGM_Mutex);
+	LightLock_Unlock(&BGM_DecodeMutex);
+	if (ring != NULL) svcSignalEvent(decodeEvent);
 	
 	// Processing music info
 	int samplerate = BGM->samplerate;
@@ -420,6 +527,11 @@ void CtrAudio::SE_Play(std::string const& file, int volume, int /* pitch */) {
 		linearFree(audiobuffers[i]);
 		audiobuffers[i] = NULL;
 	}
+	#else
+	if (cache_ids[i] >= 0){
+		unpinCache(cache_ids[i]);
+		cache_ids[i] = -1;
+	}
 	#endif
 	
 	// Init needed vars
@@ -430,7 +542,7 @@ void CtrAudio::SE_Play(std::string const& file, int volume, int /* pitch */) {
 	
 	#ifdef USE_CACHE
 	// Looking if the sound is in sounds cache
-	int cacheIdx = lookCache(file.c_str());
+	int cacheIdx = lookCache(file.c_str(), &myFile);
 	if (cacheIdx < 0){
 	#endif
 	
@@ -441,15 +553,25 @@ void CtrAudio::SE_Play(std::string const& file, int volume, int /* pitch */) {
 			return;
 		}
 	
-		// Opening and decoding the file
-		int res = DecodeSound(path, &myFile);
+		// Opening and decoding the file, unless a worker already did
+		int res;
+		DecodedSound* decoded = static_cast<DecodedSound*>(AsyncDecoder::TakeSound(path));
+		if (decoded){
+			res = ImportSound(decoded, &myFile);
+			FreeDecodedSound(decoded);
+		}else res = DecodeSound(path, &myFile);
 		if (res < 0) return;
 		#ifdef USE_CACHE
-		else sprintf(soundtable[res],"%s",file.c_str());
+		publishCache(res, file.c_str(), &myFile);
+		cacheIdx = res;
 		#endif
 		
 	#ifdef USE_CACHE
-	}else myFile = decodedtable[cacheIdx];
+	}
+	
+	// Keep the sound in the cache while the channel plays it
+	pinCache(cacheIdx);
+	cache_ids[i] = cacheIdx;
 	#endif
 	
 	// Processing sound info
@@ -513,11 +635,36 @@ void CtrAudio::SE_Stop() {
 		#ifndef USE_CACHE
 		if (audiobuffers[i] != NULL) linearFree(audiobuffers[i]);
 		audiobuffers[i] = NULL;
+		#else
+		if (cache_ids[i] >= 0) unpinCache(cache_ids[i]);
+		cache_ids[i] = -1;
 		#endif
 	}
 	if (!isDSP) CSND_UpdateInfo(true);
 }
 
+bool CtrAudio::SE_IsCached(std::string const& file) {
+	#ifdef USE_CACHE
+	return hasCache(file.c_str());
+	#else
+	return false;
+	#endif
+}
+
+void* CtrAudio::SE_Decode(std::string const& path, std::string& error) {
+	// Runs on a worker, the sound is moved to linear memory by SE_Play
+	DecodedSound* sound = new DecodedSound;
+	if (DecodeSound(path, sound, &error) < 0){
+		delete sound;
+		return NULL;
+	}
+	return sound;
+}
+
+void CtrAudio::SE_Free(void* sound) {
+	FreeDecodedSound(static_cast<DecodedSound*>(sound));
+}
+
 void CtrAudio::Update() {	
 	
 	#ifndef USE_CACHE
@@ -531,6 +678,14 @@ void CtrAudio::Update() {
 			}
 		}
 	}
+	#else
+	// Releasing finished sounds, so they can be evicted
+	for(int i=0;i<num_channels;i++){
+		if (cache_ids[i] >= 0 && !isPlayingCallback(i)){
+			unpinCache(cache_ids[i]);
+			cache_ids[i] = -1;
+		}
+	}
 	#endif
 	
 }
@@ -45,6 +45,9 @@ struct CtrAudio : public AudioInterface {
 	void ME_Fade(int /* fade */);
 	void SE_Play(std::string const&, int, int);
 	void SE_Stop();
+	bool SE_IsCached(std::string const& file);
+	void* SE_Decode(std::string const& path, std::string& error);
+	void SE_Free(void* sound);
 	void Update();
 
 	void BGM_OnPlayedOnce();
@@ -52,6 +55,9 @@ struct CtrAudio : public AudioInterface {
 
 private:
 	u8* audiobuffers[SOUND_CHANNELS]; // We'll use last two available channels for BGM
+#ifdef USE_CACHE
+	int cache_ids[SOUND_CHANNELS]; // Sound cache entries pinned by the channels
+#endif
 	uint8_t num_channels = SOUND_CHANNELS;
 	ndspWaveBuf dspSounds[SOUND_CHANNELS+1]; // We need one more waveBuf for BGM purposes
 	int bgm_volume; // Stubbed
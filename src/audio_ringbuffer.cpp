@@ -0,0 +1,139 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cstring>
+#include "audio_ringbuffer.h"
+
+AudioRingBuffer::AudioRingBuffer(size_t min_size) :
+	write_pos(0),
+	read_pos(0) {
+	size_t size = 1;
+	while (size < min_size) {
+		size <<= 1;
+	}
+	buffer.resize(size);
+	mask = size - 1;
+}
+
+size_t AudioRingBuffer::GetCapacity() const {
+	return buffer.size();
+}
+
+size_t AudioRingBuffer::GetFree() const {
+	return buffer.size() - (write_pos.load(std::memory_order_relaxed) - read_pos.load(std::memory_order_acquire));
+}
+
+size_t AudioRingBuffer::GetAvailable() const {
+	return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_relaxed);
+}
+
+uint8_t* AudioRingBuffer::GetWriteRegion(size_t& bytes) {
+	size_t const offset = write_pos.load(std::memory_order_relaxed) & mask;
+	bytes = std::min(GetFree(), buffer.size() - offset);
+	return &buffer[offset];
+}
+
+void AudioRingBuffer::CommitWrite(size_t bytes) {
+	write_pos.store(write_pos.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+}
+
+size_t AudioRingBuffer::Write(const void* data, size_t bytes) {
+	const uint8_t* src = static_cast<const uint8_t*>(data);
+	size_t const total = std::min(bytes, GetFree());
+	size_t const offset = write_pos.load(std::memory_order_relaxed) & mask;
+	size_t const first = std::min(total, buffer.size() - offset);
+
+	memcpy(&buffer[offset], src, first);
+	memcpy(&buffer[0], src + first, total - first);
+
+	CommitWrite(total);
+	return total;
+}
+
+size_t AudioRingBuffer::Read(void* data, size_t bytes) {
+	uint8_t* dst = static_cast<uint8_t*>(data);
+	size_t const total = std::min(bytes, GetAvailable());
+	size_t const pos = read_pos.load(std::memory_order_relaxed);
+	size_t const offset = pos & mask;
+	size_t const first = std::min(total, buffer.size() - offset);
+
+	memcpy(dst, &buffer[offset], first);
+	memcpy(dst + first, &buffer[0], total - first);
+
+	read_pos.store(pos + total, std::memory_order_release);
+	return total;
+}
+
+size_t AudioRingBuffer::ReadDeinterleaved(uint8_t* left, uint8_t* right, size_t frames, int sample_size) {
+	size_t const frame_size = sample_size * 2;
+	size_t const total = std::min(frames, GetAvailable() / frame_size);
+	size_t const pos = read_pos.load(std::memory_order_relaxed);
+	size_t done = 0;
+
+	while (done < total) {
+		size_t const offset = (pos + done * frame_size) & mask;
+		size_t count = std::min(total - done, (buffer.size() - offset) / frame_size);
+
+		if (count == 0) {
+			// A frame wraps around the end, sample sizes are powers of two
+			// so this only happens with a misaligned producer
+			uint8_t frame[4];
+			for (size_t i = 0; i < frame_size; ++i) {
+				frame[i] = buffer[(offset + i) & mask];
+			}
+			count = 1;
+			Deinterleave(frame, left + done * sample_size, right + done * sample_size, 1, sample_size);
+		} else {
+			Deinterleave(&buffer[offset], left + done * sample_size, right + done * sample_size, count, sample_size);
+		}
+		done += count;
+	}
+
+	read_pos.store(pos + total * frame_size, std::memory_order_release);
+	return total;
+}
+
+void AudioRingBuffer::Clear() {
+	write_pos.store(0);
+	read_pos.store(0);
+}
+
+void AudioRingBuffer::Deinterleave(const uint8_t* src, uint8_t* left, uint8_t* right, size_t frames, int sample_size) {
+	if (sample_size == 2) {
+		// Whole frames at once, both samples stay in native byte order
+		uint16_t* l = reinterpret_cast<uint16_t*>(left);
+		uint16_t* r = reinterpret_cast<uint16_t*>(right);
+		for (size_t i = 0; i < frames; ++i) {
+			uint32_t frame;
+			memcpy(&frame, src + i * 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			l[i] = (uint16_t)(frame >> 16);
+			r[i] = (uint16_t)frame;
+#else
+			l[i] = (uint16_t)frame;
+			r[i] = (uint16_t)(frame >> 16);
+#endif
+		}
+	} else {
+		for (size_t i = 0; i < frames; ++i) {
+			left[i] = src[i * 2];
+			right[i] = src[i * 2 + 1];
+		}
+	}
+}
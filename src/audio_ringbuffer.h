@@ -0,0 +1,133 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_AUDIO_RINGBUFFER_H_
+#define _EASYRPG_AUDIO_RINGBUFFER_H_
+
+// Headers
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * AudioRingBuffer class.
+ * Byte ring buffer between one producer thread (the music decoder) and one
+ * consumer thread (the audio output). Both sides only publish their own
+ * position, so no lock is needed as long as there is exactly one thread
+ * on each side.
+ */
+class AudioRingBuffer {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param min_size capacity in bytes, rounded up to a power of two.
+	 */
+	explicit AudioRingBuffer(size_t min_size);
+
+	/**
+	 * @return capacity in bytes.
+	 */
+	size_t GetCapacity() const;
+
+	/**
+	 * Producer side.
+	 *
+	 * @return bytes that can be written.
+	 */
+	size_t GetFree() const;
+
+	/**
+	 * Consumer side.
+	 *
+	 * @return bytes that can be read.
+	 */
+	size_t GetAvailable() const;
+
+	/**
+	 * Producer side. Returns the contiguous free region, so decoders can
+	 * write into the buffer without a copy. Finish with CommitWrite.
+	 *
+	 * @param bytes size of the returned region.
+	 * @return start of the free region.
+	 */
+	uint8_t* GetWriteRegion(size_t& bytes);
+
+	/**
+	 * Producer side. Publishes bytes written into the write region.
+	 *
+	 * @param bytes number of bytes written.
+	 */
+	void CommitWrite(size_t bytes);
+
+	/**
+	 * Producer side. Copies data into the buffer.
+	 *
+	 * @param data source data.
+	 * @param bytes number of bytes.
+	 * @return bytes written, less than requested when the buffer is full.
+	 */
+	size_t Write(const void* data, size_t bytes);
+
+	/**
+	 * Consumer side. Copies data out of the buffer.
+	 *
+	 * @param data destination.
+	 * @param bytes number of bytes.
+	 * @return bytes read, less than requested on underrun.
+	 */
+	size_t Read(void* data, size_t bytes);
+
+	/**
+	 * Consumer side. Reads interleaved stereo frames into separate
+	 * channel buffers.
+	 *
+	 * @param left destination of the left channel.
+	 * @param right destination of the right channel.
+	 * @param frames number of frames.
+	 * @param sample_size bytes per sample and channel, 1 or 2.
+	 * @return frames read, less than requested on underrun.
+	 */
+	size_t ReadDeinterleaved(uint8_t* left, uint8_t* right, size_t frames, int sample_size);
+
+	/**
+	 * Drops all data. Neither side may use the buffer meanwhile.
+	 */
+	void Clear();
+
+	/**
+	 * Splits interleaved stereo samples into two channel buffers.
+	 *
+	 * @param src interleaved frames.
+	 * @param left destination of the left channel.
+	 * @param right destination of the right channel.
+	 * @param frames number of frames.
+	 * @param sample_size bytes per sample and channel, 1 or 2.
+	 */
+	static void Deinterleave(const uint8_t* src, uint8_t* left, uint8_t* right, size_t frames, int sample_size);
+
+private:
+	std::vector<uint8_t> buffer;
+	size_t mask;
+	/** Total bytes written, only modified by the producer. */
+	std::atomic<size_t> write_pos;
+	/** Total bytes read, only modified by the consumer. */
+	std::atomic<size_t> read_pos;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #ifdef HAVE_SDL_MIXER
 
 #include "baseui.h"
+#include "async_decoder.h"
 #include "audio_sdl.h"
 #include "filefinder.h"
 #include "output.h"
@@ -386,7 +387,9 @@ void SdlAudio::SE_Play(std::string const& file, int volume, int /* pitch */) {
 		Output::Debug("Sound not found: %s", file.c_str());
 		return;
 	}
-	EASYRPG_SHARED_PTR<Mix_Chunk> sound(Mix_LoadWAV(path.c_str()), &Mix_FreeChunk);
+	// Decoded in the background when requested through AsyncHandler
+	Mix_Chunk* decoded = static_cast<Mix_Chunk*>(AsyncDecoder::TakeSound(path));
+	EASYRPG_SHARED_PTR<Mix_Chunk> sound(decoded ? decoded : Mix_LoadWAV(path.c_str()), &Mix_FreeChunk);
 	if (!sound) {
 		Output::Warning("Couldn't load %s SE.\n%s", file.c_str(), Mix_GetError());
 		return;
@@ -407,6 +410,19 @@ void SdlAudio::SE_Stop() {
 	sounds.clear();
 }
 
+void* SdlAudio::SE_Decode(std::string const& path, std::string& error) {
+	// Only reads the mixer format, which is set before the workers run
+	Mix_Chunk* sound = Mix_LoadWAV(path.c_str());
+	if (!sound) {
+		error = Mix_GetError();
+	}
+	return sound;
+}
+
+void SdlAudio::SE_Free(void* sound) {
+	Mix_FreeChunk(static_cast<Mix_Chunk*>(sound));
+}
+
 void SdlAudio::Update() {
 }
 
@@ -49,6 +49,8 @@ struct SdlAudio : public AudioInterface {
 	void ME_Fade(int /* fade */);
 	void SE_Play(std::string const&, int, int);
 	void SE_Stop();
+	void* SE_Decode(std::string const& path, std::string& error);
+	void SE_Free(void* sound);
 	void Update();
 
 	void BGM_OnPlayedOnce();
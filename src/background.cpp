@@ -29,7 +29,9 @@
 Background::Background(const std::string& name) :
 	visible(true),
 	bg_hscroll(0), bg_vscroll(0), bg_x(0), bg_y(0),
-	fg_hscroll(0), fg_vscroll(0), fg_x(0), fg_y(0) {
+	fg_hscroll(0), fg_vscroll(0), fg_x(0), fg_y(0),
+	damaged(true),
+	damage_bg_x(0), damage_bg_y(0), damage_fg_x(0), damage_fg_y(0) {
 
 	Graphics::RegisterDrawable(this);
 
@@ -43,7 +45,9 @@ Background::Background(const std::string& name) :
 Background::Background(int terrain_id) :
 	visible(true),
 	bg_hscroll(0), bg_vscroll(0), bg_x(0), bg_y(0),
-	fg_hscroll(0), fg_vscroll(0), fg_x(0), fg_y(0) {
+	fg_hscroll(0), fg_vscroll(0), fg_x(0), fg_y(0),
+	damaged(true),
+	damage_bg_x(0), damage_bg_y(0), damage_fg_x(0), damage_fg_y(0) {
 
 	Graphics::RegisterDrawable(this);
 
@@ -82,13 +86,16 @@ void Background::OnBackgroundGraphicReady(FileRequestResult* result) {
 	else if (result->directory == "Frame") {
 		bg_bitmap = Cache::Frame(result->file);
 	}
+	damaged = true;
 }
 
 void Background::OnForegroundFrameGraphicReady(FileRequestResult* result) {
 	fg_bitmap = Cache::Frame(result->file);
+	damaged = true;
 }
 
 Background::~Background() {
+	Graphics::InvalidateAll();
 	Graphics::RemoveDrawable(this);
 }
 
@@ -115,6 +122,22 @@ void Background::Update() {
 	Update(fg_vscroll, fg_y);
 }
 
+bool Background::ReportDamage() {
+	if (damaged ||
+		Scale(bg_x) != damage_bg_x || Scale(bg_y) != damage_bg_y ||
+		Scale(fg_x) != damage_fg_x || Scale(fg_y) != damage_fg_y) {
+		Graphics::InvalidateAll();
+	}
+
+	damaged = false;
+	damage_bg_x = Scale(bg_x);
+	damage_bg_y = Scale(bg_y);
+	damage_fg_x = Scale(fg_x);
+	damage_fg_y = Scale(fg_y);
+
+	return true;
+}
+
 int Background::Scale(int x) {
 	return x > 0 ? x / 64 : -(-x / 64);
 }
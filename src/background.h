@@ -33,6 +33,8 @@ public:
 	void Draw();
 	void Update();
 
+	bool ReportDamage();
+
 	int GetZ() const;
 	DrawableType GetType() const;
 
@@ -60,6 +62,12 @@ private:
 	int fg_y;
 
 	FileRequestBinding request_id;
+
+	bool damaged;
+	int damage_bg_x;
+	int damage_bg_y;
+	int damage_fg_x;
+	int damage_fg_y;
 };
 
 #endif
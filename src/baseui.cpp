@@ -23,6 +23,8 @@
 #include "sdl_ui.h"
 #elif _3DS
 #include "3ds_ui.h"
+#elif defined(USE_HEADLESS)
+#include "headless_ui.h"
 #endif
 
 EASYRPG_SHARED_PTR<BaseUi> DisplayUi;
@@ -32,6 +34,8 @@ EASYRPG_SHARED_PTR<BaseUi> BaseUi::CreateUi(long width, long height, bool fs_fla
 	return EASYRPG_MAKE_SHARED<SdlUi>(width, height, fs_flag);
 #elif _3DS
 	return EASYRPG_MAKE_SHARED<CtrUi>(width, height);
+#elif defined(USE_HEADLESS)
+	return EASYRPG_MAKE_SHARED<HeadlessUi>(width, height);
 #else
 #error cannot create UI
 #endif
@@ -43,10 +47,21 @@ BaseUi::BaseUi()
 	, mouse_y(0)
 	, cursor_visible(false)
 	, back_color(0, 0, 0, 255)
+	, dirty_all(true)
 {
 	keys.reset();
 }
 
+void BaseUi::SetDirtyRects(std::vector<Rect> const& rects) {
+	dirty_all = false;
+	dirty_rects = rects;
+}
+
+void BaseUi::ResetDirtyRects() {
+	dirty_all = true;
+	dirty_rects.clear();
+}
+
 BaseUi::KeyStatus& BaseUi::GetKeyStates() {
 	return keys;
 }
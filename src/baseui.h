@@ -21,6 +21,7 @@
 // Headers
 #include <string>
 #include <bitset>
+#include <vector>
 
 #include "system.h"
 #include "color.h"
@@ -92,9 +93,19 @@ public:
 
 	/**
 	 * Updates video buffer.
+	 * Only the areas passed to SetDirtyRects since the last update are
+	 * transferred, the whole display surface when there were none.
 	 */
 	virtual void UpdateDisplay() = 0;
 
+	/**
+	 * Limits the next UpdateDisplay to the areas of the display surface
+	 * the compositor changed.
+	 *
+	 * @param rects changed areas, may be empty when nothing changed.
+	 */
+	void SetDirtyRects(std::vector<Rect> const& rects);
+
 	/**
 	 * Gets a copy of the display surface.
 	 *
@@ -219,6 +230,12 @@ protected:
 	 */
 	BaseUi();
 
+	/**
+	 * Called by UpdateDisplay once the dirty areas were transferred, the
+	 * next update is a full one unless SetDirtyRects is called again.
+	 */
+	void ResetDirtyRects();
+
 	/**
 	 * Display mode data struct.
 	 */
@@ -254,6 +271,12 @@ protected:
 
 	/** Color for display background. */
 	Color back_color;
+
+	/** Whole display surface must be transferred. */
+	bool dirty_all;
+
+	/** Areas to transfer when dirty_all is not set. */
+	std::vector<Rect> dirty_rects;
 };
 
 /** Global DisplayUi variable. */
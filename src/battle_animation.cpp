@@ -30,7 +30,7 @@
 #include "spriteset_battle.h"
 
 BattleAnimation::BattleAnimation(const RPG::Animation& anim) :
-	animation(anim), frame(0), z(1500), frame_update(false), large(false)
+	animation(anim), frame(0), z(1500), frame_update(false), large(false), measuring(false)
 {
 	const std::string& name = animation.animation_name;
 	BitmapRef graphic;
@@ -63,11 +63,20 @@ BattleAnimation::BattleAnimation(const RPG::Animation& anim) :
 #endif
 }
 
+BattleAnimation::~BattleAnimation() {
+	for (const Rect& rect : damage_rects) {
+		Graphics::InvalidateRect(rect);
+	}
+}
+
 int BattleAnimation::GetZ() const {
 	return z;
 }
 
 void BattleAnimation::SetZ(int nz) {
+	if (z != nz) {
+		Graphics::UpdateZCallback(this);
+	}
 	z = nz;
 }
 
@@ -75,6 +84,24 @@ DrawableType BattleAnimation::GetType() const {
 	return TypeDefault;
 }
 
+bool BattleAnimation::ReportDamage() {
+	// The cells of the previous frame and of the coming one
+	for (const Rect& rect : damage_rects) {
+		Graphics::InvalidateRect(rect);
+	}
+	damage_rects.clear();
+
+	measuring = true;
+	Draw();
+	measuring = false;
+
+	for (const Rect& rect : damage_rects) {
+		Graphics::InvalidateRect(rect);
+	}
+
+	return true;
+}
+
 void BattleAnimation::Update() {
 	if (frame_update) {
 		frame++;
@@ -164,7 +191,11 @@ void BattleAnimation::DrawAt(int x, int y) {
 		sprite->SetOpacity(255 * (100 - cell.transparency) / 100);
 		sprite->SetZoomX(cell.zoom / 100.0);
 		sprite->SetZoomY(cell.zoom / 100.0);
-		sprite->Draw();
+		if (measuring) {
+			damage_rects.push_back(sprite->GetScreenRect());
+		} else {
+			sprite->Draw();
+		}
 	}
 }
 
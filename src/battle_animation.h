@@ -36,10 +36,12 @@ struct FileRequestResult;
 class BattleAnimation : public Drawable {
 public:
 	BattleAnimation(const RPG::Animation& anim);
+	~BattleAnimation();
 
 	int GetZ() const;
 	void SetZ(int nz);
 	DrawableType GetType() const;
+	bool ReportDamage();
 
 	void Update();
 	int GetFrame() const;
@@ -65,6 +67,11 @@ protected:
 	bool frame_update;
 	bool large;
 
+	/** Cells drawn by the last frame, collected by ReportDamage. */
+	std::vector<Rect> damage_rects;
+	/** When set DrawAt only collects the cell rects. */
+	bool measuring;
+
 	FileRequestBinding request_id;
 };
 
@@ -35,7 +35,6 @@
 #include "font.h"
 #include "output.h"
 #include "util_macro.h"
-#include "bitmap_hslrgb.h"
 
 const Opacity Opacity::opaque;
 #ifdef _3DS
@@ -57,6 +56,10 @@ BitmapRef Bitmap::Create(const uint8_t* data, unsigned bytes, bool transparent,
 	return EASYRPG_MAKE_SHARED<Bitmap>(data, bytes, transparent, flags);
 }
 
+BitmapRef Bitmap::Create(int width, int height, void* pixels, bool transparent, uint32_t flags) {
+	return EASYRPG_MAKE_SHARED<Bitmap>(width, height, pixels, transparent, flags);
+}
+
 BitmapRef Bitmap::Create(Bitmap const& source, Rect const& src_rect, bool transparent) {
 	return EASYRPG_MAKE_SHARED<Bitmap>(source, src_rect, transparent);
 }
@@ -177,6 +180,35 @@ Bitmap::TileOpacity Bitmap::GetTileOpacity(int row, int col) const {
 	return !tile_opacity.empty() ? tile_opacity[row][col] : Partial;
 }
 
+unsigned Bitmap::GetRevision() const {
+	return revision;
+}
+
+std::vector<Rect> const& Bitmap::GetClipRects() const {
+	return clip_rects;
+}
+
+void Bitmap::SetClipRects(std::vector<Rect> const& rects) {
+	clip_rects = rects;
+
+	if (rects.empty()) {
+		pixman_image_set_clip_region32(bitmap, NULL);
+		return;
+	}
+
+	std::vector<pixman_box32_t> boxes;
+	boxes.reserve(rects.size());
+	for (std::vector<Rect>::const_iterator it = rects.begin(); it != rects.end(); ++it) {
+		pixman_box32_t box = { it->x, it->y, it->x + it->width, it->y + it->height };
+		boxes.push_back(box);
+	}
+
+	pixman_region32_t region;
+	pixman_region32_init_rects(&region, &boxes.front(), boxes.size());
+	pixman_image_set_clip_region32(bitmap, &region);
+	pixman_region32_fini(&region);
+}
+
 Color Bitmap::GetBackgroundColor() const {
 	return bg_color;
 }
@@ -197,6 +229,25 @@ uint8_t const* Bitmap::pointer(int x, int y) const {
 	return (uint8_t const*) pixels() + y * pitch() + x * bytes();
 }
 
+BitmapKernels::Region Bitmap::GetKernelRegion(Rect const& rect) {
+	BitmapKernels::Region region = { pointer(rect.x, rect.y), pitch(), rect.width, rect.height };
+	return region;
+}
+
+BitmapKernels::Channels Bitmap::GetKernelChannels() {
+	BitmapKernels::Channels channels = {
+		pixel_format.r.shift, pixel_format.g.shift, pixel_format.b.shift, pixel_format.a.shift
+	};
+	return channels;
+}
+
+bool Bitmap::HasKernelChannels() const {
+	return format.bytes == 4 &&
+		format.r.mask == pixel_format.r.mask &&
+		format.g.mask == pixel_format.g.mask &&
+		format.b.mask == pixel_format.b.mask;
+}
+
 BitmapRef Bitmap::Create(int width, int height, bool transparent, int /* bpp */) {
 	return EASYRPG_MAKE_SHARED<Bitmap>(width, height, transparent);
 }
@@ -220,21 +271,14 @@ void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect
 		hue -= (hue / 0x600) * 0x600;
 
 	DynamicFormat format(32,8,24,8,16,8,8,8,0,PF::Alpha);
-	std::vector<uint32_t> pixels;
+	// Reused between calls, battle animations change the hue every frame
+	static std::vector<uint32_t> pixels;
 	pixels.resize(src_rect.width * src_rect.height);
 	Bitmap bmp(reinterpret_cast<void*>(&pixels.front()), src_rect.width, src_rect.height, src_rect.width * 4, format);
 	bmp.Blit(0, 0, src, src_rect, Opacity::opaque);
 
-	for (std::vector<uint32_t>::iterator p = pixels.begin(); p != pixels.end(); ++p) {
-		uint32_t pixel = *p;
-		uint8_t r = (pixel>>24) & 0xFF;
-		uint8_t g = (pixel>>16) & 0xFF;
-		uint8_t b = (pixel>> 8) & 0xFF;
-		uint8_t a = pixel & 0xFF;
-		if (a > 0)
-			RGB_adjust_HSL(r, g, b, hue);
-		*p = ((uint32_t) r << 24) | ((uint32_t) g << 16) | ((uint32_t) b << 8) | (uint32_t) a;
-	}
+	BitmapKernels::Channels const channels = { 24, 16, 8, 0 };
+	BitmapKernels::HueRotate(bmp.GetKernelRegion(bmp.GetRect()), channels, hue);
 
 	Blit(dst_rect.x, dst_rect.y, bmp, bmp.GetRect(), Opacity::opaque);
 
@@ -242,6 +286,7 @@ void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect
 }
 
 void Bitmap::RefreshCallback() {
+	++revision;
 }
 
 FontRef const& Bitmap::GetFont() const {
@@ -578,6 +623,18 @@ Bitmap::Bitmap(const uint8_t* data, unsigned bytes, bool transparent, uint32_t f
 	CheckPixels(flags);
 }
 
+Bitmap::Bitmap(int width, int height, void* pixels, bool transparent, uint32_t flags) {
+	InitBitmap();
+
+	format = (transparent ? pixel_format : opaque_pixel_format);
+	pixman_format = find_format(format);
+
+	Init(width, height, (void *) NULL);
+	ConvertImage(width, height, pixels, transparent);
+
+	CheckPixels(flags);
+}
+
 Bitmap::Bitmap(Bitmap const& source, Rect const& src_rect, bool transparent) {
 	InitBitmap();
 
@@ -809,12 +866,17 @@ void Bitmap::TransformBlit(Rect const& dst_rect, Bitmap const& src, Rect const&
 
 	if (mask != NULL)
 		pixman_image_unref(mask);
+
+	RefreshCallback();
 }
 
 void Bitmap::WaverBlit(int x, int y, double zoom_x, double zoom_y, Bitmap const& src, Rect const& src_rect, int depth, double phase, Opacity const& opacity) {
 	if (opacity.IsTransparent())
 		return;
 
+	if (DirectWaverBlit(x, y, zoom_x, zoom_y, src, src_rect, depth, phase, opacity))
+		return;
+
 	pixman_transform_t xform;
 	pixman_transform_init_scale(&xform,
 								pixman_double_to_fixed(1.0 / zoom_x),
@@ -874,6 +936,8 @@ void Bitmap::Fill(const Color &color) {
 		0, 0,
 		0, 0,
 		src_rect.width, src_rect.height);
+
+	RefreshCallback();
 }
 
 void Bitmap::FillRect(Rect const& dst_rect, const Color &color) {
@@ -921,22 +985,6 @@ void Bitmap::ClearRect(Rect const& dst_rect) {
 	RefreshCallback();
 }
 
-// Hard light lookup table mapping source color to destination color
-static uint8_t hard_light_lookup[256][256];
-
-static void make_hard_light_lookup() {
-	for (int i = 0; i < 256; ++i) {
-		for (int j = 0; j < 256; ++j) {
-			int res = 0;
-			if (i <= 128)
-				res = (2 * i * j) / 255;
-			else
-				res = 255 - 2 * (255 - i) * (255 - j) / 255;
-			hard_light_lookup[i][j] = res > 255 ? 255 : res < 0 ? 0 : res;
-		}
-	}
-}
-
 void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, const Tone &tone, Opacity const& opacity) {
 	if (tone == Tone(128,128,128,128)) {
 		if (&src != this) {
@@ -953,9 +1001,18 @@ void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, con
 		x, y,
 		src_rect.width, src_rect.height);
 
-	if (tone.gray != 128) {
-		uint32_t* pixels = (uint32_t*)this->pixels();
+	// Only the pixels of the destination rectangle are toned
+	Rect dst_rect(x, y, src_rect.width, src_rect.height);
+	dst_rect.Adjust(GetRect());
+	if (dst_rect.IsEmpty()) {
+		RefreshCallback();
+		return;
+	}
 
+	BitmapKernels::Region const region = GetKernelRegion(dst_rect);
+	BitmapKernels::Channels const channels = GetKernelChannels();
+
+	if (tone.gray != 128) {
 		int sat;
 		if (tone.gray > 128) {
 			sat = 1024 + (tone.gray - 128) * 16;
@@ -963,64 +1020,12 @@ void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, con
 		else {
 			sat = tone.gray * 8;
 		}
-		
-		int as = pixel_format.a.shift;
-		int rs = pixel_format.r.shift;
-		int gs = pixel_format.g.shift;
-		int bs = pixel_format.b.shift;
-
-		// Algorithm from OpenPDN (MIT license)
-		// Transformation in Y'CbCr color space
-		for (int i = 0; i < src_rect.width * src_rect.height; ++i) {
-			uint32_t pixel = pixels[i];
-			uint8_t a = (pixel >> as) & 0xFF;
-			if (a == 0) {
-				continue;
-			}
-			uint8_t r = (pixel >> rs) & 0xFF;
-			uint8_t g = (pixel >> gs) & 0xFF;
-			uint8_t b = (pixel >> bs) & 0xFF;
-			// Y' = 0.299 R' + 0.587 G' + 0.114 B'
-			uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
-			// Scale Cb/Cr by scale factor "sat"
-			int red = ((lum * 1024 + (r - lum) * sat) >> 10);
-			red = red > 255 ? 255 : red < 0 ? 0 : red;
-			int green = ((lum * 1024 + (g - lum) * sat) >> 10);
-			green = green > 255 ? 255 : green < 0 ? 0 : green;
-			int blue = ((lum * 1024 + (b - lum) * sat) >> 10);
-			blue = blue > 255 ? 255 : blue < 0 ? 0 : blue;
-			pixels[i] = ((uint32_t)red << rs) | ((uint32_t)green << gs) | ((uint32_t)blue << bs) | ((uint32_t)a << as);
-		}
+
+		BitmapKernels::ToneGray(region, channels, sat);
 	}
 
 	if (tone.red != 128 || tone.green != 128 || tone.blue != 128) {
-		static bool index_made = false;
-		if (!index_made) {
-			make_hard_light_lookup();
-			index_made = true;
-		}
-
-		int as = pixel_format.a.shift;
-		int rs = pixel_format.r.shift;
-		int gs = pixel_format.g.shift;
-		int bs = pixel_format.b.shift;
-
-		uint32_t* pixels = (uint32_t*)this->pixels();
-		for (int i = 0; i < src_rect.width * src_rect.height; ++i) {
-			uint32_t pixel = pixels[i];
-			uint8_t a = (pixel >> as) & 0xFF;
-			if (a == 0) {
-				continue;
-			}
-			uint8_t r = (pixel >> rs) & 0xFF;
-			uint8_t g = (pixel >> gs) & 0xFF;
-			uint8_t b = (pixel >> bs) & 0xFF;
-
-			int red = hard_light_lookup[tone.red][r];
-			int green = hard_light_lookup[tone.green][g];
-			int blue = hard_light_lookup[tone.blue][b];
-			pixels[i] = ((uint32_t)red << rs) | ((uint32_t)green << gs) | ((uint32_t)blue << bs) | ((uint32_t)a << as);
-		}
+		BitmapKernels::ToneColor(region, channels, tone.red, tone.green, tone.blue);
 	}
 
 	RefreshCallback();
@@ -1056,6 +1061,23 @@ void Bitmap::BlendBlit(int x, int y, Bitmap const& src, Rect const& src_rect, co
 	RefreshCallback();
 }
 
+void Bitmap::FlashBlit(Rect const& dst_rect_, const Color& color, int level) {
+	Rect dst_rect = dst_rect_;
+	dst_rect.Adjust(GetRect());
+	if (dst_rect.IsEmpty() || level <= 0) {
+		return;
+	}
+
+	uint8_t r = color.red;
+	uint8_t g = color.green;
+	uint8_t b = color.blue;
+	MultiplyAlpha(r, g, b, color.alpha);
+
+	BitmapKernels::Flash(GetKernelRegion(dst_rect), GetKernelChannels(), r, g, b, color.alpha, std::min(level, 255));
+
+	RefreshCallback();
+}
+
 void Bitmap::FlipBlit(int x, int y, Bitmap const& src, Rect const& src_rect, bool horizontal, bool vertical, Opacity const& opacity) {
 	if (!horizontal && !vertical) {
 		Blit(x, y, src, src_rect, opacity);
@@ -29,6 +29,7 @@
 #include "color.h"
 #include "rect.h"
 #include "pixel_format.h"
+#include "bitmap_kernels.h"
 #include "tone.h"
 #include "matrix.h"
 #include "text.h"
@@ -107,6 +108,18 @@ public:
 	 */
 	static BitmapRef Create(const uint8_t* data, unsigned bytes, bool transparent = true, uint32_t flags = 0);
 
+	/**
+	 * Creates a bitmap from already decoded image pixels.
+	 * Takes ownership of the pixels, they are freed afterwards.
+	 *
+	 * @param width image width.
+	 * @param height image height.
+	 * @param pixels RGBA pixels allocated with malloc.
+	 * @param transparent allow transparency on bitmap.
+	 * @param flags bitmap flags.
+	 */
+	static BitmapRef Create(int width, int height, void* pixels, bool transparent, uint32_t flags);
+
 	/**
 	 * Creates a bitmap from another.
 	 *
@@ -246,7 +259,28 @@ public:
 	Color GetShadowColor() const;
 	
 	void CheckPixels(uint32_t flags);
-	
+
+	/**
+	 * Gets the revision of the bitmap contents.
+	 * The revision changes every time the pixels are modified.
+	 *
+	 * @return contents revision.
+	 */
+	unsigned GetRevision() const;
+
+	/**
+	 * Restricts all following drawing operations on this bitmap to the
+	 * given rectangles. An empty list removes the restriction.
+	 *
+	 * @param rects clip rectangles.
+	 */
+	void SetClipRects(std::vector<Rect> const& rects);
+
+	/**
+	 * @return rectangles set with SetClipRects, empty when unrestricted.
+	 */
+	std::vector<Rect> const& GetClipRects() const;
+
 protected:
 	Bitmap();
 
@@ -448,6 +482,37 @@ public:
 	 */
 	void BlendBlit(int x, int y, Bitmap const& src, Rect const& src_rect, const Color &color, Opacity const& opacity);
 
+	/**
+	 * Blends a color over a rectangle of the bitmap, like blitting a
+	 * bitmap filled with the color at the given opacity. Ignores the clip
+	 * region.
+	 *
+	 * @param dst_rect destination rect.
+	 * @param color color to apply.
+	 * @param level opacity of the color (0-255).
+	 */
+	void FlashBlit(Rect const& dst_rect, const Color &color, int level);
+
+	/**
+	 * Gets the pixels of a rectangle for the BitmapKernels and the
+	 * renderers built on them. Only valid for 32-bit bitmaps.
+	 *
+	 * @param rect rectangle inside the bitmap.
+	 * @return pixel region.
+	 */
+	BitmapKernels::Region GetKernelRegion(Rect const& rect);
+
+	/**
+	 * @return channel layout of the bitmaps created by the player.
+	 */
+	static BitmapKernels::Channels GetKernelChannels();
+
+	/**
+	 * @return whether the bitmap is 32-bit and has the color channels
+	 *         described by GetKernelChannels.
+	 */
+	bool HasKernelChannels() const;
+
 	/**
 	 * Flips the bitmap pixels.
 	 *
@@ -550,6 +615,36 @@ public:
 						   Opacity const& opacity, const Tone& tone,
 						   double zoom_x, double zoom_y);
 
+	/**
+	 * Counters of the paths taken by EffectsBlit.
+	 */
+	struct EffectsStats {
+		/** Opaque blits done with row copies. */
+		unsigned copy;
+		/** Blits with one opacity done by the row blender. */
+		unsigned constant;
+		/** Blits with split (bush depth) opacity done by the row blender. */
+		unsigned split;
+		/** Untransformed blits left to pixman, e.g. for other formats. */
+		unsigned fallback;
+		/** Zoomed blits. */
+		unsigned zoom;
+		/** Rotated blits. */
+		unsigned rotate;
+		/** Blits with waver effect. */
+		unsigned waver;
+	};
+
+	/**
+	 * @return EffectsBlit path counters.
+	 */
+	static EffectsStats GetEffectsStats();
+
+	/**
+	 * Sets all EffectsBlit path counters to 0.
+	 */
+	static void ResetEffectsStats();
+
 private:
 	/**
 	 * Blits source bitmap with transformation and opacity scaling.
@@ -616,6 +711,37 @@ private:
 						   Bitmap const& src, Rect const& src_rect,
 						   Opacity const& opacity);
 
+	/**
+	 * Blits source bitmap with opacity scaling by blending the rows
+	 * directly, used by EffectsBlit when nothing is transformed.
+	 *
+	 * @param x x position.
+	 * @param y y position.
+	 * @param src source bitmap.
+	 * @param src_rect source bitmap rectangle.
+	 * @param opacity opacity.
+	 * @return false when the bitmaps need the pixman path.
+	 */
+	bool DirectBlit(int x, int y, Bitmap const& src, Rect const& src_rect, Opacity const& opacity);
+
+	/**
+	 * WaverBlit without pixman. The row offsets are computed once per
+	 * phase and the zoom is sampled like pixman's nearest filter.
+	 *
+	 * @return false when the bitmaps need the pixman path.
+	 */
+	bool DirectWaverBlit(int x, int y, double zoom_x, double zoom_y, Bitmap const& src, Rect const& src_rect, int depth, double phase, Opacity const& opacity);
+
+	/**
+	 * Checks whether DirectBlit and DirectWaverBlit support the bitmaps.
+	 *
+	 * @param src source bitmap.
+	 * @param opacity opacity.
+	 * @param copy set when the source is copied instead of blended.
+	 * @return whether the bitmaps can be blitted without pixman.
+	 */
+	bool CanBlitDirect(Bitmap const& src, Opacity const& opacity, bool& copy) const;
+
 public:
 	/**
 	 * Draws text to bitmap.
@@ -714,6 +840,7 @@ public:
 	Bitmap(int width, int height, bool transparent);
 	Bitmap(const std::string& filename, bool transparent, uint32_t flags);
 	Bitmap(const uint8_t* data, unsigned bytes, bool transparent, uint32_t flags);
+	Bitmap(int width, int height, void* pixels, bool transparent, uint32_t flags);
 	Bitmap(Bitmap const& source, Rect const& src_rect, bool transparent);
 	Bitmap(void *pixels, int width, int height, int pitch, const DynamicFormat& format);
 
@@ -766,6 +893,9 @@ protected:
 	
 	pixman_op_t GetOperator(pixman_image_t* mask = nullptr) const;
 	bool read_only = false;
+	unsigned revision = 0;
+	/** Rectangles set with SetClipRects, for drawing done without pixman. */
+	std::vector<Rect> clip_rects;
 };
 
 #endif
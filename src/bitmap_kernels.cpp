@@ -0,0 +1,465 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cstring>
+#include "bitmap_kernels.h"
+#include "bitmap_hslrgb.h"
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define BITMAP_KERNELS_SSE2
+#endif
+
+namespace {
+	using BitmapKernels::Channels;
+	using BitmapKernels::Region;
+
+	inline uint32_t* Row(Region const& region, int y) {
+		return reinterpret_cast<uint32_t*>(region.pixels + y * region.pitch);
+	}
+
+	inline uint32_t Pack(Channels const& ch, int r, int g, int b, int a) {
+		return ((uint32_t)r << ch.r) | ((uint32_t)g << ch.g) | ((uint32_t)b << ch.b) | ((uint32_t)a << ch.a);
+	}
+
+	// pixman's rounding multiplication of two 8-bit values
+	inline int MulUn8(int a, int b) {
+		int t = a * b + 0x80;
+		return ((t >> 8) + t) >> 8;
+	}
+
+	inline int HardLight(int tone, int value) {
+		int res;
+		if (tone <= 128)
+			res = (2 * tone * value) / 255;
+		else
+			res = 255 - 2 * (255 - tone) * (255 - value) / 255;
+		return res > 255 ? 255 : res < 0 ? 0 : res;
+	}
+
+	// Algorithm from OpenPDN (MIT license)
+	// Transformation in Y'CbCr color space
+	inline uint32_t GrayPixel(uint32_t pixel, Channels const& ch, int sat) {
+		uint8_t a = (pixel >> ch.a) & 0xFF;
+		if (a == 0) {
+			return pixel;
+		}
+		uint8_t r = (pixel >> ch.r) & 0xFF;
+		uint8_t g = (pixel >> ch.g) & 0xFF;
+		uint8_t b = (pixel >> ch.b) & 0xFF;
+		// Y' = 0.299 R' + 0.587 G' + 0.114 B'
+		uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
+		// Scale Cb/Cr by scale factor "sat"
+		int red = ((lum * 1024 + (r - lum) * sat) >> 10);
+		red = red > 255 ? 255 : red < 0 ? 0 : red;
+		int green = ((lum * 1024 + (g - lum) * sat) >> 10);
+		green = green > 255 ? 255 : green < 0 ? 0 : green;
+		int blue = ((lum * 1024 + (b - lum) * sat) >> 10);
+		blue = blue > 255 ? 255 : blue < 0 ? 0 : blue;
+		return Pack(ch, red, green, blue, a);
+	}
+
+	inline uint32_t ColorPixel(uint32_t pixel, Channels const& ch, const uint8_t* lut_r, const uint8_t* lut_g, const uint8_t* lut_b) {
+		uint8_t a = (pixel >> ch.a) & 0xFF;
+		if (a == 0) {
+			return pixel;
+		}
+		return Pack(ch, lut_r[(pixel >> ch.r) & 0xFF], lut_g[(pixel >> ch.g) & 0xFF], lut_b[(pixel >> ch.b) & 0xFF], a);
+	}
+
+	inline uint32_t FlashPixel(uint32_t pixel, Channels const& ch, int sr, int sg, int sb, int sa) {
+		int const inv = 255 - sa;
+		int r = sr + MulUn8((pixel >> ch.r) & 0xFF, inv);
+		int g = sg + MulUn8((pixel >> ch.g) & 0xFF, inv);
+		int b = sb + MulUn8((pixel >> ch.b) & 0xFF, inv);
+		int a = sa + MulUn8((pixel >> ch.a) & 0xFF, inv);
+		return Pack(ch, r > 255 ? 255 : r, g > 255 ? 255 : g, b > 255 ? 255 : b, a > 255 ? 255 : a);
+	}
+
+	inline uint32_t HuePixel(uint32_t pixel, Channels const& ch, int hue) {
+		uint8_t a = (pixel >> ch.a) & 0xFF;
+		if (a == 0) {
+			return pixel;
+		}
+		uint8_t r = (pixel >> ch.r) & 0xFF;
+		uint8_t g = (pixel >> ch.g) & 0xFF;
+		uint8_t b = (pixel >> ch.b) & 0xFF;
+		RGB_adjust_HSL(r, g, b, hue);
+		return Pack(ch, r, g, b, a);
+	}
+
+#ifdef BITMAP_KERNELS_SSE2
+	// All helpers work on four pixels, one per 32-bit lane
+
+	inline __m128i Extract(__m128i pixels, int shift) {
+		return _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF));
+	}
+
+	inline __m128i Pack(Channels const& ch, __m128i r, __m128i g, __m128i b, __m128i a) {
+		__m128i p = _mm_sll_epi32(r, _mm_cvtsi32_si128(ch.r));
+		p = _mm_or_si128(p, _mm_sll_epi32(g, _mm_cvtsi32_si128(ch.g)));
+		p = _mm_or_si128(p, _mm_sll_epi32(b, _mm_cvtsi32_si128(ch.b)));
+		return _mm_or_si128(p, _mm_sll_epi32(a, _mm_cvtsi32_si128(ch.a)));
+	}
+
+	inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	// Product of lanes holding 16-bit values, one of them may be negative
+	inline __m128i Mul(__m128i a, __m128i b) {
+		return _mm_madd_epi16(a, b);
+	}
+
+	// Clamps lanes in the int16 range to 0-255
+	inline __m128i Clamp(__m128i v) {
+		__m128i v16 = _mm_packs_epi32(v, v);
+		v16 = _mm_max_epi16(v16, _mm_setzero_si128());
+		v16 = _mm_min_epi16(v16, _mm_set1_epi16(255));
+		return _mm_unpacklo_epi16(v16, _mm_setzero_si128());
+	}
+
+	inline __m128i Max(__m128i a, __m128i b) {
+		// Lanes hold 0-255, so the 16-bit comparison is enough
+		return _mm_max_epi16(a, b);
+	}
+
+	inline __m128i Min(__m128i a, __m128i b) {
+		return _mm_min_epi16(a, b);
+	}
+
+	// Exact division of even numbers up to 130050 by 255
+	inline __m128i Div255(__m128i x) {
+		__m128i q = _mm_add_epi32(x, _mm_srli_epi32(x, 8));
+		q = _mm_add_epi32(q, _mm_srli_epi32(x, 16));
+		return _mm_srli_epi32(_mm_add_epi32(q, _mm_set1_epi32(1)), 8);
+	}
+
+	// C division (truncating) for |a| < 2^24 and 0 < b < 2^8
+	inline __m128i Div(__m128i a, __m128i b) {
+		__m128i const sign = _mm_srai_epi32(a, 31);
+		__m128 const af = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_xor_si128(a, sign), sign));
+		__m128 const bf = _mm_cvtepi32_ps(b);
+		__m128i q = _mm_cvttps_epi32(_mm_div_ps(af, bf));
+		// The float quotient can be off by one, the remainder is exact
+		__m128 const rem = _mm_sub_ps(af, _mm_mul_ps(_mm_cvtepi32_ps(q), bf));
+		q = _mm_add_epi32(q, _mm_castps_si128(_mm_cmplt_ps(rem, _mm_setzero_ps())));
+		q = _mm_sub_epi32(q, _mm_castps_si128(_mm_cmpge_ps(rem, bf)));
+		return _mm_sub_epi32(_mm_xor_si128(q, sign), sign);
+	}
+
+	inline __m128i Load(const uint32_t* p) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	}
+
+	inline void Store(uint32_t* p, __m128i v) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+	}
+
+	void ToneGraySSE2(Region const& region, Channels const& ch, int sat) {
+		__m128i const coef_rg = _mm_set1_epi32(19595 | (19235 << 16));
+		__m128i const coef_b = _mm_set1_epi32(7471);
+		__m128i const satv = _mm_set1_epi32(sat);
+		__m128i const zero = _mm_setzero_si128();
+
+		for (int y = 0; y < region.height; ++y) {
+			uint32_t* pixels = Row(region, y);
+			int x = 0;
+			for (; x + 4 <= region.width; x += 4) {
+				__m128i const p = Load(pixels + x);
+				__m128i const a = Extract(p, ch.a);
+				__m128i const r = Extract(p, ch.r);
+				__m128i const g = Extract(p, ch.g);
+				__m128i const b = Extract(p, ch.b);
+
+				// 38470 does not fit a signed 16-bit factor, use 2 * 19235
+				__m128i lum = Mul(_mm_or_si128(r, _mm_slli_epi32(g, 17)), coef_rg);
+				lum = _mm_srli_epi32(_mm_add_epi32(lum, Mul(b, coef_b)), 16);
+				__m128i const lum1024 = _mm_slli_epi32(lum, 10);
+
+				__m128i const red = Clamp(_mm_srai_epi32(_mm_add_epi32(lum1024, Mul(_mm_sub_epi32(r, lum), satv)), 10));
+				__m128i const green = Clamp(_mm_srai_epi32(_mm_add_epi32(lum1024, Mul(_mm_sub_epi32(g, lum), satv)), 10));
+				__m128i const blue = Clamp(_mm_srai_epi32(_mm_add_epi32(lum1024, Mul(_mm_sub_epi32(b, lum), satv)), 10));
+
+				Store(pixels + x, Select(_mm_cmpeq_epi32(a, zero), p, Pack(ch, red, green, blue, a)));
+			}
+			for (; x < region.width; ++x) {
+				pixels[x] = GrayPixel(pixels[x], ch, sat);
+			}
+		}
+	}
+
+	inline __m128i HardLight(__m128i value, int tone) {
+		if (tone <= 128) {
+			__m128i const q = Div255(Mul(value, _mm_set1_epi32(2 * tone)));
+			// Only 255 with the neutral tone gives 256
+			return _mm_sub_epi32(q, _mm_srli_epi32(q, 8));
+		}
+		__m128i const inv = _mm_sub_epi32(_mm_set1_epi32(255), value);
+		return _mm_sub_epi32(_mm_set1_epi32(255), Div255(Mul(inv, _mm_set1_epi32(2 * (255 - tone)))));
+	}
+
+	void ToneColorSSE2(Region const& region, Channels const& ch, int red, int green, int blue, const uint8_t* lut_r, const uint8_t* lut_g, const uint8_t* lut_b) {
+		__m128i const zero = _mm_setzero_si128();
+
+		for (int y = 0; y < region.height; ++y) {
+			uint32_t* pixels = Row(region, y);
+			int x = 0;
+			for (; x + 4 <= region.width; x += 4) {
+				__m128i const p = Load(pixels + x);
+				__m128i const a = Extract(p, ch.a);
+				__m128i const r = HardLight(Extract(p, ch.r), red);
+				__m128i const g = HardLight(Extract(p, ch.g), green);
+				__m128i const b = HardLight(Extract(p, ch.b), blue);
+
+				Store(pixels + x, Select(_mm_cmpeq_epi32(a, zero), p, Pack(ch, r, g, b, a)));
+			}
+			for (; x < region.width; ++x) {
+				pixels[x] = ColorPixel(pixels[x], ch, lut_r, lut_g, lut_b);
+			}
+		}
+	}
+
+	inline __m128i MulUn8(__m128i a, __m128i b) {
+		__m128i const t = _mm_add_epi32(Mul(a, b), _mm_set1_epi32(0x80));
+		return _mm_srli_epi32(_mm_add_epi32(_mm_srli_epi32(t, 8), t), 8);
+	}
+
+	void FlashSSE2(Region const& region, Channels const& ch, int sr, int sg, int sb, int sa) {
+		__m128i const inv = _mm_set1_epi32(255 - sa);
+		__m128i const vr = _mm_set1_epi32(sr);
+		__m128i const vg = _mm_set1_epi32(sg);
+		__m128i const vb = _mm_set1_epi32(sb);
+		__m128i const va = _mm_set1_epi32(sa);
+
+		for (int y = 0; y < region.height; ++y) {
+			uint32_t* pixels = Row(region, y);
+			int x = 0;
+			for (; x + 4 <= region.width; x += 4) {
+				__m128i const p = Load(pixels + x);
+				__m128i const r = Clamp(_mm_add_epi32(vr, MulUn8(Extract(p, ch.r), inv)));
+				__m128i const g = Clamp(_mm_add_epi32(vg, MulUn8(Extract(p, ch.g), inv)));
+				__m128i const b = Clamp(_mm_add_epi32(vb, MulUn8(Extract(p, ch.b), inv)));
+				__m128i const a = Clamp(_mm_add_epi32(va, MulUn8(Extract(p, ch.a), inv)));
+
+				Store(pixels + x, Pack(ch, r, g, b, a));
+			}
+			for (; x < region.width; ++x) {
+				pixels[x] = FlashPixel(pixels[x], ch, sr, sg, sb, sa);
+			}
+		}
+	}
+
+	// Same steps as RGB_adjust_HSL, branches become lane masks
+	void HueRotateSSE2(Region const& region, Channels const& ch, int hue) {
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const one = _mm_set1_epi32(1);
+		__m128i const c255 = _mm_set1_epi32(0xFF);
+		__m128i const c511 = _mm_set1_epi32(0x1FF);
+		__m128i const c600 = _mm_set1_epi32(0x600);
+		__m128i const huev = _mm_set1_epi32(hue);
+
+		for (int y = 0; y < region.height; ++y) {
+			uint32_t* pixels = Row(region, y);
+			int x = 0;
+			for (; x + 4 <= region.width; x += 4) {
+				__m128i const p = Load(pixels + x);
+				__m128i const a = Extract(p, ch.a);
+				__m128i const r = Extract(p, ch.r);
+				__m128i const g = Extract(p, ch.g);
+				__m128i const b = Extract(p, ch.b);
+
+				// RGB to HSL, the order decides which channel is the maximum
+				__m128i const r_gt_g = _mm_cmpgt_epi32(r, g);
+				__m128i const r_gt_b = _mm_cmpgt_epi32(r, b);
+				__m128i const g_lt_b = _mm_cmpgt_epi32(b, g);
+				__m128i const r_lt_b = _mm_cmpgt_epi32(b, r);
+				__m128i const g_gt_b = _mm_cmpgt_epi32(g, b);
+
+				__m128i const r_max = _mm_and_si128(r_gt_g, r_gt_b);
+				__m128i const b_max = _mm_or_si128(
+					_mm_andnot_si128(r_gt_b, r_gt_g),
+					_mm_andnot_si128(_mm_or_si128(r_gt_g, g_gt_b), r_lt_b));
+
+				__m128i const hi = Max(Max(r, g), b);
+				__m128i const lo = Min(Min(r, g), b);
+				__m128i const c = _mm_sub_epi32(hi, lo);
+				__m128i const l2 = _mm_add_epi32(hi, lo);
+
+				__m128i const num = Select(r_max, _mm_sub_epi32(g, b),
+					Select(b_max, _mm_sub_epi32(r, g), _mm_sub_epi32(b, r)));
+				__m128i const base = Select(r_max, _mm_and_si128(g_lt_b, c600),
+					Select(b_max, _mm_set1_epi32(0x400), _mm_set1_epi32(0x200)));
+
+				__m128i const c_zero = _mm_cmpeq_epi32(c, zero);
+				__m128i h = _mm_andnot_si128(c_zero,
+					_mm_add_epi32(Div(_mm_slli_epi32(num, 8), Select(c_zero, one, c)), base));
+
+				__m128i const l2_zero = _mm_cmpeq_epi32(l2, zero);
+				__m128i const d = Select(_mm_cmpgt_epi32(l2, c255), _mm_sub_epi32(c511, l2), Select(l2_zero, one, l2));
+				__m128i s = _mm_andnot_si128(l2_zero, Div(_mm_slli_epi32(c, 8), d));
+				__m128i const l = _mm_srli_epi32(l2, 1);
+
+				// Adjust
+				h = _mm_add_epi32(h, huev);
+				h = _mm_sub_epi32(h, _mm_and_si128(_mm_cmpgt_epi32(h, c600), c600));
+				s = Min(s, c255);
+
+				// HSL to RGB
+				__m128i const ll2 = _mm_slli_epi32(l, 1);
+				__m128i const d2 = Select(_mm_cmpgt_epi32(ll2, c255), _mm_sub_epi32(c511, ll2), ll2);
+				__m128i const cc = _mm_srli_epi32(Mul(s, d2), 8);
+				__m128i const m = _mm_srli_epi32(_mm_sub_epi32(ll2, cc), 1);
+				__m128i const h0 = _mm_and_si128(h, c255);
+				__m128i const h1 = _mm_sub_epi32(c255, h0);
+				__m128i const up = _mm_add_epi32(m, _mm_srli_epi32(Mul(h0, cc), 8));
+				__m128i const down = _mm_add_epi32(m, _mm_srli_epi32(Mul(h1, cc), 8));
+				__m128i const top = _mm_add_epi32(m, cc);
+
+				__m128i const sextant = _mm_srli_epi32(h, 8);
+				__m128i const e0 = _mm_cmpeq_epi32(sextant, zero);
+				__m128i const e1 = _mm_cmpeq_epi32(sextant, one);
+				__m128i const e2 = _mm_cmpeq_epi32(sextant, _mm_set1_epi32(2));
+				__m128i const e3 = _mm_cmpeq_epi32(sextant, _mm_set1_epi32(3));
+				__m128i const e4 = _mm_cmpeq_epi32(sextant, _mm_set1_epi32(4));
+				__m128i const e5 = _mm_cmpeq_epi32(sextant, _mm_set1_epi32(5));
+
+				// Sextant 6 (h == 0x600) keeps the color like the switch does
+				__m128i nr = Select(_mm_or_si128(e0, e5), top, r);
+				nr = Select(e1, down, nr);
+				nr = Select(e4, up, nr);
+				nr = Select(_mm_or_si128(e2, e3), m, nr);
+
+				__m128i ng = Select(_mm_or_si128(e1, e2), top, g);
+				ng = Select(e0, up, ng);
+				ng = Select(e3, down, ng);
+				ng = Select(_mm_or_si128(e4, e5), m, ng);
+
+				__m128i nb = Select(_mm_or_si128(e3, e4), top, b);
+				nb = Select(e2, up, nb);
+				nb = Select(e5, down, nb);
+				nb = Select(_mm_or_si128(e0, e1), m, nb);
+
+				__m128i const out = Pack(ch, _mm_and_si128(nr, c255), _mm_and_si128(ng, c255), _mm_and_si128(nb, c255), a);
+				Store(pixels + x, Select(_mm_cmpeq_epi32(a, zero), p, out));
+			}
+			for (; x < region.width; ++x) {
+				pixels[x] = HuePixel(pixels[x], ch, hue);
+			}
+		}
+	}
+#endif
+
+	void MakeHardLightTable(uint8_t* lut, int tone) {
+		for (int i = 0; i < 256; ++i) {
+			lut[i] = HardLight(tone, i);
+		}
+	}
+}
+
+void BitmapKernels::Scalar::ToneGray(Region const& region, Channels const& channels, int sat) {
+	for (int y = 0; y < region.height; ++y) {
+		uint32_t* pixels = Row(region, y);
+		for (int x = 0; x < region.width; ++x) {
+			pixels[x] = GrayPixel(pixels[x], channels, sat);
+		}
+	}
+}
+
+void BitmapKernels::Scalar::ToneColor(Region const& region, Channels const& channels, int red, int green, int blue) {
+	// One small table per channel stays in the cache, unlike a 64 KiB one
+	uint8_t lut_r[256], lut_g[256], lut_b[256];
+	MakeHardLightTable(lut_r, red);
+	MakeHardLightTable(lut_g, green);
+	MakeHardLightTable(lut_b, blue);
+
+	for (int y = 0; y < region.height; ++y) {
+		uint32_t* pixels = Row(region, y);
+		for (int x = 0; x < region.width; ++x) {
+			pixels[x] = ColorPixel(pixels[x], channels, lut_r, lut_g, lut_b);
+		}
+	}
+}
+
+void BitmapKernels::Scalar::Flash(Region const& region, Channels const& channels, int red, int green, int blue, int alpha, int level) {
+	int const sr = MulUn8(red, level);
+	int const sg = MulUn8(green, level);
+	int const sb = MulUn8(blue, level);
+	int const sa = MulUn8(alpha, level);
+
+	for (int y = 0; y < region.height; ++y) {
+		uint32_t* pixels = Row(region, y);
+		for (int x = 0; x < region.width; ++x) {
+			pixels[x] = FlashPixel(pixels[x], channels, sr, sg, sb, sa);
+		}
+	}
+}
+
+void BitmapKernels::Scalar::HueRotate(Region const& region, Channels const& channels, int hue) {
+	for (int y = 0; y < region.height; ++y) {
+		uint32_t* pixels = Row(region, y);
+		for (int x = 0; x < region.width; ++x) {
+			pixels[x] = HuePixel(pixels[x], channels, hue);
+		}
+	}
+}
+
+void BitmapKernels::ToneGray(Region const& region, Channels const& channels, int sat) {
+#ifdef BITMAP_KERNELS_SSE2
+	ToneGraySSE2(region, channels, sat);
+#else
+	Scalar::ToneGray(region, channels, sat);
+#endif
+}
+
+void BitmapKernels::ToneColor(Region const& region, Channels const& channels, int red, int green, int blue) {
+#ifdef BITMAP_KERNELS_SSE2
+	// The tables are only needed for the pixels at the end of the rows
+	uint8_t lut_r[256], lut_g[256], lut_b[256];
+	MakeHardLightTable(lut_r, red);
+	MakeHardLightTable(lut_g, green);
+	MakeHardLightTable(lut_b, blue);
+	ToneColorSSE2(region, channels, red, green, blue, lut_r, lut_g, lut_b);
+#else
+	Scalar::ToneColor(region, channels, red, green, blue);
+#endif
+}
+
+void BitmapKernels::Flash(Region const& region, Channels const& channels, int red, int green, int blue, int alpha, int level) {
+#ifdef BITMAP_KERNELS_SSE2
+	FlashSSE2(region, channels, MulUn8(red, level), MulUn8(green, level), MulUn8(blue, level), MulUn8(alpha, level));
+#else
+	Scalar::Flash(region, channels, red, green, blue, alpha, level);
+#endif
+}
+
+void BitmapKernels::HueRotate(Region const& region, Channels const& channels, int hue) {
+#ifdef BITMAP_KERNELS_SSE2
+	HueRotateSSE2(region, channels, hue);
+#else
+	Scalar::HueRotate(region, channels, hue);
+#endif
+}
+
+const char* BitmapKernels::GetVectorPath() {
+#ifdef BITMAP_KERNELS_SSE2
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
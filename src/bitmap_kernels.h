@@ -0,0 +1,160 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_BITMAP_KERNELS_H_
+#define _EASYRPG_BITMAP_KERNELS_H_
+
+// Headers
+#include <stdint.h>
+
+/**
+ * BitmapKernels namespace.
+ * Per-pixel color effects on 32-bit pixels, used by the Bitmap blits.
+ * Every kernel has a scalar version and, when the compiler targets SSE2,
+ * a vector version that is selected at build time. Both give identical
+ * results.
+ * Pixels with an alpha of 0 are left untouched by the tone and hue kernels.
+ */
+namespace BitmapKernels {
+	/**
+	 * Positions of the 8-bit channels inside a pixel.
+	 */
+	struct Channels {
+		int r;
+		int g;
+		int b;
+		int a;
+	};
+
+	/**
+	 * Pixel region the kernels work on.
+	 */
+	struct Region {
+		/** First pixel. */
+		uint8_t* pixels;
+		/** Bytes between two rows. */
+		int pitch;
+		int width;
+		int height;
+	};
+
+	/**
+	 * Scales the saturation in Y'CbCr color space.
+	 *
+	 * @param region pixels to modify.
+	 * @param channels pixel layout.
+	 * @param sat saturation factor, 1024 keeps the colors.
+	 */
+	void ToneGray(Region const& region, Channels const& channels, int sat);
+
+	/**
+	 * Applies the red, green and blue tone with hard light blending.
+	 *
+	 * @param region pixels to modify.
+	 * @param channels pixel layout.
+	 * @param red red tone (0-255, 128 is neutral).
+	 * @param green green tone.
+	 * @param blue blue tone.
+	 */
+	void ToneColor(Region const& region, Channels const& channels, int red, int green, int blue);
+
+	/**
+	 * Blends a color over the pixels like a pixman OVER with a constant
+	 * mask.
+	 *
+	 * @param region pixels to modify.
+	 * @param channels pixel layout.
+	 * @param red premultiplied color.
+	 * @param green premultiplied color.
+	 * @param blue premultiplied color.
+	 * @param alpha color alpha.
+	 * @param level strength (0-255).
+	 */
+	void Flash(Region const& region, Channels const& channels, int red, int green, int blue, int alpha, int level);
+
+	/**
+	 * Rotates the hue in HSL color space.
+	 *
+	 * @param region pixels to modify.
+	 * @param channels pixel layout.
+	 * @param hue rotation in 1/256 sextants (0-0x600).
+	 */
+	void HueRotate(Region const& region, Channels const& channels, int hue);
+
+	/**
+	 * Multiplies the four 8-bit channels of a pixel with a factor, with
+	 * the same rounding as pixman.
+	 *
+	 * @param x pixel.
+	 * @param a factor (0-255).
+	 * @return scaled pixel.
+	 */
+	inline uint32_t MulUn8x4(uint32_t x, uint32_t a) {
+		uint32_t rb = (x & 0xFF00FF) * a + 0x800080;
+		rb = ((rb + ((rb >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+		uint32_t ag = ((x >> 8) & 0xFF00FF) * a + 0x800080;
+		ag = (ag + ((ag >> 8) & 0xFF00FF)) & 0xFF00FF00;
+		return rb | ag;
+	}
+
+	/**
+	 * Adds the four 8-bit channels of two pixels, saturating at 255.
+	 *
+	 * @param x first pixel.
+	 * @param y second pixel.
+	 * @return sum.
+	 */
+	inline uint32_t AddUn8x4(uint32_t x, uint32_t y) {
+		uint32_t rb = (x & 0xFF00FF) + (y & 0xFF00FF);
+		rb = (rb | (0x10000100 - ((rb >> 8) & 0xFF00FF))) & 0xFF00FF;
+		uint32_t ag = ((x >> 8) & 0xFF00FF) + ((y >> 8) & 0xFF00FF);
+		ag = (ag | (0x10000100 - ((ag >> 8) & 0xFF00FF))) & 0xFF00FF;
+		return rb | (ag << 8);
+	}
+
+	/**
+	 * Blends a premultiplied pixel over another one like pixman's OVER.
+	 *
+	 * @param s source pixel.
+	 * @param d destination pixel.
+	 * @param alpha_shift position of the alpha channel.
+	 * @return blended pixel.
+	 */
+	inline uint32_t OverUn8x4(uint32_t s, uint32_t d, int alpha_shift) {
+		uint32_t const a = (s >> alpha_shift) & 0xFF;
+		if (a == 0xFF)
+			return s;
+		return AddUn8x4(s, MulUn8x4(d, 0xFF - a));
+	}
+
+	/**
+	 * @return name of the vector path compiled in, "scalar" when none.
+	 */
+	const char* GetVectorPath();
+
+	/**
+	 * Scalar versions, always available for comparison.
+	 */
+	namespace Scalar {
+		void ToneGray(Region const& region, Channels const& channels, int sat);
+		void ToneColor(Region const& region, Channels const& channels, int red, int green, int blue);
+		void Flash(Region const& region, Channels const& channels, int red, int green, int blue, int alpha, int level);
+		void HueRotate(Region const& region, Channels const& channels, int hue);
+	}
+}
+
+#endif
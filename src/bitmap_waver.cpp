@@ -0,0 +1,175 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <pixman.h>
+#include "bitmap_waver.h"
+
+namespace {
+	using BitmapKernels::MulUn8x4;
+	using BitmapKernels::OverUn8x4;
+
+	// sin() of the waver angle of each source row, for one phase
+	struct WaverTable {
+		bool valid;
+		double phase;
+		std::vector<double> sines;
+	};
+	WaverTable waver_table = { false, 0.0, std::vector<double>() };
+
+	double WaverSine(double phase, int row) {
+		if (!waver_table.valid || waver_table.phase != phase) {
+			waver_table.valid = true;
+			waver_table.phase = phase;
+			waver_table.sines.clear();
+		}
+
+		for (int r = waver_table.sines.size(); r <= row; ++r) {
+			waver_table.sines.push_back(sin((phase + r * 11.2) * 3.14159 / 180));
+		}
+
+		return waver_table.sines[row];
+	}
+
+	// Pixel sampled by pixman's nearest filter for a pixel center scaled
+	// with a 16.16 fixed point factor
+	inline int ScaledPixel(pixman_fixed_t unit, int pos) {
+		int64_t const v = ((int64_t)unit * (((int64_t)pos << 16) + 0x8000) + 0x8000) >> 16;
+		return (int)((v - pixman_fixed_e) >> 16);
+	}
+
+	// Mask pixel pixman's nearest filter samples for the pixel center at x, y
+	void MaskPixel(pixman_transform_t& xform, int x, int y, int& mask_x, int& mask_y) {
+		pixman_vector_t v = {{
+			pixman_int_to_fixed(x) + pixman_fixed_1 / 2,
+			pixman_int_to_fixed(y) + pixman_fixed_1 / 2,
+			pixman_fixed_1
+		}};
+		pixman_transform_point_3d(&xform, &v);
+		mask_x = (v.vector[0] - pixman_fixed_e) >> 16;
+		mask_y = (v.vector[1] - pixman_fixed_e) >> 16;
+	}
+
+	std::vector<int> columns;
+}
+
+void BitmapWaver::Blit(BitmapKernels::Region const& dst, int clip_x, int clip_y, int clip_width, int clip_height,
+	BitmapKernels::Region const& src, Params const& params) {
+	int const height = static_cast<int>(std::floor(params.src_height * params.zoom_y));
+	int const width = static_cast<int>(std::floor(params.src_width * params.zoom_x));
+
+	int const left = std::max(clip_x, 0);
+	int const top = std::max(clip_y, 0);
+	int const right = std::min(clip_x + clip_width, dst.width);
+	int const bottom = std::min(clip_y + clip_height, dst.height);
+	if (width <= 0 || height <= 0 || left >= right || top >= bottom)
+		return;
+
+	// Same sampling as the pixman transform of WaverBlit: the source row
+	// only depends on the destination row, not on src_y
+	pixman_fixed_t const unit_x = pixman_double_to_fixed(1.0 / params.zoom_x);
+	pixman_fixed_t const unit_y = pixman_double_to_fixed(1.0 / params.zoom_y);
+
+	// Columns sampled for each destination pixel, outside of the source
+	// pixman reads transparent pixels
+	columns.resize(width);
+	for (int k = 0; k < width; ++k) {
+		int const column = ScaledPixel(unit_x, params.src_x + k);
+		columns[k] = column < src.width ? column : -1;
+	}
+
+	// A split opacity is a 1x2 mask scaled over the source rect like in
+	// CreateMask, sampled at the mask origin src_x, i of every row
+	pixman_transform_t mask_xform;
+	int mask_begin = 0;
+	int mask_end = width;
+	if (params.split > 0) {
+		pixman_transform_t scale;
+		pixman_transform_init_scale(&scale, unit_x, unit_y);
+		pixman_transform_init_identity(&mask_xform);
+		pixman_transform_scale(NULL, &mask_xform,
+			pixman_int_to_fixed(params.src_width), pixman_int_to_fixed(params.src_height));
+		pixman_transform_translate(NULL, &mask_xform, 0, -pixman_int_to_fixed(params.split));
+		pixman_transform_multiply(&mask_xform, &mask_xform, &scale);
+
+		// Columns inside of the mask, the scale is positive so they are a run
+		int mask_x;
+		int mask_y;
+		mask_begin = width;
+		mask_end = width;
+		for (int k = 0; k < width; ++k) {
+			MaskPixel(mask_xform, params.src_x + k, 0, mask_x, mask_y);
+			if (mask_x == 0 && mask_begin == width) {
+				mask_begin = k;
+			} else if (mask_x > 0) {
+				mask_end = k;
+				break;
+			}
+		}
+		if (mask_begin >= mask_end)
+			return;
+	}
+
+	for (int i = 0; i < height; i++) {
+		int const dy = params.y + i;
+		if (dy < top)
+			continue;
+		if (dy >= bottom)
+			break;
+
+		int opacity = params.opacity_top;
+		if (params.split > 0) {
+			int mask_x;
+			int mask_y;
+			MaskPixel(mask_xform, params.src_x, i, mask_x, mask_y);
+			opacity = mask_y == 0 ? params.opacity_top :
+				mask_y == 1 ? params.opacity_bottom : 0;
+		}
+		if (!params.copy && opacity <= 0)
+			continue;
+
+		int const sy = static_cast<int>(std::floor((i+0.5) / params.zoom_y));
+		int const dx = params.x + (int) (2 * params.zoom_x * params.depth * WaverSine(params.phase, params.src_y + sy));
+
+		int const begin = std::max(mask_begin, left - dx);
+		int const end = std::min(mask_end, right - dx);
+		if (begin >= end)
+			continue;
+
+		int const row = ScaledPixel(unit_y, i);
+		const uint32_t* src_row = row < src.height ? reinterpret_cast<const uint32_t*>(src.pixels + row * src.pitch) : NULL;
+		uint32_t* dst_row = reinterpret_cast<uint32_t*>(dst.pixels + dy * dst.pitch);
+
+		if (params.copy) {
+			for (int k = begin; k < end; ++k) {
+				dst_row[dx + k] = src_row && columns[k] >= 0 ? src_row[columns[k]] : 0;
+			}
+		} else if (src_row) {
+			for (int k = begin; k < end; ++k) {
+				if (columns[k] < 0)
+					break;
+				uint32_t const pixel = src_row[columns[k]];
+				if (!pixel)
+					continue;
+				dst_row[dx + k] = OverUn8x4(opacity >= 255 ? pixel : MulUn8x4(pixel, opacity), dst_row[dx + k], params.alpha_shift);
+			}
+		}
+	}
+}
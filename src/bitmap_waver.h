@@ -0,0 +1,79 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_BITMAP_WAVER_H_
+#define _EASYRPG_BITMAP_WAVER_H_
+
+// Headers
+#include <stdint.h>
+#include "bitmap_kernels.h"
+
+/**
+ * BitmapWaver namespace.
+ * Zoomed waver blit on 32-bit pixels without pixman compositing. Gives the
+ * same pixels as the per-row pixman composite of Bitmap::WaverBlit: the
+ * zoom is sampled like pixman's nearest filter, parts of the source outside
+ * of the region read as transparent and a split opacity covers the area of
+ * the scaled 1x2 mask pixman uses.
+ */
+namespace BitmapWaver {
+	/**
+	 * Settings of one waver blit.
+	 */
+	struct Params {
+		/** Destination of the source rect, before the waver offset. */
+		int x;
+		int y;
+		double zoom_x;
+		double zoom_y;
+		/** Source rect. */
+		int src_x;
+		int src_y;
+		int src_width;
+		int src_height;
+		/** Waver amplitude and phase in degrees. */
+		int depth;
+		double phase;
+		/** Opacity of the upper rows, 255 is opaque. */
+		int opacity_top;
+		/** Opacity of the lower rows. */
+		int opacity_bottom;
+		/** Rows drawn with the bottom opacity, 0 when the opacity is not split. */
+		int split;
+		/** Copies the source instead of blending it, opacities are ignored. */
+		bool copy;
+		/** Position of the alpha channel in the pixels. */
+		int alpha_shift;
+	};
+
+	/**
+	 * Draws the zoomed source rect row by row, every row is shifted by its
+	 * waver offset.
+	 *
+	 * @param dst destination pixels.
+	 * @param clip_x left of the destination area that is drawn.
+	 * @param clip_y top of the area.
+	 * @param clip_width width of the area.
+	 * @param clip_height height of the area.
+	 * @param src source pixels with the same layout as dst.
+	 * @param params blit settings.
+	 */
+	void Blit(BitmapKernels::Region const& dst, int clip_x, int clip_y, int clip_width, int clip_height,
+		BitmapKernels::Region const& src, Params const& params);
+}
+
+#endif
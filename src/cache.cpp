@@ -20,11 +20,14 @@
 #  pragma warning(disable: 4003)
 #endif
 
+#include <list>
 #include <map>
+#include <tuple>
 
 #include <boost/preprocessor/seq/for_each.hpp>
 #include <boost/static_assert.hpp>
 
+#include "async_decoder.h"
 #include "async_handler.h"
 #include "cache.h"
 #include "filefinder.h"
@@ -36,23 +39,74 @@
 #include "data.h"
 
 namespace {
-	typedef std::pair<std::string,std::string> string_pair;
+	typedef std::tuple<std::string, std::string, bool> cache_key;
 	typedef std::pair<std::string, int> tile_pair;
 
-	typedef std::map<string_pair, EASYRPG_WEAK_PTR<Bitmap> > cache_type;
+	typedef std::map<cache_key, EASYRPG_WEAK_PTR<Bitmap> > cache_type;
 	cache_type cache;
 
+	// Strong references to recently used bitmaps, most recent first
+	struct RetainedBitmap {
+		cache_key key;
+		BitmapRef bitmap;
+		size_t bytes;
+	};
+	typedef std::list<RetainedBitmap> retained_list_type;
+	retained_list_type retained_list;
+	std::map<cache_key, retained_list_type::iterator> retained_map;
+
+	size_t retained_budget = 8 * 1024 * 1024;
+	Cache::Stats stats = Cache::Stats();
+
 	typedef std::map<tile_pair, EASYRPG_WEAK_PTR<Bitmap> > cache_tiles_type;
 	cache_tiles_type cache_tiles;
 
 	static std::string system_name;
 
+	void EvictRetained() {
+		while (stats.bytes > retained_budget && !retained_list.empty()) {
+			RetainedBitmap const& entry = retained_list.back();
+			stats.bytes -= entry.bytes;
+			retained_map.erase(entry.key);
+			retained_list.pop_back();
+			++stats.evictions;
+		}
+		stats.entries = retained_list.size();
+	}
+
+	void Retain(cache_key const& key, BitmapRef const& bitmap) {
+		std::map<cache_key, retained_list_type::iterator>::iterator const it = retained_map.find(key);
+
+		if (it != retained_map.end()) {
+			// Move to the front
+			retained_list.splice(retained_list.begin(), retained_list, it->second);
+			return;
+		}
+
+		if (retained_budget == 0) {
+			return;
+		}
+
+		RetainedBitmap entry;
+		entry.key = key;
+		entry.bitmap = bitmap;
+		entry.bytes = (size_t)bitmap->pitch() * bitmap->height();
+
+		retained_list.push_front(entry);
+		retained_map[key] = retained_list.begin();
+		stats.bytes += entry.bytes;
+
+		EvictRetained();
+	}
+
 	BitmapRef LoadBitmap(std::string const& folder_name, const std::string& filename,
 						 bool transparent, uint32_t const flags) {
-		string_pair const key(folder_name, filename);
+		cache_key const key(folder_name, filename, transparent);
 
 		cache_type::const_iterator const it = cache.find(key);
 
+		BitmapRef bitmap;
+
 		if (it == cache.end() || it->second.expired()) {
 			std::string const path = FileFinder::FindImage(folder_name, filename);
 
@@ -60,8 +114,27 @@ namespace {
 				return BitmapRef();
 			}
 
-			return (cache[key] = Bitmap::Create(path, transparent, flags)).lock();
-		} else { return it->second.lock(); }
+			++stats.misses;
+
+			// Use the pixels of the background decoder when available
+			int width, height;
+			void* pixels;
+			if (AsyncDecoder::Take(path, transparent, width, height, pixels)) {
+				bitmap = Bitmap::Create(width, height, pixels, transparent, flags);
+			} else {
+				bitmap = Bitmap::Create(path, transparent, flags);
+			}
+			cache[key] = bitmap;
+		} else {
+			++stats.hits;
+			bitmap = it->second.lock();
+		}
+
+		if (bitmap) {
+			Retain(key, bitmap);
+		}
+
+		return bitmap;
 	}
 
 	struct Material {
@@ -163,7 +236,7 @@ namespace {
 
 		Spec const& s = spec[T];
 
-		string_pair const key(folder_name, filename);
+		cache_key const key(folder_name, filename, s.transparent);
 
 		BitmapRef bitmap = s.dummy_renderer();
 
@@ -229,7 +302,7 @@ BitmapRef Cache::Picture(const std::string& f, bool trans) {
 }
 
 BitmapRef Cache::Exfont() {
-	string_pair const hash("ExFont","ExFont");
+	cache_key const hash("ExFont", "ExFont", true);
 
 	cache_type::const_iterator const it = cache.find(hash);
 
@@ -272,10 +345,15 @@ BitmapRef Cache::Tile(const std::string& filename, int tile_id) {
 }
 
 void Cache::Clear() {
+	retained_map.clear();
+	retained_list.clear();
+	stats.bytes = 0;
+	stats.entries = 0;
+
 	for(cache_type::const_iterator i = cache.begin(); i != cache.end(); ++i) {
 		if(i->second.expired()) { continue; }
 		Output::Debug("possible leak in cached bitmap %s/%s",
-					  i->first.first.c_str(), i->first.second.c_str());
+					  std::get<0>(i->first).c_str(), std::get<1>(i->first).c_str());
 	}
 	cache.clear();
 
@@ -287,6 +365,30 @@ void Cache::Clear() {
 	cache_tiles.clear();
 }
 
+bool Cache::GetDirectoryTransparency(const std::string& directory, bool& transparent) {
+	for (int i = 0; i < Material::END; ++i) {
+		if (directory == spec[i].directory) {
+			transparent = spec[i].transparent;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Cache::SetBudget(size_t bytes) {
+	retained_budget = bytes;
+	EvictRetained();
+}
+
+size_t Cache::GetBudget() {
+	return retained_budget;
+}
+
+Cache::Stats Cache::GetStats() {
+	return stats;
+}
+
 void Cache::SetSystemName(std::string const& filename) {
 	system_name = filename;
 }
@@ -52,6 +52,50 @@ namespace Cache {
 
 	void Clear();
 
+	/**
+	 * Looks up the default transparency of images in a directory.
+	 *
+	 * @param directory image directory name.
+	 * @param transparent transparency images are loaded with.
+	 * @return false when the directory doesn't hold cached images.
+	 */
+	bool GetDirectoryTransparency(const std::string& directory, bool& transparent);
+
+	/**
+	 * Counters of the bitmap cache.
+	 */
+	struct Stats {
+		/** Requests served from memory. */
+		unsigned hits;
+		/** Requests that had to decode the image. */
+		unsigned misses;
+		/** Bitmaps dropped from the retained set to stay in budget. */
+		unsigned evictions;
+		/** Pixel memory held by the retained set. */
+		size_t bytes;
+		/** Number of bitmaps in the retained set. */
+		size_t entries;
+	};
+
+	/**
+	 * Sets the memory budget for keeping recently used bitmaps alive after
+	 * their last user released them. The least recently used bitmaps are
+	 * released first when the budget is exceeded.
+	 *
+	 * @param bytes budget in bytes, 0 disables retaining.
+	 */
+	void SetBudget(size_t bytes);
+
+	/**
+	 * @return memory budget of the retained set in bytes.
+	 */
+	size_t GetBudget();
+
+	/**
+	 * @return cache counters.
+	 */
+	Stats GetStats();
+
 	BitmapRef System();
 	void SetSystemName(std::string const& filename);
 }
@@ -0,0 +1,65 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cassert>
+#include "change_journal.h"
+
+ChangeJournal::ChangeJournal() :
+	listener(NULL), generation(1) {
+}
+
+void ChangeJournal::Record(int id) {
+	assert(id >= 0);
+
+	if (id >= (int)stamps.size()) {
+		stamps.resize(id + 1, 0);
+	}
+	if (stamps[id] != generation) {
+		stamps[id] = generation;
+		changed.push_back(id);
+	}
+
+	if (listener) {
+		listener(id);
+	}
+}
+
+void ChangeJournal::SetListener(Listener listener) {
+	this->listener = listener;
+}
+
+const std::vector<int>& ChangeJournal::GetChanged() const {
+	return changed;
+}
+
+bool ChangeJournal::IsChanged(int id) const {
+	return id >= 0 && id < (int)stamps.size() && stamps[id] == generation;
+}
+
+void ChangeJournal::Clear() {
+	if (changed.empty())
+		return;
+
+	changed.clear();
+	if (++generation == 0) {
+		// Wrapped around, old stamps could match again
+		std::fill(stamps.begin(), stamps.end(), 0);
+		generation = 1;
+	}
+}
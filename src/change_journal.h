@@ -0,0 +1,78 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_CHANGE_JOURNAL_H_
+#define _EASYRPG_CHANGE_JOURNAL_H_
+
+// Headers
+#include <vector>
+#include <stdint.h>
+
+/**
+ * ChangeJournal class.
+ * Records which IDs of a value store (switches, variables) were written
+ * in the current frame, so the debug windows or a savegame diff only look
+ * at the changed entries instead of comparing thousands of them.
+ * A listener is told about every write right away, e.g. to refresh the
+ * events depending on the value.
+ */
+class ChangeJournal {
+public:
+	typedef void (*Listener)(int id);
+
+	ChangeJournal();
+
+	/**
+	 * Records a changed ID and tells the listener.
+	 *
+	 * @param id ID, must not be negative.
+	 */
+	void Record(int id);
+
+	/**
+	 * Sets the function told about every change.
+	 *
+	 * @param listener listener, NULL for none.
+	 */
+	void SetListener(Listener listener);
+
+	/**
+	 * @return IDs changed since the last Clear, in the order of their
+	 *         first change.
+	 */
+	const std::vector<int>& GetChanged() const;
+
+	/**
+	 * @param id ID.
+	 * @return whether the ID changed since the last Clear.
+	 */
+	bool IsChanged(int id) const;
+
+	/**
+	 * Forgets the changes, called when a new frame starts.
+	 */
+	void Clear();
+
+private:
+	Listener listener;
+	std::vector<int> changed;
+	/** Generation of the last change of every ID. */
+	std::vector<uint32_t> stamps;
+	uint32_t generation;
+};
+
+#endif
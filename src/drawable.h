@@ -18,6 +18,10 @@
 #ifndef _DRAWABLE_H_
 #define _DRAWABLE_H_
 
+#include <stddef.h>
+
+class DrawableList;
+
 // What kind of drawable is the current one?
 enum DrawableType {
 	TypeWindow,
@@ -36,8 +40,13 @@ enum DrawableType {
  */
 class Drawable {
 public:
+	Drawable() {}
 	virtual ~Drawable() {};
 
+	/** A copy is not registered in the list of the original. */
+	Drawable(Drawable const&) {}
+	Drawable& operator=(Drawable const&) { return *this; }
+
 	virtual void Draw() = 0;
 
 	virtual int GetZ() const = 0;
@@ -45,6 +54,24 @@ public:
 	virtual DrawableType GetType() const = 0;
 
 	virtual bool IsGlobal() const { return false; }
+
+	/**
+	 * Reports the screen areas that changed since the last frame through
+	 * Graphics::InvalidateRect. Only called when dirty rectangle tracking
+	 * is enabled.
+	 *
+	 * @return false when the drawable can't track its changes, the whole
+	 *         screen is redrawn then.
+	 */
+	virtual bool ReportDamage() { return false; }
+
+private:
+	friend class DrawableList;
+
+	/** List the drawable is registered in, see Graphics::RegisterDrawable. */
+	DrawableList* drawable_list = NULL;
+	/** Slot in the list. */
+	size_t drawable_index = 0;
 };
 
 #endif
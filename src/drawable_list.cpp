@@ -0,0 +1,159 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "drawable_list.h"
+
+DrawableList::iterator::iterator(const DrawableList* list, size_t index) :
+	list(list), index(index) {
+	Skip();
+}
+
+DrawableList::DrawableList() :
+	removed(0), next_serial(0), dirty(false) {
+}
+
+DrawableList::~DrawableList() {
+	Clear();
+}
+
+bool DrawableList::Less(Entry const& a, Entry const& b) {
+	return a.z < b.z || (a.z == b.z && a.serial < b.serial);
+}
+
+void DrawableList::Add(Drawable* drawable) {
+	Remove(drawable);
+
+	drawable->drawable_list = this;
+	drawable->drawable_index = entries.size();
+
+	// The z is read by the next Sort, the drawable may still change it
+	Entry const entry = { drawable, 0, next_serial++ };
+	entries.push_back(entry);
+	dirty = true;
+}
+
+void DrawableList::Remove(Drawable* drawable) {
+	DrawableList* list = drawable->drawable_list;
+	if (!list)
+		return;
+
+	list->entries[drawable->drawable_index].drawable = NULL;
+	++list->removed;
+	drawable->drawable_list = NULL;
+}
+
+void DrawableList::MarkDirty(Drawable* drawable) {
+	if (drawable->drawable_list) {
+		drawable->drawable_list->dirty = true;
+	}
+}
+
+void DrawableList::Sort() {
+	if (removed > 0) {
+		Compact();
+	}
+
+	if (!dirty)
+		return;
+	dirty = false;
+
+	for (std::vector<Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+		it->z = it->drawable->GetZ();
+	}
+
+	// Insertion sort, give up on it when the order changed a lot (e.g. a
+	// new scene added its drawables in arbitrary z order)
+	size_t const max_moves = entries.size() * 4 + 16;
+	size_t moves = 0;
+	size_t first_moved = entries.size();
+
+	for (size_t i = 1; i < entries.size(); ++i) {
+		if (!Less(entries[i], entries[i - 1]))
+			continue;
+
+		Entry const entry = entries[i];
+		size_t j = i;
+		do {
+			entries[j] = entries[j - 1];
+			--j;
+		} while (j > 0 && Less(entry, entries[j - 1]));
+		entries[j] = entry;
+
+		first_moved = std::min(first_moved, j);
+		moves += i - j;
+		if (moves > max_moves) {
+			std::sort(entries.begin(), entries.end(), Less);
+			first_moved = 0;
+			break;
+		}
+	}
+
+	UpdateSlots(first_moved);
+}
+
+void DrawableList::Clear() {
+	for (std::vector<Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+		if (it->drawable) {
+			it->drawable->drawable_list = NULL;
+		}
+	}
+	entries.clear();
+	removed = 0;
+	dirty = false;
+}
+
+size_t DrawableList::size() const {
+	return entries.size() - removed;
+}
+
+bool DrawableList::IsDirty() const {
+	return dirty || removed > 0;
+}
+
+DrawableList::iterator DrawableList::begin() const {
+	return iterator(this, 0);
+}
+
+DrawableList::iterator DrawableList::end() const {
+	return iterator(this, entries.size());
+}
+
+void DrawableList::Compact() {
+	std::vector<Entry>::iterator out = entries.begin();
+	while (out != entries.end() && out->drawable) {
+		++out;
+	}
+	size_t const first = out - entries.begin();
+
+	for (std::vector<Entry>::iterator it = out; it != entries.end(); ++it) {
+		if (it->drawable) {
+			*out++ = *it;
+		}
+	}
+	entries.erase(out, entries.end());
+	removed = 0;
+
+	UpdateSlots(first);
+}
+
+void DrawableList::UpdateSlots(size_t first) {
+	for (size_t i = first; i < entries.size(); ++i) {
+		entries[i].drawable->drawable_index = i;
+	}
+}
@@ -0,0 +1,149 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_DRAWABLE_LIST_H_
+#define _EASYRPG_DRAWABLE_LIST_H_
+
+// Headers
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "drawable.h"
+
+/**
+ * DrawableList class.
+ * Drawables ordered by z, drawables with the same z in the order they were
+ * added. The drawables are kept in an array and every drawable knows its
+ * slot, so removing one only clears the slot, the gaps are closed by the
+ * next Sort.
+ * Sort only does work after a z change was reported through MarkDirty.
+ * As the list is nearly sorted then (a few characters walked a row up or
+ * down) it uses an insertion sort, which only moves the drawables whose z
+ * changed past their new neighbours.
+ */
+class DrawableList {
+public:
+	/** Iterates the drawables, skipping removed ones. */
+	class iterator {
+	public:
+		iterator(const DrawableList* list, size_t index);
+
+		Drawable* operator*() const;
+		iterator& operator++();
+		bool operator!=(iterator const& other) const;
+
+	private:
+		void Skip();
+
+		const DrawableList* list;
+		size_t index;
+	};
+
+	DrawableList();
+	~DrawableList();
+
+	/**
+	 * Adds a drawable after the drawables with the same z, it is removed
+	 * from its old list first.
+	 *
+	 * @param drawable drawable.
+	 */
+	void Add(Drawable* drawable);
+
+	/**
+	 * Removes a drawable from the list it was added to.
+	 *
+	 * @param drawable drawable, nothing happens when it is in no list.
+	 */
+	static void Remove(Drawable* drawable);
+
+	/**
+	 * Reports that the z of a drawable changed.
+	 *
+	 * @param drawable drawable, nothing happens when it is in no list.
+	 */
+	static void MarkDirty(Drawable* drawable);
+
+	/**
+	 * Closes the gaps of removed drawables and restores the z order after
+	 * z changes.
+	 */
+	void Sort();
+
+	/**
+	 * Removes all drawables.
+	 */
+	void Clear();
+
+	/**
+	 * @return number of drawables.
+	 */
+	size_t size() const;
+
+	/**
+	 * @return whether Sort has work to do.
+	 */
+	bool IsDirty() const;
+
+	iterator begin() const;
+	iterator end() const;
+
+private:
+	DrawableList(DrawableList const&);
+	DrawableList& operator=(DrawableList const&);
+
+	struct Entry {
+		/** NULL when removed. */
+		Drawable* drawable;
+		/** z when the list was sorted the last time. */
+		int z;
+		/** Position in the order the drawables were added. */
+		uint32_t serial;
+	};
+
+	static bool Less(Entry const& a, Entry const& b);
+
+	void Compact();
+	void UpdateSlots(size_t first);
+
+	std::vector<Entry> entries;
+	size_t removed;
+	uint32_t next_serial;
+	bool dirty;
+};
+
+inline Drawable* DrawableList::iterator::operator*() const {
+	return list->entries[index].drawable;
+}
+
+inline DrawableList::iterator& DrawableList::iterator::operator++() {
+	++index;
+	Skip();
+	return *this;
+}
+
+inline bool DrawableList::iterator::operator!=(iterator const& other) const {
+	return index != other.index;
+}
+
+inline void DrawableList::iterator::Skip() {
+	while (index < list->entries.size() && !list->entries[index].drawable) {
+		++index;
+	}
+}
+
+#endif
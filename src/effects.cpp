@@ -16,8 +16,185 @@
  */
 
 // Headers
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <vector>
 #include "bitmap.h"
+#include "bitmap_waver.h"
+
+namespace {
+	Bitmap::EffectsStats stats = {};
+
+	using BitmapKernels::MulUn8x4;
+	using BitmapKernels::AddUn8x4;
+	using BitmapKernels::OverUn8x4;
+
+	struct CopyRow {
+		void operator()(uint32_t* dst, const uint32_t* src, int width) const {
+			memcpy(dst, src, width * 4);
+		}
+	};
+
+	struct OverRow {
+		int alpha_shift;
+
+		void operator()(uint32_t* dst, const uint32_t* src, int width) const {
+			for (int i = 0; i < width; ++i) {
+				if (src[i])
+					dst[i] = OverUn8x4(src[i], dst[i], alpha_shift);
+			}
+		}
+	};
+
+	struct OpacityRow {
+		int alpha_shift;
+		uint32_t opacity;
+
+		void operator()(uint32_t* dst, const uint32_t* src, int width) const {
+			for (int i = 0; i < width; ++i) {
+				if (src[i])
+					dst[i] = OverUn8x4(MulUn8x4(src[i], opacity), dst[i], alpha_shift);
+			}
+		}
+	};
+
+	template <typename Row>
+	void BlitRows(Row const& row, uint8_t* dst, int dst_pitch, const uint8_t* src, int src_pitch, int width, int height) {
+		for (int y = 0; y < height; ++y) {
+			row(reinterpret_cast<uint32_t*>(dst), reinterpret_cast<const uint32_t*>(src), width);
+			dst += dst_pitch;
+			src += src_pitch;
+		}
+	}
+
+	void BlendRows(int opacity, int alpha_shift, uint8_t* dst, int dst_pitch, const uint8_t* src, int src_pitch, int width, int height) {
+		if (opacity <= 0 || height <= 0)
+			return;
+
+		if (opacity >= 255) {
+			OverRow const row = { alpha_shift };
+			BlitRows(row, dst, dst_pitch, src, src_pitch, width, height);
+		} else {
+			OpacityRow const row = { alpha_shift, (uint32_t)opacity };
+			BlitRows(row, dst, dst_pitch, src, src_pitch, width, height);
+		}
+	}
+}
+
+bool Bitmap::CanBlitDirect(Bitmap const& src, Opacity const& opacity, bool& copy) const {
+	if (&src == this || src.pixman_format != pixman_format || format.bytes != 4)
+		return false;
+
+	// Pixman only uses the low byte of the opacity
+	if (opacity.top < 0 || opacity.top > 255 || opacity.bottom < 0 || opacity.bottom > 255)
+		return false;
+
+	copy = opacity.IsOpaque() && (!src.GetTransparent() || src.GetOpacity() == Opaque);
+	return copy || (format.alpha_type != PF::NoAlpha && format.a.bits == 8);
+}
+
+bool Bitmap::DirectBlit(int x, int y, Bitmap const& src, Rect const& src_rect, Opacity const& opacity) {
+	bool copy;
+	if (!CanBlitDirect(src, opacity, copy))
+		return false;
+
+	// Pixman reads parts of the source outside of the bitmap as transparent
+	if (src_rect.x < 0 || src_rect.y < 0 ||
+		src_rect.x + src_rect.width > src.width() || src_rect.y + src_rect.height > src.height())
+		return false;
+
+	bool const split = opacity.IsSplit();
+	// Rows of the source rect drawn with the bottom opacity
+	int const split_row = split ? src_rect.height - opacity.split : src_rect.height;
+
+	Rect const bounds = GetRect();
+	size_t const areas = clip_rects.empty() ? 1 : clip_rects.size();
+
+	for (size_t i = 0; i < areas; ++i) {
+		Rect dst_rect(x, y, src_rect.width, src_rect.height);
+		dst_rect.Adjust(bounds);
+		if (!clip_rects.empty())
+			dst_rect.Adjust(clip_rects[i]);
+		if (dst_rect.IsEmpty())
+			continue;
+
+		int const sx = src_rect.x + dst_rect.x - x;
+		int const sy = src_rect.y + dst_rect.y - y;
+		uint8_t* dst_pixels = pointer(dst_rect.x, dst_rect.y);
+		const uint8_t* src_pixels = src.pointer(sx, sy);
+
+		if (copy) {
+			BlitRows(CopyRow(), dst_pixels, pitch(), src_pixels, src.pitch(), dst_rect.width, dst_rect.height);
+			continue;
+		}
+
+		int const top_rows = std::max(0, std::min(dst_rect.height, split_row - (dst_rect.y - y)));
+		BlendRows(opacity.top, format.a.shift, dst_pixels, pitch(), src_pixels, src.pitch(),
+			dst_rect.width, top_rows);
+		BlendRows(opacity.bottom, format.a.shift, dst_pixels + top_rows * pitch(), pitch(),
+			src_pixels + top_rows * src.pitch(), src.pitch(), dst_rect.width, dst_rect.height - top_rows);
+	}
+
+	if (copy)
+		++stats.copy;
+	else if (split)
+		++stats.split;
+	else
+		++stats.constant;
+
+	RefreshCallback();
+	return true;
+}
+
+bool Bitmap::DirectWaverBlit(int x, int y, double zoom_x, double zoom_y, Bitmap const& src, Rect const& src_rect, int depth, double phase, Opacity const& opacity) {
+	bool copy;
+	if (!CanBlitDirect(src, opacity, copy))
+		return false;
+
+	BitmapWaver::Params params;
+	params.x = x;
+	params.y = y;
+	params.zoom_x = zoom_x;
+	params.zoom_y = zoom_y;
+	params.src_x = src_rect.x;
+	params.src_y = src_rect.y;
+	params.src_width = src_rect.width;
+	params.src_height = src_rect.height;
+	params.depth = depth;
+	params.phase = phase;
+	params.opacity_top = opacity.top;
+	params.opacity_bottom = opacity.bottom;
+	// Pixman only gets a split mask when the blit is not opaque
+	params.split = opacity.IsSplit() && !opacity.IsOpaque() ? opacity.split : 0;
+	params.copy = copy;
+	params.alpha_shift = format.a.shift;
+
+	BitmapKernels::Region const dst_region = GetKernelRegion(GetRect());
+	BitmapKernels::Region const src_region = {
+		const_cast<uint8_t*>(src.pointer(0, 0)), src.pitch(), src.width(), src.height()
+	};
+
+	if (clip_rects.empty()) {
+		BitmapWaver::Blit(dst_region, 0, 0, width(), height(), src_region, params);
+	} else {
+		for (size_t i = 0; i < clip_rects.size(); ++i) {
+			Rect const& clip = clip_rects[i];
+			BitmapWaver::Blit(dst_region, clip.x, clip.y, clip.width, clip.height, src_region, params);
+		}
+	}
+
+	RefreshCallback();
+	return true;
+}
+
+Bitmap::EffectsStats Bitmap::GetEffectsStats() {
+	return stats;
+}
+
+void Bitmap::ResetEffectsStats() {
+	stats = EffectsStats();
+}
 
 // Rotate, Zoom, Opacity
 void Bitmap::EffectsBlit(const Matrix &fwd, Bitmap const& src, Rect const& src_rect, Opacity const& opacity) {
@@ -65,7 +242,13 @@ void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
 void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
 						   Bitmap const& src, Rect const& src_rect,
 						   Opacity const& opacity) {
-	Blit(x - ox, y - oy, src, src_rect, opacity);
+	if (opacity.IsTransparent())
+		return;
+
+	if (!DirectBlit(x - ox, y - oy, src, src_rect, opacity)) {
+		++stats.fallback;
+		Blit(x - ox, y - oy, src, src_rect, opacity);
+	}
 }
 
 void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
@@ -78,16 +261,19 @@ void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
 	bool waver = waver_depth != 0;
 
 	if (waver) {
+		++stats.waver;
 		EffectsBlit(x, y, ox, oy, src, src_rect,
 					opacity,
 					zoom_x, zoom_y,
 					waver_depth, waver_phase);
 	}
 	else if (rotate) {
+		++stats.rotate;
 		Matrix fwd = Matrix::Setup(-angle, zoom_x, zoom_y, ox, oy, x, y);
 		EffectsBlit(fwd, src, src_rect, opacity);
 	}
 	else if (scale) {
+		++stats.zoom;
 		EffectsBlit(x, y, ox, oy, src, src_rect, zoom_x, zoom_y, opacity);
 	}
 	else {
@@ -0,0 +1,81 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cassert>
+#include "event_dependencies.h"
+
+EventDependencies::EventDependencies() {
+}
+
+void EventDependencies::Reset(int count) {
+	for (int kind = 0; kind < KindCount; ++kind) {
+		users[kind].clear();
+	}
+	marked.assign(count, false);
+	dirty.clear();
+}
+
+void EventDependencies::Add(int item, Kind kind, int id) {
+	assert(item >= 0 && item < (int)marked.size());
+
+	if (id < 0)
+		return;
+
+	std::vector<std::vector<int> >& ids = users[kind];
+	if (id >= (int)ids.size()) {
+		ids.resize(id + 1);
+	}
+
+	// The pages of an event are added together, so duplicates are adjacent
+	std::vector<int>& items = ids[id];
+	if (items.empty() || items.back() != item) {
+		items.push_back(item);
+	}
+}
+
+void EventDependencies::Mark(Kind kind, int id) {
+	std::vector<std::vector<int> > const& ids = users[kind];
+	if (id < 0 || id >= (int)ids.size())
+		return;
+
+	std::vector<int> const& items = ids[id];
+	for (std::vector<int>::const_iterator it = items.begin(); it != items.end(); ++it) {
+		if (!marked[*it]) {
+			marked[*it] = true;
+			dirty.push_back(*it);
+		}
+	}
+}
+
+bool EventDependencies::IsDirty() const {
+	return !dirty.empty();
+}
+
+void EventDependencies::TakeDirty(std::vector<int>& items) {
+	std::sort(dirty.begin(), dirty.end());
+	for (std::vector<int>::const_iterator it = dirty.begin(); it != dirty.end(); ++it) {
+		marked[*it] = false;
+		items.push_back(*it);
+	}
+	dirty.clear();
+}
+
+size_t EventDependencies::size() const {
+	return marked.size();
+}
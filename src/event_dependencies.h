@@ -0,0 +1,94 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_EVENT_DEPENDENCIES_H_
+#define _EASYRPG_EVENT_DEPENDENCIES_H_
+
+// Headers
+#include <vector>
+#include <stddef.h>
+
+/**
+ * EventDependencies class.
+ * Reverse index from the values event page conditions test (switches,
+ * variables, items, actors and timers) to the events testing them.
+ * Marking a changed value collects the events which have to choose their
+ * page again, instead of refreshing every event of the map.
+ */
+class EventDependencies {
+public:
+	enum Kind {
+		Switch,
+		Variable,
+		Item,
+		Actor,
+		/** The timer index is the id. */
+		Timer,
+		KindCount
+	};
+
+	EventDependencies();
+
+	/**
+	 * Removes all dependencies and marks.
+	 *
+	 * @param count number of events.
+	 */
+	void Reset(int count);
+
+	/**
+	 * Adds a value an event depends on.
+	 *
+	 * @param item event, 0 to count - 1.
+	 * @param kind kind of the value.
+	 * @param id ID of the value, negative IDs are ignored.
+	 */
+	void Add(int item, Kind kind, int id);
+
+	/**
+	 * Marks the events depending on a value.
+	 *
+	 * @param kind kind of the value.
+	 * @param id ID of the value.
+	 */
+	void Mark(Kind kind, int id);
+
+	/**
+	 * @return whether events are marked.
+	 */
+	bool IsDirty() const;
+
+	/**
+	 * Removes the marks.
+	 *
+	 * @param items the marked events are appended in ascending order.
+	 */
+	void TakeDirty(std::vector<int>& items);
+
+	/**
+	 * @return number of events.
+	 */
+	size_t size() const;
+
+private:
+	/** Events of every ID of every kind. */
+	std::vector<std::vector<int> > users[KindCount];
+	std::vector<bool> marked;
+	std::vector<int> dirty;
+};
+
+#endif
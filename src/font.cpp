@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -69,6 +70,20 @@ namespace {
 		return mincho == NULL? find_gothic_glyph(code) : mincho;
 	}
 
+	// Glyph atlas dimensions, it starts small and doubles its height.
+	// A full atlas is flushed and filled again.
+	const int atlas_width = 256;
+	const int atlas_min_height = 64;
+	const int atlas_max_height = 512;
+
+	// Color variants kept per font, the least recently used one is dropped
+	const size_t max_color_variants = 6;
+
+	// Variant key of the drop shadow, which uses the solid shadow color
+	const int shadow_variant = -2;
+
+	DynamicFormat const alpha_format(8,8,0,8,0,8,0,8,0,PF::Alpha);
+
 	struct ShinonomeFont : public Font {
 		enum { HEIGHT = 12, FULL_WIDTH = HEIGHT, HALF_WIDTH = FULL_WIDTH / 2 };
 
@@ -145,7 +160,7 @@ BitmapRef ShinonomeFont::Glyph(unsigned code) {
 	assert(glyph);
 	size_t const width = glyph->is_full? FULL_WIDTH : HALF_WIDTH;
 
-	BitmapRef bm = Bitmap::Create(reinterpret_cast<void*>(NULL), width, HEIGHT, 0, DynamicFormat(8,8,0,8,0,8,0,8,0,PF::Alpha));
+	BitmapRef bm = Bitmap::Create(reinterpret_cast<void*>(NULL), width, HEIGHT, 0, alpha_format);
 	uint8_t* data = reinterpret_cast<uint8_t*>(bm->pixels());
 	int pitch = bm->pitch();
 	for(size_t y_ = 0; y_ < HEIGHT; ++y_)
@@ -194,7 +209,7 @@ BitmapRef FTFont::Glyph(unsigned glyph) {
 	int const width = ft_bitmap.width;
 	int const height = ft_bitmap.rows;
 
-	BitmapRef bm = Bitmap::Create(reinterpret_cast<void*>(NULL), width, height, 0, DynamicFormat(8,8,0,8,0,8,0,8,0,PF::Alpha));
+	BitmapRef bm = Bitmap::Create(reinterpret_cast<void*>(NULL), width, height, 0, alpha_format);
 	uint8_t* data = reinterpret_cast<uint8_t*>(bm->pixels());
 	int dst_pitch = bm->pitch();
 
@@ -223,6 +238,10 @@ void Font::Dispose() {
 		Output::Debug("possible leak in cached font face %s", i->first.c_str());
 	}
 	face_cache.clear();
+
+	gothic->ClearAtlas();
+	mincho->ClearAtlas();
+	exfont->ClearAtlas();
 }
 
 // Constructor.
@@ -231,9 +250,137 @@ Font::Font(const std::string& name, int size, bool bold, bool italic)
 	, size(size)
 	, bold(bold)
 	, italic(italic)
+	, atlas_x(0)
+	, atlas_y(0)
+	, atlas_row_height(0)
+	, variant_counter(0)
+	, atlas_size(0)
+	, atlas_bold(false)
+	, atlas_italic(false)
 {
 }
 
+void Font::ClearAtlas() {
+	atlas.reset();
+	glyph_index.clear();
+	glyph_rects.clear();
+	color_variants.clear();
+	atlas_x = 0;
+	atlas_y = 0;
+	atlas_row_height = 0;
+}
+
+int Font::GetGlyphIndex(unsigned code) {
+	if (atlas_name != name || atlas_size != size || atlas_bold != bold || atlas_italic != italic) {
+		ClearAtlas();
+		atlas_name = name;
+		atlas_size = size;
+		atlas_bold = bold;
+		atlas_italic = italic;
+	}
+
+	std::map<unsigned, int>::const_iterator it = glyph_index.find(code);
+	if (it != glyph_index.end()) {
+		return it->second;
+	}
+
+	BitmapRef glyph = Glyph(code);
+	int const width = std::min(glyph->width(), atlas_width);
+	int const height = std::min(glyph->height(), atlas_max_height);
+
+	if (atlas_x + width > atlas_width) {
+		atlas_x = 0;
+		atlas_y += atlas_row_height;
+		atlas_row_height = 0;
+	}
+
+	if (atlas_y + height > atlas_max_height) {
+		ClearAtlas();
+	}
+
+	int const needed_height = atlas_y + height;
+	if (!atlas || needed_height > atlas->height()) {
+		int atlas_height = atlas ? atlas->height() : atlas_min_height;
+		while (atlas_height < needed_height) {
+			atlas_height *= 2;
+		}
+
+		BitmapRef grown = Bitmap::Create(reinterpret_cast<void*>(NULL), atlas_width, atlas_height, 0, alpha_format);
+		if (atlas) {
+			grown->BlitFast(0, 0, *atlas, atlas->GetRect(), Opacity::opaque);
+		}
+		atlas = grown;
+
+		// Variants are masked again on demand with the new layout
+		color_variants.clear();
+	}
+
+	Rect const rect(atlas_x, atlas_y, width, height);
+	atlas->BlitFast(rect.x, rect.y, *glyph, Rect(0, 0, width, height), Opacity::opaque);
+
+	atlas_x += width;
+	atlas_row_height = std::max(atlas_row_height, height);
+
+	int const index = glyph_rects.size();
+	glyph_rects.push_back(rect);
+	glyph_index[code] = index;
+
+	return index;
+}
+
+Bitmap& Font::GetColorVariant(BitmapRef const& system, int color, int glyph) {
+	std::map<int, ColorVariant>::iterator it = color_variants.find(color);
+
+	if (it == color_variants.end()) {
+		if (color_variants.size() >= max_color_variants) {
+			std::map<int, ColorVariant>::iterator oldest = color_variants.begin();
+			for (std::map<int, ColorVariant>::iterator v = color_variants.begin(); v != color_variants.end(); ++v) {
+				if (v->second.last_used < oldest->second.last_used) {
+					oldest = v;
+				}
+			}
+			color_variants.erase(oldest);
+		}
+
+		it = color_variants.insert(std::make_pair(color, ColorVariant())).first;
+		it->second.bitmap = Bitmap::Create(atlas->width(), atlas->height(), true);
+	}
+
+	ColorVariant& variant = it->second;
+	variant.last_used = ++variant_counter;
+
+	// The system graphic changed, mask everything again
+	if (variant.system != system || variant.system_revision != system->GetRevision()) {
+		if (variant.system) {
+			variant.bitmap->Clear();
+		}
+		variant.system = system;
+		variant.system_revision = system->GetRevision();
+		variant.masked.clear();
+	}
+
+	if (variant.masked.size() < glyph_rects.size()) {
+		variant.masked.resize(glyph_rects.size(), false);
+	}
+
+	if (!variant.masked[glyph]) {
+		Rect const& rect = glyph_rects[glyph];
+
+		if (color == shadow_variant) {
+			variant.bitmap->MaskedBlit(rect, *atlas, rect.x, rect.y, system->GetShadowColor());
+		} else {
+			unsigned const
+				src_x = color == ColorShadow? 16 : color % 10 * 16 + 2,
+				src_y = color == ColorShadow? 32 : color / 10 * 16 + 48 + 16 - rect.height;
+
+			variant.bitmap->MaskedBlit(rect, *atlas, rect.x, rect.y, *system, src_x, src_y);
+		}
+		variant.masked[glyph] = true;
+	}
+
+	return *variant.bitmap;
+}
+
 bool FTFont::check_face() {
 	if(!library_) {
 		if(library_checker_.expired()) {
@@ -300,24 +447,36 @@ bool FTFont::check_face() {
 }
 
 void Font::Render(Bitmap& bmp, int const x, int const y, Bitmap const& sys, int color, unsigned code) {
-	if(color != ColorShadow) {
-		BitmapRef system = Cache::System();
-		Render(bmp, x + 1, y + 1, system->GetShadowColor(), code);
-	}
+	BitmapRef system = Cache::System();
+	int const glyph = GetGlyphIndex(code);
+	Rect const rect = glyph_rects[glyph];
+
+	if (&sys != system.get()) {
+		// Not the cached system graphic, mask the glyph directly
+		if (color != ColorShadow) {
+			bmp.MaskedBlit(Rect(x + 1, y + 1, rect.width, rect.height), *atlas, rect.x, rect.y, system->GetShadowColor());
+		}
 
-	BitmapRef bm = Glyph(code);
+		unsigned const
+			src_x = color == ColorShadow? 16 : color % 10 * 16 + 2,
+			src_y = color == ColorShadow? 32 : color / 10 * 16 + 48 + 16 - rect.height;
 
-	unsigned const
-		src_x = color == ColorShadow? 16 : color % 10 * 16 + 2,
-		src_y = color == ColorShadow? 32 : color / 10 * 16 + 48 + 16 - bm->height();
+		bmp.MaskedBlit(Rect(x, y, rect.width, rect.height), *atlas, rect.x, rect.y, sys, src_x, src_y);
+		return;
+	}
+
+	if (color != ColorShadow) {
+		bmp.Blit(x + 1, y + 1, GetColorVariant(system, shadow_variant, glyph), rect, Opacity::opaque);
+	}
 
-	bmp.MaskedBlit(Rect(x, y, bm->width(), bm->height()), *bm, 0, 0, sys, src_x, src_y);
+	bmp.Blit(x, y, GetColorVariant(system, color, glyph), rect, Opacity::opaque);
 }
 
 void Font::Render(Bitmap& bmp, int x, int y, Color const& color, unsigned code) {
-	BitmapRef bm = Glyph(code);
+	int const glyph = GetGlyphIndex(code);
+	Rect const& rect = glyph_rects[glyph];
 
-	bmp.MaskedBlit(Rect(x, y, bm->width(), bm->height()), *bm, 0, 0, color);
+	bmp.MaskedBlit(Rect(x, y, rect.width, rect.height), *atlas, rect.x, rect.y, color);
 }
 
 ExFont::ExFont() : Font("exfont", 12, false, false) {
@@ -20,10 +20,12 @@
 
 // Headers
 #include "system.h"
+#include "rect.h"
+#include <map>
 #include <string>
+#include <vector>
 
 class Color;
-class Rect;
 
 /**
  * Font class.
@@ -65,6 +67,59 @@ class Font {
 	size_t pixel_size() const { return size * 96 / 72; }
  protected:
 	Font(const std::string& name, int size, bool bold, bool italic);
+
+ private:
+	/**
+	 * Glyphs rendered in one system graphic color, laid out like the atlas.
+	 * Glyphs are masked on first use.
+	 */
+	struct ColorVariant {
+		BitmapRef bitmap;
+		BitmapRef system;
+		unsigned system_revision;
+		std::vector<bool> masked;
+		unsigned last_used;
+	};
+
+	/**
+	 * Returns the atlas index of a glyph, rendering it into the atlas
+	 * when it is not cached yet.
+	 *
+	 * @param code codepoint.
+	 * @return glyph index into glyph_rects.
+	 */
+	int GetGlyphIndex(unsigned code);
+
+	/**
+	 * Returns the variant of a system graphic color with the glyph masked.
+	 *
+	 * @param system system graphic.
+	 * @param color color index, ColorShadow or the drop shadow key.
+	 * @param glyph glyph index.
+	 * @return variant bitmap.
+	 */
+	Bitmap& GetColorVariant(BitmapRef const& system, int color, int glyph);
+
+	/**
+	 * Drops all cached glyphs and color variants.
+	 */
+	void ClearAtlas();
+
+	/** 8-bit alpha atlas of all rendered glyphs. */
+	BitmapRef atlas;
+	std::map<unsigned, int> glyph_index;
+	std::vector<Rect> glyph_rects;
+	std::map<int, ColorVariant> color_variants;
+	int atlas_x;
+	int atlas_y;
+	int atlas_row_height;
+	unsigned variant_counter;
+
+	/** Attributes the atlas was rendered with. */
+	std::string atlas_name;
+	unsigned atlas_size;
+	bool atlas_bold;
+	bool atlas_italic;
 };
 
 #endif
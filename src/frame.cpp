@@ -25,7 +25,9 @@
 #include "main_data.h"
 #include "frame.h"
 
-Frame::Frame() {
+Frame::Frame() :
+	damaged(false),
+	damage_shown(false) {
 	if (!Data::system.frame_name.empty()) {
 		FileRequestAsync* request = AsyncHandler::RequestFile("Frame", Data::system.frame_name);
 		request_id = request->Bind(&Frame::OnFrameGraphicReady, this);
@@ -36,6 +38,9 @@ Frame::Frame() {
 }
 
 Frame::~Frame() {
+	if (damage_shown) {
+		Graphics::InvalidateAll();
+	}
 	Graphics::RemoveDrawable(this);
 }
 
@@ -50,6 +55,19 @@ DrawableType Frame::GetType() const {
 void Frame::Update() {
 }
 
+bool Frame::ReportDamage() {
+	bool shown = frame_bitmap && Data::system.show_frame;
+
+	if (damaged || shown != damage_shown) {
+		Graphics::InvalidateAll();
+	}
+
+	damaged = false;
+	damage_shown = shown;
+
+	return true;
+}
+
 void Frame::Draw() {
 	if (frame_bitmap && Data::system.show_frame) {
 		BitmapRef dst = DisplayUi->GetDisplaySurface();
@@ -59,4 +77,5 @@ void Frame::Draw() {
 
 void Frame::OnFrameGraphicReady(FileRequestResult* result) {
 	frame_bitmap = Cache::Frame(result->file);
+	damaged = true;
 }
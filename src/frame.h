@@ -34,6 +34,8 @@ public:
 	void Draw();
 	void Update();
 
+	bool ReportDamage();
+
 	int GetZ() const;
 	DrawableType GetType() const;
 
@@ -47,6 +49,9 @@ private:
 	BitmapRef frame_bitmap;
 
 	FileRequestBinding request_id;
+
+	bool damaged;
+	bool damage_shown;
 };
 
 #endif
@@ -0,0 +1,139 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include "frame_stats.h"
+
+namespace {
+	void WriteString(std::ostream& os, std::string const& str) {
+		os << '"';
+		for (size_t i = 0; i < str.size(); ++i) {
+			unsigned char const c = str[i];
+			if (c == '"' || c == '\\') {
+				os << '\\' << c;
+			} else if (c < 0x20) {
+				char escaped[8];
+				sprintf(escaped, "\\u%04x", c);
+				os << escaped;
+			} else {
+				os << c;
+			}
+		}
+		os << '"';
+	}
+
+	void WriteNumber(std::ostream& os, double value) {
+		char number[32];
+		sprintf(number, "%.4f", value);
+		os << number;
+	}
+}
+
+FrameStats::Scope::Scope(FrameStats* stats, int section) :
+	stats(stats), section(section), begin(stats ? Now() : 0.0) {
+}
+
+FrameStats::Scope::~Scope() {
+	if (stats) {
+		stats->Add(section, Now() - begin);
+	}
+}
+
+double FrameStats::Now() {
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameStats::FrameStats(std::vector<std::string> const& names) :
+	names(names), current(names.size(), 0.0) {
+}
+
+void FrameStats::Add(int section, double ms) {
+	current[section] += ms;
+}
+
+void FrameStats::EndFrame() {
+	samples.insert(samples.end(), current.begin(), current.end());
+	std::fill(current.begin(), current.end(), 0.0);
+}
+
+int FrameStats::GetFrameCount() const {
+	return names.empty() ? 0 : (int)(samples.size() / names.size());
+}
+
+FrameStats::Summary FrameStats::GetSummary(int section) const {
+	Summary summary = { 0.0, 0.0, 0.0, 0.0 };
+	int const count = GetFrameCount();
+	if (count == 0)
+		return summary;
+
+	std::vector<double> times(count);
+	double sum = 0.0;
+	for (int i = 0; i < count; ++i) {
+		times[i] = samples[i * names.size() + section];
+		sum += times[i];
+	}
+	std::sort(times.begin(), times.end());
+
+	summary.mean = sum / count;
+	summary.p50 = times[(int)std::ceil(count * 0.50) - 1];
+	summary.p99 = times[(int)std::ceil(count * 0.99) - 1];
+	summary.max = times.back();
+	return summary;
+}
+
+void FrameStats::SetInfo(std::string const& key, std::string const& value) {
+	for (size_t i = 0; i < info.size(); ++i) {
+		if (info[i].first == key) {
+			info[i].second = value;
+			return;
+		}
+	}
+	info.push_back(std::make_pair(key, value));
+}
+
+void FrameStats::WriteJson(std::ostream& os) const {
+	os << "{\n  \"frames\": " << GetFrameCount() << ",\n  \"info\": {";
+	for (size_t i = 0; i < info.size(); ++i) {
+		os << (i == 0 ? "\n    " : ",\n    ");
+		WriteString(os, info[i].first);
+		os << ": ";
+		WriteString(os, info[i].second);
+	}
+	os << (info.empty() ? "},\n" : "\n  },\n");
+
+	os << "  \"sections\": {";
+	for (size_t i = 0; i < names.size(); ++i) {
+		Summary const summary = GetSummary(i);
+		os << (i == 0 ? "\n    " : ",\n    ");
+		WriteString(os, names[i]);
+		os << ": { \"mean\": ";
+		WriteNumber(os, summary.mean);
+		os << ", \"p50\": ";
+		WriteNumber(os, summary.p50);
+		os << ", \"p99\": ";
+		WriteNumber(os, summary.p99);
+		os << ", \"max\": ";
+		WriteNumber(os, summary.max);
+		os << " }";
+	}
+	os << (names.empty() ? "}\n}\n" : "\n  }\n}\n");
+}
@@ -0,0 +1,120 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_FRAME_STATS_H_
+#define _EASYRPG_FRAME_STATS_H_
+
+// Headers
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * FrameStats class.
+ * Collects the time spent in named sections of every frame of a benchmark
+ * run and summarizes it as JSON.
+ */
+class FrameStats {
+public:
+	/** Summary of one section over all frames, in ms. */
+	struct Summary {
+		double mean;
+		double p50;
+		double p99;
+		double max;
+	};
+
+	/**
+	 * Times a section from construction to destruction, does nothing when
+	 * no FrameStats is passed.
+	 */
+	class Scope {
+	public:
+		Scope(FrameStats* stats, int section);
+		~Scope();
+
+	private:
+		FrameStats* stats;
+		int section;
+		double begin;
+	};
+
+	/**
+	 * @return monotonic time in ms.
+	 */
+	static double Now();
+
+	/**
+	 * Constructor.
+	 *
+	 * @param names section names, used as JSON keys.
+	 */
+	explicit FrameStats(std::vector<std::string> const& names);
+
+	/**
+	 * Adds time to a section of the current frame.
+	 *
+	 * @param section section index.
+	 * @param ms time in ms.
+	 */
+	void Add(int section, double ms);
+
+	/**
+	 * Stores the current frame and starts the next one.
+	 */
+	void EndFrame();
+
+	/**
+	 * @return number of stored frames.
+	 */
+	int GetFrameCount() const;
+
+	/**
+	 * Summarizes a section, percentiles use the nearest rank.
+	 *
+	 * @param section section index.
+	 * @return summary, all zero without frames.
+	 */
+	Summary GetSummary(int section) const;
+
+	/**
+	 * Adds a string to the "info" object of the JSON output, e.g. the game
+	 * and seed of the run.
+	 *
+	 * @param key name.
+	 * @param value value.
+	 */
+	void SetInfo(std::string const& key, std::string const& value);
+
+	/**
+	 * Writes the frame count, the info and the summary of every section.
+	 *
+	 * @param os output stream.
+	 */
+	void WriteJson(std::ostream& os) const;
+
+private:
+	std::vector<std::string> names;
+	std::vector<std::pair<std::string, std::string> > info;
+	/** Section times of the current frame. */
+	std::vector<double> current;
+	/** Section times of all frames, frame after frame. */
+	std::vector<double> samples;
+};
+
+#endif
@@ -404,7 +404,7 @@ void Game_BattleAlgorithm::AlgorithmBase::Apply() {
 	}
 
 	if (GetAffectedSwitch() != -1) {
-		Game_Switches[GetAffectedSwitch()] = true;
+		Game_Switches.Set(GetAffectedSwitch(), true);
 	}
 
 	std::vector<RPG::State>::const_iterator it = conditions.begin();
@@ -267,7 +267,7 @@ bool Game_Battler::UseSkill(int skill_id) {
 			// ToDo: Show Teleport/Escape target menu
 			break;
 		case RPG::Skill::Type_switch:
-			Game_Switches[skill.switch_id] = true;
+			Game_Switches.Set(skill.switch_id, true);
 			return true;
 	}
 
@@ -75,6 +75,7 @@ int Game_Event::GetX() const {
 
 void Game_Event::SetX(int new_x) {
 	data.position_x = new_x;
+	Game_Map::UpdateEventPosition(this);
 }
 
 int Game_Event::GetY() const {
@@ -83,6 +84,7 @@ int Game_Event::GetY() const {
 
 void Game_Event::SetY(int new_y) {
 	data.position_y = new_y;
+	Game_Map::UpdateEventPosition(this);
 }
 
 int Game_Event::GetMapId() const {
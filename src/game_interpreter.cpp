@@ -41,6 +41,7 @@
 #include "main_data.h"
 #include "output.h"
 #include "player.h"
+#include "profiler.h"
 #include "util_macro.h"
 
 Game_Interpreter::Game_Interpreter(int _depth, bool _main_flag) {
@@ -130,6 +131,8 @@ bool Game_Interpreter::HasRunned() const {
 
 // Update
 void Game_Interpreter::Update() {
+	PROFILE_SCOPE(Profiler::SectionInterpreter);
+
 	updating = true;
 	runned = false;
 	// 10000 based on: https://gist.github.com/4406621
@@ -518,24 +521,24 @@ bool Game_Interpreter::CommandControlSwitches(RPG::EventCommand const& com) { //
 			// Single and switch range
 			for (i = com.parameters[1]; i <= com.parameters[2]; i++) {
 				if (com.parameters[3] != 2) {
-					Game_Switches[i] = com.parameters[3] == 0;
+					Game_Switches.Set(i, com.parameters[3] == 0);
 				} else {
-					Game_Switches[i] = !Game_Switches[i];
+					Game_Switches.Flip(i);
 				}
 			}
 			break;
 		case 2:
 			// Switch from variable
+			i = Game_Variables[com.parameters[1]];
 			if (com.parameters[3] != 2) {
-				Game_Switches[Game_Variables[com.parameters[1]]] = com.parameters[3] == 0;
+				Game_Switches.Set(i, com.parameters[3] == 0);
 			} else {
-				Game_Switches[Game_Variables[com.parameters[1]]] = !Game_Switches[Game_Variables[com.parameters[1]]];
+				Game_Switches.Flip(i);
 			}
 			break;
 		default:
 			return false;
 	}
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_All);
 	return true;
 }
 
@@ -733,86 +736,89 @@ bool Game_Interpreter::CommandControlVariables(RPG::EventCommand const& com) { /
 		case 1:
 			// Single and Var range
 			for (i = com.parameters[1]; i <= com.parameters[2]; i++) {
+				int result = Game_Variables[i];
 				switch (com.parameters[3]) {
 					case 0:
 						// Assignement
-						Game_Variables[i] = value;
+						result = value;
 						break;
 					case 1:
 						// Addition
-						Game_Variables[i] += value;
+						result += value;
 						break;
 					case 2:
 						// Subtraction
-						Game_Variables[i] -= value;
+						result -= value;
 						break;
 					case 3:
 						// Multiplication
-						Game_Variables[i] *= value;
+						result *= value;
 						break;
 					case 4:
 						// Division
 						if (value != 0) {
-							Game_Variables[i] /= value;
+							result /= value;
 						}
 						break;
 					case 5:
 						// Module
 						if (value != 0) {
-							Game_Variables[i] %= value;
+							result %= value;
 						} else {
-							Game_Variables[i] = 0;
+							result = 0;
 						}
 				}
-				if (Game_Variables[i] > MaxSize) {
-					Game_Variables[i] = MaxSize;
+				if (result > MaxSize) {
+					result = MaxSize;
 				}
-				if (Game_Variables[i] < MinSize) {
-					Game_Variables[i] = MinSize;
+				if (result < MinSize) {
+					result = MinSize;
 				}
+				Game_Variables.Set(i, result);
 			}
 			break;
 
 		case 2:
 			int var_index = Game_Variables[com.parameters[1]];
+			int result = Game_Variables[var_index];
 			switch (com.parameters[3]) {
 				case 0:
 					// Assignement
-					Game_Variables[var_index] = value;
+					result = value;
 					break;
 				case 1:
 					// Addition
-					Game_Variables[var_index] += value;
+					result += value;
 					break;
 				case 2:
 					// Subtraction
-					Game_Variables[var_index] -= value;
+					result -= value;
 					break;
 				case 3:
 					// Multiplication
-					Game_Variables[var_index] *= value;
+					result *= value;
 					break;
 				case 4:
 					// Division
 					if (value != 0) {
-						Game_Variables[var_index] /= value;
+						result /= value;
 					}
 					break;
 				case 5:
 					// Module
 					if (value != 0) {
-						Game_Variables[var_index] %= value;
+						result %= value;
 					}
 			}
-			if (Game_Variables[var_index] > MaxSize) {
-				Game_Variables[var_index] = MaxSize;
+			if (result > MaxSize) {
+				result = MaxSize;
 			}
-			if (Game_Variables[var_index] < MinSize) {
-				Game_Variables[var_index] = MinSize;
+			if (result < MinSize) {
+				result = MinSize;
 			}
+			Game_Variables.Set(var_index, result);
 	}
 
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
 	return true;
 }
 
@@ -906,17 +912,16 @@ bool Game_Interpreter::CommandChangeItems(RPG::EventCommand const& com) { // Cod
 		}
 	}
 
+	int item_id;
 	if (com.parameters[1] == 0) {
 		// Item by const number
-		Main_Data::game_party->AddItem(com.parameters[2], value);
+		item_id = com.parameters[2];
 	} else {
 		// Item by variable
-		Main_Data::game_party->AddItem(
-			Game_Variables[com.parameters[2]],
-			value
-		);
+		item_id = Game_Variables[com.parameters[2]];
 	}
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Main_Data::game_party->AddItem(item_id, value);
+	Game_Map::SetNeedRefresh(EventDependencies::Item, item_id);
 	// Continue
 	return true;
 }
@@ -977,7 +982,7 @@ bool Game_Interpreter::CommandChangePartyMember(RPG::EventCommand const& com) {
 		}
 	}
 
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Map::SetNeedRefresh(EventDependencies::Actor, id);
 
 	// Continue
 	return true;
@@ -442,10 +442,9 @@ bool Game_Interpreter_Map::CommandMemorizeLocation(RPG::EventCommand const& com)
 	int var_map_id = com.parameters[0];
 	int var_x = com.parameters[1];
 	int var_y = com.parameters[2];
-	Game_Variables[var_map_id] = Game_Map::GetMapId();
-	Game_Variables[var_x] = player->GetX();
-	Game_Variables[var_y] = player->GetY();
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_map_id, Game_Map::GetMapId());
+	Game_Variables.Set(var_x, player->GetX());
+	Game_Variables.Set(var_y, player->GetY());
 	return true;
 }
 
@@ -483,8 +482,7 @@ bool Game_Interpreter_Map::CommandStoreTerrainID(RPG::EventCommand const& com) {
 	int x = ValueOrVariable(com.parameters[0], com.parameters[1]);
 	int y = ValueOrVariable(com.parameters[0], com.parameters[2]);
 	int var_id = com.parameters[3];
-	Game_Variables[var_id] = Game_Map::GetTerrainTag(x, y);
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_id, Game_Map::GetTerrainTag(x, y));
 	return true;
 }
 
@@ -494,8 +492,7 @@ bool Game_Interpreter_Map::CommandStoreEventID(RPG::EventCommand const& com) { /
 	int var_id = com.parameters[3];
 	std::vector<Game_Event*> events;
 	Game_Map::GetEventsXY(events, x, y);
-	Game_Variables[var_id] = events.size() > 0 ? events.back()->GetId() : 0;
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_id, events.size() > 0 ? events.back()->GetId() : 0);
 	return true;
 }
 
@@ -1575,8 +1572,7 @@ bool Game_Interpreter_Map::CommandKeyInputProc(RPG::EventCommand const& com) { /
 		}
 	}
 
-	Game_Variables[var_id] = result;
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_id, result);
 
 	if (!wait)
 		return true;
@@ -1588,7 +1584,7 @@ bool Game_Interpreter_Map::CommandKeyInputProc(RPG::EventCommand const& com) { /
 
 	if (time) {
 		// 10 per second
-		Game_Variables[time_id] = (int)((float)button_timer / Graphics::GetDefaultFps() * 10);
+		Game_Variables.Set(time_id, (int)((float)button_timer / Graphics::GetDefaultFps() * 10));
 	}
 
 	button_timer = 0;
@@ -1698,8 +1694,7 @@ bool Game_Interpreter_Map::CommandSimulatedAttack(RPG::EventCommand const& com)
 		CheckGameOver();
 
 		if (com.parameters[6] != 0) {
-			Game_Variables[com.parameters[7]] = result;
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Variables.Set(com.parameters[7], result);
 		}
 	}
 
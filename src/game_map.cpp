@@ -29,10 +29,13 @@
 #include "game_battler.h"
 #include "game_map.h"
 #include "game_interpreter_map.h"
+#include "game_party.h"
 #include "game_switches.h"
+#include "game_variables.h"
 #include "game_temp.h"
 #include "game_player.h"
 #include "lmu_reader.h"
+#include "map_prefetcher.h"
 #include "reader_lcf.h"
 #include "map_data.h"
 #include "main_data.h"
@@ -41,8 +44,13 @@
 #include "game_system.h"
 #include "filefinder.h"
 #include "player.h"
+#include "profiler.h"
 #include "input.h"
+#include "event_dependencies.h"
+#include "passability_grid.h"
+#include "tile_index.h"
 #include <boost/scoped_ptr.hpp>
+#include <functional>
 
 namespace {
 	RPG::SaveMapInfo& map_info = Main_Data::game_data.map_info;
@@ -61,8 +69,14 @@ namespace {
 
 	std::vector<unsigned char> passages_down;
 	std::vector<unsigned char> passages_up;
+	PassabilityGrid passability;
 	std::vector<Game_Event> events;
 	std::vector<Game_CommonEvent> common_events;
+	// Events by position, items are indices into events
+	TileIndex event_index;
+	// Events by page condition, items are indices into events followed
+	// by the common events
+	EventDependencies dependencies;
 
 	std::auto_ptr<RPG::Map> map;
 	int scroll_direction;
@@ -79,11 +93,110 @@ namespace {
 	bool pan_locked;
 	bool pan_wait;
 	int pan_speed;
+
+	// Map loaded ahead of time by PrefetchMap
+	std::auto_ptr<RPG::Map> prefetched_map;
+	int prefetched_map_id = 0;
+
+	std::auto_ptr<RPG::Map> LoadMapFile(int map_id) {
+		std::auto_ptr<RPG::Map> map_file_data;
+
+		// Try loading EasyRPG map files first, then fallback to normal RPG Maker
+		std::stringstream ss;
+		ss << "Map" << std::setfill('0') << std::setw(4) << map_id << ".emu";
+
+		std::string map_file = FileFinder::FindDefault(ss.str());
+		if (map_file.empty()) {
+			ss.str("");
+			ss << "Map" << std::setfill('0') << std::setw(4) << map_id << ".lmu";
+			map_file = FileFinder::FindDefault(ss.str());
+
+			map_file_data = LMU_Reader::Load(map_file, Player::encoding);
+		} else {
+			map_file_data = LMU_Reader::LoadXml(map_file);
+		}
+		Output::Debug("Loading Map %s", ss.str().c_str());
+
+		if (map_file_data.get() == NULL) {
+			Output::ErrorStr(LcfReader::GetError());
+		}
+
+		return map_file_data;
+	}
+
+	void OnSwitchChanged(int switch_id) {
+		Game_Map::SetNeedRefresh(EventDependencies::Switch, switch_id);
+	}
+
+	void OnVariableChanged(int variable_id) {
+		Game_Map::SetNeedRefresh(EventDependencies::Variable, variable_id);
+	}
+
+	void BuildPassability() {
+		std::vector<short> const& terrain_data = Data::chipsets[map_info.chipset_id - 1].terrain_data;
+
+		// Chips as numbered by PassabilityGrid::GetTerrainChip
+		std::vector<uint8_t> terrain_flags(162);
+		for (size_t i = 0; i < terrain_flags.size(); ++i) {
+			// RPG_RT optimisation: When the terrain is all 1, no terrain data is stored
+			int const tag = i < terrain_data.size() ? terrain_data[i] : 1;
+			RPG::Terrain const terrain = (tag >= 1 && tag <= (int)Data::terrains.size()) ?
+				Data::terrains[tag - 1] : RPG::Terrain();
+
+			terrain_flags[i] =
+				(terrain.boat_pass ? PassabilityGrid::TerrainBoat : 0) |
+				(terrain.ship_pass ? PassabilityGrid::TerrainShip : 0) |
+				(terrain.airship_pass ? PassabilityGrid::TerrainAirship : 0) |
+				(terrain.airship_land ? PassabilityGrid::TerrainAirshipLand : 0);
+		}
+
+		passability.Build(Game_Map::GetWidth(), Game_Map::GetHeight(),
+			map->lower_layer, map->upper_layer,
+			passages_down, passages_up,
+			map_info.lower_tiles, map_info.upper_tiles,
+			terrain_flags);
+	}
+
+	void IndexEvents() {
+		event_index.Reset(Game_Map::GetWidth(), Game_Map::GetHeight(), events.size());
+		for (size_t i = 0; i < events.size(); ++i) {
+			event_index.Place(i, events[i].GetX(), events[i].GetY());
+		}
+
+		dependencies.Reset(events.size() + common_events.size());
+		for (size_t i = 0; i < events.size(); ++i) {
+			for (const RPG::EventPage& page : map->events[i].pages) {
+				const RPG::EventPageCondition& condition = page.condition;
+				if (condition.flags.switch_a)
+					dependencies.Add(i, EventDependencies::Switch, condition.switch_a_id);
+				if (condition.flags.switch_b)
+					dependencies.Add(i, EventDependencies::Switch, condition.switch_b_id);
+				if (condition.flags.variable)
+					dependencies.Add(i, EventDependencies::Variable, condition.variable_id);
+				if (condition.flags.item)
+					dependencies.Add(i, EventDependencies::Item, condition.item_id);
+				if (condition.flags.actor)
+					dependencies.Add(i, EventDependencies::Actor, condition.actor_id);
+				if (condition.flags.timer)
+					dependencies.Add(i, EventDependencies::Timer, Game_Party::Timer1);
+				if (condition.flags.timer2)
+					dependencies.Add(i, EventDependencies::Timer, Game_Party::Timer2);
+			}
+		}
+		for (size_t i = 0; i < common_events.size(); ++i) {
+			if (common_events[i].GetSwitchFlag()) {
+				dependencies.Add(events.size() + i, EventDependencies::Switch, common_events[i].GetSwitchId());
+			}
+		}
+	}
 }
 
 void Game_Map::Init() {
 	Dispose();
 
+	Game_Switches.GetJournal().SetListener(OnSwitchChanged);
+	Game_Variables.GetJournal().SetListener(OnVariableChanged);
+
 	map_info.position_x = 0;
 	map_info.position_y = 0;
 	refresh_type = Refresh_All;
@@ -116,6 +229,9 @@ void Game_Map::Init() {
 
 void Game_Map::Dispose() {
 	events.clear();
+	event_index.Reset(0, 0, 0);
+	dependencies.Reset(0);
+	passability.Clear();
 	pending.clear();
 
 	if (Main_Data::game_screen) {
@@ -129,6 +245,9 @@ void Game_Map::Dispose() {
 void Game_Map::Quit() {
 	Dispose();
 
+	Game_Switches.GetJournal().SetListener(NULL);
+	Game_Variables.GetJournal().SetListener(NULL);
+
 	common_events.clear();
 	interpreter.reset();
 }
@@ -140,6 +259,7 @@ void Game_Map::Setup(int _id) {
 	for (const RPG::Event& ev : map->events) {
 		events.emplace_back(location.map_id, ev);
 	}
+	IndexEvents();
 
 	location.pan_finish_x = 0;
 	location.pan_finish_y = 0;
@@ -165,6 +285,7 @@ void Game_Map::SetupFromSave() {
 		if (events.back().IsMoveRouteOverwritten())
 			pending.push_back(&events.back());
 	}
+	IndexEvents();
 
 	for (size_t i = 0; i < Main_Data::game_data.common_events.size() && i < common_events.size(); ++i) {
 		common_events[i].SetSaveData(Main_Data::game_data.common_events[i].event_data);
@@ -188,25 +309,15 @@ void Game_Map::SetupCommon(int _id) {
 
 	location.map_id = _id;
 
-	// Try loading EasyRPG map files first, then fallback to normal RPG Maker
-	std::stringstream ss;
-	ss << "Map" << std::setfill('0') << std::setw(4) << location.map_id << ".emu";
-
-	std::string map_file = FileFinder::FindDefault(ss.str());
-	if (map_file.empty()) {
-		ss.str("");
-		ss << "Map" << std::setfill('0') << std::setw(4) << location.map_id << ".lmu";
-		map_file = FileFinder::FindDefault(ss.str());
-
-		map = LMU_Reader::Load(map_file, Player::encoding);
+	if (prefetched_map.get() && prefetched_map_id == _id) {
+		// Assets are already being loaded
+		map = prefetched_map;
 	} else {
-		map = LMU_Reader::LoadXml(map_file);
-	}
-	Output::Debug("Loading Map %s", ss.str().c_str());
-
-	if (map.get() == NULL) {
-		Output::ErrorStr(LcfReader::GetError());
+		map = LoadMapFile(_id);
+		MapPrefetcher::Prefetch(*map, _id);
 	}
+	prefetched_map.reset();
+	prefetched_map_id = 0;
 
 	if (map->parallax_flag) {
 		SetParallaxName(map->parallax_name);
@@ -228,7 +339,7 @@ void Game_Map::SetupCommon(int _id) {
 	int current_index = GetMapIndex(location.map_id);
 	map_info.encounter_rate = Data::treemap.maps[current_index].encounter_steps;
 
-	ss.str("");
+	std::stringstream ss;
 	for (int cur = current_index;
 		GetMapIndex(Data::treemap.maps[cur].parent_map) != cur;
 		cur = GetMapIndex(Data::treemap.maps[cur].parent_map)) {
@@ -296,15 +407,34 @@ void Game_Map::PlayBgm() {
 }
 
 void Game_Map::Refresh() {
-	if (location.map_id > 0) {
-		for (Game_Event& ev : events) {
-			ev.Refresh();
-		}
+	std::vector<int> dirty;
+	dependencies.TakeDirty(dirty);
 
-		if (refresh_type == Refresh_All) {
-			for (Game_CommonEvent& ev : common_events) {
+	if (location.map_id > 0) {
+		if (refresh_type == Refresh_Dependent) {
+			for (int i : dirty) {
+				if (i < (int)events.size()) {
+					events[i].Refresh();
+				} else {
+					common_events[i - events.size()].Refresh();
+				}
+			}
+		} else {
+			for (Game_Event& ev : events) {
 				ev.Refresh();
 			}
+
+			if (refresh_type == Refresh_All) {
+				for (Game_CommonEvent& ev : common_events) {
+					ev.Refresh();
+				}
+			} else {
+				for (int i : dirty) {
+					if (i >= (int)events.size()) {
+						common_events[i - events.size()].Refresh();
+					}
+				}
+			}
 		}
 	}
 
@@ -467,14 +597,16 @@ bool Game_Map::IsPassable(int x, int y, int d, const Game_Character* self_event)
 bool Game_Map::IsPassableVehicle(int x, int y, Game_Vehicle::Type vehicle_type) {
 	if (!Game_Map::IsValid(x, y)) return false;
 
+	int const flags = passability.GetFlags(x + y * GetWidth());
+
 	if (vehicle_type == Game_Vehicle::Boat) {
-		if (!Data::data.terrains[GetTerrainTag(x, y) -1].boat_pass)
+		if ((flags & PassabilityGrid::Boat) == 0)
 			return false;
 	} else if (vehicle_type == Game_Vehicle::Ship) {
-		if (!Data::data.terrains[GetTerrainTag(x, y) -1].ship_pass)
+		if ((flags & PassabilityGrid::Ship) == 0)
 			return false;
 	} else if (vehicle_type == Game_Vehicle::Airship) {
-		return Data::data.terrains[GetTerrainTag(x, y) -1].airship_pass;
+		return (flags & PassabilityGrid::Airship) != 0;
 	}
 
 	int tile_id;
@@ -495,12 +627,7 @@ bool Game_Map::IsPassableVehicle(int x, int y, Game_Vehicle::Type vehicle_type)
 		}
 	}
 
-	int const tile_index = x + y * GetWidth();
-
-	tile_id = map->upper_layer[tile_index] - BLOCK_F;
-	tile_id = map_info.upper_tiles[tile_id];
-
-	if ((passages_up[tile_id] & Passable::Above) == 0)
+	if ((flags & PassabilityGrid::Above) == 0)
 		return false;
 
 	for (int i = 0; i < 3; i++) {
@@ -521,8 +648,11 @@ bool Game_Map::IsLandable(int x, int y, const Game_Character *self_event) {
 	int bit = Passable::Down | Passable::Right | Passable::Left | Passable::Up;
 
 	if (self_event) {
-		for (Game_Event& ev : events) {
-			if (&ev != self_event && ev.IsInPosition(x, y)) {
+		std::vector<int> indices;
+		event_index.Get(x, y, indices);
+		for (int i : indices) {
+			const Game_Event& ev = events[i];
+			if (&ev != self_event) {
 				if (!ev.GetThrough()) {
 					if (ev.GetLayer() == RPG::EventPage::Layers_same) {
 						return false;
@@ -540,40 +670,7 @@ bool Game_Map::IsLandable(int x, int y, const Game_Character *self_event) {
 }
 
 bool Game_Map::IsPassableTile(int bit, int tile_index) {
-	int tile_id = map->upper_layer[tile_index] - BLOCK_F;
-	tile_id = map_info.upper_tiles[tile_id];
-
-	if ((passages_up[tile_id] & bit) == 0)
-		return false;
-
-	if ((passages_up[tile_id] & Passable::Above) == 0)
-		return true;
-
-	int tile_raw_id = map->lower_layer[tile_index];
-
-	if (tile_raw_id >= BLOCK_E) {
-		tile_id = tile_raw_id - BLOCK_E;
-		tile_id = map_info.lower_tiles[tile_id] + 18;
-
-	} else if (tile_raw_id >= BLOCK_D) {
-		tile_id = (tile_raw_id - BLOCK_D) / 50 + 6;
-		int autotile_id = (tile_raw_id - BLOCK_D) % 50;
-
-		if (((passages_down[tile_id] & Passable::Wall) != 0) && (
-				(autotile_id >= 20 && autotile_id <= 23) ||
-				(autotile_id >= 33 && autotile_id <= 37) ||
-				autotile_id == 42 || autotile_id == 43 ||
-				autotile_id == 45 || autotile_id == 46))
-			return true;
-
-	} else if (tile_raw_id >= BLOCK_C) {
-		tile_id = (tile_raw_id - BLOCK_C) / 50 + 3;
-
-	} else if (map->lower_layer[tile_index] < BLOCK_C) {
-		tile_id = tile_raw_id / 1000;
-	}
-
-	return (passages_down[tile_id] & bit) != 0;
+	return passability.IsPassable(tile_index, bit);
 }
 
 int Game_Map::GetBushDepth(int x, int y) {
@@ -585,28 +682,16 @@ int Game_Map::GetBushDepth(int x, int y) {
 bool Game_Map::IsCounter(int x, int y) {
 	if (!Game_Map::IsValid(x, y)) return false;
 
-	int const tile_id = map->upper_layer[x + y * GetWidth()];
-	if (tile_id < BLOCK_F) return false;
-	int const index = map_info.upper_tiles[tile_id - BLOCK_F];
-	return !!(passages_up[index] & Passable::Counter);
+	return (passability.GetFlags(x + y * GetWidth()) & PassabilityGrid::Counter) != 0;
 }
 
 int Game_Map::GetTerrainTag(int const x, int const y) {
 	if (!Game_Map::IsValid(x, y)) return 1;
 
-	unsigned const chipID = map->lower_layer[x + y * GetWidth()];
-	unsigned chip_index =
-		(chipID <  3050)?  0 + chipID/1000 :
-		(chipID <  4000)?  4 + (chipID-3050)/50 :
-		(chipID <  5000)?  6 + (chipID-4000)/50 :
-		(chipID <  5144)? 18 + (chipID-5000) :
-		0;
+	unsigned const chip_index = PassabilityGrid::GetTerrainChip(
+		map->lower_layer[x + y * GetWidth()], map_info.lower_tiles);
 	unsigned const chipset_index = map_info.chipset_id - 1;
 
-	// Apply tile substitution
-	if (chip_index >= 18 && chip_index <= 144)
-		chip_index = map_info.lower_tiles[chip_index - 18] + 18;
-
 	assert(chipset_index < Data::data.chipsets.size());
 	
 	auto& terrain_data = Data::data.chipsets[chipset_index].terrain_data;
@@ -622,17 +707,35 @@ int Game_Map::GetTerrainTag(int const x, int const y) {
 }
 
 bool Game_Map::AirshipLandOk(int const x, int const y) {
-	return Data::data.terrains[GetTerrainTag(x, y) - 1].airship_land;
+	if (!Game_Map::IsValid(x, y))
+		return Data::data.terrains[GetTerrainTag(x, y) - 1].airship_land;
+
+	return (passability.GetFlags(x + y * GetWidth()) & PassabilityGrid::AirshipLand) != 0;
 }
 
-void Game_Map::GetEventsXY(std::vector<Game_Event*>& events, int x, int y) {
-	for (Game_Event& ev : GetEvents()) {
-		if (ev.IsInPosition(x, y) && ev.GetActive()) {
-			events.push_back(&ev);
+void Game_Map::GetEventsXY(std::vector<Game_Event*>& result, int x, int y) {
+	std::vector<int> indices;
+	event_index.Get(x, y, indices);
+	for (int i : indices) {
+		if (events[i].GetActive()) {
+			result.push_back(&events[i]);
 		}
 	}
 }
 
+void Game_Map::UpdateEventPosition(const Game_Event* ev) {
+	// Events report their position while they are constructed, they are
+	// indexed once the whole map is set up
+	if (event_index.size() != events.size() || events.empty())
+		return;
+
+	std::less<const Game_Event*> const less;
+	if (less(ev, &events.front()) || !less(ev, &events.front() + events.size()))
+		return;
+
+	event_index.Place(ev - &events.front(), ev->GetX(), ev->GetY());
+}
+
 bool Game_Map::LoopHorizontal() {
 	return map->scroll_type == RPG::Map::ScrollType_horizontal || map->scroll_type == RPG::Map::ScrollType_both;
 }
@@ -666,13 +769,8 @@ int Game_Map::YwithDirection(int y, int direction) {
 }
 
 int Game_Map::CheckEvent(int x, int y) {
-	for (const Game_Event& ev : events) {
-		if (ev.IsInPosition(x, y)) {
-			return ev.GetId();
-		}
-	}
-
-	return 0;
+	int const i = event_index.GetFirst(x, y);
+	return i >= 0 ? events[i].GetId() : 0;
 }
 
 void Game_Map::StartScroll(int direction, int distance, int speed) {
@@ -707,6 +805,8 @@ void Game_Map::UpdateScroll() {
 }
 
 void Game_Map::Update(bool only_parallel) {
+	PROFILE_SCOPE(Profiler::SectionMap);
+
 	if (GetNeedRefresh() != Refresh_None) Refresh();
 	UpdateScroll();
 	UpdatePan();
@@ -943,6 +1043,13 @@ void Game_Map::SetNeedRefresh(Game_Map::RefreshMode refresh_mode) {
 	refresh_type = refresh_mode;
 }
 
+void Game_Map::SetNeedRefresh(EventDependencies::Kind kind, int id) {
+	dependencies.Mark(kind, id);
+	if (dependencies.IsDirty() && refresh_type == Refresh_None) {
+		refresh_type = Refresh_Dependent;
+	}
+}
+
 std::vector<unsigned char>& Game_Map::GetPassagesDown() {
 	return passages_down;
 }
@@ -1041,6 +1148,10 @@ void Game_Map::SetChipset(int id) {
 		map_info.lower_tiles[i] = i;
 		map_info.upper_tiles[i] = i;
 	}
+
+	if (map.get()) {
+		BuildPassability();
+	}
 }
 
 Game_Vehicle* Game_Map::GetVehicle(Game_Vehicle::Type which) {
@@ -1095,6 +1206,7 @@ void Game_Map::SubstituteDown(int old_id, int new_id) {
 			map_info.lower_tiles[i] = (uint8_t) new_id;
 		}
 	}
+	passability.SubstituteDown(old_id, new_id);
 }
 
 void Game_Map::SubstituteUp(int old_id, int new_id) {
@@ -1103,6 +1215,7 @@ void Game_Map::SubstituteUp(int old_id, int new_id) {
 			map_info.upper_tiles[i] = (uint8_t) new_id;
 		}
 	}
+	passability.SubstituteUp(old_id, new_id);
 }
 
 void Game_Map::LockPan() {
@@ -1202,6 +1315,17 @@ const std::string& Game_Map::GetParallaxName() {
 	return map_info.parallax_name;
 }
 
+void Game_Map::PrefetchMap(int map_id) {
+	if (map_id == location.map_id || (prefetched_map.get() && prefetched_map_id == map_id)) {
+		return;
+	}
+
+	prefetched_map = LoadMapFile(map_id);
+	prefetched_map_id = map_id;
+
+	MapPrefetcher::Prefetch(*prefetched_map, map_id);
+}
+
 FileRequestAsync* Game_Map::RequestMap(int map_id) {
 	std::stringstream ss;
 	ss << "Map" << std::setfill('0') << std::setw(4) << map_id << ".lmu";
@@ -22,6 +22,7 @@
 #include <vector>
 #include <string>
 #include "system.h"
+#include "event_dependencies.h"
 #include "game_commonevent.h"
 #include "game_event.h"
 #include "game_vehicle.h"
@@ -39,7 +40,9 @@ namespace Game_Map {
 	enum RefreshMode {
 		Refresh_None,
 		Refresh_All,
-		Refresh_Map
+		Refresh_Map,
+		/** Only the events depending on a changed value. */
+		Refresh_Dependent
 	};
 
 	/**
@@ -437,6 +440,15 @@ namespace Game_Map {
 	 */
 	void SetNeedRefresh(RefreshMode refresh_type);
 
+	/**
+	 * Refreshes the events whose page conditions test a value, call it
+	 * after changing the value.
+	 *
+	 * @param kind kind of the value.
+	 * @param id switch, variable, item or actor ID, or timer index.
+	 */
+	void SetNeedRefresh(EventDependencies::Kind kind, int id);
+
 	/**
 	 * Gets lower passages list.
 	 *
@@ -494,8 +506,23 @@ namespace Game_Map {
 	 */
 	std::vector<Game_CommonEvent>& GetCommonEvents();
 
+	/**
+	 * Gets the active events on a tile, in the order of the events list.
+	 *
+	 * @param events the events are appended.
+	 * @param x tile x.
+	 * @param y tile y.
+	 */
 	void GetEventsXY(std::vector<Game_Event*>& events, int x, int y);
 
+	/**
+	 * Moves an event of the current map to its new position in the index
+	 * used by the position queries. Called whenever an event moves.
+	 *
+	 * @param ev event, ignored when it is not part of the events list.
+	 */
+	void UpdateEventPosition(const Game_Event* ev);
+
 	bool LoopHorizontal();
 	bool LoopVertical();
 
@@ -572,6 +599,15 @@ namespace Game_Map {
 	const std::string& GetParallaxName();
 
 	FileRequestAsync* RequestMap(int map_id);
+
+	/**
+	 * Loads a map ahead of time and starts loading all its assets.
+	 * The next Setup of this map uses the loaded map data.
+	 * The map file must have been requested before.
+	 *
+	 * @param map_id ID of the map.
+	 */
+	void PrefetchMap(int map_id);
 }
 
 #endif
@@ -444,11 +444,11 @@ void Game_Party::SetTimer(int which, int seconds) {
 	switch (which) {
 		case Timer1:
 			data.timer1_secs = seconds * DEFAULT_FPS;
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(EventDependencies::Timer, Timer1);
 			break;
 		case Timer2:
 			data.timer2_secs = seconds * DEFAULT_FPS;
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(EventDependencies::Timer, Timer2);
 			break;
 	}
 }
@@ -486,7 +486,7 @@ void Game_Party::UpdateTimers() {
 	if (data.timer1_active && (data.timer1_battle || !battle) && data.timer1_secs > 0) {
 		data.timer1_secs--;
 		if (data.timer1_secs % DEFAULT_FPS == 0) {
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(EventDependencies::Timer, Timer1);
 		}
 		if (data.timer1_secs == 0) {
 			StopTimer(Timer1);
@@ -495,7 +495,7 @@ void Game_Party::UpdateTimers() {
 	if (data.timer2_active && (data.timer2_battle || !battle) && data.timer2_secs > 0) {
 		data.timer2_secs--;
 		if (data.timer2_secs % DEFAULT_FPS == 0) {
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(EventDependencies::Timer, Timer2);
 		}
 		if (data.timer2_secs == 0) {
 			StopTimer(Timer2);
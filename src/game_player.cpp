@@ -209,9 +209,17 @@ void Game_Player::ReserveTeleport(int map_id, int x, int y, int direction) {
 
 	FileRequestAsync* request = Game_Map::RequestMap(new_map_id);
 	request->SetImportantFile(true);
+	teleport_map_request_id = request->Bind(&Game_Player::OnTeleportMapReady, this);
 	request->Start();
 }
 
+void Game_Player::OnTeleportMapReady(FileRequestResult* result) {
+	// Load the assets of the destination map while the screen fades out
+	if (result->success) {
+		Game_Map::PrefetchMap(new_map_id);
+	}
+}
+
 void Game_Player::StartTeleport() {
 	teleporting = true;
 }
@@ -19,6 +19,7 @@
 #define _GAME_PLAYER_H_
 
 // Headers
+#include "async_handler.h"
 #include "rpg_music.h"
 #include "rpg_savepartylocation.h"
 #include "game_character.h"
@@ -120,6 +121,9 @@ private:
 	int new_map_id, new_x, new_y, new_direction;
 	int last_pan_x, last_pan_y;
 	RPG::Music walking_bgm;
+	FileRequestBinding teleport_map_request_id;
+
+	void OnTeleportMapReady(FileRequestResult* result);
 
 	void UpdateScroll();
 	bool CheckTouchEvent();
@@ -197,36 +197,62 @@ static double interpolate(double d, double x0, double x1)
 
 void Game_Screen::StopWeather() {
 	data.weather = Weather_None;
-	snowflakes.clear();
+	particles.x.clear();
+	particles.y.clear();
+	particles.life.clear();
 }
 
-void Game_Screen::InitSnowRain() {
-	if (!snowflakes.empty())
+void Game_Screen::InitParticles() {
+	if (particles.size() > 0)
 		return;
 
-	static const int num_snowflakes[3] = {100, 200, 300};
+	static const int num_particles[3] = {100, 200, 300};
+	int const count = num_particles[data.weather_strength];
 
-	for (int i = 0; i < num_snowflakes[data.weather_strength]; i++) {
-		Snowflake f;
-		f.x = (short) (rand() * 440.0 / RAND_MAX);
-		f.y = (uint8_t) rand();
-		f.life = (uint8_t) rand();
-		snowflakes.push_back(f);
+	particles.x.resize(count);
+	particles.y.resize(count);
+	particles.life.resize(count);
+
+	for (int i = 0; i < count; i++) {
+		particles.x[i] = (short) (rand() * 440.0 / RAND_MAX);
+		particles.y[i] = (uint8_t) rand();
+		particles.life[i] = (uint8_t) rand();
 	}
 }
 
-static const int snowflake_life = 200;
+static const int particle_life = 200;
+
+void Game_Screen::AgeParticles() {
+	std::vector<uint8_t>::iterator it;
+	for (it = particles.life.begin(); it != particles.life.end(); ++it) {
+		uint8_t life = *it + 1;
+		*it = life > particle_life ? 0 : life;
+	}
+}
 
 void Game_Screen::UpdateSnowRain(int speed) {
-	std::vector<Snowflake>::iterator it;
-
-	for (it = snowflakes.begin(); it != snowflakes.end(); ++it) {
-		Snowflake& f = *it;
-		f.y += (uint8_t)speed;
-		f.life++;
-		if (f.life > snowflake_life)
-			f.life = 0;
+	size_t const count = particles.size();
+
+	for (size_t i = 0; i < count; ++i) {
+		particles.y[i] += (uint8_t)speed;
+	}
+
+	AgeParticles();
+}
+
+static const int sand_speed = 6;
+
+void Game_Screen::UpdateSandstorm() {
+	size_t const count = particles.size();
+
+	// Sand is blown to the left and sinks slowly
+	for (size_t i = 0; i < count; ++i) {
+		int const x = particles.x[i] - sand_speed;
+		particles.x[i] = (uint16_t)(x < 0 ? x + 440 : x);
+		particles.y[i] += (uint8_t)(i % 2);
 	}
+
+	AgeParticles();
 }
 
 void Game_Screen::Update() {
@@ -275,16 +301,18 @@ void Game_Screen::Update() {
 		case Weather_None:
 			break;
 		case Weather_Rain:
-			InitSnowRain();
+			InitParticles();
 			UpdateSnowRain(4);
 			break;
 		case Weather_Snow:
-			InitSnowRain();
+			InitParticles();
 			UpdateSnowRain(2);
 			break;
 		case Weather_Fog:
 			break;
 		case Weather_Sandstorm:
+			InitParticles();
+			UpdateSandstorm();
 			break;
 	}
 }
@@ -310,6 +338,6 @@ int Game_Screen::GetWeatherStrength() {
 	return data.weather_strength;
 }
 
-const std::vector<Game_Screen::Snowflake>& Game_Screen::GetSnowflakes() {
-	return snowflakes;
+const Game_Screen::Particles& Game_Screen::GetParticles() {
+	return particles;
 }
@@ -79,13 +79,27 @@ public:
 	 */
 	int GetWeatherStrength();
 
-	struct Snowflake {
-		uint16_t x;
-		uint8_t y;
-		uint8_t life;
+	/**
+	 * Weather particles (rain, snow and sand) in structure-of-arrays
+	 * layout, all arrays have the same size.
+	 */
+	struct Particles {
+		/** Horizontal position, 0 to 439. */
+		std::vector<uint16_t> x;
+		/** Vertical position, wraps around. */
+		std::vector<uint8_t> y;
+		/** Frames since the particle appeared, it is only visible for a part of its life. */
+		std::vector<uint8_t> life;
+
+		size_t size() const { return x.size(); }
 	};
 
-	const std::vector<Snowflake>& GetSnowflakes();
+	/**
+	 * Returns the particles of the current weather.
+	 *
+	 * @return particles
+	 */
+	const Particles& GetParticles();
 
 	enum Weather {
 		Weather_None,
@@ -110,11 +124,13 @@ private:
 	int movie_res_y;
 
 protected:
-	std::vector<Snowflake> snowflakes;
+	Particles particles;
 
 	void StopWeather();
-	void InitSnowRain();
+	void InitParticles();
 	void UpdateSnowRain(int speed);
+	void UpdateSandstorm();
+	void AgeParticles();
 };
 
 #endif
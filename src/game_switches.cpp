@@ -28,7 +28,18 @@ static std::vector<bool>& switches() {
 	return Main_Data::game_data.system.switches;
 }
 
-std::vector<bool>::reference Game_Switches_Class::operator[](int switch_id) {
+bool Game_Switches_Class::operator[](int switch_id) const {
+	if (!IsValid(switch_id)) {
+		if (switch_id <= 0 || switch_id > PLAYER_VAR_LIMIT) {
+			Output::Debug("Switch index %d is invalid.", switch_id);
+		}
+		return false;
+	}
+
+	return switches()[switch_id - 1];
+}
+
+void Game_Switches_Class::Set(int switch_id, bool value) {
 	if (!IsValid(switch_id)) {
 		if (switch_id > 0 && switch_id <= PLAYER_VAR_LIMIT) {
 			Output::Debug("Resizing switch array to %d elements.", switch_id);
@@ -36,12 +47,23 @@ std::vector<bool>::reference Game_Switches_Class::operator[](int switch_id) {
 			Main_Data::game_data.system.switches_size = switches().size();
 		} else {
 			Output::Debug("Switch index %d is invalid.", switch_id);
-			dummy.resize(1);
-			return dummy[0];
+			return;
 		}
 	}
 
-	return switches()[switch_id - 1];
+	std::vector<bool>::reference state = switches()[switch_id - 1];
+	if (state != value) {
+		state = value;
+		journal.Record(switch_id);
+	}
+}
+
+void Game_Switches_Class::Flip(int switch_id) {
+	Set(switch_id, !(*this)[switch_id]);
+}
+
+ChangeJournal& Game_Switches_Class::GetJournal() {
+	return journal;
 }
 
 std::string Game_Switches_Class::GetName(int _id) const {
@@ -62,4 +84,5 @@ int Game_Switches_Class::GetSize() const {
 
 void Game_Switches_Class::Reset() {
 	switches().assign(Data::switches.size(), false);
+	journal.Clear();
 }
@@ -21,16 +21,43 @@
 // Headers
 #include <vector>
 #include <string>
+#include "change_journal.h"
 
 /**
  * Game_Switches class
+ * The switches are stored as bits in the savegame. Writes go through Set
+ * and Flip, which record the changed switches in the journal.
  */
 class Game_Switches_Class {
 public:
 	Game_Switches_Class();
 
-	std::vector<bool>::reference operator[](int switch_id);
-	
+	/**
+	 * @param switch_id switch ID.
+	 * @return switch state, false for switches which were never set.
+	 */
+	bool operator[](int switch_id) const;
+
+	/**
+	 * Sets a switch, the switch array grows when needed.
+	 *
+	 * @param switch_id switch ID.
+	 * @param value new state.
+	 */
+	void Set(int switch_id, bool value);
+
+	/**
+	 * Toggles a switch.
+	 *
+	 * @param switch_id switch ID.
+	 */
+	void Flip(int switch_id);
+
+	/**
+	 * @return switches changed in this frame.
+	 */
+	ChangeJournal& GetJournal();
+
 	std::string GetName(int _id) const;
 
 	bool IsValid(int switch_id) const;
@@ -40,7 +67,7 @@ public:
 	void Reset();
 
 private:
-	std::vector<bool> dummy;
+	ChangeJournal journal;
 };
 
 // Global variable
@@ -28,7 +28,19 @@ static std::vector<uint32_t>& variables() {
 	return Main_Data::game_data.system.variables;
 }
 
-int& Game_Variables_Class::operator[] (int variable_id) {
+int Game_Variables_Class::operator[] (int variable_id) const {
+	if (!IsValid(variable_id)) {
+		if (variable_id <= 0 || variable_id > PLAYER_VAR_LIMIT) {
+			Output::Debug("Variable index %d is invalid.",
+				variable_id);
+		}
+		return 0;
+	}
+
+	return (int)variables()[variable_id - 1];
+}
+
+void Game_Variables_Class::Set(int variable_id, int value) {
 	if (!IsValid(variable_id)) {
 		if (variable_id > 0 && variable_id <= PLAYER_VAR_LIMIT) {
 			Output::Debug("Resizing variable array to %d elements.", variable_id);
@@ -37,12 +49,19 @@ int& Game_Variables_Class::operator[] (int variable_id) {
 		} else {
 			Output::Debug("Variable index %d is invalid.",
 				variable_id);
-			dummy = 0;
-			return dummy;
+			return;
 		}
 	}
 
-	return (int&)variables()[variable_id - 1];
+	uint32_t& stored = variables()[variable_id - 1];
+	if (stored != (uint32_t)value) {
+		stored = (uint32_t)value;
+		journal.Record(variable_id);
+	}
+}
+
+ChangeJournal& Game_Variables_Class::GetJournal() {
+	return journal;
 }
 
 std::string Game_Variables_Class::GetName(int _id) const {
@@ -63,4 +82,5 @@ int Game_Variables_Class::GetSize() const {
 
 void Game_Variables_Class::Reset() {
 	variables().assign(Data::variables.size(), 0);
+	journal.Clear();
 }
@@ -20,16 +20,36 @@
 
 // Headers
 #include "data.h"
+#include "change_journal.h"
 #include <string>
 
 /**
  * Game_Variables class.
+ * The variables are stored as a flat int32 array in the savegame. Writes
+ * go through Set, which records the changed variables in the journal.
  */
 class Game_Variables_Class {
 public:
 	Game_Variables_Class();
 
-	int& operator[] (int variable_id);
+	/**
+	 * @param variable_id variable ID.
+	 * @return variable value, 0 for variables which were never set.
+	 */
+	int operator[] (int variable_id) const;
+
+	/**
+	 * Sets a variable, the variable array grows when needed.
+	 *
+	 * @param variable_id variable ID.
+	 * @param value new value.
+	 */
+	void Set(int variable_id, int value);
+
+	/**
+	 * @return variables changed in this frame.
+	 */
+	ChangeJournal& GetJournal();
 
 	std::string GetName(int _id) const;
 
@@ -40,7 +60,7 @@ public:
 	void Reset();
 
 private:
-	int dummy = 0;
+	ChangeJournal journal;
 };
 
 // Global variable
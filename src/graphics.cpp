@@ -17,28 +17,37 @@
 
 // Headers
 #include <algorithm>
+#include <cstdio>
 #include <sstream>
 #include <vector>
-#include <list>
 
 #include "graphics.h"
 #include "bitmap.h"
 #include "cache.h"
 #include "baseui.h"
 #include "drawable.h"
+#include "drawable_list.h"
 #include "util_macro.h"
 #include "output.h"
 #include "player.h"
+#include "profiler.h"
+#include "transition_renderer.h"
 
 namespace Graphics {
 	void UpdateTitle();
 	void DrawFrame();
 	void DrawOverlay();
+#ifdef ENABLE_PROFILER
+	void DrawProfiler(int text_y);
+#endif
+	void CollectDamage();
+	void ResetDamage();
 
 	int fps;
 	int framerate;
 
 	void UpdateTransition();
+	TransitionRenderer::Type GetRendererType(TransitionType type);
 
 	BitmapRef frozen_screen;
 	BitmapRef black_screen;
@@ -49,14 +58,17 @@ namespace Graphics {
 	int transition_duration;
 	int transition_frames_left;
 	int transition_frame;
+	/** Composites the transition frames, tables are built once per transition. */
+	EASYRPG_SHARED_PTR<TransitionRenderer> transition_renderer;
+	/** Seeds the random block order, rand() is left to the game. */
+	uint32_t transition_seed;
 	bool screen_erased;
 
 	uint32_t next_fps_time;
 
 	struct State {
 		State() {}
-		std::list<Drawable*> drawable_list;
-		bool zlist_dirty = false;
+		DrawableList drawable_list;
 		bool draw_background = true;
 	};
 
@@ -66,7 +78,21 @@ namespace Graphics {
 	std::vector<EASYRPG_SHARED_PTR<State> > stack;
 	EASYRPG_SHARED_PTR<State> global_state;
 
-	bool SortDrawableList(const Drawable* first, const Drawable* second);
+	/** Whole screen must be redrawn in the next frame. */
+	bool damage_all;
+	/** Areas reported by the drawables since the last frame. */
+	std::vector<Rect> damage_list;
+	/** Areas covered by the overlays of the last frame. */
+	std::vector<Rect> restore_list;
+	/** Non-overlapping areas composited in the current frame. */
+	std::vector<Rect> damage_rects;
+	int composited_pixels;
+	const Bitmap* last_display_surface;
+
+	// More rectangles are slower than redrawing the whole screen
+	const size_t max_damage_list = 256;
+	const int max_damage_rects = 32;
+
 }
 
 unsigned SecondToFrame(float const second) {
@@ -78,21 +104,30 @@ void Graphics::Init() {
 	frozen_screen = BitmapRef();
 	screen_erased = false;
 	transition_frames_left = 0;
+	transition_seed = (uint32_t)DisplayUi->GetTicks();
 
 	black_screen = Bitmap::Create(DisplayUi->GetWidth(), DisplayUi->GetHeight(), Color(0,0,0,255));
 
 	state.reset(new State());
 	global_state.reset(new State());
 
+	damage_all = true;
+	damage_list.clear();
+	restore_list.clear();
+	composited_pixels = 0;
+	last_display_surface = NULL;
+	ResetDamage();
+
 	next_fps_time = 0;
 }
 
 void Graphics::Quit() {
-	state->drawable_list.clear();
-	global_state->drawable_list.clear();
+	state->drawable_list.Clear();
+	global_state->drawable_list.Clear();
 
 	frozen_screen.reset();
 	black_screen.reset();
+	transition_renderer.reset();
 
 	Cache::Clear();
 }
@@ -153,48 +188,95 @@ void Graphics::DrawFrame() {
 		UpdateTransition();
 
 		for (Drawable* drawable : global_state->drawable_list) {
+			PROFILE_SCOPE(Profiler::GetDrawSection(drawable->GetType()));
 			drawable->Draw();
 		}
 
 		DrawOverlay();
 
-		DisplayUi->UpdateDisplay();
+		{
+			PROFILE_SCOPE(Profiler::SectionUpload);
+			DisplayUi->UpdateDisplay();
+		}
+		InvalidateAll();
 		return;
 	}
 
 	if (screen_erased) {
 		DisplayUi->CleanDisplay();
+		InvalidateAll();
 		return;
 	}
 
-	if (state->zlist_dirty) {
-		state->drawable_list.sort(SortDrawableList);
-		state->zlist_dirty = false;
-	}
+	state->drawable_list.Sort();
+	global_state->drawable_list.Sort();
 
-	if (global_state->zlist_dirty) {
-		global_state->drawable_list.sort(SortDrawableList);
-		global_state->zlist_dirty = false;
-	}
+	BitmapRef disp = DisplayUi->GetDisplaySurface();
 
-	if (state->draw_background) {
-		DisplayUi->AddBackground();
-	}
+	if (Player::dirty_rect_flag) {
+		if (disp.get() != last_display_surface) {
+			last_display_surface = disp.get();
+			InvalidateAll();
+		}
 
-	for (Drawable* drawable : state->drawable_list) {
-		drawable->Draw();
+		for (Drawable* drawable : state->drawable_list) {
+			if (!drawable->ReportDamage()) {
+				InvalidateAll();
+			}
+		}
+
+		for (Drawable* drawable : global_state->drawable_list) {
+			if (!drawable->ReportDamage()) {
+				InvalidateAll();
+			}
+		}
+
+		CollectDamage();
+	} else {
+		ResetDamage();
 	}
 
-	for (Drawable* drawable : global_state->drawable_list) {
-		drawable->Draw();
+	if (!damage_rects.empty()) {
+		if (Player::dirty_rect_flag) {
+			disp->SetClipRects(damage_rects);
+		}
+
+		if (state->draw_background) {
+			DisplayUi->AddBackground();
+		}
+
+		for (Drawable* drawable : state->drawable_list) {
+			PROFILE_SCOPE(Profiler::GetDrawSection(drawable->GetType()));
+			drawable->Draw();
+		}
+
+		for (Drawable* drawable : global_state->drawable_list) {
+			PROFILE_SCOPE(Profiler::GetDrawSection(drawable->GetType()));
+			drawable->Draw();
+		}
+
+		if (Player::dirty_rect_flag) {
+			disp->SetClipRects(std::vector<Rect>());
+		}
 	}
 
 	DrawOverlay();
 
+	if (Player::dirty_rect_flag) {
+		// Only the composited areas and the overlay changed
+		std::vector<Rect> dirty_rects = damage_rects;
+		dirty_rects.insert(dirty_rects.end(), restore_list.begin(), restore_list.end());
+		DisplayUi->SetDirtyRects(dirty_rects);
+	}
+
+	PROFILE_SCOPE(Profiler::SectionUpload);
 	DisplayUi->UpdateDisplay();
 }
 
 void Graphics::DrawOverlay() {
+	BitmapRef disp = DisplayUi->GetDisplaySurface();
+	int text_y = 2;
+
 	if (
 #ifndef EMSCRIPTEN
 		DisplayUi->IsFullscreen() &&
@@ -202,11 +284,156 @@ void Graphics::DrawOverlay() {
 		Player::fps_flag) {
 		std::stringstream text;
 		text << "FPS: " << real_fps;
-		DisplayUi->GetDisplaySurface()->TextDraw(2, 2, Color(255, 255, 255, 255), text.str());
+		disp->TextDraw(2, text_y, Color(255, 255, 255, 255), text.str());
+
+		Rect text_rect = disp->GetFont()->GetSize(text.str());
+		restore_list.push_back(Rect(2, text_y, text_rect.width + 1, text_rect.height + 1));
+		text_y += text_rect.height;
+	}
+
+	if (Player::dirty_rect_flag && Player::show_damage_flag) {
+		// Outline the areas reported by the drawables
+		Color outline(255, 0, 0, 255);
+		for (const Rect& rect : damage_list) {
+			disp->FillRect(Rect(rect.x, rect.y, rect.width, 1), outline);
+			disp->FillRect(Rect(rect.x, rect.y + rect.height - 1, rect.width, 1), outline);
+			disp->FillRect(Rect(rect.x, rect.y, 1, rect.height), outline);
+			disp->FillRect(Rect(rect.x + rect.width - 1, rect.y, 1, rect.height), outline);
+			restore_list.push_back(rect);
+		}
+
+		std::stringstream text;
+		text << "Pixels: " << composited_pixels;
+		disp->TextDraw(2, text_y, Color(255, 255, 255, 255), text.str());
+
+		Rect text_rect = disp->GetFont()->GetSize(text.str());
+		restore_list.push_back(Rect(2, text_y, text_rect.width + 1, text_rect.height + 1));
+		text_y += text_rect.height;
+	}
+
+#ifdef ENABLE_PROFILER
+	if (Profiler::IsEnabled()) {
+		DrawProfiler(text_y);
+	}
+#endif
+
+	damage_list.clear();
+}
+
+#ifdef ENABLE_PROFILER
+void Graphics::DrawProfiler(int text_y) {
+	BitmapRef disp = DisplayUi->GetDisplaySurface();
+	Color white(255, 255, 255, 255);
+
+	// Mean and longest time in ms of the sections that ran recently
+	for (int section = 0; section < Profiler::SectionCount; ++section) {
+		double const max = Profiler::GetMax(section);
+		if (max < 0.01)
+			continue;
+
+		char text[64];
+		sprintf(text, "%s %.2f/%.2f", Profiler::GetName(section), Profiler::GetMean(section), max);
+		disp->TextDraw(2, text_y, white, text);
+
+		Rect text_rect = disp->GetFont()->GetSize(text);
+		restore_list.push_back(Rect(2, text_y, text_rect.width + 1, text_rect.height + 1));
+		text_y += text_rect.height;
+	}
+
+	// Frame times, newest on the right, the line is the time of one frame
+	// at the default rate
+	const int graph_height = 32;
+	Rect graph(DisplayUi->GetWidth() - Profiler::history_size - 2, DisplayUi->GetHeight() - graph_height - 2,
+		Profiler::history_size, graph_height);
+	double const budget = 1000.0 / GetDefaultFps();
+
+	disp->FillRect(graph, Color(0, 0, 0, 255));
+	for (int i = 0; i < Profiler::history_size; ++i) {
+		double const time = Profiler::GetTime(Profiler::SectionFrame, i);
+		int const height = std::min(graph_height, (int)(time * graph_height / (2 * budget) + 0.5));
+		if (height > 0) {
+			Color color = time > budget ? Color(255, 64, 64, 255) : Color(64, 255, 64, 255);
+			disp->FillRect(Rect(graph.x + graph.width - 1 - i, graph.y + graph_height - height, 1, height), color);
+		}
+	}
+	disp->FillRect(Rect(graph.x, graph.y + graph_height / 2, graph.width, 1), white);
+	restore_list.push_back(graph);
+}
+#endif
+
+void Graphics::CollectDamage() {
+	int w = DisplayUi->GetWidth();
+	int h = DisplayUi->GetHeight();
+
+	damage_rects.clear();
+	composited_pixels = 0;
+
+	if (!damage_all) {
+		pixman_region32_t region;
+		pixman_region32_init(&region);
+
+		for (const Rect& rect : damage_list) {
+			pixman_region32_union_rect(&region, &region, rect.x, rect.y, rect.width, rect.height);
+		}
+		for (const Rect& rect : restore_list) {
+			pixman_region32_union_rect(&region, &region, rect.x, rect.y, rect.width, rect.height);
+		}
+		pixman_region32_intersect_rect(&region, &region, 0, 0, w, h);
+
+		int count;
+		pixman_box32_t* boxes = pixman_region32_rectangles(&region, &count);
+		for (int i = 0; i < count; ++i) {
+			Rect rect(boxes[i].x1, boxes[i].y1, boxes[i].x2 - boxes[i].x1, boxes[i].y2 - boxes[i].y1);
+			composited_pixels += rect.width * rect.height;
+			damage_rects.push_back(rect);
+		}
+
+		pixman_region32_fini(&region);
+	}
+
+	if (damage_all || (int)damage_rects.size() > max_damage_rects || composited_pixels * 4 > w * h * 3) {
+		ResetDamage();
+	}
+
+	damage_all = false;
+	restore_list.clear();
+}
+
+void Graphics::ResetDamage() {
+	damage_rects.clear();
+	damage_rects.push_back(Rect(0, 0, DisplayUi->GetWidth(), DisplayUi->GetHeight()));
+	composited_pixels = DisplayUi->GetWidth() * DisplayUi->GetHeight();
+}
+
+void Graphics::InvalidateRect(Rect const& rect) {
+	if (!Player::dirty_rect_flag || damage_all || rect.IsEmpty()) {
+		return;
+	}
+
+	if (damage_list.size() >= max_damage_list) {
+		InvalidateAll();
+		return;
 	}
+
+	damage_list.push_back(rect);
+}
+
+void Graphics::InvalidateAll() {
+	damage_all = true;
+	damage_list.clear();
+}
+
+const std::vector<Rect>& Graphics::GetDamageRects() {
+	return damage_rects;
+}
+
+int Graphics::GetCompositedPixels() {
+	return composited_pixels;
 }
 
 BitmapRef Graphics::SnapToBitmap() {
+	ResetDamage();
+
 	DisplayUi->AddBackground();
 
 	for (Drawable* drawable : state->drawable_list) {
@@ -231,15 +458,16 @@ void Graphics::Transition(TransitionType type, int duration, bool erase) {
 		transition_duration = type == TransitionErase ? 1 : duration;
 		transition_frames_left = transition_duration;
 
-		if (state->zlist_dirty) {
-			state->drawable_list.sort(SortDrawableList);
-			state->zlist_dirty = false;
+		if (type == TransitionErase) {
+			transition_renderer.reset();
+		} else {
+			transition_seed = transition_seed * 1103515245 + 12345 + (uint32_t)DisplayUi->GetTicks();
+			transition_renderer.reset(new TransitionRenderer(GetRendererType(type),
+				DisplayUi->GetWidth(), DisplayUi->GetHeight(), transition_seed));
 		}
 
-		if (global_state->zlist_dirty) {
-			global_state->drawable_list.sort(SortDrawableList);
-			global_state->zlist_dirty = false;
-		}
+		state->drawable_list.Sort();
+		global_state->drawable_list.Sort();
 
 		Freeze();
 
@@ -264,166 +492,101 @@ bool Graphics::IsTransitionPending() {
 	return transition_frames_left > 0;
 }
 
-void Graphics::UpdateTransition() {
-	// FIXME: Comments. Pleeeease. screen1, screen2?
-	BitmapRef dst = DisplayUi->GetDisplaySurface();
-	int w = DisplayUi->GetWidth();
-	int h = DisplayUi->GetHeight();
-
-	transition_frame++;
-
-	int percentage = transition_frame * 100 / transition_duration;
-
-	transition_frames_left--;
-
-	// Fallback to FadeIn/Out for not implemented transition types:
-	// (Remove from here when implemented below)
-	switch (transition_type) {
+TransitionRenderer::Type Graphics::GetRendererType(TransitionType type) {
+	switch (type) {
 	case TransitionRandomBlocks:
+		return TransitionRenderer::RandomBlocks;
 	case TransitionRandomBlocksUp:
+		return TransitionRenderer::RandomBlocksUp;
 	case TransitionRandomBlocksDown:
-	case TransitionZoomIn:
-	case TransitionZoomOut:
-	case TransitionMosaicIn:
-	case TransitionMosaicOut:
-	case TransitionWaveIn:
-	case TransitionWaveOut:
-		transition_type = TransitionFadeIn;
-		break;
-	default:
-		break;
-	}
-
-	switch (transition_type) {
-	case TransitionFadeIn:
-	case TransitionFadeOut:
-		dst->Blit(0, 0, *screen1, screen1->GetRect(), 255);
-		dst->Blit(0, 0, *screen2, screen2->GetRect(), 255 * percentage / 100);
-		break;
-	case TransitionRandomBlocks:
-		break;
-	case TransitionRandomBlocksUp:
-		break;
-	case TransitionRandomBlocksDown:
-		break;
+		return TransitionRenderer::RandomBlocksDown;
 	case TransitionBlindOpen:
-		for (int i = 0; i < h / 8; i++) {
-			dst->Blit(0, i * 8, *screen1, Rect(0, i * 8, w, 8 - 8 * percentage / 100), 255);
-			dst->Blit(0, i * 8 + 8 - 8 * percentage / 100, *screen2, Rect(0, i * 8 + 8 - 8 * percentage / 100, w, 8 * percentage / 100), 255 * percentage / 100);
-		}
-		break;
+		return TransitionRenderer::BlindOpen;
 	case TransitionBlindClose:
-		for (int i = 0; i < h / 8; i++) {
-			dst->Blit(0, i * 8 + 8 * percentage / 100, *screen1, Rect(0, i * 8 + 8 * percentage / 100, w, 8 - 8 * percentage / 100), 255);
-			dst->Blit(0, i * 8, *screen2, Rect(0, i * 8, w, 8 * percentage / 100), 255);
-		}
-		break;
+		return TransitionRenderer::BlindClose;
 	case TransitionVerticalStripesIn:
 	case TransitionVerticalStripesOut:
-		for (int i = 0; i < h / 6 + 1 - h / 6 * percentage / 100; i++) {
-			dst->Blit(0, i * 6 + 3, *screen1, Rect(0, i * 6 + 3, w, 3), 255);
-			dst->Blit(0, h - i * 6, *screen1, Rect(0, h - i * 6, w, 3), 255);
-		}
-		for (int i = 0; i < h / 6 * percentage / 100; i++) {
-			dst->Blit(0, i * 6, *screen2, Rect(0, i * 6, w, 3), 255);
-			dst->Blit(0, h - 3 - i * 6, *screen2, Rect(0, h - 3 - i * 6, w, 3), 255);
-		}
-		break;
+		return TransitionRenderer::VerticalStripes;
 	case TransitionHorizontalStripesIn:
 	case TransitionHorizontalStripesOut:
-		for (int i = 0; i < w / 8 + 1 - w / 8 * percentage / 100; i++) {
-			dst->Blit(i * 8 + 4, 0, *screen1, Rect(i * 8 + 4, 0, 4, h), 255);
-			dst->Blit(w - i * 8, 0, *screen1, Rect(w - i * 8, 0, 4, h), 255);
-		}
-		for (int i = 0; i < w / 8 * percentage / 100; i++) {
-			dst->Blit(i * 8, 0, *screen2, Rect(i * 8, 0, 4, h), 255);
-			dst->Blit(w - 4 - i * 8, 0, *screen2, Rect(w - 4 - i * 8, 0, 4, h), 255);
-		}
-		break;
+		return TransitionRenderer::HorizontalStripes;
 	case TransitionBorderToCenterIn:
 	case TransitionBorderToCenterOut:
-		dst->Blit(0,  0, *screen2, screen2->GetRect(), 255);
-		dst->Blit((w / 2) * percentage / 100, (h / 2) * percentage / 100, *screen1, Rect((w / 2) * percentage / 100, (h / 2) * percentage / 100, w - w * percentage / 100, h - h * percentage / 100), 255);
-		break;
+		return TransitionRenderer::BorderToCenter;
 	case TransitionCenterToBorderIn:
 	case TransitionCenterToBorderOut:
-		dst->Blit(0,  0, *screen1, screen1->GetRect(), 255);
-		dst->Blit(w / 2 - (w / 2) * percentage / 100, h / 2 - (h / 2) * percentage / 100, *screen2, Rect(w / 2 - (w / 2) * percentage / 100, h / 2 - (h / 2) * percentage / 100, w * percentage / 100, h * percentage / 100), 255);
-		break;
+		return TransitionRenderer::CenterToBorder;
 	case TransitionScrollUpIn:
 	case TransitionScrollUpOut:
-		dst->Blit(0,  -h * percentage / 100, *screen1, screen1->GetRect(), 255);
-		dst->Blit(0,  h - h * percentage / 100, *screen2, screen2->GetRect(), 255);
-		break;
+		return TransitionRenderer::ScrollUp;
 	case TransitionScrollDownIn:
 	case TransitionScrollDownOut:
-		dst->Blit(0,  h * percentage / 100, *screen1, screen1->GetRect(), 255);
-		dst->Blit(0,  -h + h * percentage / 100, *screen2, screen2->GetRect(), 255);
-		break;
+		return TransitionRenderer::ScrollDown;
 	case TransitionScrollLeftIn:
 	case TransitionScrollLeftOut:
-		dst->Blit(-w * percentage / 100,  0, *screen1, screen1->GetRect(), 255);
-		dst->Blit(w - w * percentage / 100,  0, *screen2, screen2->GetRect(), 255);
-		break;
+		return TransitionRenderer::ScrollLeft;
 	case TransitionScrollRightIn:
 	case TransitionScrollRightOut:
-		dst->Blit(w * percentage / 100,  0, *screen1, screen1->GetRect(), 255);
-		dst->Blit(-w + w * percentage / 100,  0, *screen2, screen2->GetRect(), 255);
-		break;
+		return TransitionRenderer::ScrollRight;
 	case TransitionVerticalCombine:
-		dst->Blit(0, (h / 2) * percentage / 100, *screen1, Rect(0, (h / 2) * percentage / 100, w, h - h * percentage / 100), 255);
-		dst->Blit(0, -h / 2 + (h / 2) * percentage / 100, *screen2, Rect(0, 0, w, h / 2), 255);
-		dst->Blit(0, h - (h / 2) * percentage / 100, *screen2, Rect(0, h / 2, w, h / 2), 255);
-		break;
+		return TransitionRenderer::VerticalCombine;
 	case TransitionVerticalDivision:
-		dst->Blit(0, -(h / 2) * percentage / 100, *screen1, Rect(0, 0, w, h / 2), 255);
-		dst->Blit(0, h / 2 + (h / 2) * percentage / 100, *screen1, Rect(0, h / 2, w, h / 2), 255);
-		dst->Blit(0, h / 2 - (h / 2) * percentage / 100, *screen2, Rect(0, h / 2 - (h / 2) * percentage / 100, w, h * percentage / 100), 255);
-		break;
+		return TransitionRenderer::VerticalDivision;
 	case TransitionHorizontalCombine:
-		dst->Blit((w / 2) * percentage / 100, 0, *screen1, Rect((w / 2) * percentage / 100, 0, w - w * percentage / 100, h), 255);
-		dst->Blit(- w / 2 + (w / 2) * percentage / 100, 0, *screen2, Rect(0, 0, w / 2, h), 255);
-		dst->Blit(w - (w / 2) * percentage / 100, 0, *screen2, Rect(w / 2, 0, w / 2, h), 255);
-		break;
+		return TransitionRenderer::HorizontalCombine;
 	case TransitionHorizontalDivision:
-		dst->Blit(-(w / 2) * percentage / 100, 0, *screen1, Rect(0, 0, w / 2, h), 255);
-		dst->Blit(w / 2 + (w / 2) * percentage / 100, 0, *screen1, Rect(w / 2, 0, w / 2, h), 255);
-		dst->Blit(w / 2 - (w / 2) * percentage / 100, 0, *screen2, Rect(w / 2 - (w / 2) * percentage / 100, 0, w * percentage / 100, h), 255);
-		break;
+		return TransitionRenderer::HorizontalDivision;
 	case TransitionCrossCombine:
-		dst->Blit((w / 2) * percentage / 100, 0, *screen1, Rect((w / 2) * percentage / 100, 0, w - w * percentage / 100, (h / 2) * percentage / 100), 255);
-		dst->Blit((w / 2) * percentage / 100, h - (h / 2) * percentage / 100, *screen1, Rect((w / 2) * percentage / 100, h - (h / 2) * percentage / 100, w - w * percentage / 100, (h / 2) * percentage / 100), 255);
-		dst->Blit(0, (h / 2) * percentage / 100, *screen1, Rect(0, (h / 2) * percentage / 100, w, h - h * percentage / 100), 255);
-		dst->Blit(- w / 2 + (w / 2) * percentage / 100, -h / 2 + (h / 2) * percentage / 100, *screen2, Rect(0, 0, w / 2, h / 2), 255);
-		dst->Blit(w - (w / 2) * percentage / 100, -h / 2 + (h / 2) * percentage / 100, *screen2, Rect(w / 2, 0, w / 2, h / 2), 255);
-		dst->Blit(w - (w / 2) * percentage / 100, h - (h / 2) * percentage / 100, *screen2, Rect(w / 2, h / 2, w / 2, h / 2), 255);
-		dst->Blit(- w / 2 + (w / 2) * percentage / 100, h - (h / 2) * percentage / 100, *screen2, Rect(0, h / 2, w / 2, h / 2), 255);
-		break;
+		return TransitionRenderer::CrossCombine;
 	case TransitionCrossDivision:
-		dst->Blit(-(w / 2) * percentage / 100, -(h / 2) * percentage / 100, *screen1, Rect(0, 0, w / 2, h / 2), 255);
-		dst->Blit(w / 2 + (w / 2) * percentage / 100, -(h / 2) * percentage / 100, *screen1, Rect(w / 2, 0, w / 2, h / 2), 255);
-		dst->Blit(w / 2 + (w / 2) * percentage / 100, h / 2 + (h / 2) * percentage / 100, *screen1, Rect(w / 2, h / 2, w / 2, h / 2), 255);
-		dst->Blit(-(w / 2) * percentage / 100, h / 2 + (h / 2) * percentage / 100, *screen1, Rect(0, h / 2, w / 2, h / 2), 255);
-		dst->Blit(w / 2 - (w / 2) * percentage / 100, 0, *screen2, Rect(w / 2 - (w / 2) * percentage / 100, 0, w * percentage / 100, h / 2 - (h / 2) * percentage / 100), 255);
-		dst->Blit(w / 2 - (w / 2) * percentage / 100, h / 2 + (h / 2) * percentage / 100, *screen2, Rect(w / 2 - (w / 2) * percentage / 100, h / 2 + (h / 2) * percentage / 100, w * percentage / 100, h / 2 + (h / 2) * percentage / 100), 255);
-		dst->Blit(0, h / 2 - (h / 2) * percentage / 100, *screen2, Rect(0, h / 2 - (h / 2) * percentage / 100, w, h * percentage / 100), 255);
-		break;
+		return TransitionRenderer::CrossDivision;
 	case TransitionZoomIn:
-		break;
+		return TransitionRenderer::ZoomIn;
 	case TransitionZoomOut:
-		break;
+		return TransitionRenderer::ZoomOut;
 	case TransitionMosaicIn:
-		break;
 	case TransitionMosaicOut:
-		break;
+		return TransitionRenderer::Mosaic;
 	case TransitionWaveIn:
-		break;
 	case TransitionWaveOut:
-		break;
+		return TransitionRenderer::Wave;
 	default:
+		return TransitionRenderer::Fade;
+	}
+}
+
+void Graphics::UpdateTransition() {
+	// screen1 is the screen before the transition, screen2 the one after it
+	BitmapRef dst = DisplayUi->GetDisplaySurface();
+
+	transition_frame++;
+
+	int percentage = transition_frame * 100 / transition_duration;
+
+	transition_frames_left--;
+
+	if (!transition_renderer) {
 		DisplayUi->CleanDisplay();
-		break;
+		return;
+	}
+
+	// The renderer only handles 32-bit screens of the display size
+	int w = DisplayUi->GetWidth();
+	int h = DisplayUi->GetHeight();
+	bool const supported = dst->bpp() == 32 && screen1->bpp() == 32 && screen2->bpp() == 32 &&
+		dst->width() >= w && dst->height() >= h &&
+		screen1->width() == w && screen1->height() == h &&
+		screen2->width() == w && screen2->height() == h;
+
+	if (!supported) {
+		dst->Blit(0, 0, *screen1, screen1->GetRect(), 255);
+		dst->Blit(0, 0, *screen2, screen2->GetRect(), 255 * percentage / 100);
+		return;
 	}
+
+	Rect const rect(0, 0, w, h);
+	transition_renderer->Render(dst->GetKernelRegion(rect), screen1->GetKernelRegion(rect),
+		screen2->GetKernelRegion(rect), percentage);
 }
 
 void Graphics::FrameReset() {
@@ -433,38 +596,25 @@ void Graphics::FrameReset() {
 
 void Graphics::RegisterDrawable(Drawable* drawable) {
 	if (drawable->IsGlobal()) {
-		global_state->drawable_list.push_back(drawable);
+		global_state->drawable_list.Add(drawable);
 	} else {
-		state->drawable_list.push_back(drawable);
+		state->drawable_list.Add(drawable);
 	}
-	UpdateZCallback();
 }
 
 void Graphics::RemoveDrawable(Drawable* drawable) {
-	std::list<Drawable*>::iterator it;
-	if (drawable->IsGlobal()) {
-		it = std::find(global_state->drawable_list.begin(), global_state->drawable_list.end(), drawable);
-		if (it != global_state->drawable_list.end()) { global_state->drawable_list.erase(it); }
-	} else {
-		it = std::find(state->drawable_list.begin(), state->drawable_list.end(), drawable);
-		if (it != state->drawable_list.end()) { state->drawable_list.erase(it); }
-	}
-}
-
-void Graphics::UpdateZCallback() {
-	state->zlist_dirty = true;
-	global_state->zlist_dirty = true;
+	DrawableList::Remove(drawable);
 }
 
-inline bool Graphics::SortDrawableList(const Drawable* first, const Drawable* second) {
-	if (first->GetZ() < second->GetZ()) return true;
-	return false;
+void Graphics::UpdateZCallback(Drawable* drawable) {
+	DrawableList::MarkDirty(drawable);
 }
 
 void Graphics::Push(bool draw_background){
 	stack.push_back(state);
 	state.reset(new State());
 	state->draw_background = draw_background;
+	InvalidateAll();
 }
 
 void Graphics::Pop() {
@@ -472,6 +622,7 @@ void Graphics::Pop() {
 		state = stack.back();
 		stack.pop_back();
 	}
+	InvalidateAll();
 }
 
 int Graphics::GetDefaultFps() {
@@ -20,9 +20,11 @@
 
 // Headers
 #include <string>
+#include <vector>
 
 #include "system.h"
 #include "drawable.h"
+#include "rect.h"
 
 /**
  * Graphics namespace.
@@ -123,7 +125,42 @@ namespace Graphics {
 	void RegisterDrawable(Drawable* drawable);
 	void RemoveDrawable(Drawable* drawable);
 
-	void UpdateZCallback();
+	/**
+	 * Reports a z change, the drawables are sorted again before the next
+	 * frame is drawn.
+	 *
+	 * @param drawable drawable whose z changed.
+	 */
+	void UpdateZCallback(Drawable* drawable);
+
+	/**
+	 * Marks a screen area for redrawing in the next frame.
+	 * Used by the drawables when dirty rectangle tracking is enabled.
+	 *
+	 * @param rect screen area that changed.
+	 */
+	void InvalidateRect(Rect const& rect);
+
+	/**
+	 * Marks the whole screen for redrawing in the next frame.
+	 */
+	void InvalidateAll();
+
+	/**
+	 * Gets the screen areas that are composited in the current frame.
+	 * The rectangles don't overlap. Without dirty rectangle tracking
+	 * this is the whole screen.
+	 *
+	 * @return composited rectangles.
+	 */
+	const std::vector<Rect>& GetDamageRects();
+
+	/**
+	 * Gets the amount of pixels composited in the last frame.
+	 *
+	 * @return composited pixels.
+	 */
+	int GetCompositedPixels();
 
 	void Push(bool draw_background = true);
 	void Pop();
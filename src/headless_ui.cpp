@@ -0,0 +1,163 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system.h"
+#ifdef USE_HEADLESS
+
+// Headers
+#include "headless_ui.h"
+#include "bitmap.h"
+#include "filefinder.h"
+#include "input.h"
+#include "main_data.h"
+#include "output.h"
+#include "player.h"
+#include <cstdio>
+#include <fstream>
+
+HeadlessUi::HeadlessUi(long width, long height) :
+	BaseUi(),
+	ticks(0),
+	displayed_frames(0),
+	script(Input::GetKeyNames()),
+	next_dump(0) {
+
+	current_display_mode.width = width;
+	current_display_mode.height = height;
+	current_display_mode.bpp = 32;
+	const DynamicFormat format(
+		32,
+		0x00FF0000,
+		0x0000FF00,
+		0x000000FF,
+		0xFF000000,
+		PF::NoAlpha);
+	Bitmap::SetFormat(Bitmap::ChooseFormat(format));
+	main_surface = Bitmap::Create(width, height, true, 32);
+
+#ifdef SUPPORT_AUDIO
+	audio_.reset(new EmptyAudio());
+#endif
+
+	LoadInputScript();
+}
+
+void HeadlessUi::LoadInputScript() {
+	if (Player::input_script.empty())
+		return;
+
+	std::ifstream stream(Player::input_script.c_str());
+	if (!stream) {
+		Output::Error("Could not open input script %s", Player::input_script.c_str());
+	}
+	if (!script.Load(stream)) {
+		Output::Error("Invalid input script %s, %s", Player::input_script.c_str(), script.GetError().c_str());
+	}
+	Output::Debug("Replaying %s, last key is released in frame %d",
+		Player::input_script.c_str(), script.GetLength());
+}
+
+#ifdef SUPPORT_AUDIO
+AudioInterface& HeadlessUi::GetAudio() {
+	return *audio_;
+}
+#endif
+
+uint32_t HeadlessUi::GetTicks() const {
+	return ticks;
+}
+
+void HeadlessUi::Sleep(uint32_t time) {
+	// Nothing to wait for, the next frame starts right away
+	ticks += time;
+}
+
+void HeadlessUi::BeginDisplayModeChange() {
+	// no-op
+}
+
+void HeadlessUi::EndDisplayModeChange() {
+	// no-op
+}
+
+void HeadlessUi::Resize(long /*width*/, long /*height*/) {
+	// no-op
+}
+
+void HeadlessUi::ToggleFullscreen() {
+	// no-op
+}
+
+void HeadlessUi::ToggleZoom() {
+	// no-op
+}
+
+bool HeadlessUi::IsFullscreen() {
+	return false;
+}
+
+void HeadlessUi::ProcessEvents() {
+	script.GetHeld(Player::GetFrames(), held);
+
+	keys.reset();
+	for (size_t i = 0; i < held.size(); ++i) {
+		keys[held[i]] = true;
+	}
+}
+
+void HeadlessUi::UpdateDisplay() {
+	// The surface is the display, nothing to transfer
+	ResetDirtyRects();
+	++displayed_frames;
+
+	int const frame = Player::GetFrames();
+	std::vector<int> const& dump_frames = Player::dump_frames;
+	if (next_dump < dump_frames.size() && dump_frames[next_dump] <= frame) {
+		DumpFrame(frame);
+		while (next_dump < dump_frames.size() && dump_frames[next_dump] <= frame) {
+			++next_dump;
+		}
+	}
+}
+
+void HeadlessUi::DumpFrame(int frame) {
+	std::string const dir = Player::dump_path.empty() ? Main_Data::GetSavePath() : Player::dump_path;
+
+	char name[32];
+	sprintf(name, "frame_%06d.png", frame);
+	std::string const path = FileFinder::MakePath(dir, name);
+
+	EASYRPG_SHARED_PTR<std::fstream> stream =
+		FileFinder::openUTF8(path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+	if (!stream || !main_surface->WritePNG(*stream)) {
+		Output::Warning("Could not write frame %s", path.c_str());
+	}
+}
+
+int HeadlessUi::GetDisplayedFrames() const {
+	return displayed_frames;
+}
+
+void HeadlessUi::SetTitle(const std::string& /* title */) {
+	// no-op
+}
+
+bool HeadlessUi::ShowCursor(bool /* flag */) {
+	return false;
+}
+
+#endif
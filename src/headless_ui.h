@@ -0,0 +1,96 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HEADLESS_UI_H_
+#define _HEADLESS_UI_H_
+
+// Headers
+#include "audio.h"
+#include "baseui.h"
+#include "input_script.h"
+#include "system.h"
+
+#include <boost/scoped_ptr.hpp>
+
+/**
+ * HeadlessUi class.
+ * Backend without window, input device or audio output for benchmarks and
+ * automated runs. The display is a software surface, the keys come from the
+ * --input-script and the frames listed in --dump-frames are written as PNG
+ * files. Time only advances when the player sleeps, so frames are never
+ * skipped and the game runs as fast as the CPU allows.
+ */
+class HeadlessUi : public BaseUi {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param width display width.
+	 * @param height display height.
+	 */
+	HeadlessUi(long width, long height);
+
+	/**
+	 * Inherited from BaseUi.
+	 */
+	/** @{ */
+
+	void BeginDisplayModeChange();
+	void EndDisplayModeChange();
+	void Resize(long width, long height);
+	void ToggleFullscreen();
+	void ToggleZoom();
+	void UpdateDisplay();
+	void SetTitle(const std::string &title);
+	bool ShowCursor(bool flag);
+
+	void ProcessEvents();
+
+	bool IsFullscreen();
+
+	uint32_t GetTicks() const;
+	void Sleep(uint32_t time_milli);
+#ifdef SUPPORT_AUDIO
+	AudioInterface& GetAudio();
+#endif
+
+	/** @} */
+
+	/**
+	 * @return number of UpdateDisplay calls.
+	 */
+	int GetDisplayedFrames() const;
+
+private:
+	void LoadInputScript();
+	void DumpFrame(int frame);
+
+	/** Virtual clock in ms, advanced by Sleep. */
+	uint32_t ticks;
+	int displayed_frames;
+
+	InputScript script;
+	std::vector<int> held;
+	/** Next entry of Player::dump_frames. */
+	size_t next_dump;
+
+#ifdef SUPPORT_AUDIO
+	boost::scoped_ptr<AudioInterface> audio_;
+#endif
+};
+
+#endif
@@ -43,8 +43,16 @@ static uint32_t get_4(const uint8_t *p)
 		((uint32_t) p[3] << 24);
 }
 
-void ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
-					   int& width, int& height, void*& pixels) {
+static bool Fail(std::string* error, const char* msg) {
+	if (error)
+		*error = msg;
+	else
+		Output::Error("%s", msg);
+	return false;
+}
+
+bool ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
+					   int& width, int& height, void*& pixels, std::string* error) {
 	pixels = NULL;
 
 	// BITMAPFILEHEADER structure
@@ -57,8 +65,7 @@ void ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
 	static const unsigned BITMAPFILEHEADER_SIZE = 14;
 
 	if (len < 64) {
-		Output::Error("Not a valid BMP file.");
-		return;
+		return Fail(error, "Not a valid BMP file.");
 	}
 
 	// file size is skipped because every program writes other data into
@@ -94,21 +101,18 @@ void ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
 
 	const int planes = (int) get_2(&data[BITMAPFILEHEADER_SIZE + 12]);
 	if (planes != 1) {
-		Output::Error("BMP planes is not 1.");
-		return;
+		return Fail(error, "BMP planes is not 1.");
 	}
 
 	const int depth = (int) get_2(&data[BITMAPFILEHEADER_SIZE + 14]);
 	if (depth != 8) {
-		Output::Error("BMP image is not 8-bit.");
-		return;
+		return Fail(error, "BMP image is not 8-bit.");
 	}
 
 	const int compression = get_4(&data[BITMAPFILEHEADER_SIZE + 16]);
 	static const int BI_RGB = 0;
 	if (compression != BI_RGB) {
-		Output::Error("BMP image is compressed.");
-		return;
+		return Fail(error, "BMP image is compressed.");
 	}
 
 	int num_colors = std::min((uint32_t) 256, get_4(&data[BITMAPFILEHEADER_SIZE + 32]));
@@ -139,20 +143,23 @@ void ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
 			*dst++ = (transparent && pix == 0) ? 0 : 255;
 		}
 	}
+
+	return true;
 }
 
-void ImageBMP::ReadBMP(FILE* stream, bool transparent,
-					int& width, int& height, void*& pixels) {
+bool ImageBMP::ReadBMP(FILE* stream, bool transparent,
+					int& width, int& height, void*& pixels, std::string* error) {
+	pixels = NULL;
+
 	fseek(stream, 0, SEEK_END);
 	long size = ftell(stream);
 	fseek(stream, 0, SEEK_SET);
 	std::vector<uint8_t> buffer(size);
 	long size_read = fread((void*) &buffer.front(), 1, size, stream);
 	if (size_read != size) {
-		Output::Error("Error reading BMP file.");
-		return;
+		return Fail(error, "Error reading BMP file.");
 	}
-	ReadBMP(&buffer.front(), (unsigned) size, transparent, width, height, pixels);
+	return ReadBMP(&buffer.front(), (unsigned) size, transparent, width, height, pixels, error);
 }
 
 #endif // SUPPORT_BMP
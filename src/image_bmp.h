@@ -22,10 +22,16 @@
 #ifdef SUPPORT_BMP
 
 #include <cstdio>
+#include <string>
 
 namespace ImageBMP {
-	void ReadBMP(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels);
-	void ReadBMP(FILE* stream, bool transparent, int& width, int& height, void*& pixels);
+	/**
+	 * Decodes a BMP image, error is handled like in ImagePNG::ReadPNG.
+	 *
+	 * @return whether the image was decoded.
+	 */
+	bool ReadBMP(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels, std::string* error = NULL);
+	bool ReadBMP(FILE* stream, bool transparent, int& width, int& height, void*& pixels, std::string* error = NULL);
 }
 
 #endif // SUPPORT_BMP
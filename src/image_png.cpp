@@ -34,12 +34,21 @@ static void read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
 	*bufp += length;
 }
 
-static void on_png_warning(png_structp, png_const_charp warn_msg) {
-	Output::Debug("%s", warn_msg);
+// The error pointer is the error string of ReadPNG, when set errors are
+// stored there and unwind to ReadPNG instead of being logged
+static void on_png_warning(png_structp png_ptr, png_const_charp warn_msg) {
+	if (!png_get_error_ptr(png_ptr))
+		Output::Debug("%s", warn_msg);
 }
 
-static void on_png_error(png_structp, png_const_charp error_msg) {
-	Output::Error("%s", error_msg);
+static void on_png_error(png_structp png_ptr, png_const_charp error_msg) {
+	std::string* error = (std::string*) png_get_error_ptr(png_ptr);
+	if (!error) {
+		Output::Error("%s", error_msg);
+		return;
+	}
+	*error = error_msg;
+	longjmp(png_jmpbuf(png_ptr), 1);
 }
 
 static void ReadPalettedData(png_struct*, png_info*, png_uint_32, png_uint_32, bool, uint32_t*);
@@ -48,20 +57,34 @@ static void ReadGrayAlphaData(png_struct*, png_info*, png_uint_32, png_uint_32,
 static void ReadRGBData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*);
 static void ReadRGBAData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*);
 
-void ImagePNG::ReadPNG(FILE* stream, const void* buffer, bool transparent,
-					int& width, int& height, void*& pixels) {
+static bool Fail(std::string* error, const char* msg) {
+	if (error)
+		*error = msg;
+	else
+		Output::Error("%s", msg);
+	return false;
+}
+
+bool ImagePNG::ReadPNG(FILE* stream, const void* buffer, bool transparent,
+					int& width, int& height, void*& pixels, std::string* error) {
 	pixels = NULL;
 
-	png_struct *png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, on_png_error, on_png_warning);
+	png_struct *png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp) error, on_png_error, on_png_warning);
 	if (png_ptr == NULL) {
-		Output::Error("Couldn't allocate PNG structure");
-		return;
+		return Fail(error, "Couldn't allocate PNG structure");
 	}
 
 	png_info *info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == NULL) {
-		Output::Error("Couldn't allocate PNG info structure");
-		return;
+		png_destroy_read_struct(&png_ptr, NULL, NULL);
+		return Fail(error, "Couldn't allocate PNG info structure");
+	}
+
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		free(pixels);
+		pixels = NULL;
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		return false;
 	}
 
 	if (stream != NULL)
@@ -101,6 +124,8 @@ void ImagePNG::ReadPNG(FILE* stream, const void* buffer, bool transparent,
 
 	png_read_end(png_ptr, NULL);
 	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+
+	return true;
 }
 
 static void ReadPalettedData(
@@ -117,7 +142,7 @@ static void ReadPalettedData(
 		png_read_update_info(png_ptr, info_ptr);
 
 		if (!png_get_valid(png_ptr, info_ptr, PNG_INFO_PLTE)) {
-			Output::Error("Palette PNG without PLTE block");
+			png_error(png_ptr, "Palette PNG without PLTE block");
 		}
 
 		png_colorp palette;
@@ -23,10 +23,19 @@
 
 #include <cstdio>
 #include <ostream>
+#include <string>
 #include "system.h"
 
 namespace ImagePNG {
-	void ReadPNG(FILE* stream, const void* buffer, bool transparent, int& width, int& height, void*& pixels);
+	/**
+	 * Decodes a PNG image from a stream or, when stream is NULL, a buffer.
+	 * Errors are reported with Output::Error unless error is passed, then
+	 * the message is stored there and nothing is logged, so the image can
+	 * be decoded outside of the main thread.
+	 *
+	 * @return whether the image was decoded.
+	 */
+	bool ReadPNG(FILE* stream, const void* buffer, bool transparent, int& width, int& height, void*& pixels, std::string* error = NULL);
 	bool WritePNG(std::ostream& os, uint32_t width, uint32_t height, uint32_t* data);
 }
 
@@ -26,13 +26,20 @@
 #include "output.h"
 #include "image_xyz.h"
 
-void ImageXYZ::ReadXYZ(const uint8_t* data, unsigned len, bool transparent,
-					int& width, int& height, void*& pixels) {
+static bool Fail(std::string* error, const char* msg) {
+	if (error)
+		*error = msg;
+	else
+		Output::Error("%s", msg);
+	return false;
+}
+
+bool ImageXYZ::ReadXYZ(const uint8_t* data, unsigned len, bool transparent,
+					int& width, int& height, void*& pixels, std::string* error) {
 	pixels = NULL;
 
     if (len < 8) {
-		Output::Error("Not a valid XYZ file.");
-		return;
+		return Fail(error, "Not a valid XYZ file.");
     }
 
     unsigned short w = data[4] + (data[5] << 8);
@@ -45,8 +52,7 @@ void ImageXYZ::ReadXYZ(const uint8_t* data, unsigned len, bool transparent,
 
     int status = uncompress(&dst_buffer.front(), &dst_size, src_buffer, src_size);
 	if (status != Z_OK) {
-		Output::Error("Error decompressing XYZ file.");
-		return;
+		return Fail(error, "Error decompressing XYZ file.");
 	}
     const uint8_t (*palette)[3] = (const uint8_t(*)[3]) &dst_buffer.front();
 
@@ -66,20 +72,23 @@ void ImageXYZ::ReadXYZ(const uint8_t* data, unsigned len, bool transparent,
 			*dst++ = (transparent && pix == 0) ? 0 : 255;
 		}
     }
+
+	return true;
 }
 
-void ImageXYZ::ReadXYZ(FILE* stream, bool transparent,
-					int& width, int& height, void*& pixels) {
+bool ImageXYZ::ReadXYZ(FILE* stream, bool transparent,
+					int& width, int& height, void*& pixels, std::string* error) {
+	pixels = NULL;
+
     fseek(stream, 0, SEEK_END);
     long size = ftell(stream);
     fseek(stream, 0, SEEK_SET);
 	std::vector<uint8_t> buffer(size);
     long size_read = fread((void*) &buffer.front(), 1, size, stream);
     if (size_read != size) {
-        Output::Error("Error reading XYZ file.");
-        return;
+        return Fail(error, "Error reading XYZ file.");
     }
-	ReadXYZ(&buffer.front(), (unsigned) size, transparent, width, height, pixels);
+	return ReadXYZ(&buffer.front(), (unsigned) size, transparent, width, height, pixels, error);
 }
 
 
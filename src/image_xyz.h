@@ -19,11 +19,17 @@
 #define _EASYRPG_IMAGE_XYZ_H_
 
 #include <cstdio>
+#include <string>
 #include "system.h"
 
 namespace ImageXYZ {
-	void ReadXYZ(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels);
-	void ReadXYZ(FILE* stream, bool transparent, int& width, int& height, void*& pixels);
+	/**
+	 * Decodes a XYZ image, error is handled like in ImagePNG::ReadPNG.
+	 *
+	 * @return whether the image was decoded.
+	 */
+	bool ReadXYZ(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels, std::string* error = NULL);
+	bool ReadXYZ(FILE* stream, bool transparent, int& width, int& height, void*& pixels, std::string* error = NULL);
 }
 
 #endif
@@ -21,6 +21,7 @@
 #include "system.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <boost/lambda/lambda.hpp>
 
 namespace Input {
@@ -224,3 +225,44 @@ std::vector<Input::InputButton> Input::GetAllReleased() {
 	}
 	return vector;
 }
+
+std::map<std::string, int> Input::GetKeyNames() {
+	std::map<std::string, int> names;
+	names["BACKSPACE"] = Keys::BACKSPACE;
+	names["TAB"] = Keys::TAB;
+	names["RETURN"] = Keys::RETURN;
+	names["ESCAPE"] = Keys::ESCAPE;
+	names["SPACE"] = Keys::SPACE;
+	names["PGUP"] = Keys::PGUP;
+	names["PGDN"] = Keys::PGDN;
+	names["HOME"] = Keys::HOME;
+	names["LEFT"] = Keys::LEFT;
+	names["UP"] = Keys::UP;
+	names["RIGHT"] = Keys::RIGHT;
+	names["DOWN"] = Keys::DOWN;
+	names["SHIFT"] = Keys::SHIFT;
+	names["CTRL"] = Keys::CTRL;
+	names["ALT"] = Keys::ALT;
+	names["MULTIPLY"] = Keys::MULTIPLY;
+	names["ADD"] = Keys::ADD;
+	names["SUBTRACT"] = Keys::SUBTRACT;
+	names["PERIOD"] = Keys::PERIOD;
+	names["DIVIDE"] = Keys::DIVIDE;
+
+	char name[4];
+	for (int i = 0; i < 26; ++i) {
+		sprintf(name, "%c", 'A' + i);
+		names[name] = Keys::A + i;
+	}
+	for (int i = 0; i < 10; ++i) {
+		sprintf(name, "N%d", i);
+		names[name] = Keys::N0 + i;
+		sprintf(name, "KP%d", i);
+		names[name] = Keys::KP0 + i;
+	}
+	for (int i = 0; i < 12; ++i) {
+		sprintf(name, "F%d", i + 1);
+		names[name] = Keys::F1 + i;
+	}
+	return names;
+}
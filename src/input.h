@@ -19,6 +19,8 @@
 #define _EASY_INPUT_H_
 
 // Headers
+#include <map>
+#include <string>
 #include <vector>
 #include <bitset>
 #include "system.h"
@@ -173,6 +175,14 @@ namespace Input {
 
 	bool IsWaitingInput();
 	void WaitInput(bool val);
+
+	/**
+	 * Gets the names of the keyboard keys, e.g. "UP", "Z", "N1" or "F12",
+	 * as used by input scripts.
+	 *
+	 * @return key index of every name.
+	 */
+	std::map<std::string, int> GetKeyNames();
 }
 
 #endif
@@ -55,6 +55,7 @@ namespace Input {
 		TOGGLE_FPS,
 		TAKE_SCREENSHOT,
 		SHOW_LOG,
+		TOGGLE_PROFILER,
 		BUTTON_COUNT
 	};
 
@@ -0,0 +1,213 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include "input_script.h"
+
+namespace {
+	bool ParseNumber(std::string const& str, int& value) {
+		if (str.empty())
+			return false;
+		char* end;
+		long const result = strtol(str.c_str(), &end, 10);
+		if (*end != '\0' || result < 0)
+			return false;
+		value = (int)result;
+		return true;
+	}
+}
+
+InputScript::InputScript(KeyMap const& keys) :
+	keys(keys), next(0), last_recorded(-1) {
+}
+
+bool InputScript::Earlier(Press const& a, Press const& b) {
+	return a.frame < b.frame;
+}
+
+bool InputScript::Load(std::istream& stream) {
+	presses.clear();
+	error.clear();
+	Rewind();
+
+	std::string line;
+	int line_number = 0;
+	while (std::getline(stream, line)) {
+		++line_number;
+
+		std::istringstream words(line);
+		std::string frame, duration, key;
+		if (!(words >> frame) || frame[0] == '#')
+			continue;
+
+		Press press;
+		if (!ParseNumber(frame, press.frame) || !(words >> duration) || !ParseNumber(duration, press.duration)) {
+			std::ostringstream message;
+			message << "line " << line_number << ": expected frame and duration";
+			error = message.str();
+			presses.clear();
+			return false;
+		}
+
+		bool has_key = false;
+		while (words >> key) {
+			KeyMap::const_iterator it = keys.find(key);
+			if (it == keys.end()) {
+				std::ostringstream message;
+				message << "line " << line_number << ": unknown key " << key;
+				error = message.str();
+				presses.clear();
+				return false;
+			}
+			press.key = it->second;
+			presses.push_back(press);
+			has_key = true;
+		}
+
+		if (!has_key) {
+			std::ostringstream message;
+			message << "line " << line_number << ": no keys";
+			error = message.str();
+			presses.clear();
+			return false;
+		}
+	}
+
+	std::stable_sort(presses.begin(), presses.end(), Earlier);
+	return true;
+}
+
+std::string const& InputScript::GetError() const {
+	return error;
+}
+
+void InputScript::GetHeld(int frame, std::vector<int>& held) {
+	while (next < presses.size() && presses[next].frame <= frame) {
+		active.push_back(presses[next]);
+		++next;
+	}
+
+	held.clear();
+	std::vector<Press>::iterator out = active.begin();
+	for (std::vector<Press>::iterator it = active.begin(); it != active.end(); ++it) {
+		// Released presses are dropped for good
+		if (frame >= it->frame + it->duration)
+			continue;
+		held.push_back(it->key);
+		*out++ = *it;
+	}
+	active.erase(out, active.end());
+}
+
+void InputScript::Rewind() {
+	next = 0;
+	active.clear();
+}
+
+int InputScript::GetLength() const {
+	int length = 0;
+	for (size_t i = 0; i < presses.size(); ++i) {
+		length = std::max(length, presses[i].frame + presses[i].duration);
+	}
+	return length;
+}
+
+void InputScript::Record(int frame, std::vector<int> const& held) {
+	if (last_recorded < 0) {
+		presses.clear();
+		Rewind();
+	}
+
+	// Released keys
+	std::map<int, int>::iterator it = recording.begin();
+	while (it != recording.end()) {
+		if (std::find(held.begin(), held.end(), it->first) == held.end()) {
+			Press const press = { it->second, frame - it->second, it->first };
+			presses.push_back(press);
+			recording.erase(it++);
+		} else {
+			++it;
+		}
+	}
+
+	// Pressed keys
+	for (size_t i = 0; i < held.size(); ++i) {
+		recording.insert(std::make_pair(held[i], frame));
+	}
+
+	last_recorded = frame;
+}
+
+void InputScript::Save(std::ostream& stream) {
+	for (std::map<int, int>::const_iterator it = recording.begin(); it != recording.end(); ++it) {
+		Press const press = { it->second, last_recorded + 1 - it->second, it->first };
+		presses.push_back(press);
+	}
+	recording.clear();
+	last_recorded = -1;
+	std::stable_sort(presses.begin(), presses.end(), Earlier);
+
+	std::map<int, std::string> names;
+	for (KeyMap::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+		names.insert(std::make_pair(it->second, it->first));
+	}
+
+	stream << "# frame duration keys\n";
+	for (size_t i = 0; i < presses.size(); ++i) {
+		std::map<int, std::string>::const_iterator name = names.find(presses[i].key);
+		if (name == names.end())
+			continue;
+		stream << presses[i].frame << " " << presses[i].duration << " " << name->second << "\n";
+	}
+}
+
+bool InputScript::ParseFrameList(std::string const& list, std::vector<int>& frames) {
+	frames.clear();
+
+	std::istringstream items(list);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		int first, last, step = 1;
+
+		size_t const colon = item.find(':');
+		if (colon != std::string::npos) {
+			if (!ParseNumber(item.substr(colon + 1), step) || step == 0)
+				return false;
+			item.erase(colon);
+		}
+
+		size_t const dash = item.find('-');
+		if (dash == std::string::npos) {
+			if (!ParseNumber(item, first) || step != 1)
+				return false;
+			last = first;
+		} else if (!ParseNumber(item.substr(0, dash), first) || !ParseNumber(item.substr(dash + 1), last) || last < first) {
+			return false;
+		}
+
+		for (int frame = first; frame <= last; frame += step) {
+			frames.push_back(frame);
+		}
+	}
+
+	std::sort(frames.begin(), frames.end());
+	frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+	return true;
+}
@@ -0,0 +1,135 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_INPUT_SCRIPT_H_
+#define _EASYRPG_INPUT_SCRIPT_H_
+
+// Headers
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * InputScript class.
+ * Key presses of a scripted run, one press per line:
+ *
+ *     # frame duration keys...
+ *     60 1 Z
+ *     120 30 DOWN
+ *     200 2 SHIFT X
+ *
+ * A press holds its keys from the given frame for duration frames.
+ * Empty lines and lines starting with # are ignored.
+ */
+class InputScript {
+public:
+	/** Key name to key index, names are case sensitive. */
+	typedef std::map<std::string, int> KeyMap;
+
+	/**
+	 * Constructor.
+	 *
+	 * @param keys keys the script may use.
+	 */
+	explicit InputScript(KeyMap const& keys);
+
+	/**
+	 * Reads a script, replacing the loaded presses.
+	 *
+	 * @param stream script.
+	 * @return whether the script is valid, see GetError otherwise.
+	 */
+	bool Load(std::istream& stream);
+
+	/**
+	 * @return description of the last Load error.
+	 */
+	std::string const& GetError() const;
+
+	/**
+	 * Gets the keys held in a frame. The frames passed to consecutive calls
+	 * must not decrease, use Rewind to start over.
+	 *
+	 * @param frame frame number.
+	 * @param held receives the held keys, a key held by overlapping presses
+	 *             is contained more than once.
+	 */
+	void GetHeld(int frame, std::vector<int>& held);
+
+	/**
+	 * Restarts the script at frame 0.
+	 */
+	void Rewind();
+
+	/**
+	 * @return frame after the last release, 0 for an empty script.
+	 */
+	int GetLength() const;
+
+	/**
+	 * Records the keys held in a frame, the recorded presses replace the
+	 * loaded ones once the recording is saved. The frames passed to
+	 * consecutive calls must increase.
+	 *
+	 * @param frame frame number.
+	 * @param held held keys.
+	 */
+	void Record(int frame, std::vector<int> const& held);
+
+	/**
+	 * Ends the recording, keys still held are released after the last
+	 * recorded frame, and writes the presses in the format Load reads.
+	 *
+	 * @param stream destination.
+	 */
+	void Save(std::ostream& stream);
+
+	/**
+	 * Parses a list of frames like "60,120,300-400:10", a range adds every
+	 * frame between its ends, or every nth frame with a ":n" step.
+	 *
+	 * @param list frame list.
+	 * @param frames receives the frames in ascending order.
+	 * @return whether the list is valid.
+	 */
+	static bool ParseFrameList(std::string const& list, std::vector<int>& frames);
+
+private:
+	struct Press {
+		int frame;
+		int duration;
+		int key;
+	};
+
+	static bool Earlier(Press const& a, Press const& b);
+
+	KeyMap keys;
+	std::string error;
+	/** Presses sorted by frame. */
+	std::vector<Press> presses;
+	/** First press that did not start yet. */
+	size_t next;
+	/** Started presses that may still be held. */
+	std::vector<Press> active;
+	/** Start frame of every key held while recording. */
+	std::map<int, int> recording;
+	int last_recorded;
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <set>
+#include <string>
+#include <vector>
+
+#include "async_handler.h"
+#include "baseui.h"
+#include "cache.h"
+#include "data.h"
+#include "game_map.h"
+#include "map_prefetcher.h"
+#include "output.h"
+
+namespace {
+	typedef std::pair<std::string, std::string> asset_type;
+
+	std::vector<FileRequestBinding> bindings;
+	int prefetch_map_id = 0;
+	int assets_pending = 0;
+	uint32_t start_ticks = 0;
+	int latency = -1;
+
+	void OnAllAssetsReady() {
+		latency = (int)(DisplayUi->GetTicks() - start_ticks);
+		Output::Debug("Map %d: assets ready after %d ms", prefetch_map_id, latency);
+	}
+
+	void OnAssetReady(FileRequestResult* result) {
+		// Load images into the Cache, it keeps them alive until they are used
+		if (result->success) {
+			if (result->directory == "ChipSet") {
+				Cache::Chipset(result->file);
+			} else if (result->directory == "CharSet") {
+				Cache::Charset(result->file);
+			} else if (result->directory == "Panorama") {
+				Cache::Panorama(result->file);
+			}
+		}
+
+		if (--assets_pending == 0) {
+			OnAllAssetsReady();
+		}
+	}
+
+	void CollectMusic(int map_id, std::set<asset_type>& assets) {
+		int index = Game_Map::GetMapIndex(map_id);
+
+		// Music type 0 inherits the BGM of the parent map
+		while (index > -1 && Data::treemap.maps[index].music_type == 0 &&
+			Game_Map::GetMapIndex(Data::treemap.maps[index].parent_map) != index) {
+			index = Game_Map::GetMapIndex(Data::treemap.maps[index].parent_map);
+		}
+
+		if (index > -1 && Data::treemap.maps[index].music_type != 1 &&
+			!Data::treemap.maps[index].music.name.empty() &&
+			Data::treemap.maps[index].music.name != "(OFF)") {
+			assets.insert(asset_type("Music", Data::treemap.maps[index].music.name));
+		}
+	}
+}
+
+void MapPrefetcher::Prefetch(const RPG::Map& map, int map_id) {
+	std::set<asset_type> assets;
+
+	if (map.chipset_id > 0 && map.chipset_id <= (int)Data::chipsets.size()) {
+		const std::string& chipset = Data::chipsets[map.chipset_id - 1].chipset_name;
+		if (!chipset.empty()) {
+			assets.insert(asset_type("ChipSet", chipset));
+		}
+	}
+
+	if (map.parallax_flag && !map.parallax_name.empty()) {
+		assets.insert(asset_type("Panorama", map.parallax_name));
+	}
+
+	for (const RPG::Event& event : map.events) {
+		for (const RPG::EventPage& page : event.pages) {
+			if (!page.character_name.empty()) {
+				assets.insert(asset_type("CharSet", page.character_name));
+			}
+		}
+	}
+
+	CollectMusic(map_id, assets);
+
+	// Unbinds the listeners of the previous prefetch
+	bindings.clear();
+
+	prefetch_map_id = map_id;
+	start_ticks = DisplayUi->GetTicks();
+	latency = -1;
+
+	// Requests can finish inside Start, hold one extra count until all
+	// requests are started
+	assets_pending = assets.size() + 1;
+
+	for (const asset_type& asset : assets) {
+		FileRequestAsync* request = AsyncHandler::RequestFile(asset.first, asset.second);
+		bindings.push_back(request->Bind(&OnAssetReady));
+		request->Start();
+	}
+
+	if (--assets_pending == 0) {
+		OnAllAssetsReady();
+	}
+}
+
+int MapPrefetcher::GetMapId() {
+	return prefetch_map_id;
+}
+
+bool MapPrefetcher::IsReady() {
+	return assets_pending <= 0;
+}
+
+int MapPrefetcher::GetLatency() {
+	return latency;
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_MAP_PREFETCHER_H_
+#define _EASYRPG_MAP_PREFETCHER_H_
+
+// Headers
+#include "rpg_map.h"
+
+/**
+ * MapPrefetcher namespace.
+ * Requests all assets of a map (chipset, panorama, charsets of all event
+ * pages and the BGM) at once, so they are loaded while the screen
+ * transition is still running instead of one at a time when the sprites
+ * update for the first time.
+ */
+namespace MapPrefetcher {
+	/**
+	 * Starts loading the assets referenced by a map.
+	 * Cancels the listeners of a previous prefetch.
+	 *
+	 * @param map map data.
+	 * @param map_id ID of the map.
+	 */
+	void Prefetch(const RPG::Map& map, int map_id);
+
+	/**
+	 * @return ID of the map of the last prefetch, 0 if none.
+	 */
+	int GetMapId();
+
+	/**
+	 * @return whether all assets of the last prefetch are loaded.
+	 */
+	bool IsReady();
+
+	/**
+	 * Gets the time between starting the last prefetch and all its
+	 * assets being loaded.
+	 *
+	 * @return latency in ms, -1 while assets are pending.
+	 */
+	int GetLatency();
+}
+
+#endif
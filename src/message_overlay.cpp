@@ -31,7 +31,8 @@ MessageOverlay::MessageOverlay() :
 	message_max(10),
 	dirty(false),
 	counter(0),
-	show_all(false) {
+	show_all(false),
+	damage_visible(false) {
 	
 	black = Bitmap::Create(DisplayUi->GetWidth(), text_height, Color());
 
@@ -41,6 +42,9 @@ MessageOverlay::MessageOverlay() :
 }
 
 MessageOverlay::~MessageOverlay() {
+	if (damage_visible) {
+		Graphics::InvalidateRect(Rect(ox, oy, bitmap->GetWidth(), bitmap->GetHeight()));
+	}
 	Graphics::RemoveDrawable(this);
 }
 
@@ -88,6 +92,19 @@ void MessageOverlay::Draw() {
 	dirty = false;
 }
 
+bool MessageOverlay::ReportDamage() {
+	bool visible = IsAnyMessageVisible() || show_all;
+
+	// The hide timer advances in Draw, so keep the area damaged while shown
+	if (visible || damage_visible || dirty) {
+		Graphics::InvalidateRect(Rect(ox, oy, bitmap->GetWidth(), bitmap->GetHeight()));
+	}
+
+	damage_visible = visible;
+
+	return true;
+}
+
 int MessageOverlay::GetZ() const {
 	return z;
 }
@@ -44,6 +44,8 @@ public:
 
 	void Draw();
 
+	bool ReportDamage();
+
 	int GetZ() const;
 
 	DrawableType GetType() const;
@@ -76,6 +78,8 @@ private:
 	int counter;
 
 	bool show_all;
+
+	bool damage_visible;
 };
 
 #endif
@@ -93,4 +93,10 @@
 
 //#define USE_FIXED_TIMESTEP_FPS
 
+/**
+ * Frame profiler (--profile), PROFILE_SCOPE compiles to nothing without it.
+ * Off by default, builds enable it with PROFILER=1 or -DENABLE_PROFILER.
+ */
+//#define ENABLE_PROFILER
+
 #endif
@@ -0,0 +1,182 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cstring>
+#include "particle_renderer.h"
+
+using BitmapKernels::OverUn8x4;
+
+ParticleRenderer::Sprite ParticleRenderer::CreateSprite(const uint8_t* indices, int width, int height, const uint32_t* palette) {
+	Sprite sprite;
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			uint8_t const index = indices[y * width + x];
+			if (index == 0)
+				continue;
+			Point point = { (int16_t)x, (int16_t)y, palette[index] };
+			sprite.push_back(point);
+		}
+	}
+	return sprite;
+}
+
+uint32_t ParticleRenderer::GetPixel(BitmapKernels::Channels const& channels, int red, int green, int blue, int opacity) {
+	uint32_t const pixel = ((uint32_t)red << channels.r) | ((uint32_t)green << channels.g) |
+		((uint32_t)blue << channels.b) | (0xFFu << channels.a);
+	// Same as blitting an opaque pixel with the opacity
+	return BitmapKernels::MulUn8x4(pixel, opacity);
+}
+
+ParticleRenderer::ParticleRenderer(int width, int height, BitmapKernels::Channels const& channels) :
+	width(width),
+	height(height),
+	alpha_shift(channels.a),
+	layer(width * height, 0),
+	span_begin(height, width),
+	span_end(height, 0) {
+	touched_rows.reserve(height);
+}
+
+void ParticleRenderer::Plot(const int* x, const int* y, size_t count, Sprite const& sprite) {
+	for (size_t i = 0; i < count; ++i) {
+		for (Sprite::const_iterator it = sprite.begin(); it != sprite.end(); ++it) {
+			int const px = x[i] + it->x;
+			int const py = y[i] + it->y;
+			if (px < 0 || px >= width || py < 0 || py >= height)
+				continue;
+
+			uint32_t& dst = layer[py * width + px];
+			dst = OverUn8x4(it->pixel, dst, alpha_shift);
+
+			if (span_begin[py] >= span_end[py]) {
+				touched_rows.push_back(py);
+				span_begin[py] = px;
+				span_end[py] = px + 1;
+			} else {
+				span_begin[py] = std::min(span_begin[py], px);
+				span_end[py] = std::max(span_end[py], px + 1);
+			}
+		}
+	}
+}
+
+void ParticleRenderer::CompositeRow(uint32_t* out, int y, uint32_t background, int begin, int end) {
+	if (background) {
+		for (int x = begin; x < end; ++x) {
+			out[x] = OverUn8x4(background, out[x], alpha_shift);
+		}
+	}
+
+	begin = std::max(begin, span_begin[y]);
+	end = std::min(end, span_end[y]);
+
+	uint32_t const* row = &layer[y * width];
+	for (int x = begin; x < end; ++x) {
+		if (row[x])
+			out[x] = OverUn8x4(row[x], out[x], alpha_shift);
+	}
+}
+
+void ParticleRenderer::ClearRow(int y) {
+	int const begin = span_begin[y];
+	int const end = span_end[y];
+	if (begin >= end)
+		return;
+
+	memset(&layer[y * width + begin], 0, (end - begin) * 4);
+	span_begin[y] = width;
+	span_end[y] = 0;
+}
+
+void ParticleRenderer::Composite(BitmapKernels::Region const& dst, uint32_t background) {
+	// The layer rows are cleared while they are still in the cache
+	if (background) {
+		for (int y = 0; y < height; ++y) {
+			CompositeRow(reinterpret_cast<uint32_t*>(dst.pixels + y * dst.pitch), y, background, 0, width);
+			ClearRow(y);
+		}
+	} else {
+		for (std::vector<int>::const_iterator it = touched_rows.begin(); it != touched_rows.end(); ++it) {
+			CompositeRow(reinterpret_cast<uint32_t*>(dst.pixels + *it * dst.pitch), *it, 0, 0, width);
+			ClearRow(*it);
+		}
+	}
+	touched_rows.clear();
+}
+
+void ParticleRenderer::Composite(BitmapKernels::Region const& dst, uint32_t background, std::vector<Area> const& areas) {
+	if (areas.empty()) {
+		Composite(dst, background);
+		return;
+	}
+
+	for (int y = 0; y < height; ++y) {
+		if (background || span_begin[y] < span_end[y]) {
+			// Merge the overlapping areas, no pixel may be blended twice
+			row_spans.clear();
+			for (std::vector<Area>::const_iterator it = areas.begin(); it != areas.end(); ++it) {
+				int const begin = std::max(it->x, 0);
+				int const end = std::min(it->x + it->width, width);
+				if (y >= it->y && y < it->y + it->height && begin < end) {
+					row_spans.push_back(std::make_pair(begin, end));
+				}
+			}
+			std::sort(row_spans.begin(), row_spans.end());
+
+			uint32_t* out = reinterpret_cast<uint32_t*>(dst.pixels + y * dst.pitch);
+			int covered = 0;
+			for (size_t i = 0; i < row_spans.size(); ++i) {
+				int const begin = std::max(row_spans[i].first, covered);
+				int const end = row_spans[i].second;
+				if (begin < end) {
+					CompositeRow(out, y, background, begin, end);
+					covered = end;
+				}
+			}
+		}
+		ClearRow(y);
+	}
+	touched_rows.clear();
+}
+
+int ParticleRenderer::GetTouchedRows() const {
+	return (int)touched_rows.size();
+}
+
+void ParticleRenderer::GetTouchedAreas(std::vector<Area>& areas) const {
+	areas.clear();
+	if (touched_rows.empty())
+		return;
+
+	for (int y = 0; y < height; ++y) {
+		if (span_begin[y] >= span_end[y])
+			continue;
+
+		if (!areas.empty() && areas.back().y + areas.back().height == y) {
+			Area& area = areas.back();
+			int const begin = std::min(area.x, span_begin[y]);
+			area.width = std::max(area.x + area.width, span_end[y]) - begin;
+			area.x = begin;
+			++area.height;
+		} else {
+			Area const area = { span_begin[y], y, span_end[y] - span_begin[y], 1 };
+			areas.push_back(area);
+		}
+	}
+}
@@ -0,0 +1,152 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_PARTICLE_RENDERER_H_
+#define _EASYRPG_PARTICLE_RENDERER_H_
+
+// Headers
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "bitmap_kernels.h"
+
+/**
+ * ParticleRenderer class.
+ * Draws many small sprites (rain drops, snow flakes, sand) into a 32-bit
+ * premultiplied layer and blends the layer over the screen.
+ * Only the pixels of a sprite that are not transparent are plotted and the
+ * renderer remembers the span of every row it touched, so compositing and
+ * clearing the layer only visit these rows.
+ */
+class ParticleRenderer {
+public:
+	/** Visible pixel of a sprite. */
+	struct Point {
+		/** Offset from the particle position. */
+		int16_t x;
+		int16_t y;
+		/** Premultiplied pixel. */
+		uint32_t pixel;
+	};
+
+	/** Visible pixels of a sprite, in row order. */
+	typedef std::vector<Point> Sprite;
+
+	/** Part of the screen, may overlap other areas. */
+	struct Area {
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	/**
+	 * Creates a sprite from a palette image.
+	 *
+	 * @param indices palette index of every pixel, 0 is transparent.
+	 * @param width image width.
+	 * @param height image height.
+	 * @param palette premultiplied pixels, see GetPixel.
+	 * @return sprite.
+	 */
+	static Sprite CreateSprite(const uint8_t* indices, int width, int height, const uint32_t* palette);
+
+	/**
+	 * Converts a color to a premultiplied pixel.
+	 *
+	 * @param channels pixel layout.
+	 * @param red red component.
+	 * @param green green component.
+	 * @param blue blue component.
+	 * @param opacity alpha of the color.
+	 * @return pixel.
+	 */
+	static uint32_t GetPixel(BitmapKernels::Channels const& channels, int red, int green, int blue, int opacity);
+
+	/**
+	 * Constructor.
+	 *
+	 * @param width layer width.
+	 * @param height layer height.
+	 * @param channels pixel layout of the layer and the screen.
+	 */
+	ParticleRenderer(int width, int height, BitmapKernels::Channels const& channels);
+
+	/**
+	 * Plots a sprite at every position. Pixels outside the layer are
+	 * skipped.
+	 *
+	 * @param x horizontal positions.
+	 * @param y vertical positions.
+	 * @param count number of particles.
+	 * @param sprite sprite to draw.
+	 */
+	void Plot(const int* x, const int* y, size_t count, Sprite const& sprite);
+
+	/**
+	 * Blends a background color and the layer over the screen in one pass
+	 * and clears the touched rows of the layer for the next frame.
+	 *
+	 * @param dst screen, at least as large as the layer.
+	 * @param background premultiplied pixel blended under the particles,
+	 *                   0 for none.
+	 */
+	void Composite(BitmapKernels::Region const& dst, uint32_t background);
+
+	/**
+	 * Like Composite, but only the pixels inside the areas are drawn, e.g.
+	 * the damaged parts of a screen that is not redrawn completely.
+	 *
+	 * @param dst screen, at least as large as the layer.
+	 * @param background premultiplied pixel blended under the particles,
+	 *                   0 for none.
+	 * @param areas areas to draw, all of the screen when empty.
+	 */
+	void Composite(BitmapKernels::Region const& dst, uint32_t background, std::vector<Area> const& areas);
+
+	/**
+	 * @return number of rows plotted since the last Composite.
+	 */
+	int GetTouchedRows() const;
+
+	/**
+	 * Gets the parts of the layer plotted since the last Composite, one
+	 * area for every run of touched rows.
+	 *
+	 * @param areas receives the areas, top to bottom.
+	 */
+	void GetTouchedAreas(std::vector<Area>& areas) const;
+
+private:
+	void CompositeRow(uint32_t* out, int y, uint32_t background, int begin, int end);
+	void ClearRow(int y);
+
+	int width;
+	int height;
+	int alpha_shift;
+	std::vector<uint32_t> layer;
+	/** Touched pixels of every row, empty when begin >= end. */
+	std::vector<int> span_begin;
+	std::vector<int> span_end;
+	/** Rows in the order they were touched first. */
+	std::vector<int> touched_rows;
+	/** Spans of the areas in the current row. */
+	std::vector<std::pair<int, int> > row_spans;
+};
+
+#endif
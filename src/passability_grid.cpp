@@ -0,0 +1,177 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "passability_grid.h"
+#include "map_data.h"
+
+namespace {
+	int GetPassage(std::vector<unsigned char> const& passages, int chip) {
+		return (chip >= 0 && chip < (int)passages.size()) ? passages[chip] : 0;
+	}
+
+	bool IsWallAutotile(int autotile_id) {
+		return (autotile_id >= 20 && autotile_id <= 23) ||
+			(autotile_id >= 33 && autotile_id <= 37) ||
+			autotile_id == 42 || autotile_id == 43 ||
+			autotile_id == 45 || autotile_id == 46;
+	}
+}
+
+PassabilityGrid::PassabilityGrid() :
+	width(0), height(0) {
+}
+
+void PassabilityGrid::Build(int width, int height,
+	std::vector<int16_t> const& lower_layer,
+	std::vector<int16_t> const& upper_layer,
+	std::vector<unsigned char> const& passages_down,
+	std::vector<unsigned char> const& passages_up,
+	std::vector<uint8_t> const& lower_tiles,
+	std::vector<uint8_t> const& upper_tiles,
+	std::vector<uint8_t> const& terrain_flags) {
+
+	this->width = width;
+	this->height = height;
+	this->lower_layer = lower_layer;
+	this->upper_layer = upper_layer;
+	this->passages_down = passages_down;
+	this->passages_up = passages_up;
+	this->lower_tiles = lower_tiles;
+	this->upper_tiles = upper_tiles;
+	this->terrain_flags = terrain_flags;
+
+	int const count = width * height;
+	this->lower_layer.resize(count, 0);
+	this->upper_layer.resize(count, BLOCK_F);
+	flags.assign(count, 0);
+
+	lower_users.assign(BLOCK_E_TILES, std::vector<int>());
+	upper_users.assign(BLOCK_F_TILES, std::vector<int>());
+
+	for (int i = 0; i < count; ++i) {
+		int const lower = this->lower_layer[i] - BLOCK_E;
+		if (lower >= 0 && lower < BLOCK_E_TILES) {
+			lower_users[lower].push_back(i);
+		}
+		int const upper = this->upper_layer[i] - BLOCK_F;
+		if (upper >= 0 && upper < BLOCK_F_TILES) {
+			upper_users[upper].push_back(i);
+		}
+		Update(i);
+	}
+}
+
+void PassabilityGrid::Clear() {
+	width = 0;
+	height = 0;
+	flags.clear();
+	lower_layer.clear();
+	upper_layer.clear();
+	lower_users.clear();
+	upper_users.clear();
+}
+
+void PassabilityGrid::SubstituteDown(int old_id, int new_id) {
+	for (size_t i = 0; i < lower_tiles.size(); ++i) {
+		if (lower_tiles[i] == old_id) {
+			lower_tiles[i] = (uint8_t) new_id;
+			if (i < lower_users.size()) {
+				for (int tile : lower_users[i]) {
+					Update(tile);
+				}
+			}
+		}
+	}
+}
+
+void PassabilityGrid::SubstituteUp(int old_id, int new_id) {
+	for (size_t i = 0; i < upper_tiles.size(); ++i) {
+		if (upper_tiles[i] == old_id) {
+			upper_tiles[i] = (uint8_t) new_id;
+			if (i < upper_users.size()) {
+				for (int tile : upper_users[i]) {
+					Update(tile);
+				}
+			}
+		}
+	}
+}
+
+int PassabilityGrid::GetTerrainChip(int tile_id, std::vector<uint8_t> const& lower_tiles) {
+	int chip_index =
+		(tile_id < 0)? 0 :
+		(tile_id < 3050)?  0 + tile_id/1000 :
+		(tile_id < 4000)?  4 + (tile_id-3050)/50 :
+		(tile_id < 5000)?  6 + (tile_id-4000)/50 :
+		(tile_id < 5144)? 18 + (tile_id-5000) :
+		0;
+
+	// Apply tile substitution
+	if (chip_index >= 18 && chip_index <= 144 && chip_index - 18 < (int)lower_tiles.size())
+		chip_index = lower_tiles[chip_index - 18] + 18;
+
+	return chip_index;
+}
+
+void PassabilityGrid::Update(int tile_index) {
+	int result = 0;
+
+	// Upper layer
+	int const upper_raw = upper_layer[tile_index];
+	int upper_chip = upper_raw - BLOCK_F;
+	if (upper_chip >= 0 && upper_chip < (int)upper_tiles.size()) {
+		upper_chip = upper_tiles[upper_chip];
+	}
+	int const up = GetPassage(passages_up, upper_chip);
+	result |= (up & 0x0F) << UpperShift;
+	if ((up & Passable::Above) != 0)
+		result |= Above;
+	if (upper_raw >= BLOCK_F && (up & Passable::Counter) != 0)
+		result |= Counter;
+
+	// Lower layer
+	int const lower_raw = lower_layer[tile_index];
+	int lower_chip;
+	bool wall = false;
+
+	if (lower_raw >= BLOCK_E) {
+		lower_chip = lower_raw - BLOCK_E;
+		lower_chip = (lower_chip < (int)lower_tiles.size()) ? lower_tiles[lower_chip] + 18 : -1;
+
+	} else if (lower_raw >= BLOCK_D) {
+		lower_chip = (lower_raw - BLOCK_D) / 50 + 6;
+		wall = (GetPassage(passages_down, lower_chip) & Passable::Wall) != 0 &&
+			IsWallAutotile((lower_raw - BLOCK_D) % 50);
+
+	} else if (lower_raw >= BLOCK_C) {
+		lower_chip = (lower_raw - BLOCK_C) / 50 + 3;
+
+	} else {
+		lower_chip = lower_raw / 1000;
+	}
+
+	// Walls of autotiles can be passed below star tiles
+	result |= wall ? LowerMask : (GetPassage(passages_down, lower_chip) & LowerMask);
+
+	int const terrain_chip = GetTerrainChip(lower_raw, lower_tiles);
+	int const terrain = terrain_chip < (int)terrain_flags.size() ?
+		terrain_flags[terrain_chip] : (TerrainAirship | TerrainAirshipLand);
+	result |= terrain << TerrainShift;
+
+	flags[tile_index] = (uint16_t) result;
+}
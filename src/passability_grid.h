@@ -0,0 +1,170 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_PASSABILITY_GRID_H_
+#define _EASYRPG_PASSABILITY_GRID_H_
+
+// Headers
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * PassabilityGrid class.
+ * Passability of every tile of a map, derived once from the layers, the
+ * chipset passages, the tile substitutions and the terrains instead of on
+ * every movement check.
+ * Every tile has 4 direction bits for the lower and for the upper layer,
+ * the star and counter flags of the upper layer and the vehicle flags of
+ * its terrain. A substitution only recomputes the tiles using the
+ * substituted chip.
+ * Events with a tile graphic are not part of the grid, they move and
+ * change pages and are checked on top of it.
+ */
+class PassabilityGrid {
+public:
+	/** Terrain flags, given per chip to Build. */
+	enum TerrainFlag {
+		TerrainBoat = 0x01,
+		TerrainShip = 0x02,
+		TerrainAirship = 0x04,
+		TerrainAirshipLand = 0x08
+	};
+
+	/** Flags of a tile. */
+	enum Flag {
+		/** Passable directions of the lower layer, see Passable. */
+		LowerMask = 0x000F,
+		/** Passable directions of the upper layer, shifted by UpperShift. */
+		UpperMask = 0x00F0,
+		UpperShift = 4,
+		/** Upper tile is drawn above characters, the lower tile decides. */
+		Above = 0x0100,
+		Counter = 0x0200,
+		/** Terrain flags, shifted by TerrainShift. */
+		TerrainShift = 10,
+		Boat = TerrainBoat << TerrainShift,
+		Ship = TerrainShip << TerrainShift,
+		Airship = TerrainAirship << TerrainShift,
+		AirshipLand = TerrainAirshipLand << TerrainShift
+	};
+
+	PassabilityGrid();
+
+	/**
+	 * Computes the flags of all tiles.
+	 *
+	 * @param width map width.
+	 * @param height map height.
+	 * @param lower_layer lower layer tile IDs.
+	 * @param upper_layer upper layer tile IDs.
+	 * @param passages_down chipset passages of the lower chips.
+	 * @param passages_up chipset passages of the upper chips.
+	 * @param lower_tiles lower chip substitutions.
+	 * @param upper_tiles upper chip substitutions.
+	 * @param terrain_flags TerrainFlag of every chip as numbered by
+	 *                      GetTerrainChip.
+	 */
+	void Build(int width, int height,
+		std::vector<int16_t> const& lower_layer,
+		std::vector<int16_t> const& upper_layer,
+		std::vector<unsigned char> const& passages_down,
+		std::vector<unsigned char> const& passages_up,
+		std::vector<uint8_t> const& lower_tiles,
+		std::vector<uint8_t> const& upper_tiles,
+		std::vector<uint8_t> const& terrain_flags);
+
+	/**
+	 * Removes all tiles.
+	 */
+	void Clear();
+
+	/**
+	 * Replaces a lower chip like Game_Map::SubstituteDown.
+	 *
+	 * @param old_id chip to replace.
+	 * @param new_id replacement.
+	 */
+	void SubstituteDown(int old_id, int new_id);
+
+	/**
+	 * Replaces an upper chip like Game_Map::SubstituteUp.
+	 *
+	 * @param old_id chip to replace.
+	 * @param new_id replacement.
+	 */
+	void SubstituteUp(int old_id, int new_id);
+
+	/**
+	 * @param tile_index x + y * width.
+	 * @return Flag combination.
+	 */
+	int GetFlags(int tile_index) const;
+
+	/**
+	 * Checks whether the tiles can be passed in a direction, the upper
+	 * tile decides unless it is a star tile.
+	 *
+	 * @param tile_index x + y * width.
+	 * @param bit Passable direction.
+	 * @return whether it is passable.
+	 */
+	bool IsPassable(int tile_index, int bit) const;
+
+	/**
+	 * Gets the chip a lower layer tile takes its terrain from.
+	 *
+	 * @param tile_id lower layer tile ID.
+	 * @param lower_tiles lower chip substitutions.
+	 * @return chip index.
+	 */
+	static int GetTerrainChip(int tile_id, std::vector<uint8_t> const& lower_tiles);
+
+private:
+	void Update(int tile_index);
+
+	int width;
+	int height;
+	std::vector<uint16_t> flags;
+
+	std::vector<int16_t> lower_layer;
+	std::vector<int16_t> upper_layer;
+	std::vector<unsigned char> passages_down;
+	std::vector<unsigned char> passages_up;
+	std::vector<uint8_t> lower_tiles;
+	std::vector<uint8_t> upper_tiles;
+	std::vector<uint8_t> terrain_flags;
+
+	/** Tiles of the substitutable lower and upper chips. */
+	std::vector<std::vector<int> > lower_users;
+	std::vector<std::vector<int> > upper_users;
+};
+
+inline int PassabilityGrid::GetFlags(int tile_index) const {
+	return flags[tile_index];
+}
+
+inline bool PassabilityGrid::IsPassable(int tile_index, int bit) const {
+	int const f = flags[tile_index];
+	if (((f >> UpperShift) & bit) == 0)
+		return false;
+	if ((f & Above) == 0)
+		return true;
+	return (f & bit) != 0;
+}
+
+#endif
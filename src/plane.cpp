@@ -26,15 +26,33 @@ Plane::Plane() :
 	visible(true),
 	z(0),
 	ox(0),
-	oy(0) {
+	oy(0),
+	damage_revision(0),
+	damaged(true) {
 
 	Graphics::RegisterDrawable(this);
 }
 
 Plane::~Plane() {
+	Graphics::InvalidateRect(damage_rect);
 	Graphics::RemoveDrawable(this);
 }
 
+bool Plane::ReportDamage() {
+	Rect rect = visible && bitmap ? Rect(0, 0, DisplayUi->GetWidth(), DisplayUi->GetHeight()) : Rect();
+	unsigned revision = bitmap ? bitmap->GetRevision() : 0;
+
+	if (damaged || rect != damage_rect || revision != damage_revision) {
+		Graphics::InvalidateRect(damage_rect);
+		Graphics::InvalidateRect(rect);
+		damage_rect = rect;
+		damage_revision = revision;
+		damaged = false;
+	}
+
+	return true;
+}
+
 void Plane::Draw() {
 	if (!visible || !bitmap) return;
 
@@ -49,31 +67,38 @@ BitmapRef const& Plane::GetBitmap() const {
 }
 void Plane::SetBitmap(BitmapRef const& nbitmap) {
 	bitmap = nbitmap;
+	damaged = true;
 }
 
 bool Plane::GetVisible() const {
 	return visible;
 }
 void Plane::SetVisible(bool nvisible) {
+	if (visible != nvisible) damaged = true;
 	visible = nvisible;
 }
 int Plane::GetZ() const {
 	return z;
 }
 void Plane::SetZ(int nz) {
-	if (z != nz) Graphics::UpdateZCallback();
+	if (z != nz) {
+		Graphics::UpdateZCallback(this);
+		damaged = true;
+	}
 	z = nz;
 }
 int Plane::GetOx() const {
 	return ox;
 }
 void Plane::SetOx(int nox) {
+	if (ox != nox) damaged = true;
 	ox = nox;
 }
 int Plane::GetOy() const {
 	return oy;
 }
 void Plane::SetOy(int noy) {
+	if (oy != noy) damaged = true;
 	oy = noy;
 }
 
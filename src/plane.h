@@ -22,6 +22,7 @@
 #include "system.h"
 #include "color.h"
 #include "drawable.h"
+#include "rect.h"
 #include "tone.h"
 
 /**
@@ -47,6 +48,8 @@ public:
 
 	DrawableType GetType() const;
 
+	bool ReportDamage();
+
 private:
 	DrawableType type;
 
@@ -56,6 +59,10 @@ private:
 	int z;
 	int ox;
 	int oy;
+
+	Rect damage_rect;
+	unsigned damage_revision;
+	bool damaged;
 };
 
 #endif
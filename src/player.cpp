@@ -39,10 +39,12 @@
 #  include <emscripten.h>
 #endif
 
+#include "async_decoder.h"
 #include "async_handler.h"
 #include "audio.h"
 #include "cache.h"
 #include "filefinder.h"
+#include "frame_stats.h"
 #include "game_actors.h"
 #include "game_map.h"
 #include "game_message.h"
@@ -56,16 +58,20 @@
 #include "graphics.h"
 #include "inireader.h"
 #include "input.h"
+#include "input_script.h"
 #include "ldb_reader.h"
 #include "lmt_reader.h"
 #include "lsd_reader.h"
 #include "main_data.h"
 #include "output.h"
 #include "player.h"
+#include "profiler.h"
 #include "reader_lcf.h"
 #include "reader_util.h"
 #include "scene_battle.h"
 #include "scene_logo.h"
+#include "sprite.h"
+#include "text.h"
 #include "utils.h"
 #include "version.h"
 
@@ -79,6 +85,8 @@ namespace Player {
 	bool hide_title_flag;
 	bool window_flag;
 	bool fps_flag;
+	bool dirty_rect_flag;
+	bool show_damage_flag;
 	bool battle_test_flag;
 	int battle_test_troop_id;
 	bool new_game_flag;
@@ -93,6 +101,12 @@ namespace Player {
 	std::string escape_symbol;
 	int engine;
 	std::string game_title;
+	int max_frames;
+	std::string benchmark_path;
+	std::string record_path;
+	std::string input_script;
+	std::string dump_path;
+	std::vector<int> dump_frames;
 	int frames;
 #ifdef EMSCRIPTEN
 	std::string emscripten_game_name;
@@ -109,6 +123,55 @@ namespace {
 	FileRequestBinding system_request_id;
 	FileRequestBinding save_request_id;
 	FileRequestBinding map_request_id;
+
+	// Seed of the random number generator
+	int rng_seed;
+
+	enum BenchmarkSection {
+		BenchmarkFrame,
+		BenchmarkScene,
+		BenchmarkDraw,
+		BenchmarkAudio,
+		BenchmarkSectionCount
+	};
+
+	// Time of every frame, only set by --benchmark
+	EASYRPG_SHARED_PTR<FrameStats> benchmark;
+
+	// Held keys of every frame, only set by --record-input
+	EASYRPG_SHARED_PTR<InputScript> recorder;
+
+	void WriteBenchmark() {
+		std::stringstream seed;
+		seed << rng_seed;
+		benchmark->SetInfo("game", Player::game_title);
+		benchmark->SetInfo("project_path", Main_Data::GetProjectPath());
+		benchmark->SetInfo("seed", seed.str());
+		benchmark->SetInfo("input_script", Player::input_script);
+
+		if (Player::benchmark_path == "-") {
+			benchmark->WriteJson(std::cout);
+			return;
+		}
+
+		EASYRPG_SHARED_PTR<std::fstream> stream =
+			FileFinder::openUTF8(Player::benchmark_path, std::ios_base::out | std::ios_base::trunc);
+		if (!stream) {
+			Output::Warning("Could not write benchmark results to %s", Player::benchmark_path.c_str());
+			return;
+		}
+		benchmark->WriteJson(*stream);
+	}
+
+	void WriteRecording() {
+		EASYRPG_SHARED_PTR<std::fstream> stream =
+			FileFinder::openUTF8(Player::record_path, std::ios_base::out | std::ios_base::trunc);
+		if (!stream) {
+			Output::Warning("Could not write input recording to %s", Player::record_path.c_str());
+			return;
+		}
+		recorder->Save(*stream);
+	}
 }
 
 void Player::Init(int argc, char *argv[]) {
@@ -142,10 +205,20 @@ void Player::Init(int argc, char *argv[]) {
 	InitMiniDumpWriter();
 #endif
 
-	srand(time(NULL));
+	rng_seed = time(NULL);
 
 	ParseCommandLine(argc, argv);
 
+	srand(rng_seed);
+
+	if (!benchmark_path.empty()) {
+		const char* const names[BenchmarkSectionCount] = { "frame", "scene_update", "draw_frame", "audio" };
+		benchmark = EASYRPG_MAKE_SHARED<FrameStats>(std::vector<std::string>(names, names + BenchmarkSectionCount));
+	}
+	if (!record_path.empty()) {
+		recorder = EASYRPG_MAKE_SHARED<InputScript>(Input::GetKeyNames());
+	}
+
 #ifdef EMSCRIPTEN
 	Output::IgnorePause(true);
 
@@ -233,24 +306,44 @@ void Player::Update(bool update_scene) {
 	static const double framerate_interval = 1000.0 / Graphics::GetDefaultFps();
 	next_frame = start_time + framerate_interval;
 
+	FrameStats* stats = benchmark.get();
+	double const frame_begin = stats ? FrameStats::Now() : 0.0;
+
+#ifdef ENABLE_PROFILER
+	// All scopes of the previous frame are closed
+	Profiler::EndFrame();
+#endif
+	PROFILE_SCOPE(Profiler::SectionFrame);
+
+	// The journals hold the changes of one frame
+	Game_Switches.GetJournal().Clear();
+	Game_Variables.GetJournal().Clear();
+
 #ifdef EMSCRIPTEN
 	// Ticks in emscripten are unreliable due to how the main loop works:
 	// This function is only called 60 times per second instead of theoretical
 	// 1000s of times.
 	Graphics::Update(true);
 #else
-	// Time left before next frame? Let's render the current frame.
-	double cur_time = (double)DisplayUi->GetTicks();
-	if (cur_time < next_frame) {
+	if (stats) {
+		// Every frame is drawn and nothing waits, a benchmark runs as fast
+		// as the work allows
+		FrameStats::Scope scope(stats, BenchmarkDraw);
 		Graphics::Update(true);
-
-		cur_time = (double)DisplayUi->GetTicks();
-		// Still time after graphic update? Yield until it's time for next one.
+	} else {
+		// Time left before next frame? Let's render the current frame.
+		double cur_time = (double)DisplayUi->GetTicks();
 		if (cur_time < next_frame) {
-			DisplayUi->Sleep((uint32_t)(next_frame - cur_time));
+			Graphics::Update(true);
+
+			cur_time = (double)DisplayUi->GetTicks();
+			// Still time after graphic update? Yield until it's time for next one.
+			if (cur_time < next_frame) {
+				DisplayUi->Sleep((uint32_t)(next_frame - cur_time));
+			}
+		} else {
+			Graphics::Update(false);
 		}
-	} else {
-		Graphics::Update(false);
 	}
 #endif
 
@@ -264,9 +357,25 @@ void Player::Update(bool update_scene) {
 	if (Input::IsTriggered(Input::SHOW_LOG)) {
 		Output::ToggleLog();
 	}
+#ifdef ENABLE_PROFILER
+	if (Input::IsTriggered(Input::TOGGLE_PROFILER)) {
+		Profiler::SetEnabled(!Profiler::IsEnabled());
+	}
+#endif
 
 	DisplayUi->ProcessEvents();
 
+	if (recorder) {
+		static std::vector<int> held;
+		BaseUi::KeyStatus const& keys = DisplayUi->GetKeyStates();
+		held.clear();
+		for (size_t i = 0; i < keys.size(); ++i) {
+			if (keys[i])
+				held.push_back(i);
+		}
+		recorder->Record(frames, held);
+	}
+
 	if (exit_flag) {
 		Scene::PopUntil(Scene::Null);
 	} else if (reset_flag) {
@@ -278,14 +387,30 @@ void Player::Update(bool update_scene) {
 		}
 	}
 
-	Audio().Update();
+	AsyncHandler::Update();
+	{
+		FrameStats::Scope scope(stats, BenchmarkAudio);
+		PROFILE_SCOPE(Profiler::SectionAudio);
+		Audio().Update();
+	}
 	Input::Update();
 	if (update_scene) {
+		FrameStats::Scope scope(stats, BenchmarkScene);
+		PROFILE_SCOPE(Profiler::SectionScene);
 		Scene::instance->Update();
 	}
 
 	start_time = next_frame;
 	++frames;
+
+	if (max_frames > 0 && frames >= max_frames) {
+		exit_flag = true;
+	}
+
+	if (stats) {
+		stats->Add(BenchmarkFrame, FrameStats::Now() - frame_begin);
+		stats->EndFrame();
+	}
 }
 
 void Player::FrameReset() {
@@ -316,6 +441,18 @@ void Player::Exit() {
 	DisplayUi->UpdateDisplay();
 #endif
 
+	if (benchmark) {
+		WriteBenchmark();
+		benchmark.reset();
+	}
+	if (recorder) {
+		WriteRecording();
+		recorder.reset();
+	}
+
+	AsyncDecoder::Quit();
+	Text::ClearCache();
+	Sprite::ClearEffectCache();
 	Font::Dispose();
 	Graphics::Quit();
 	FileFinder::Quit();
@@ -340,6 +477,8 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 	window_flag = false;
 #endif
 	fps_flag = false;
+	dirty_rect_flag = false;
+	show_damage_flag = false;
 	debug_flag = false;
 	hide_title_flag = false;
 	exit_flag = false;
@@ -353,6 +492,7 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 	start_map_id = -1;
 	no_rtp_flag = false;
 	no_audio_flag = false;
+	max_frames = 0;
 
 	std::vector<std::string> args;
 
@@ -380,6 +520,13 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 		else if (*it == "--show-fps") {
 			fps_flag = true;
 		}
+		else if (*it == "--dirty-rects") {
+			dirty_rect_flag = true;
+		}
+		else if (*it == "--show-damage") {
+			dirty_rect_flag = true;
+			show_damage_flag = true;
+		}
 		else if (*it == "testplay" || *it == "--test-play") {
 			debug_flag = true;
 		}
@@ -457,7 +604,7 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 			if (it == args.end()) {
 				return;
 			}
-			srand(atoi((*it).c_str()));
+			rng_seed = atoi((*it).c_str());
 		}
 		else if (*it == "--start-map-id") {
 			++it;
@@ -503,6 +650,59 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 			}
 			forced_encoding = *it;
 		}
+		else if (*it == "--profile") {
+#ifdef ENABLE_PROFILER
+			Profiler::SetEnabled(true);
+#endif
+		}
+		else if (*it == "--max-frames") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			max_frames = atoi((*it).c_str());
+		}
+		else if (*it == "--benchmark") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			// case sensitive
+			benchmark_path = argv[it - args.begin() + 1];
+		}
+		else if (*it == "--record-input") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			// case sensitive
+			record_path = argv[it - args.begin() + 1];
+		}
+		else if (*it == "--input-script") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			// case sensitive
+			input_script = argv[it - args.begin() + 1];
+		}
+		else if (*it == "--dump-path") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			// case sensitive
+			dump_path = argv[it - args.begin() + 1];
+		}
+		else if (*it == "--dump-frames") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			if (!InputScript::ParseFrameList(*it, dump_frames)) {
+				Output::Warning("Invalid frame list %s", (*it).c_str());
+			}
+		}
 		else if (*it == "--disable-audio") {
 			no_audio_flag = true;
 		}
@@ -776,8 +976,19 @@ void Player::PrintUsage() {
 R"(EasyRPG Player - An open source interpreter for RPG Maker 2000/2003 games.
 Options:
       --battle-test N      Start a battle test with monster party N.
+      --benchmark FILE     Draw every frame without waiting and write the
+                           mean, median and 99th percentile time of the
+                           frames and their scene update, drawing and audio
+                           parts as JSON to FILE ("-" for stdout) on exit.
+                           Use with --max-frames and --seed for
+                           reproducible runs.
       --disable-audio      Disable audio (in case you prefer your own music).
       --disable-rtp        Disable support for the Runtime Package (RTP).
+      --dirty-rects        Only redraw the screen areas that changed.
+      --dump-frames LIST   Save the frames in LIST (e.g. 60,100-200:10) as
+                           PNG files. Headless backend only.
+      --dump-path PATH     Directory of the --dump-frames files, defaults to
+                           the save directory.
       --encoding N         Instead of auto detecting the encoding or using
                            the one in RPG_RT.ini, the encoding N is used.
                            Use "auto" for automatic detection.
@@ -788,13 +999,26 @@ Options:
                             rpg2k3e - RPG Maker 2003 (English release) engine
       --fullscreen         Start in fullscreen mode.
       --show-fps           Enable frames per second counter.
+      --show-damage        Outline the redrawn screen areas and display the
+                           amount of composited pixels per frame.
+                           Implies --dirty-rects.
       --hide-title         Hide the title background image and center the
                            command menu.
+      --input-script FILE  Replay the key presses in FILE, one
+                           "FRAME DURATION KEY..." per line.
+                           Headless backend only.
       --load-game-id N     Skip the title scene and load SaveN.lsd
                            (N is padded to two digits).
+      --max-frames N       Exit after N frames.
       --new-game           Skip the title scene and start a new game directly.
+      --profile            Show the time spent in the scene, map, interpreter,
+                           audio, drawing and display upload of the recent
+                           frames. Toggled with F6 (ZL on the 3DS). Needs
+                           a build with ENABLE_PROFILER.
       --project-path PATH  Instead of using the working directory the game in
                            PATH is used.
+      --record-input FILE  Write the held keys to FILE on exit, in the format
+                           --input-script reads.
       --save-path PATH     Instead of storing save files in the game directory
                            they are stored in PATH. The directory must exist.
                            When using the game browser all games will share
@@ -172,6 +172,12 @@ namespace Player {
 	/** FPS flag, if true will display frames per second counter. */
 	extern bool fps_flag;
 
+	/** Dirty rectangle flag, if true only the changed screen areas are redrawn. */
+	extern bool dirty_rect_flag;
+
+	/** Show damage flag, if true the redrawn screen areas are outlined. */
+	extern bool show_damage_flag;
+
 	/** Battle Test flag, if true will run battle test. */
 	extern bool battle_test_flag;
 
@@ -214,6 +220,24 @@ namespace Player {
 	/** Game title. */
 	extern std::string game_title;
 
+	/** Stop after this many frames, 0 runs until the game ends. */
+	extern int max_frames;
+
+	/** File the benchmark results are written to, empty for no benchmark. */
+	extern std::string benchmark_path;
+
+	/** File the held keys are recorded to, empty for no recording. */
+	extern std::string record_path;
+
+	/** Input script replayed by the headless backend, see InputScript. */
+	extern std::string input_script;
+
+	/** Directory the headless backend dumps frames to. */
+	extern std::string dump_path;
+
+	/** Frames the headless backend dumps, in ascending order. */
+	extern std::vector<int> dump_frames;
+
 #ifdef EMSCRIPTEN
 	/** Name of game emscripten uses */
 	extern std::string emscripten_game_name;
@@ -0,0 +1,125 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <chrono>
+#include "profiler.h"
+
+namespace {
+	const char* const names[Profiler::SectionCount] = {
+		"Frame",
+		"Scene",
+		"Map",
+		"Interpreter",
+		"Audio",
+		"Upload",
+		"Draw Window",
+		"Draw Tilemap",
+		"Draw Sprite",
+		"Draw Plane",
+		"Draw Background",
+		"Draw Screen",
+		"Draw Frame",
+		"Draw Weather",
+		"Draw Overlay",
+		"Draw Other"
+	};
+
+	bool enabled = false;
+	/** Running scopes of every section. */
+	int depth[Profiler::SectionCount];
+	double current[Profiler::SectionCount];
+	double history[Profiler::SectionCount][Profiler::history_size];
+	/** Slot of the next finished frame. */
+	int position = 0;
+	/** Frames in the histories. */
+	int kept = 0;
+}
+
+Profiler::Scope::Scope(int section) :
+	section(enabled ? section : -1), begin(0.0) {
+	if (this->section >= 0 && depth[section]++ == 0) {
+		begin = Now();
+	}
+}
+
+Profiler::Scope::~Scope() {
+	if (section >= 0 && --depth[section] == 0) {
+		Add(section, Now() - begin);
+	}
+}
+
+double Profiler::Now() {
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::SetEnabled(bool enable) {
+	enabled = enable;
+	std::fill(&current[0], &current[0] + SectionCount, 0.0);
+	std::fill(&history[0][0], &history[0][0] + SectionCount * history_size, 0.0);
+	position = 0;
+	kept = 0;
+}
+
+bool Profiler::IsEnabled() {
+	return enabled;
+}
+
+int Profiler::GetDrawSection(DrawableType type) {
+	return SectionDraw + type;
+}
+
+const char* Profiler::GetName(int section) {
+	return names[section];
+}
+
+void Profiler::Add(int section, double ms) {
+	current[section] += ms;
+}
+
+void Profiler::EndFrame() {
+	if (!enabled)
+		return;
+
+	for (int i = 0; i < SectionCount; ++i) {
+		history[i][position] = current[i];
+		current[i] = 0.0;
+	}
+	position = (position + 1) % history_size;
+	kept = std::min(kept + 1, history_size);
+}
+
+double Profiler::GetTime(int section, int frames_ago) {
+	return history[section][(position - 1 - frames_ago + 2 * history_size) % history_size];
+}
+
+double Profiler::GetMean(int section) {
+	if (kept == 0)
+		return 0.0;
+
+	double sum = 0.0;
+	for (int i = 0; i < kept; ++i) {
+		sum += GetTime(section, i);
+	}
+	return sum / kept;
+}
+
+double Profiler::GetMax(int section) {
+	return *std::max_element(&history[section][0], &history[section][0] + history_size);
+}
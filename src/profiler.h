@@ -0,0 +1,140 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_PROFILER_H_
+#define _EASYRPG_PROFILER_H_
+
+// Headers
+#include "drawable.h"
+#include "options.h"
+
+/**
+ * Profiler namespace.
+ * Measures the time spent in the subsystems of every frame and keeps the
+ * last frames in ring buffers for the on-screen overlay (--profile).
+ * Sections are timed with PROFILE_SCOPE, which compiles to nothing unless
+ * ENABLE_PROFILER is defined. A section entered again while it is running
+ * (e.g. a child interpreter) is only counted once, but sections containing
+ * other sections include their time: the map update contains the
+ * interpreters and the scene update contains both.
+ */
+namespace Profiler {
+	enum Section {
+		SectionFrame,
+		SectionScene,
+		SectionMap,
+		SectionInterpreter,
+		SectionAudio,
+		SectionUpload,
+		/** First of the Drawable::Draw sections, one per DrawableType. */
+		SectionDraw,
+		SectionCount = SectionDraw + TypeDefault + 1
+	};
+
+	/** Number of frames kept per section. */
+	const int history_size = 120;
+
+	/**
+	 * Times a section from construction to destruction while the profiler
+	 * is enabled.
+	 */
+	class Scope {
+	public:
+		explicit Scope(int section);
+		~Scope();
+
+	private:
+		int section;
+		double begin;
+	};
+
+	/**
+	 * @return monotonic time in ms.
+	 */
+	double Now();
+
+	/**
+	 * Enables or disables the measurements, the histories are cleared.
+	 *
+	 * @param enabled whether to measure.
+	 */
+	void SetEnabled(bool enabled);
+
+	/**
+	 * @return whether the profiler measures.
+	 */
+	bool IsEnabled();
+
+	/**
+	 * Gets the section drawables of a type are timed in.
+	 *
+	 * @param type drawable type.
+	 * @return section.
+	 */
+	int GetDrawSection(DrawableType type);
+
+	/**
+	 * @param section section.
+	 * @return display name.
+	 */
+	const char* GetName(int section);
+
+	/**
+	 * Adds time to a section of the current frame.
+	 *
+	 * @param section section.
+	 * @param ms time in ms.
+	 */
+	void Add(int section, double ms);
+
+	/**
+	 * Moves the times of the current frame into the histories.
+	 */
+	void EndFrame();
+
+	/**
+	 * Gets the time of a past frame.
+	 *
+	 * @param section section.
+	 * @param frames_ago 0 for the last finished frame, up to
+	 *                   history_size - 1.
+	 * @return time in ms, 0 for frames before the profiler was enabled.
+	 */
+	double GetTime(int section, int frames_ago);
+
+	/**
+	 * @param section section.
+	 * @return mean time of the kept frames in ms.
+	 */
+	double GetMean(int section);
+
+	/**
+	 * @param section section.
+	 * @return longest time of the kept frames in ms.
+	 */
+	double GetMax(int section);
+}
+
+#ifdef ENABLE_PROFILER
+#  define PROFILE_SCOPE_NAME2(line) profile_scope_##line
+#  define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_NAME2(line)
+#  define PROFILE_SCOPE(section) Profiler::Scope PROFILE_SCOPE_NAME(__LINE__)(section)
+#else
+#  define PROFILE_SCOPE(section)
+#endif
+
+#endif
@@ -82,7 +82,7 @@ void Scene_Debug::Update() {
 			var_window->SetActive(true);
 		} else if (var_window->GetActive()) {
 			if (current_var_type == TypeSwitch && Game_Switches.IsValid(GetIndex()))
-				Game_Switches[GetIndex()] = !Game_Switches[GetIndex()];
+				Game_Switches.Flip(GetIndex());
 			else if (current_var_type == TypeInt && Game_Variables.IsValid(GetIndex())) {
 				var_window->SetActive(false);
 				numberinput_window->SetNumber(Game_Variables[GetIndex()]);
@@ -91,7 +91,7 @@ void Scene_Debug::Update() {
 			}
 			var_window->Refresh();
 		} else if (numberinput_window->GetActive()) {
-			Game_Variables[GetIndex()] = numberinput_window->GetNumber();
+			Game_Variables.Set(GetIndex(), numberinput_window->GetNumber());
 			numberinput_window->SetActive(false);
 			numberinput_window->SetVisible(false);
 			var_window->SetActive(true);
@@ -59,7 +59,7 @@ void Scene_Item::Update() {
 
 			if (Data::items[item_id - 1].type == RPG::Item::Type_switch) {
 				Main_Data::game_party->UseItem(item_id);
-				Game_Switches[Data::items[item_id - 1].switch_id] = true;
+				Game_Switches.Set(Data::items[item_id - 1].switch_id, true);
 				Scene::PopUntil(Scene::Map);
 				Game_Map::SetNeedRefresh(Game_Map::Refresh_All);
 			} else {
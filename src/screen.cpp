@@ -25,13 +25,18 @@
 #include "main_data.h"
 #include "screen.h"
 
-Screen::Screen() {
+Screen::Screen() :
+	damage_flash(false) {
 	Graphics::RegisterDrawable(this);
 
 	default_tone = Tone(128, 128, 128, 128);
+	damage_tone = default_tone;
 }
 
 Screen::~Screen() {
+	if (damage_tone != default_tone || damage_flash) {
+		Graphics::InvalidateAll();
+	}
 	Graphics::RemoveDrawable(this);
 }
 
@@ -46,13 +51,36 @@ DrawableType Screen::GetType() const {
 void Screen::Update() {
 }
 
+bool Screen::ReportDamage() {
+	Tone tone = Main_Data::game_screen->GetTone();
+
+	int flash_time_left;
+	int flash_current_level;
+	Main_Data::game_screen->GetFlash(flash_current_level, flash_time_left);
+	bool flash_active = flash_time_left > 0;
+
+	// A steady tone only needs to be applied to damaged areas, a changing
+	// tone or a flash (including its last frame) affects the whole screen
+	if (tone != damage_tone || flash_active || damage_flash) {
+		Graphics::InvalidateAll();
+	}
+
+	damage_tone = tone;
+	damage_flash = flash_active;
+
+	return true;
+}
+
 void Screen::Draw() {
 	BitmapRef disp = DisplayUi->GetDisplaySurface();
 
 	Tone tone = Main_Data::game_screen->GetTone();
 
 	if (tone != default_tone) {
-		disp->ToneBlit(0, 0, *disp, Rect(0, 0, SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT), tone, Opacity::opaque);
+		// ToneBlit works on the pixels directly and ignores the clip region
+		for (const Rect& rect : Graphics::GetDamageRects()) {
+			disp->ToneBlit(rect.x, rect.y, *disp, rect, tone, Opacity::opaque);
+		}
 	}
 
 	int flash_time_left;
@@ -60,11 +88,6 @@ void Screen::Draw() {
 	Color flash_color = Main_Data::game_screen->GetFlash(flash_current_level, flash_time_left);
 
 	if (flash_time_left > 0) {
-		if (!flash) {
-			flash = Bitmap::Create(SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT, flash_color);
-		} else {
-			flash->Fill(flash_color);
-		}
-		disp->Blit(0, 0, *flash, flash->GetRect(), flash_current_level);
+		disp->FlashBlit(disp->GetRect(), flash_color, flash_current_level);
 	}
 }
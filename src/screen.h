@@ -40,6 +40,8 @@ public:
 	void Draw();
 	void Update();
 
+	bool ReportDamage();
+
 	int GetZ() const;
 	DrawableType GetType() const;
 
@@ -48,7 +50,9 @@ private:
 	static const DrawableType type = TypeScreen;
 
 	Tone default_tone;
-	BitmapRef flash;
+
+	Tone damage_tone;
+	bool damage_flash;
 };
 
 #endif
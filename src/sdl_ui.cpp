@@ -568,14 +568,44 @@ void SdlUi::UpdateDisplay() {
 	if (zoom_available && current_display_mode.zoom) {
 		// Blit drawing surface x2 scaled over window surface
 		Blit2X(*main_surface, sdl_surface);
+		SDL_UpdateRect(sdl_surface, 0, 0, 0, 0);
+	} else if (dirty_all) {
+		SDL_UpdateRect(sdl_surface, 0, 0, 0, 0);
+	} else {
+		std::vector<SDL_Rect> rects;
+		for (const Rect& dirty : dirty_rects) {
+			Rect rect = dirty;
+			rect.Adjust(main_surface->GetRect());
+			if (rect.IsEmpty())
+				continue;
+			SDL_Rect sdl_rect = { (Sint16)rect.x, (Sint16)rect.y, (Uint16)rect.width, (Uint16)rect.height };
+			rects.push_back(sdl_rect);
+		}
+		if (!rects.empty()) {
+			SDL_UpdateRects(sdl_surface, (int)rects.size(), &rects.front());
+		}
 	}
-	SDL_UpdateRect(sdl_surface, 0, 0, 0, 0);
 #else
-	SDL_UpdateTexture(sdl_texture, NULL, main_surface->pixels(), main_surface->pitch());
+	if (dirty_all) {
+		SDL_UpdateTexture(sdl_texture, NULL, main_surface->pixels(), main_surface->pitch());
+	} else {
+		// Upload only the areas the compositor changed
+		for (const Rect& dirty : dirty_rects) {
+			Rect rect = dirty;
+			rect.Adjust(main_surface->GetRect());
+			if (rect.IsEmpty())
+				continue;
+			SDL_Rect sdl_rect = { rect.x, rect.y, rect.width, rect.height };
+			const uint8_t* pixels = (const uint8_t*)main_surface->pixels() +
+				rect.y * main_surface->pitch() + rect.x * main_surface->bpp() / 8;
+			SDL_UpdateTexture(sdl_texture, &sdl_rect, pixels, main_surface->pitch());
+		}
+	}
 	SDL_RenderClear(sdl_renderer);
 	SDL_RenderCopy(sdl_renderer, sdl_texture, NULL, NULL);
 	SDL_RenderPresent(sdl_renderer);
 #endif
+	ResetDirtyRects();
 }
 
 void SdlUi::SetTitle(const std::string &title) {
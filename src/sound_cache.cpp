@@ -0,0 +1,239 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cassert>
+#include "sound_cache.h"
+
+SoundCache::SoundCache(uint8_t* arena, size_t size, size_t max_entries) :
+	arena(arena),
+	arena_size(size - size % alignment),
+	stats() {
+	entries.resize(max_entries);
+	Clear();
+}
+
+void SoundCache::Clear() {
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].used = false;
+		entries[i].name.clear();
+		entries[i].pins = 0;
+		entries[i].orphan = false;
+	}
+
+	free_ids.clear();
+	for (int i = entries.size() - 1; i >= 0; --i) {
+		free_ids.push_back(i);
+	}
+
+	index.clear();
+	lru_list.clear();
+	free_blocks.clear();
+	if (arena_size > 0) {
+		free_blocks[0] = arena_size;
+	}
+
+	stats.bytes = 0;
+	stats.entries = 0;
+}
+
+int SoundCache::Find(const std::string& name) {
+	std::unordered_map<std::string, int>::const_iterator const it = index.find(name);
+
+	if (it == index.end()) {
+		++stats.misses;
+		return -1;
+	}
+
+	++stats.hits;
+	Entry& entry = entries[it->second];
+	lru_list.splice(lru_list.begin(), lru_list, entry.lru);
+
+	return it->second;
+}
+
+bool SoundCache::Contains(const std::string& name) const {
+	return index.find(name) != index.end();
+}
+
+bool SoundCache::AllocateBlock(size_t size, size_t& offset) {
+	for (std::map<size_t, size_t>::iterator it = free_blocks.begin(); it != free_blocks.end(); ++it) {
+		if (it->second < size) {
+			continue;
+		}
+
+		offset = it->first;
+		size_t const rest = it->second - size;
+		free_blocks.erase(it);
+		if (rest > 0) {
+			free_blocks[offset + size] = rest;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void SoundCache::FreeBlock(size_t offset, size_t size) {
+	std::map<size_t, size_t>::iterator next = free_blocks.lower_bound(offset);
+
+	// Merge with the following block
+	if (next != free_blocks.end() && offset + size == next->first) {
+		size += next->second;
+		free_blocks.erase(next++);
+	}
+
+	// Merge with the preceding block
+	if (next != free_blocks.begin()) {
+		std::map<size_t, size_t>::iterator prev = next;
+		--prev;
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
+		}
+	}
+
+	free_blocks[offset] = size;
+}
+
+bool SoundCache::EvictOne() {
+	for (std::list<int>::reverse_iterator it = lru_list.rbegin(); it != lru_list.rend(); ++it) {
+		if (entries[*it].pins == 0) {
+			Remove(*it);
+			++stats.evictions;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int SoundCache::Allocate(size_t size) {
+	size_t const reserved = (size + alignment - 1) / alignment * alignment;
+
+	if (reserved == 0 || reserved > arena_size) {
+		++stats.failures;
+		return -1;
+	}
+
+	while (free_ids.empty()) {
+		if (!EvictOne()) {
+			++stats.failures;
+			return -1;
+		}
+	}
+
+	size_t offset;
+	while (!AllocateBlock(reserved, offset)) {
+		if (!EvictOne()) {
+			++stats.failures;
+			return -1;
+		}
+	}
+
+	int const id = free_ids.back();
+	free_ids.pop_back();
+
+	Entry& entry = entries[id];
+	entry.used = true;
+	entry.name.clear();
+	entry.offset = offset;
+	entry.size = size;
+	entry.reserved = reserved;
+	entry.pins = 1;
+	entry.orphan = false;
+	entry.lru = lru_list.end();
+
+	stats.bytes += reserved;
+	++stats.entries;
+
+	return id;
+}
+
+void SoundCache::Publish(int id, const std::string& name) {
+	Entry& entry = entries[id];
+	assert(entry.used && entry.lru == lru_list.end());
+
+	std::unordered_map<std::string, int>::iterator const it = index.find(name);
+	if (it != index.end()) {
+		Entry& old = entries[it->second];
+		if (old.pins > 0) {
+			// Still playing, freed when the last pin is released
+			lru_list.erase(old.lru);
+			old.lru = lru_list.end();
+			old.orphan = true;
+			index.erase(it);
+		} else {
+			Remove(it->second);
+		}
+	}
+
+	entry.name = name;
+	index[name] = id;
+	lru_list.push_front(id);
+	entry.lru = lru_list.begin();
+	--entry.pins;
+}
+
+void SoundCache::Remove(int id) {
+	Entry& entry = entries[id];
+	assert(entry.used);
+
+	if (entry.lru != lru_list.end()) {
+		index.erase(entry.name);
+		lru_list.erase(entry.lru);
+	}
+
+	FreeBlock(entry.offset, entry.reserved);
+
+	stats.bytes -= entry.reserved;
+	--stats.entries;
+
+	entry.used = false;
+	entry.name.clear();
+	entry.pins = 0;
+	entry.orphan = false;
+	free_ids.push_back(id);
+}
+
+void SoundCache::Pin(int id) {
+	assert(entries[id].used);
+	++entries[id].pins;
+}
+
+void SoundCache::Unpin(int id) {
+	assert(entries[id].used && entries[id].pins > 0);
+	if (--entries[id].pins == 0 && entries[id].orphan) {
+		Remove(id);
+	}
+}
+
+uint8_t* SoundCache::GetBuffer(int id) const {
+	return arena + entries[id].offset;
+}
+
+size_t SoundCache::GetSize(int id) const {
+	return entries[id].size;
+}
+
+bool SoundCache::IsPinned(int id) const {
+	return entries[id].pins > 0;
+}
+
+SoundCache::Stats SoundCache::GetStats() const {
+	return stats;
+}
@@ -0,0 +1,186 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_SOUND_CACHE_H_
+#define _EASYRPG_SOUND_CACHE_H_
+
+// Headers
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * SoundCache class.
+ * Keeps decoded sound effects in a fixed memory arena. Entries are found
+ * by name through a hash index, buffers are placed first-fit in a free list
+ * that merges neighbouring blocks. When the arena is full the least
+ * recently used entries are evicted, except pinned ones which are still
+ * being played.
+ * The class does not depend on a platform, the arena is provided by the
+ * caller.
+ */
+class SoundCache {
+public:
+	/**
+	 * Counters of the cache.
+	 */
+	struct Stats {
+		/** Lookups that found the sound. */
+		unsigned hits;
+		/** Lookups that did not find the sound. */
+		unsigned misses;
+		/** Entries dropped to make room. */
+		unsigned evictions;
+		/** Allocations that did not fit even after evicting. */
+		unsigned failures;
+		/** Arena bytes held by entries, including alignment. */
+		size_t bytes;
+		/** Number of entries. */
+		size_t entries;
+	};
+
+	/** Alignment of the buffers inside the arena. */
+	static const size_t alignment = 128;
+
+	/**
+	 * Constructor.
+	 *
+	 * @param arena memory the buffers are placed in.
+	 * @param size arena size in bytes.
+	 * @param max_entries maximum number of entries.
+	 */
+	SoundCache(uint8_t* arena, size_t size, size_t max_entries);
+
+	/**
+	 * Looks up a sound and marks it as recently used.
+	 *
+	 * @param name sound name.
+	 * @return entry id, -1 when the sound is not cached.
+	 */
+	int Find(const std::string& name);
+
+	/**
+	 * Checks for a sound without counting a lookup or marking it as used.
+	 *
+	 * @param name sound name.
+	 * @return whether the sound is cached.
+	 */
+	bool Contains(const std::string& name) const;
+
+	/**
+	 * Allocates a buffer for a sound, evicting the least recently used
+	 * unpinned entries when needed.
+	 * The new entry is pinned and not found by name until Publish is
+	 * called, so it can be filled by the decoder first.
+	 *
+	 * @param size buffer size in bytes.
+	 * @return entry id, -1 when the buffer does not fit.
+	 */
+	int Allocate(size_t size);
+
+	/**
+	 * Makes an allocated entry available for lookups and unpins it.
+	 * An older entry with the same name is removed, or once its last pin
+	 * is released when it is still pinned.
+	 *
+	 * @param id entry id returned by Allocate.
+	 * @param name sound name.
+	 */
+	void Publish(int id, const std::string& name);
+
+	/**
+	 * Removes an entry and frees its buffer.
+	 *
+	 * @param id entry id.
+	 */
+	void Remove(int id);
+
+	/**
+	 * Protects an entry from eviction. Pins are counted.
+	 *
+	 * @param id entry id.
+	 */
+	void Pin(int id);
+
+	/**
+	 * Releases a pin taken with Pin.
+	 *
+	 * @param id entry id.
+	 */
+	void Unpin(int id);
+
+	/**
+	 * @param id entry id.
+	 * @return buffer of the entry.
+	 */
+	uint8_t* GetBuffer(int id) const;
+
+	/**
+	 * @param id entry id.
+	 * @return requested buffer size of the entry.
+	 */
+	size_t GetSize(int id) const;
+
+	/**
+	 * @param id entry id.
+	 * @return whether the entry is pinned.
+	 */
+	bool IsPinned(int id) const;
+
+	/**
+	 * @return cache counters.
+	 */
+	Stats GetStats() const;
+
+	/**
+	 * Removes all entries, pinned ones included.
+	 */
+	void Clear();
+
+private:
+	struct Entry {
+		bool used;
+		std::string name;
+		size_t offset;
+		size_t size;
+		size_t reserved;
+		int pins;
+		/** Replaced by a newer entry while pinned. */
+		bool orphan;
+		std::list<int>::iterator lru;
+	};
+
+	bool AllocateBlock(size_t size, size_t& offset);
+	void FreeBlock(size_t offset, size_t size);
+	bool EvictOne();
+
+	uint8_t* arena;
+	size_t arena_size;
+	std::vector<Entry> entries;
+	std::vector<int> free_ids;
+	std::unordered_map<std::string, int> index;
+	/** Published entries, most recently used first. */
+	std::list<int> lru_list;
+	/** Free blocks by offset. */
+	std::map<size_t, size_t> free_blocks;
+	Stats stats;
+};
+
+#endif
@@ -16,13 +16,119 @@
  */
 
 // Headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <map>
 #include <string>
+#include <tuple>
 #include "sprite.h"
 #include "player.h"
 #include "graphics.h"
 #include "util_macro.h"
 #include "bitmap.h"
 
+namespace {
+	// Source bitmap, source rect (x, y, w, h), tone (r, g, b, gray),
+	// flash (r, g, b, a) and flip (x | y << 1)
+	typedef std::tuple<Bitmap const*, int, int, int, int, int, int, int, int, int, int, int, int, int> effect_key;
+
+	struct EffectEntry {
+		effect_key key;
+		EASYRPG_WEAK_PTR<Bitmap> source;
+		unsigned source_revision;
+		BitmapRef bitmap;
+		size_t bytes;
+	};
+
+	typedef std::list<EffectEntry> effect_list_type;
+	effect_list_type effect_list;
+	std::map<effect_key, effect_list_type::iterator> effect_map;
+
+	// Enough for the flashing members of a battle or a crowd of toned events
+	const size_t effect_budget = 1024 * 1024;
+
+	Sprite::EffectStats stats = {};
+
+	void EnforceBudget() {
+		while (stats.bytes > effect_budget && !effect_list.empty()) {
+			EffectEntry const& entry = effect_list.back();
+			stats.bytes -= entry.bytes;
+			effect_map.erase(entry.key);
+			effect_list.pop_back();
+			++stats.evictions;
+		}
+		stats.entries = effect_list.size();
+	}
+
+	// Flash fades change the alpha every frame, close levels share a bitmap
+	Color QuantizeFlash(Color flash) {
+		flash.alpha = std::min(255, (flash.alpha + 4) & ~7);
+		return flash;
+	}
+
+	BitmapRef RenderEffects(Bitmap const& src, Rect const& rect, Tone const& tone, Color const& flash, bool flipx, bool flipy) {
+		BitmapRef result = Bitmap::Create(rect.width, rect.height, true);
+		Rect const dst_rect = result->GetRect();
+		bool const no_tone = tone == Tone();
+
+		if (flash.alpha != 0) {
+			result->BlendBlit(0, 0, src, rect, flash, Opacity::opaque);
+			if (!no_tone)
+				result->ToneBlit(0, 0, *result, dst_rect, tone, Opacity::opaque);
+		} else if (!no_tone) {
+			result->ToneBlit(0, 0, src, rect, tone, Opacity::opaque);
+		} else {
+			result->FlipBlit(0, 0, src, rect, flipx, flipy, Opacity::opaque);
+			return result;
+		}
+
+		if (flipx || flipy)
+			result->Flip(dst_rect, flipx, flipy);
+
+		return result;
+	}
+
+	BitmapRef GetEffects(BitmapRef const& src, Rect const& rect, Tone const& tone, Color const& flash, bool flipx, bool flipy) {
+		effect_key const key(src.get(), rect.x, rect.y, rect.width, rect.height,
+			tone.red, tone.green, tone.blue, tone.gray,
+			flash.red, flash.green, flash.blue, flash.alpha,
+			(flipx ? 1 : 0) | (flipy ? 2 : 0));
+		std::map<effect_key, effect_list_type::iterator>::iterator const it = effect_map.find(key);
+
+		if (it != effect_map.end()) {
+			EffectEntry& entry = *it->second;
+			// An expired source means the address belongs to a new bitmap now
+			if (!entry.source.expired() && entry.source_revision == src->GetRevision()) {
+				++stats.hits;
+				effect_list.splice(effect_list.begin(), effect_list, it->second);
+				return entry.bitmap;
+			}
+
+			stats.bytes -= entry.bytes;
+			effect_list.erase(it->second);
+			effect_map.erase(it);
+		}
+
+		++stats.misses;
+
+		EffectEntry entry;
+		entry.key = key;
+		entry.source = src;
+		entry.source_revision = src->GetRevision();
+		entry.bitmap = RenderEffects(*src, rect, tone, flash, flipx, flipy);
+		entry.bytes = entry.bitmap->pitch() * entry.bitmap->height();
+
+		stats.bytes += entry.bytes;
+		effect_list.push_front(entry);
+		effect_map[key] = effect_list.begin();
+		EnforceBudget();
+
+		return entry.bitmap;
+	}
+}
+
 // Constructor
 Sprite::Sprite() :
 	type(TypeSprite),
@@ -52,18 +158,22 @@ Sprite::Sprite() :
 	waver_effect_phase(0.0),
 	flash_effect(Color(0,0,0,0)),
 	bitmap_effects_src_rect(Rect()),
+	bitmap_effects_revision(0),
 	bitmap_effects_valid(false),
 
 	current_tone(Tone()),
 	current_flash(Color(0,0,0,0)),
 	current_flip_x(false),
-	current_flip_y(false) {
+	current_flip_y(false),
+	damage_revision(0),
+	damaged(true) {
 
 	Graphics::RegisterDrawable(this);
 }
 
 // Destructor
 Sprite::~Sprite() {
+	Graphics::InvalidateRect(damage_rect);
 	Graphics::RemoveDrawable(this);
 }
 
@@ -114,79 +224,99 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 	}
 	rect.Adjust(bitmap->GetWidth(), bitmap->GetHeight());
 
+	Color const flash = QuantizeFlash(flash_effect);
 	bool no_tone = tone_effect == Tone();
-	bool no_flash = flash_effect.alpha == 0;
+	bool no_flash = flash.alpha == 0;
 	bool no_flip = !flipx_effect && !flipy_effect;
 	bool no_effects = no_tone && no_flash && no_flip;
+
+	if (no_effects || rect.IsEmpty()) {
+		bitmap_effects.reset();
+		bitmap_effects_valid = false;
+		return bitmap;
+	}
+
 	bool effects_changed = tone_effect != current_tone ||
-		flash_effect != current_flash ||
+		flash != current_flash ||
 		flipx_effect != current_flip_x ||
 		flipy_effect != current_flip_y;
 	bool effects_rect_changed = rect != bitmap_effects_src_rect;
 
-	if (effects_changed || effects_rect_changed || bitmap_changed) {
+	if (effects_changed || effects_rect_changed || bitmap_changed ||
+		bitmap->GetRevision() != bitmap_effects_revision) {
 		bitmap_effects_valid = false;
 	}
 
-	if (no_effects)
-		return bitmap;
-
-	if (bitmap_effects && bitmap_effects_valid)
-		return bitmap_effects;
-
-	BitmapRef src_bitmap;
-
-	if (no_effects)
-		src_bitmap = bitmap;
-	else if (bitmap_effects_valid)
-		src_bitmap = bitmap_effects;
-	else {
+	if (!bitmap_effects_valid) {
 		current_tone = tone_effect;
-		current_flash = flash_effect;
+		current_flash = flash;
 		current_flip_x = flipx_effect;
 		current_flip_y = flipy_effect;
 
-		if (bitmap_effects &&
-			bitmap_effects->GetWidth() < rect.x + rect.width &&
-			bitmap_effects->GetHeight() < rect.y + rect.height) {
-		bitmap_effects.reset();
-		}
-
-		if (!bitmap_effects)
-			bitmap_effects = Bitmap::Create(bitmap->GetWidth(), bitmap->GetHeight(), true);
-
-		bitmap_effects->Clear();
-		if (no_tone && no_flash)
-			bitmap_effects->FlipBlit(rect.x, rect.y, *bitmap, rect, flipx_effect, flipy_effect, Opacity::opaque);
-		else if (no_flip && no_flash)
-			bitmap_effects->ToneBlit(rect.x, rect.y, *bitmap, rect, tone_effect, Opacity::opaque);
-		else if (no_flip && no_tone)
-			bitmap_effects->BlendBlit(rect.x, rect.y, *bitmap, rect, flash_effect, Opacity::opaque);
-		else if (no_flash) {
-			bitmap_effects->ToneBlit(rect.x, rect.y, *bitmap, rect, tone_effect, Opacity::opaque);
-			bitmap_effects->Flip(rect, flipx_effect, flipy_effect);
-		}
-		else if (no_tone) {
-			bitmap_effects->BlendBlit(rect.x, rect.y, *bitmap, rect, flash_effect, Opacity::opaque);
-			bitmap_effects->Flip(rect, flipx_effect, flipy_effect);
-		}
-		else if (no_flip) {
-			bitmap_effects->BlendBlit(rect.x, rect.y, *bitmap, rect, flash_effect, Opacity::opaque);
-			bitmap_effects->ToneBlit(rect.x, rect.y, *bitmap_effects, rect, tone_effect, Opacity::opaque);
-		}
-		else {
-			bitmap_effects->BlendBlit(rect.x, rect.y, *bitmap, rect, flash_effect, Opacity::opaque);
-			bitmap_effects->ToneBlit(rect.x, rect.y, *bitmap_effects, rect, tone_effect, Opacity::opaque);
-			bitmap_effects->Flip(rect, flipx_effect, flipy_effect);
-		}
-
+		// The result is shared with all sprites using the same effects
+		bitmap_effects = GetEffects(bitmap, rect, tone_effect, flash, flipx_effect, flipy_effect);
 		bitmap_effects_src_rect = rect;
+		bitmap_effects_revision = bitmap->GetRevision();
 		bitmap_effects_valid = true;
+	}
+
+	// Effected bitmaps only hold the source rect
+	rect = bitmap_effects->GetRect();
+	return bitmap_effects;
+}
+
+Sprite::EffectStats Sprite::GetEffectStats() {
+	return stats;
+}
 
-		src_bitmap = bitmap_effects;
+void Sprite::ClearEffectCache() {
+	effect_map.clear();
+	effect_list.clear();
+	stats.bytes = 0;
+	stats.entries = 0;
+}
+
+Rect Sprite::GetScreenRect() const {
+	if (!visible || !bitmap || GetWidth() <= 0 || GetHeight() <= 0)
+		return Rect();
+
+	if (angle_effect != 0.0) {
+		// Rotated sprites can end up anywhere
+		return Rect(0, 0, SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT);
+	}
+
+	if (zoom_x_effect == 1.0 && zoom_y_effect == 1.0 && waver_effect_depth == 0) {
+		return Rect(x - ox, y - oy, GetWidth(), GetHeight());
+	}
+
+	Rect rect(
+		x - static_cast<int>(std::ceil(ox * zoom_x_effect)),
+		y - static_cast<int>(std::ceil(oy * zoom_y_effect)),
+		static_cast<int>(std::ceil(GetWidth() * zoom_x_effect)) + 1,
+		static_cast<int>(std::ceil(GetHeight() * zoom_y_effect)) + 1);
+
+	if (waver_effect_depth != 0) {
+		int offset = static_cast<int>(std::ceil(2 * zoom_x_effect * std::abs(waver_effect_depth))) + 1;
+		rect.x -= offset;
+		rect.width += offset * 2;
 	}
 
-	return src_bitmap;
+	return rect;
+}
+
+bool Sprite::ReportDamage() {
+	Rect rect = GetScreenRect();
+	unsigned revision = bitmap ? bitmap->GetRevision() : 0;
+
+	if (damaged || rect != damage_rect || revision != damage_revision) {
+		Graphics::InvalidateRect(damage_rect);
+		Graphics::InvalidateRect(rect);
+		damage_rect = rect;
+		damage_revision = revision;
+		damaged = false;
+	}
+
+	return true;
 }
 
 int Sprite::GetWidth() const {
@@ -229,6 +359,7 @@ void Sprite::SetFlashEffect(const Color &color) {
 	if (flash_effect != color) {
 		flash_effect = color;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -248,6 +379,7 @@ void Sprite::SetBitmap(BitmapRef const& nbitmap) {
 
 	needs_refresh = true;
 	bitmap_changed = true;
+	damaged = true;
 }
 
 Rect const& Sprite::GetSrcRect() const {
@@ -255,12 +387,14 @@ Rect const& Sprite::GetSrcRect() const {
 }
 
 void Sprite::SetSrcRect(Rect const& nsrc_rect) {
+	if (src_rect != nsrc_rect) damaged = true;
 	src_rect = nsrc_rect;
 }
 void Sprite::SetSpriteRect(Rect const& nsprite_rect) {
 	if (src_rect_effect != nsprite_rect) {
 		src_rect_effect = nsprite_rect;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -268,6 +402,7 @@ bool Sprite::GetVisible() const {
 	return visible;
 }
 void Sprite::SetVisible(bool nvisible) {
+	if (visible != nvisible) damaged = true;
 	visible = nvisible;
 }
 
@@ -289,7 +424,10 @@ int Sprite::GetZ() const {
 	return z;
 }
 void Sprite::SetZ(int nz) {
-	if (z != nz) Graphics::UpdateZCallback();
+	if (z != nz) {
+		Graphics::UpdateZCallback(this);
+		damaged = true;
+	}
 	z = nz;
 }
 
@@ -311,6 +449,7 @@ double Sprite::GetZoomX() const {
 	return zoom_x_effect;
 }
 void Sprite::SetZoomX(double zoom_x) {
+	if (zoom_x_effect != zoom_x) damaged = true;
 	zoom_x_effect = zoom_x;
 }
 
@@ -318,6 +457,7 @@ double Sprite::GetZoomY() const {
 	return zoom_y_effect;
 }
 void Sprite::SetZoomY(double zoom_y) {
+	if (zoom_y_effect != zoom_y) damaged = true;
 	zoom_y_effect = zoom_y;
 }
 
@@ -326,6 +466,7 @@ double Sprite::GetAngle() const {
 }
 
 void Sprite::SetAngle(double angle) {
+	if (angle_effect != angle) damaged = true;
 	angle_effect = angle;
 }
 
@@ -337,6 +478,7 @@ void Sprite::SetFlipX(bool flipx) {
 	if (flipx_effect != flipx) {
 		flipx_effect = flipx;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -348,6 +490,7 @@ void Sprite::SetFlipY(bool flipy) {
 	if (flipy_effect != flipy) {
 		flipy_effect = flipy;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -359,6 +502,7 @@ void Sprite::SetBushDepth(int bush_depth) {
 	if (bush_effect != bush_depth) {
 		bush_effect = bush_depth;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -370,12 +514,14 @@ void Sprite::SetOpacity(int opacity_top, int opacity_bottom) {
 	if (opacity_top_effect != opacity_top) {
 		opacity_top_effect = opacity_top;
 		needs_refresh = true;
+		damaged = true;
 	}
 	if (opacity_bottom == -1)
 		opacity_bottom = (opacity_top + 1) / 2;
 	if (opacity_bottom_effect != opacity_bottom) {
 		opacity_bottom_effect = opacity_bottom;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -384,6 +530,7 @@ int Sprite::GetBlendType() const {
 }
 
 void Sprite::SetBlendType(int blend_type) {
+	if (blend_type_effect != blend_type) damaged = true;
 	blend_type_effect = blend_type;
 }
 
@@ -392,6 +539,7 @@ Color Sprite::GetBlendColor() const {
 }
 
 void Sprite::SetBlendColor(Color blend_color) {
+	if (blend_color_effect != blend_color) damaged = true;
 	blend_color_effect = blend_color;
 }
 
@@ -403,6 +551,7 @@ void Sprite::SetTone(Tone tone) {
 	if (tone_effect != tone) {
 		tone_effect = tone;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -414,6 +563,7 @@ void Sprite::SetWaverDepth(int depth) {
 	if (waver_effect_depth != depth) {
 		waver_effect_depth = depth;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
@@ -425,6 +575,7 @@ void Sprite::SetWaverPhase(double phase) {
 	if (waver_effect_phase != phase) {
 		waver_effect_phase = phase;
 		needs_refresh = true;
+		damaged = true;
 	}
 }
 
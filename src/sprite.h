@@ -85,6 +85,39 @@ public:
 
 	DrawableType GetType() const;
 
+	bool ReportDamage();
+
+	/**
+	 * @return screen area covered by the sprite with its current settings.
+	 */
+	Rect GetScreenRect() const;
+
+	/**
+	 * Counters of the effect cache shared by all sprites.
+	 */
+	struct EffectStats {
+		/** Effected bitmaps reused from the cache. */
+		unsigned hits;
+		/** Effected bitmaps that had to be rendered. */
+		unsigned misses;
+		/** Effected bitmaps dropped to stay in budget. */
+		unsigned evictions;
+		/** Pixel memory held by the cache. */
+		size_t bytes;
+		/** Number of cached bitmaps. */
+		size_t entries;
+	};
+
+	/**
+	 * @return effect cache counters.
+	 */
+	static EffectStats GetEffectStats();
+
+	/**
+	 * Releases all cached effected bitmaps.
+	 */
+	static void ClearEffectCache();
+
 private:
 	DrawableType type;
 
@@ -124,6 +157,7 @@ private:
 	BitmapRef bitmap_effects;
 
 	Rect bitmap_effects_src_rect;
+	unsigned bitmap_effects_revision;
 	bool bitmap_effects_valid;
 
 	Tone current_tone;
@@ -131,6 +165,10 @@ private:
 	bool current_flip_x;
 	bool current_flip_y;
 
+	Rect damage_rect;
+	unsigned damage_revision;
+	bool damaged;
+
 	void BlitScreen();
 	void BlitScreenIntern(Bitmap const& draw_bitmap,
 							Rect const& src_rect, int opacity_split) const;
@@ -26,7 +26,7 @@
 #  include <config.h>
 #endif
 
-#if !(defined(USE_SDL) || defined(_3DS))
+#if !(defined(USE_SDL) || defined(_3DS) || defined(USE_HEADLESS))
 #  error "This build doesn't target a backend"
 #endif
 
@@ -95,6 +95,10 @@
 #  endif
 #endif
 
+#ifdef USE_HEADLESS
+#  define SUPPORT_AUDIO
+#endif
+
 #ifdef _3DS
 #  define NO_SDL_MIXER
 #  undef SUPPORT_ZOOM
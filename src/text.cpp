@@ -26,91 +26,158 @@
 #include "game_system.h"
 
 #include <cctype>
+#include <list>
+#include <map>
+#include <tuple>
 
 #include <boost/next_prior.hpp>
 #include <boost/regex/pending/unicode_iterator.hpp>
 
+namespace {
+	typedef std::tuple<Font const*, Bitmap const*, int, std::string> run_key;
+
+	struct TextRun {
+		run_key key;
+		FontRef font;
+		BitmapRef system;
+		unsigned system_revision;
+		BitmapRef bitmap;
+		size_t bytes;
+	};
+
+	typedef std::list<TextRun> run_list_type;
+	run_list_type run_list;
+	std::map<run_key, run_list_type::iterator> run_map;
+
+	// Enough for the labels of a few item and skill windows
+	const size_t run_budget = 512 * 1024;
+
+	Text::Stats stats = {};
+
+	void EnforceBudget() {
+		while (stats.bytes > run_budget && !run_list.empty()) {
+			TextRun const& run = run_list.back();
+			stats.bytes -= run.bytes;
+			run_map.erase(run.key);
+			run_list.pop_back();
+			++stats.evictions;
+		}
+		stats.entries = run_list.size();
+	}
+
+	BitmapRef RenderRun(FontRef const& font, BitmapRef const& system, int color, std::string const& text) {
+		Rect const size = font->GetSize(text);
+
+		// Need place for shadow
+		BitmapRef text_surface = Bitmap::Create(size.width + 1, size.height + 1, true);
+
+		// Where to draw the next glyph (x pos)
+		int next_glyph_pos = 0;
+
+		// The current char is an exfont
+		bool is_exfont = false;
+
+		// This loops always renders a single char, color blends it and then puts
+		// it onto the text_surface (including the drop shadow)
+		for (boost::u8_to_u32_iterator<std::string::const_iterator>
+				 c(text.begin(), text.begin(), text.end()),
+				 end(text.end(), text.begin(), text.end()); c != end; ++c) {
+			boost::u8_to_u32_iterator<std::string::const_iterator> next_c_it = boost::next(c);
+			uint32_t const next_c = std::distance(c, end) > 1? *next_c_it : 0;
+
+			// ExFont-Detection: Check for A-Z or a-z behind the $
+			if (*c == '$' && std::isalpha(next_c)) {
+				int exfont_value = -1;
+				// Calculate which exfont shall be rendered
+				if (islower(next_c)) {
+					exfont_value = 26 + next_c - 'a';
+				} else if (isupper(next_c)) {
+					exfont_value = next_c - 'A';
+				} else { assert(false); }
+				is_exfont = true;
+
+				Font::exfont->Render(*text_surface, next_glyph_pos, 0, *system, color, exfont_value);
+			} else { // Not ExFont, draw normal text
+				font->Render(*text_surface, next_glyph_pos, 0, *system, color, *c);
+			}
+
+			// If it's a full size glyph, add the size of a half-size glyph twice
+			if (is_exfont) {
+				is_exfont = false;
+				next_glyph_pos += 12;
+				// Skip the next character
+				++c;
+			} else {
+				std::string const glyph(c.base(), next_c_it.base());
+				next_glyph_pos += font->GetSize(glyph).width;
+			}
+		}
+
+		return text_surface;
+	}
+
+	BitmapRef GetRun(FontRef const& font, BitmapRef const& system, int color, std::string const& text) {
+		run_key const key(font.get(), system.get(), color, text);
+		std::map<run_key, run_list_type::iterator>::iterator const it = run_map.find(key);
+
+		if (it != run_map.end()) {
+			TextRun& run = *it->second;
+			if (run.system_revision == system->GetRevision()) {
+				++stats.hits;
+				run_list.splice(run_list.begin(), run_list, it->second);
+				return run.bitmap;
+			}
+
+			// The system graphic was modified, render again
+			stats.bytes -= run.bytes;
+			run_list.erase(it->second);
+			run_map.erase(it);
+		}
+
+		++stats.misses;
+
+		TextRun run;
+		run.key = key;
+		run.font = font;
+		run.system = system;
+		run.system_revision = system->GetRevision();
+		run.bitmap = RenderRun(font, system, color, text);
+		run.bytes = run.bitmap->pitch() * run.bitmap->height();
+
+		stats.bytes += run.bytes;
+		run_list.push_front(run);
+		run_map[key] = run_list.begin();
+		EnforceBudget();
+
+		return run.bitmap;
+	}
+}
+
 void Text::Draw(Bitmap& dest, int x, int y, int color, std::string const& text, Text::Alignment align) {
 	if (text.length() == 0) return;
 
 	FontRef font = dest.GetFont();
-	Rect dst_rect = font->GetSize(text);
+	BitmapRef system = Cache::System();
+
+	// Complete text including the shadow
+	BitmapRef text_bmp = GetRun(font, system, color, text);
+	Rect dst_rect = text_bmp->GetRect();
+	int const text_width = dst_rect.width - 1;
 
 	switch (align) {
 	case Text::AlignCenter:
-		dst_rect.x = x - dst_rect.width / 2; break;
+		dst_rect.x = x - text_width / 2; break;
 	case Text::AlignRight:
-		dst_rect.x = x - dst_rect.width; break;
+		dst_rect.x = x - text_width; break;
 	case Text::AlignLeft:
 		dst_rect.x = x; break;
 	default: assert(false);
 	}
 
 	dst_rect.y = y;
-	dst_rect.width += 1; dst_rect.height += 1; // Need place for shadow
 	if (dst_rect.IsOutOfBounds(dest.GetWidth(), dest.GetHeight())) return;
 
-	BitmapRef text_surface; // Complete text will be on this surface
-	text_surface = Bitmap::Create(dst_rect.width, dst_rect.height, true);
-	text_surface->SetTransparentColor(dest.GetTransparentColor());
-	text_surface->Clear();
-
-	BitmapRef system = Cache::System();
-
-	// Where to draw the next glyph (x pos)
-	int next_glyph_pos = 0;
-
-	// The current char is an exfont
-	bool is_exfont = false;
-
-	// This loops always renders a single char, color blends it and then puts
-	// it onto the text_surface (including the drop shadow)
-	for (boost::u8_to_u32_iterator<std::string::const_iterator>
-			 c(text.begin(), text.begin(), text.end()),
-			 end(text.end(), text.begin(), text.end()); c != end; ++c) {
-		Rect next_glyph_rect(next_glyph_pos, 0, 0, 0);
-
-		boost::u8_to_u32_iterator<std::string::const_iterator> next_c_it = boost::next(c);
-		uint32_t const next_c = std::distance(c, end) > 1? *next_c_it : 0;
-
-		// ExFont-Detection: Check for A-Z or a-z behind the $
-		if (*c == '$' && std::isalpha(next_c)) {
-			int exfont_value = -1;
-			// Calculate which exfont shall be rendered
-			if (islower(next_c)) {
-				exfont_value = 26 + next_c - 'a';
-			} else if (isupper(next_c)) {
-				exfont_value = next_c - 'A';
-			} else { assert(false); }
-			is_exfont = true;
-
-			Font::exfont->Render(*text_surface, next_glyph_rect.x, next_glyph_rect.y, *system, color, exfont_value);
-		} else { // Not ExFont, draw normal text
-			font->Render(*text_surface, next_glyph_rect.x, next_glyph_rect.y, *system, color, *c);
-		}
-
-		// If it's a full size glyph, add the size of a half-size glyph twice
-		if (is_exfont) {
-			is_exfont = false;
-			next_glyph_pos += 12;
-			// Skip the next character
-			++c;
-		} else {
-			std::string const glyph(c.base(), next_c_it.base());
-			next_glyph_pos += font->GetSize(glyph).width;
-		}
-	}
-
-	BitmapRef text_bmp = Bitmap::Create(*text_surface, text_surface->GetRect());
-
-	Rect src_rect(0, 0, dst_rect.width, dst_rect.height);
-	int iy = dst_rect.y;
-	if (dst_rect.height > text_bmp->GetHeight()) {
-		iy += ((dst_rect.height - text_bmp->GetHeight()) / 2);
-	}
-	int ix = dst_rect.x;
-
-	dest.Blit(ix, iy, *text_bmp, src_rect, 255);
+	dest.Blit(dst_rect.x, dst_rect.y, *text_bmp, text_bmp->GetRect(), 255);
 }
 
 void Text::Draw(Bitmap& dest, int x, int y, Color color, std::string const& text) {
@@ -138,3 +205,14 @@ void Text::Draw(Bitmap& dest, int x, int y, Color color, std::string const& text
 		next_glyph_pos += font->GetSize(glyph).width;
 	}
 }
+
+Text::Stats Text::GetStats() {
+	return stats;
+}
+
+void Text::ClearCache() {
+	run_map.clear();
+	run_list.clear();
+	stats.bytes = 0;
+	stats.entries = 0;
+}
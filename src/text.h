@@ -29,11 +29,41 @@ namespace Text {
 		AlignRight
 	};
 
+	/**
+	 * Counters of the rendered text run cache.
+	 */
+	struct Stats {
+		/** Runs blitted from the cache. */
+		unsigned hits;
+		/** Runs that had to be rendered. */
+		unsigned misses;
+		/** Runs dropped to stay in budget. */
+		unsigned evictions;
+		/** Pixel memory held by the cached runs. */
+		size_t bytes;
+		/** Number of cached runs. */
+		size_t entries;
+	};
+
+	/**
+	 * Draws text using a system graphic color on dest.
+	 * Rendered runs are cached by font, color, system graphic and text.
+	 */
 	void Draw(Bitmap& dest, int x, int y, int color, std::string const& text, Text::Alignment align = Text::AlignLeft);
 
 	/**
 	 * Draws text using the specified color on dest
 	 */
 	void Draw(Bitmap& dest, int x, int y, Color color, std::string const& text);
+
+	/**
+	 * @return text run cache counters.
+	 */
+	Stats GetStats();
+
+	/**
+	 * Releases all cached text runs.
+	 */
+	void ClearCache();
 }
 #endif
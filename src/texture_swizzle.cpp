@@ -0,0 +1,101 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "texture_swizzle.h"
+
+namespace {
+	// Morton order inside a tile: x bits at the even, y bits at the odd
+	// positions
+	const uint8_t morton_x[8] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15 };
+	const uint8_t morton_y[8] = { 0x00, 0x02, 0x08, 0x0A, 0x20, 0x22, 0x28, 0x2A };
+
+	inline uint32_t Convert(uint32_t pixel) {
+		return __builtin_bswap32(pixel);
+	}
+
+	/** First pixel of the tile row that holds image row y, plus the Morton offset of the row. */
+	inline uint32_t* GetRow(TextureSwizzle::Texture const& texture, int y) {
+		int const ty = texture.height - 1 - y;
+		return texture.pixels + (ty & ~7) * texture.width + morton_y[ty & 7];
+	}
+}
+
+uint32_t TextureSwizzle::GetTiledOffset(Texture const& texture, int x, int y) {
+	int const ty = texture.height - 1 - y;
+	return (ty & ~7) * texture.width + (x & ~7) * tile_size + morton_x[x & 7] + morton_y[ty & 7];
+}
+
+int TextureSwizzle::SwizzleRect(Texture const& texture, Image const& image, int x, int y, int width, int height) {
+	// Whole tiles, clipped to the image
+	int const x0 = std::max(x, 0) & ~7;
+	int const y0 = std::max(y, 0) & ~7;
+	int const x1 = std::min((x + width + 7) & ~7, image.width);
+	int const y1 = std::min((y + height + 7) & ~7, image.height);
+
+	if (width <= 0 || height <= 0 || x0 >= x1 || y0 >= y1)
+		return 0;
+
+	int const full_end = x0 + (x1 - x0) / tile_size * tile_size;
+
+	for (int row = y0; row < y1; ++row) {
+		const uint32_t* src = reinterpret_cast<const uint32_t*>(image.pixels + row * image.pitch);
+		uint32_t* dst_row = GetRow(texture, row);
+
+		int tx = x0;
+		for (; tx < full_end; tx += tile_size) {
+			const uint32_t* s = src + tx;
+			uint32_t* d = dst_row + tx * tile_size;
+			d[0x00] = Convert(s[0]);
+			d[0x01] = Convert(s[1]);
+			d[0x04] = Convert(s[2]);
+			d[0x05] = Convert(s[3]);
+			d[0x10] = Convert(s[4]);
+			d[0x11] = Convert(s[5]);
+			d[0x14] = Convert(s[6]);
+			d[0x15] = Convert(s[7]);
+		}
+
+		// Image width that is not a multiple of the tile size
+		for (; tx < x1; ++tx) {
+			dst_row[(tx & ~7) * tile_size + morton_x[tx & 7]] = Convert(src[tx]);
+		}
+	}
+
+	return (x1 - x0) * (y1 - y0);
+}
+
+void TextureSwizzle::SwizzleImage(Texture const& texture, Image const& image) {
+	SwizzleRect(texture, image, 0, 0, image.width, image.height);
+}
+
+void TextureSwizzle::GetRowBytes(Texture const& texture, int y, int height, uint32_t& offset, uint32_t& size) {
+	y = std::max(y, 0);
+	height = std::min(height, texture.height - y);
+	if (height <= 0) {
+		offset = 0;
+		size = 0;
+		return;
+	}
+
+	// Rows are stored bottom up
+	int const first = (texture.height - y - height) & ~7;
+	int const last = (texture.height - 1 - y) | 7;
+	offset = first * texture.width * 4;
+	size = (last + 1 - first) * texture.width * 4;
+}
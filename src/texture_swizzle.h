@@ -0,0 +1,102 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_TEXTURE_SWIZZLE_H_
+#define _EASYRPG_TEXTURE_SWIZZLE_H_
+
+// Headers
+#include <stdint.h>
+
+/**
+ * TextureSwizzle namespace.
+ * Converts linear 32-bit images to the tiled layout of 3DS GPU textures.
+ * A tiled texture is stored bottom row first in 8x8 pixel tiles, the
+ * pixels of a tile in Morton (Z) order and every pixel byte swapped
+ * (RGBA8 in memory becomes the ABGR8 word the GPU reads).
+ */
+namespace TextureSwizzle {
+	/** Edge of a texture tile in pixels. */
+	const int tile_size = 8;
+
+	/**
+	 * Texture the image is swizzled into.
+	 */
+	struct Texture {
+		uint32_t* pixels;
+		/** Power of two texture size, at least the image size. */
+		int width;
+		int height;
+	};
+
+	/**
+	 * Image that is swizzled.
+	 */
+	struct Image {
+		const uint8_t* pixels;
+		/** Bytes between two rows. */
+		int pitch;
+		int width;
+		int height;
+	};
+
+	/**
+	 * Gets the position of an image pixel in the tiled texture.
+	 *
+	 * @param texture texture.
+	 * @param x column.
+	 * @param y row, counted from the top of the image.
+	 * @return index of the pixel in texture.pixels.
+	 */
+	uint32_t GetTiledOffset(Texture const& texture, int x, int y);
+
+	/**
+	 * Converts the tiles covering a rectangle of the image. The rectangle
+	 * is extended to whole tiles and clipped to the image, pixels of the
+	 * texture outside of the image are left untouched.
+	 *
+	 * @param texture destination texture.
+	 * @param image source image.
+	 * @param x left edge of the rectangle.
+	 * @param y top edge of the rectangle.
+	 * @param width rectangle width.
+	 * @param height rectangle height.
+	 * @return number of converted pixels.
+	 */
+	int SwizzleRect(Texture const& texture, Image const& image, int x, int y, int width, int height);
+
+	/**
+	 * Converts the whole image.
+	 *
+	 * @param texture destination texture.
+	 * @param image source image.
+	 */
+	void SwizzleImage(Texture const& texture, Image const& image);
+
+	/**
+	 * Gets the bytes of the texture holding the tiled rows of a range of
+	 * image rows, e.g. to flush them from the CPU cache.
+	 *
+	 * @param texture texture.
+	 * @param y first image row.
+	 * @param height number of image rows.
+	 * @param offset first byte.
+	 * @param size number of bytes.
+	 */
+	void GetRowBytes(Texture const& texture, int y, int height, uint32_t& offset, uint32_t& size);
+}
+
+#endif
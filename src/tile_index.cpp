@@ -0,0 +1,149 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cassert>
+#include "tile_index.h"
+
+TileIndex::TileIndex() :
+	width(0), height(0) {
+}
+
+void TileIndex::Reset(int width, int height, int count) {
+	this->width = width;
+	this->height = height;
+	heads.assign(width * height, -1);
+
+	Item const item = { 0, 0, TileNone, -1, -1 };
+	items.assign(count, item);
+	outside.clear();
+}
+
+void TileIndex::Place(int item, int x, int y) {
+	assert(item >= 0 && item < (int)items.size());
+
+	Item& it = items[item];
+	if (it.tile != TileNone && it.x == x && it.y == y)
+		return;
+
+	Unlink(item);
+	it.x = x;
+	it.y = y;
+	it.tile = GetTile(x, y);
+	Link(item);
+}
+
+void TileIndex::Remove(int item) {
+	assert(item >= 0 && item < (int)items.size());
+
+	Unlink(item);
+	items[item].tile = TileNone;
+}
+
+void TileIndex::Get(int x, int y, std::vector<int>& result) const {
+	int const tile = GetTile(x, y);
+
+	if (tile == TileOutside) {
+		for (std::vector<int>::const_iterator it = outside.begin(); it != outside.end(); ++it) {
+			if (items[*it].x == x && items[*it].y == y) {
+				result.push_back(*it);
+			}
+		}
+		return;
+	}
+
+	for (int item = heads[tile]; item != -1; item = items[item].next) {
+		result.push_back(item);
+	}
+}
+
+int TileIndex::GetFirst(int x, int y) const {
+	int const tile = GetTile(x, y);
+
+	if (tile == TileOutside) {
+		for (std::vector<int>::const_iterator it = outside.begin(); it != outside.end(); ++it) {
+			if (items[*it].x == x && items[*it].y == y) {
+				return *it;
+			}
+		}
+		return -1;
+	}
+
+	return heads[tile];
+}
+
+size_t TileIndex::size() const {
+	return items.size();
+}
+
+int TileIndex::GetTile(int x, int y) const {
+	if (x < 0 || x >= width || y < 0 || y >= height)
+		return TileOutside;
+	return x + y * width;
+}
+
+void TileIndex::Link(int item) {
+	Item& it = items[item];
+
+	if (it.tile == TileOutside) {
+		outside.insert(std::lower_bound(outside.begin(), outside.end(), item), item);
+		return;
+	}
+
+	// Few items share a tile, a linear search keeps the list sorted
+	int prev = -1;
+	int next = heads[it.tile];
+	while (next != -1 && next < item) {
+		prev = next;
+		next = items[next].next;
+	}
+
+	it.prev = prev;
+	it.next = next;
+	if (prev == -1) {
+		heads[it.tile] = item;
+	} else {
+		items[prev].next = item;
+	}
+	if (next != -1) {
+		items[next].prev = item;
+	}
+}
+
+void TileIndex::Unlink(int item) {
+	Item& it = items[item];
+
+	if (it.tile == TileNone)
+		return;
+
+	if (it.tile == TileOutside) {
+		outside.erase(std::lower_bound(outside.begin(), outside.end(), item));
+		return;
+	}
+
+	if (it.prev == -1) {
+		heads[it.tile] = it.next;
+	} else {
+		items[it.prev].next = it.next;
+	}
+	if (it.next != -1) {
+		items[it.next].prev = it.prev;
+	}
+	it.prev = -1;
+	it.next = -1;
+}
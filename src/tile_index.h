@@ -0,0 +1,114 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_TILE_INDEX_H_
+#define _EASYRPG_TILE_INDEX_H_
+
+// Headers
+#include <vector>
+#include <stddef.h>
+
+/**
+ * TileIndex class.
+ * Buckets items (e.g. the events of a map, identified by their index) by
+ * the tile they stand on, so position queries only look at the items of
+ * one tile instead of all of them.
+ * Every tile keeps a doubly linked list of its items sorted by item, moving
+ * an item unlinks it from the old and links it into the new tile. Items
+ * outside of the map are kept in a separate sorted list.
+ */
+class TileIndex {
+public:
+	TileIndex();
+
+	/**
+	 * Removes all items and resizes the index.
+	 *
+	 * @param width map width in tiles.
+	 * @param height map height in tiles.
+	 * @param count number of items, all of them are not placed yet.
+	 */
+	void Reset(int width, int height, int count);
+
+	/**
+	 * Places an item on a tile, it is removed from its old tile first.
+	 *
+	 * @param item item, 0 to count - 1.
+	 * @param x tile x, may be outside of the map.
+	 * @param y tile y, may be outside of the map.
+	 */
+	void Place(int item, int x, int y);
+
+	/**
+	 * Removes an item until it is placed again.
+	 *
+	 * @param item item.
+	 */
+	void Remove(int item);
+
+	/**
+	 * Gets the items on a tile.
+	 *
+	 * @param x tile x.
+	 * @param y tile y.
+	 * @param items the items are appended in ascending order.
+	 */
+	void Get(int x, int y, std::vector<int>& items) const;
+
+	/**
+	 * Gets the lowest item on a tile.
+	 *
+	 * @param x tile x.
+	 * @param y tile y.
+	 * @return item, -1 if there is none.
+	 */
+	int GetFirst(int x, int y) const;
+
+	/**
+	 * @return number of items.
+	 */
+	size_t size() const;
+
+private:
+	enum {
+		/** Not placed or removed. */
+		TileNone = -2,
+		/** Placed outside of the map. */
+		TileOutside = -1
+	};
+
+	struct Item {
+		int x;
+		int y;
+		int tile;
+		int prev;
+		int next;
+	};
+
+	int GetTile(int x, int y) const;
+	void Link(int item);
+	void Unlink(int item);
+
+	int width;
+	int height;
+	/** First item of every tile, -1 when empty. */
+	std::vector<int> heads;
+	std::vector<Item> items;
+	std::vector<int> outside;
+};
+
+#endif
@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 #include "tilemap_layer.h"
@@ -159,24 +160,186 @@ TilemapLayer::TilemapLayer(int ilayer) :
 	sublayers.push_back(EASYRPG_MAKE_SHARED<TilemapSubLayer>(this, -2+layer));
 }
 
-void TilemapLayer::DrawTile(Bitmap& screen, int x, int y, int row, int col, bool autotile) {
+void TilemapLayer::DrawTile(Bitmap& dst, Bitmap& screen, int x, int y, int row, int col, bool autotile) {
 	Bitmap::TileOpacity op = screen.GetTileOpacity(row, col);
 	
 	if (!fast_blit && op == Bitmap::Transparent)
 		return;
 	Rect rect(col * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
 
-	BitmapRef dst = DisplayUi->GetDisplaySurface();
-	
 	if (fast_blit || op == Bitmap::Opaque) {
-		dst->BlitFast(x, y, screen, rect, 255);
+		dst.BlitFast(x, y, screen, rect, 255);
 	} else {
-		dst->Blit(x, y, screen, rect, 255);
+		dst.Blit(x, y, screen, rect, 255);
+	}
+}
+
+void TilemapLayer::DrawTileData(Bitmap& dst, int x, int y, const TileData& tile) {
+	switch (tile.source) {
+		case TileSourceChipset:
+			DrawTile(dst, *chipset, x, y, tile.row[0], tile.col[0], false);
+			break;
+		case TileSourceBlockC:
+			DrawTile(dst, *chipset, x, y, tile.row[0] + animation_step_c, tile.col[0], false);
+			break;
+		case TileSourceAutotileAB:
+			DrawTile(dst, *autotiles_ab_screen, x, y, tile.row[(int)animation_step_ab], tile.col[(int)animation_step_ab], true);
+			break;
+		case TileSourceAutotileD:
+			DrawTile(dst, *autotiles_d_screen, x, y, tile.row[0], tile.col[0], true);
+			break;
+		default:
+			break;
+	}
+}
+
+void TilemapLayer::ResolveTileSource(TileData& tile) {
+	tile.source = TileSourceNone;
+
+	if (layer == 0) {
+		// If lower layer
+
+		if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
+			// If Block E
+			if ((size_t)(tile.ID - BLOCK_E) >= substitutions.size())
+				return;
+
+			int id = substitutions[tile.ID - BLOCK_E];
+
+			// Get the tile coordinates from chipset
+			if (id < 96) {
+				// If from first column of the block
+				tile.col[0] = 12 + id % 6;
+				tile.row[0] = id / 6;
+			} else {
+				// If from second column of the block
+				tile.col[0] = 18 + (id - 96) % 6;
+				tile.row[0] = (id - 96) / 6;
+			}
+			tile.source = TileSourceChipset;
+		} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
+			// If Block C, the row advances with the animation
+			tile.col[0] = 3 + (tile.ID - BLOCK_C) / 50;
+			tile.row[0] = 4;
+			tile.source = TileSourceBlockC;
+		} else if (tile.ID < BLOCK_C) {
+			// If Blocks A1, A2, B, one position per animation step
+			for (int step = 0; step < 3; ++step) {
+				TileXY pos = GetCachedAutotileAB(tile.ID, step);
+				tile.col[step] = pos.x;
+				tile.row[step] = pos.y;
+			}
+			tile.source = TileSourceAutotileAB;
+		} else if (tile.ID < BLOCK_E) {
+			// If blocks D1-D12
+			TileXY pos = GetCachedAutotileD(tile.ID);
+			tile.col[0] = pos.x;
+			tile.row[0] = pos.y;
+			tile.source = TileSourceAutotileD;
+		}
+	} else {
+		// If upper layer
+
+		// Check that block F is being drawn
+		if (tile.ID >= BLOCK_F && tile.ID < BLOCK_F + BLOCK_F_TILES) {
+			if ((size_t)(tile.ID - BLOCK_F) >= substitutions.size())
+				return;
+
+			int id = substitutions[tile.ID - BLOCK_F];
+
+			// Get the tile coordinates from chipset
+			if (id < 48) {
+				// If from first column of the block
+				tile.col[0] = 18 + id % 6;
+				tile.row[0] = 8 + id / 6;
+			} else {
+				// If from second column of the block
+				tile.col[0] = 24 + (id - 48) % 6;
+				tile.row[0] = (id - 48) / 6;
+			}
+			tile.source = TileSourceChipset;
+		}
+	}
+}
+
+void TilemapLayer::RenderChunk(int chunk_x, int chunk_y, int z_order) {
+	Chunk& chunk = chunks[chunk_x + chunk_y * chunks_x];
+	int sub = z_order < 0 ? 0 : 1;
+
+	int tile_x = chunk_x * CHUNK_TILES;
+	int tile_y = chunk_y * CHUNK_TILES;
+	int tiles_w = std::min(CHUNK_TILES, width - tile_x);
+	int tiles_h = std::min(CHUNK_TILES, height - tile_y);
+
+	BitmapRef& bitmap = chunk.bitmaps[sub];
+	if (bitmap) {
+		bitmap->Clear();
+	}
+
+	bool empty = true;
+
+	for (int y = 0; y < tiles_h; ++y) {
+		const TileData* row = &data_cache[tile_x + (tile_y + y) * width];
+
+		for (int x = 0; x < tiles_w; ++x) {
+			const TileData& tile = row[x];
+			if (tile.z != z_order || tile.source == TileSourceNone) {
+				continue;
+			}
+
+			if (!bitmap) {
+				bitmap = Bitmap::Create(tiles_w * TILE_SIZE, tiles_h * TILE_SIZE, true);
+			}
+
+			DrawTileData(*bitmap, x * TILE_SIZE, y * TILE_SIZE, tile);
+			empty = false;
+		}
+	}
+
+	if (empty) {
+		// Nothing of this sublayer is in the chunk, don't keep a bitmap around
+		bitmap.reset();
+	}
+
+	chunk.valid[sub] = true;
+	chunk.step_ab[sub] = animation_step_ab;
+	chunk.step_c[sub] = animation_step_c;
+}
+
+void TilemapLayer::RenderAnimatedTiles(int chunk_x, int chunk_y, int z_order) {
+	Chunk& chunk = chunks[chunk_x + chunk_y * chunks_x];
+	int sub = z_order < 0 ? 0 : 1;
+
+	bool step_ab_changed = chunk.step_ab[sub] != animation_step_ab;
+	bool step_c_changed = chunk.step_c[sub] != animation_step_c;
+	chunk.step_ab[sub] = animation_step_ab;
+	chunk.step_c[sub] = animation_step_c;
+
+	if (!chunk.bitmaps[sub]) return;
+
+	Bitmap& bitmap = *chunk.bitmaps[sub];
+	int tile_x = chunk_x * CHUNK_TILES;
+	int tile_y = chunk_y * CHUNK_TILES;
+
+	for (int index : chunk.animated) {
+		const TileData& tile = data_cache[index];
+		if (tile.z != z_order ||
+			!((step_ab_changed && tile.source == TileSourceAutotileAB) ||
+			(step_c_changed && tile.source == TileSourceBlockC))) {
+			continue;
+		}
+
+		int x = (index % width - tile_x) * TILE_SIZE;
+		int y = (index / width - tile_y) * TILE_SIZE;
+
+		// The tile is drawn over its previous step
+		bitmap.ClearRect(Rect(x, y, TILE_SIZE, TILE_SIZE));
+		DrawTileData(bitmap, x, y, tile);
 	}
 }
 
 void TilemapLayer::Draw(int z_order) {
-	if (!visible) return;
+	if (!visible || chunks.empty()) return;
 
 	// Get the number of tiles that can be displayed on window
 	int tiles_x = (int)ceil(DisplayUi->GetWidth() / (float)TILE_SIZE);
@@ -191,94 +354,76 @@ void TilemapLayer::Draw(int z_order) {
 		++tiles_y;
 	}
 
-	for (int x = 0; x < tiles_x; x++) {
-		for (int y = 0; y < tiles_y; y++) {
+	TilemapLayout::GetTileSpans(ox, tiles_x, width, CHUNK_TILES, spans_x);
+	TilemapLayout::GetTileSpans(oy, tiles_y, height, CHUNK_TILES, spans_y);
 
-			// Get the real maps tile coordinates
-			int map_x = (ox / TILE_SIZE + x + width) % width;
-			int map_y = (oy / TILE_SIZE + y + height) % height;
-
-			if (width <= map_x || height <= map_y) continue;
-
-			int map_draw_x = x * TILE_SIZE - ox % TILE_SIZE;
-			int map_draw_y = y * TILE_SIZE - oy % TILE_SIZE;
+	int sub = z_order < 0 ? 0 : 1;
+	BitmapRef dst = DisplayUi->GetDisplaySurface();
 
-			// Get the tile data
-			TileData &tile = data_cache[map_x][map_y];
+	// Both sublayers draw the same view, count a drawn frame once
+	if (sub == 0) {
+		++chunk_frame;
+	}
 
-			// Draw the sublayer if its z is being draw now
-			if (z_order == tile.z) {
-				if (layer == 0) {
-					// If lower layer
+	for (const TileSpan& span_x : spans_x) {
+		for (const TileSpan& span_y : spans_y) {
+			int chunk_x = span_x.map / CHUNK_TILES;
+			int chunk_y = span_y.map / CHUNK_TILES;
+			Chunk& chunk = chunks[chunk_x + chunk_y * chunks_x];
 
-					if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
-						int id = substitutions[tile.ID - BLOCK_E];
-						// If Block E
+			chunk.last_used = chunk_frame;
 
-						int row, col;
+			if (!chunk.valid[sub]) {
+				RenderChunk(chunk_x, chunk_y, z_order);
+			} else if (chunk.step_ab[sub] != animation_step_ab || chunk.step_c[sub] != animation_step_c) {
+				RenderAnimatedTiles(chunk_x, chunk_y, z_order);
+			}
 
-						// Get the tile coordinates from chipset
-						if (id < 96) {
-							// If from first column of the block
-							col = 12 + id % 6;
-							row = id / 6;
-						} else {
-							// If from second column of the block
-							col = 18 + (id - 96) % 6;
-							row = (id - 96) / 6;
-						}
+			if (!chunk.bitmaps[sub]) continue;
 
-						DrawTile(*chipset, map_draw_x, map_draw_y, row, col, false);
-					} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
-						// If Block C
+			Rect src_rect(
+				(span_x.map % CHUNK_TILES) * TILE_SIZE,
+				(span_y.map % CHUNK_TILES) * TILE_SIZE,
+				span_x.count * TILE_SIZE,
+				span_y.count * TILE_SIZE);
 
-						// Get the tile coordinates from chipset
-						int col = 3 + (tile.ID - BLOCK_C) / 50;
-						int row = 4 + animation_step_c;
+			int map_draw_x = span_x.screen * TILE_SIZE - ox % TILE_SIZE;
+			int map_draw_y = span_y.screen * TILE_SIZE - oy % TILE_SIZE;
 
-						// Draw the tile
-						DrawTile(*chipset, map_draw_x, map_draw_y, row, col, false);
-					} else if (tile.ID < BLOCK_C) {
-						// If Blocks A1, A2, B
+			// Tiles of the other sublayer are transparent in the chunk, only the
+			// lowest sublayer may overwrite what is below it
+			if (fast_blit && sub == 0) {
+				dst->BlitFast(map_draw_x, map_draw_y, *chunk.bitmaps[sub], src_rect, 255);
+			} else {
+				dst->Blit(map_draw_x, map_draw_y, *chunk.bitmaps[sub], src_rect, 255);
+			}
+		}
+	}
 
-						// Draw the tile from autotile cache
-						TileXY pos = GetCachedAutotileAB(tile.ID, animation_step_ab);
-						DrawTile(*autotiles_ab_screen, map_draw_x, map_draw_y, pos.y, pos.x, true);
-					} else {
-						// If blocks D1-D12
+	if (sub == 0) {
+		EvictChunks();
+	}
+}
 
-						// Draw the tile from autotile cache
-						TileXY pos = GetCachedAutotileD(tile.ID);
-						DrawTile(*autotiles_d_screen, map_draw_x, map_draw_y, pos.y, pos.x, true);
-					}
-				} else {
-					// If upper layer
-
-					// Check that block F is being drawn
-					if (tile.ID >= BLOCK_F && tile.ID < BLOCK_F + BLOCK_F_TILES) {
-						int id = substitutions[tile.ID - BLOCK_F];
-						int row, col;
-
-						// Get the tile coordinates from chipset
-						if (id < 48) {
-							// If from first column of the block
-							col = 18 + id % 6;
-							row = 8 + id / 6;
-						} else {
-							// If from second column of the block
-							col = 24 + (id - 48) % 6;
-							row = (id - 48) / 6;
-						}
-
-						// Draw the tile
-						DrawTile(*chipset, map_draw_x, map_draw_y, row, col, false);
-					}
-				}
-			}
+void TilemapLayer::EvictChunks() {
+	// Free chunks that were not drawn for a while, they scrolled out of view
+	for (Chunk& chunk : chunks) {
+		if (chunk_frame - chunk.last_used > CHUNK_KEEP_FRAMES) {
+			chunk.bitmaps[0].reset();
+			chunk.bitmaps[1].reset();
+			chunk.valid[0] = false;
+			chunk.valid[1] = false;
 		}
 	}
 }
 
+void TilemapLayer::InvalidateChunks() {
+	for (Chunk& chunk : chunks) {
+		chunk.valid[0] = false;
+		chunk.valid[1] = false;
+	}
+}
+
 TilemapLayer::TileXY TilemapLayer::GetCachedAutotileAB(short ID, short animID) {
 	short block = ID / 1000;
 	short b_subtile = (ID - block * 1000) / 50;
@@ -293,11 +438,10 @@ TilemapLayer::TileXY TilemapLayer::GetCachedAutotileD(short ID) {
 }
 
 void TilemapLayer::CreateTileCache(const std::vector<short>& nmap_data) {
-	data_cache.resize(width);
-	for (int x = 0; x < width; x++) {
-		data_cache[x].resize(height);
-		for (int y = 0; y < height; y++) {
-			TileData tile;
+	data_cache.resize(width * height);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			TileData& tile = data_cache[x + y * width];
 
 			// Get the tile ID
 			tile.ID = nmap_data[x + y * width];
@@ -325,7 +469,25 @@ void TilemapLayer::CreateTileCache(const std::vector<short>& nmap_data) {
 
 				}
 			}
-			data_cache[x][y] = tile;
+
+			ResolveTileSource(tile);
+		}
+	}
+
+	// Chunks are rendered on demand, only remember where their animated
+	// tiles are
+	chunks_x = (width + CHUNK_TILES - 1) / CHUNK_TILES;
+	chunks_y = (height + CHUNK_TILES - 1) / CHUNK_TILES;
+	chunks.clear();
+	chunks.resize(chunks_x * chunks_y);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			Chunk& chunk = chunks[x / CHUNK_TILES + (y / CHUNK_TILES) * chunks_x];
+			uint8_t source = data_cache[x + y * width].source;
+			if (source == TileSourceAutotileAB || source == TileSourceBlockC) {
+				chunk.animated.push_back(x + y * width);
+			}
 		}
 	}
 }
@@ -555,12 +717,66 @@ void TilemapLayer::Update() {
 	}
 }
 
+void TilemapLayer::ReportDamage() {
+	bool step_ab_changed = animation_step_ab != damage_step_ab;
+	bool step_c_changed = animation_step_c != damage_step_c;
+	damage_step_ab = animation_step_ab;
+	damage_step_c = animation_step_c;
+
+	if (damaged) {
+		// Scrolling and map changes touch the whole layer
+		Graphics::InvalidateAll();
+		damaged = false;
+		return;
+	}
+
+	// Only the lower layer contains animated tiles (Blocks A, B and C)
+	if (!visible || layer != 0 || (!step_ab_changed && !step_c_changed) ||
+		width <= 0 || height <= 0 || data_cache.empty()) {
+		return;
+	}
+
+	int tiles_x = (int)ceil(DisplayUi->GetWidth() / (float)TILE_SIZE);
+	int tiles_y = (int)ceil(DisplayUi->GetHeight() / (float)TILE_SIZE);
+
+	if (ox % TILE_SIZE != 0) {
+		++tiles_x;
+	}
+	if (oy % TILE_SIZE != 0) {
+		++tiles_y;
+	}
+
+	TilemapLayout::GetTileSpans(ox, tiles_x, width, CHUNK_TILES, spans_x);
+	TilemapLayout::GetTileSpans(oy, tiles_y, height, CHUNK_TILES, spans_y);
+
+	for (const TileSpan& span_y : spans_y) {
+		for (int y = 0; y < span_y.count; y++) {
+			const TileData* row = &data_cache[(span_y.map + y) * width];
+			int draw_y = (span_y.screen + y) * TILE_SIZE - oy % TILE_SIZE;
+
+			for (const TileSpan& span_x : spans_x) {
+				const TileData* tile = row + span_x.map;
+
+				for (int x = 0; x < span_x.count; x++, tile++) {
+					if ((step_ab_changed && tile->source == TileSourceAutotileAB) ||
+						(step_c_changed && tile->source == TileSourceBlockC)) {
+						Graphics::InvalidateRect(Rect((span_x.screen + x) * TILE_SIZE - ox % TILE_SIZE,
+							draw_y, TILE_SIZE, TILE_SIZE));
+					}
+				}
+			}
+		}
+	}
+}
+
 BitmapRef const& TilemapLayer::GetChipset() const {
 	return chipset;
 }
 
 void TilemapLayer::SetChipset(BitmapRef const& nchipset) {
 	chipset = nchipset;
+	damaged = true;
+	InvalidateChunks();
 	if (autotiles_ab_next != 0 && autotiles_d_screen != 0 && layer == 0) {
 		autotiles_ab_screen = GenerateAutotiles(autotiles_ab_next, autotiles_ab_map);
 		autotiles_d_screen = GenerateAutotiles(autotiles_d_next, autotiles_d_map);
@@ -572,8 +788,6 @@ std::vector<short> TilemapLayer::GetMapData() const {
 }
 
 void TilemapLayer::SetMapData(const std::vector<short>& nmap_data) {
-	// Create the tiles data cache
-	CreateTileCache(nmap_data);
 	memset(autotiles_ab, 0, sizeof(autotiles_ab));
 	memset(autotiles_d, 0, sizeof(autotiles_d));
 
@@ -584,17 +798,18 @@ void TilemapLayer::SetMapData(const std::vector<short>& nmap_data) {
 		autotiles_d_next = 0;
 		for (int y = 0; y < height; y++) {
 			for (int x = 0; x < width; x++) {
+				short id = nmap_data[x + y * width];
 
-				if (data_cache[x][y].ID < BLOCK_C) {
+				if (id < BLOCK_C) {
 					// If blocks A and B
 
-					GenerateAutotileAB(data_cache[x][y].ID, 0);
-					GenerateAutotileAB(data_cache[x][y].ID, 1);
-					GenerateAutotileAB(data_cache[x][y].ID, 2);
-				} else if (data_cache[x][y].ID >= BLOCK_D && data_cache[x][y].ID < BLOCK_E) {
+					GenerateAutotileAB(id, 0);
+					GenerateAutotileAB(id, 1);
+					GenerateAutotileAB(id, 2);
+				} else if (id >= BLOCK_D && id < BLOCK_E) {
 					// If block D
 
-					GenerateAutotileD(data_cache[x][y].ID);
+					GenerateAutotileD(id);
 				}
 			}
 		}
@@ -602,7 +817,11 @@ void TilemapLayer::SetMapData(const std::vector<short>& nmap_data) {
 		autotiles_d_screen = GenerateAutotiles(autotiles_d_next, autotiles_d_map);
 	}
 
+	// Create the tiles data cache, needs the autotile positions
+	CreateTileCache(nmap_data);
+
 	map_data = nmap_data;
+	damaged = true;
 }
 
 std::vector<unsigned char> TilemapLayer::GetPassable() const {
@@ -621,6 +840,7 @@ void TilemapLayer::SetPassable(const std::vector<unsigned char>& npassable) {
 
 	// Recalculate z values of all tiles
 	CreateTileCache(map_data);
+	damaged = true;
 }
 
 bool TilemapLayer::GetVisible() const {
@@ -628,6 +848,7 @@ bool TilemapLayer::GetVisible() const {
 }
 
 void TilemapLayer::SetVisible(bool nvisible) {
+	if (visible != nvisible) damaged = true;
 	visible = nvisible;
 }
 
@@ -636,6 +857,7 @@ int TilemapLayer::GetOx() const {
 }
 
 void TilemapLayer::SetOx(int nox) {
+	if (ox != nox) damaged = true;
 	ox = nox;
 }
 
@@ -644,6 +866,7 @@ int TilemapLayer::GetOy() const {
 }
 
 void TilemapLayer::SetOy(int noy) {
+	if (oy != noy) damaged = true;
 	oy = noy;
 }
 
@@ -692,6 +915,7 @@ void TilemapLayer::Substitute(int old_id, int new_id) {
 	if (subst_count > 0) {
 		// Recalculate z values of all tiles
 		CreateTileCache(map_data);
+		damaged = true;
 	}
 }
 
@@ -711,6 +935,11 @@ TilemapSubLayer::~TilemapSubLayer() {
 	Graphics::RemoveDrawable(this);
 }
 
+bool TilemapSubLayer::ReportDamage() {
+	tilemap->ReportDamage();
+	return true;
+}
+
 void TilemapSubLayer::Draw() {
 	if (!tilemap->GetChipset()) {
 		return;
@@ -23,6 +23,7 @@
 #include <map>
 #include "system.h"
 #include "drawable.h"
+#include "tilemap_layout.h"
 
 class TilemapLayer;
 
@@ -36,6 +37,8 @@ public:
 
 	void Draw();
 
+	bool ReportDamage();
+
 	int GetZ() const;
 
 	DrawableType GetType() const;
@@ -53,11 +56,18 @@ class TilemapLayer {
 public:
 	TilemapLayer(int ilayer);
 
-	void DrawTile(Bitmap& screen, int x, int y, int row, int col, bool autotile);
+	void DrawTile(Bitmap& dst, Bitmap& screen, int x, int y, int row, int col, bool autotile);
 	void Draw(int z_order);
 
 	void Update();
 
+	/**
+	 * Invalidates the screen areas that changed since the last call.
+	 * Animated tiles are reported individually, any other change
+	 * invalidates the whole screen.
+	 */
+	void ReportDamage();
+
 	BitmapRef const& GetChipset() const;
 	void SetChipset(BitmapRef const& nchipset);
 	std::vector<short> GetMapData() const;
@@ -107,6 +117,9 @@ private:
 	int animation_type;
 	int layer;
 	bool fast_blit = false;
+	bool damaged = true;
+	char damage_step_ab = 0;
+	char damage_step_c = 0;
 
 	void CreateTileCache(const std::vector<short>& nmap_data);
 	void GenerateAutotileAB(short ID, short animID);
@@ -138,12 +151,73 @@ private:
 	std::map<uint32_t, TileXY> autotiles_ab_map;
 	std::map<uint32_t, TileXY> autotiles_d_map;
 
-	struct TileData {
-		short ID;
-		int z;
+	enum TileSource {
+		TileSourceNone,
+		TileSourceChipset,
+		TileSourceBlockC,
+		TileSourceAutotileAB,
+		TileSourceAutotileD
 	};
-	std::vector<std::vector<TileData> > data_cache;
+
+	typedef TilemapLayout::TileData TileData;
+
+	void ResolveTileSource(TileData& tile);
+
+	/** Tiles of the map in row-major order (x + y * width). */
+	std::vector<TileData> data_cache;
 	std::vector<EASYRPG_SHARED_PTR<TilemapSubLayer> > sublayers;
+
+	void DrawTileData(Bitmap& dst, int x, int y, const TileData& tile);
+
+	/** Size of a pre-rendered chunk in tiles (256x256 pixels). */
+	static const int CHUNK_TILES = 16;
+	/** Drawn frames a chunk stays cached after it was last used. */
+	static const int CHUNK_KEEP_FRAMES = 2;
+
+	/**
+	 * Pre-rendered block of tiles. Holds one bitmap per sublayer, the
+	 * bitmap is empty when the sublayer has no tiles in the chunk.
+	 * Animated tiles are redrawn in place when the animation steps, the
+	 * static tiles stay as they are.
+	 */
+	struct Chunk {
+		BitmapRef bitmaps[2];
+		bool valid[2] = { false, false };
+		/** Animation steps the bitmaps show. */
+		char step_ab[2] = { 0, 0 };
+		char step_c[2] = { 0, 0 };
+		/** Map indices of the Block A, B and C tiles of the chunk. */
+		std::vector<int> animated;
+		unsigned last_used = 0;
+	};
+
+	typedef TilemapLayout::TileSpan TileSpan;
+
+	void RenderChunk(int chunk_x, int chunk_y, int z_order);
+
+	/**
+	 * Redraws the animated tiles of a rendered chunk whose animation step
+	 * changed since it was drawn.
+	 */
+	void RenderAnimatedTiles(int chunk_x, int chunk_y, int z_order);
+
+	/**
+	 * Marks all chunks for re-rendering.
+	 */
+	void InvalidateChunks();
+
+	/**
+	 * Frees the chunks that were not used by the last drawn frames.
+	 * Called by Draw, so frames that are skipped don't age the chunks.
+	 */
+	void EvictChunks();
+
+	std::vector<Chunk> chunks;
+	int chunks_x = 0;
+	int chunks_y = 0;
+	unsigned chunk_frame = 0;
+	std::vector<TileSpan> spans_x;
+	std::vector<TileSpan> spans_y;
 };
 
 #endif
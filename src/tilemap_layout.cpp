@@ -0,0 +1,41 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "tilemap_layout.h"
+#include "options.h"
+
+void TilemapLayout::GetTileSpans(int offset, int tiles, int size, int chunk_tiles, std::vector<TileSpan>& spans) {
+	spans.clear();
+
+	for (int i = 0; i < tiles; i++) {
+		int map = (offset / TILE_SIZE + i + size) % size;
+
+		if (map < 0 || size <= map) continue;
+
+		if (!spans.empty()) {
+			TileSpan& last = spans.back();
+			if (last.screen + last.count == i && last.map + last.count == map && map % chunk_tiles != 0) {
+				++last.count;
+				continue;
+			}
+		}
+
+		TileSpan span = { i, map, 1 };
+		spans.push_back(span);
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_TILEMAP_LAYOUT_H_
+#define _EASYRPG_TILEMAP_LAYOUT_H_
+
+// Headers
+#include <vector>
+#include <stdint.h>
+
+/**
+ * TilemapLayout namespace.
+ * Tile storage of TilemapLayer and the walk over the visible part of the
+ * map: the tiles are kept in row-major order and the visible rows and
+ * columns are split in runs that are continuous on the map, so the map
+ * wraparound is computed once per run instead of once per tile.
+ */
+namespace TilemapLayout {
+	/**
+	 * Tile with precomputed source coordinates.
+	 * Autotiles of Block A and B have a position per animation step, for
+	 * Block C the animation step is added to the row.
+	 */
+	struct TileData {
+		short ID;
+		int8_t z;
+		uint8_t source;
+		uint8_t col[3];
+		uint8_t row[3];
+	};
+
+	/** Run of visible tiles continuous on the map and inside one chunk. */
+	struct TileSpan {
+		/** First tile on the screen. */
+		int screen;
+		/** First tile on the map. */
+		int map;
+		int count;
+	};
+
+	/**
+	 * Splits the visible tiles of one axis in spans.
+	 * A span ends at the map border and at chunk borders.
+	 *
+	 * @param offset scroll position in pixels.
+	 * @param tiles number of visible tiles.
+	 * @param size map size in tiles.
+	 * @param chunk_tiles chunk size in tiles.
+	 * @param spans receives the spans, in screen order.
+	 */
+	void GetTileSpans(int offset, int tiles, int size, int chunk_tiles, std::vector<TileSpan>& spans);
+}
+
+#endif
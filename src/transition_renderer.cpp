@@ -0,0 +1,498 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "transition_renderer.h"
+
+using BitmapKernels::Region;
+
+namespace {
+	/** Edge of the random blocks in pixels. */
+	const int block_size = 4;
+	/** Rows of random jitter of the block up/down edge. */
+	const int block_jitter = 3;
+	/** Height of the vertical stripes, width of the horizontal ones. */
+	const int vertical_stripe_size = 3;
+	const int horizontal_stripe_size = 4;
+	const int blind_size = 8;
+	const int mosaic_max_cell = 32;
+	/** Wave periods over the screen height. */
+	const int wave_periods = 3;
+
+	uint32_t NextRandom(uint32_t& state) {
+		state = state * 1103515245 + 12345;
+		return state >> 16;
+	}
+
+	/** sin of 256 steps per turn, scaled by 1024. */
+	std::vector<int> MakeSine() {
+		std::vector<int> table(256);
+		for (int i = 0; i < 256; ++i) {
+			table[i] = (int)std::floor(std::sin(i * 2 * M_PI / 256) * 1024 + 0.5);
+		}
+		return table;
+	}
+
+	uint32_t* Row(Region const& region, int y) {
+		return reinterpret_cast<uint32_t*>(region.pixels + y * region.pitch);
+	}
+
+	/** Same result as blitting the opaque pixel s2 with the opacity over s1. */
+	inline uint32_t FadePixel(uint32_t s1, uint32_t s2, uint32_t opacity) {
+		return BitmapKernels::AddUn8x4(BitmapKernels::MulUn8x4(s2, opacity),
+			BitmapKernels::MulUn8x4(s1, 255 - opacity));
+	}
+
+	/** Display line i shows source line i + offset. */
+	void Shift(std::vector<int>& map, int n, int offset) {
+		map.resize(n);
+		for (int i = 0; i < n; ++i) {
+			int const src = i + offset;
+			map[i] = src >= 0 && src < n ? src : -1;
+		}
+	}
+
+	/** The two halves slide in from the edges and meet in the middle. */
+	void Combine(std::vector<int>& map, int n, int percentage) {
+		int const half = n / 2;
+		int const first = half * percentage / 100;
+		int const second = (n - half) * percentage / 100;
+		map.resize(n);
+		for (int i = 0; i < n; ++i) {
+			if (i < first)
+				map[i] = i + half - first;
+			else if (i >= n - second)
+				map[i] = i - (n - second) + half;
+			else
+				map[i] = -1;
+		}
+	}
+
+	/** The two halves slide out to the edges. */
+	void Divide(std::vector<int>& map, int n, int percentage) {
+		int const half = n / 2;
+		int const first = half * percentage / 100;
+		int const second = (n - half) * percentage / 100;
+		map.resize(n);
+		for (int i = 0; i < n; ++i) {
+			if (i < half - first)
+				map[i] = i + first;
+			else if (i >= half + second)
+				map[i] = i - second;
+			else
+				map[i] = -1;
+		}
+	}
+
+	/** The whole source scaled to size lines, centered. */
+	void Scale(std::vector<int>& map, int n, int size) {
+		int const start = (n - size) / 2;
+		map.resize(n);
+		for (int i = 0; i < n; ++i) {
+			map[i] = i >= start && i < start + size ? (i - start) * n / size : -1;
+		}
+	}
+
+	/** Every line of a cell shows the center line of the cell. */
+	void Cells(std::vector<int>& map, int n, int cell) {
+		map.resize(n);
+		for (int i = 0; i < n; ++i) {
+			map[i] = std::min(i / cell * cell + cell / 2, n - 1);
+		}
+	}
+
+	/**
+	 * First percentage at which a line is revealed, 101 when never. Once
+	 * revealed a line stays revealed, so it can be searched.
+	 */
+	template <typename T>
+	uint8_t FirstPercentage(T revealed) {
+		int low = 0;
+		int high = 101;
+		while (low < high) {
+			int const mid = (low + high) / 2;
+			if (revealed(mid))
+				high = mid;
+			else
+				low = mid + 1;
+		}
+		return (uint8_t)low;
+	}
+
+	/**
+	 * Index of a stripe in its fill order: even stripes fill from the
+	 * start, odd stripes from the end.
+	 */
+	int StripeOrder(int stripe, int count) {
+		if (stripe % 2 == 0)
+			return stripe / 2;
+		return count / 2 - 1 - stripe / 2;
+	}
+}
+
+TransitionRenderer::TransitionRenderer(Type type, int width, int height, uint32_t seed) :
+	type(type), width(width), height(height) {
+	top.screen = NULL;
+	bottom.screen = NULL;
+
+	if (IsMasked(type)) {
+		ComputeThresholds(seed);
+	} else if (type == Wave) {
+		wave_phases.resize(height);
+		for (int y = 0; y < height; ++y) {
+			wave_phases[y] = (uint8_t)(y * 256 * wave_periods / height);
+		}
+	}
+}
+
+TransitionRenderer::Type TransitionRenderer::GetType() const {
+	return type;
+}
+
+bool TransitionRenderer::IsMasked(Type type) {
+	switch (type) {
+	case RandomBlocks:
+	case RandomBlocksUp:
+	case RandomBlocksDown:
+	case BlindOpen:
+	case BlindClose:
+	case VerticalStripes:
+	case HorizontalStripes:
+	case BorderToCenter:
+	case CenterToBorder:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void TransitionRenderer::ComputeBlockRanks(uint32_t seed) {
+	int const columns = (width + block_size - 1) / block_size;
+	int const rows = (height + block_size - 1) / block_size;
+	int const count = columns * rows;
+
+	std::vector<int> order(count);
+	for (int i = 0; i < count; ++i) {
+		order[i] = i;
+	}
+	for (int i = count - 1; i > 0; --i) {
+		std::swap(order[i], order[NextRandom(seed) % (i + 1)]);
+	}
+
+	if (type != RandomBlocks) {
+		// Row by row with a ragged edge, the shuffle breaks the ties
+		std::vector<int> keys(count);
+		for (int i = 0; i < count; ++i) {
+			int const row = type == RandomBlocksDown ? i / columns : rows - 1 - i / columns;
+			keys[i] = row * block_size + NextRandom(seed) % (block_size * block_jitter);
+		}
+		std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) {
+			return keys[a] < keys[b];
+		});
+	}
+
+	block_ranks.resize(count);
+	for (int i = 0; i < count; ++i) {
+		block_ranks[order[i]] = i;
+	}
+}
+
+void TransitionRenderer::ComputeThresholds(uint32_t seed) {
+	thresholds.resize(width * height);
+
+	if (type == RandomBlocks || type == RandomBlocksUp || type == RandomBlocksDown) {
+		ComputeBlockRanks(seed);
+		int const columns = (width + block_size - 1) / block_size;
+		int const count = (int)block_ranks.size();
+		std::vector<uint8_t> blocks(count);
+		for (int i = 0; i < count; ++i) {
+			int const rank = block_ranks[i];
+			blocks[i] = FirstPercentage([=](int p) { return rank < count * p / 100; });
+		}
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				thresholds[y * width + x] = blocks[(y / block_size) * columns + x / block_size];
+			}
+		}
+		return;
+	}
+
+	// The other masks are separable: a pixel is revealed once its row or
+	// its column is (both for CenterToBorder).
+	std::vector<uint8_t> rows(height, 101);
+	std::vector<uint8_t> cols(width, 101);
+	int const w = width;
+	int const h = height;
+
+	switch (type) {
+	case BlindOpen:
+		for (int y = 0; y < h; ++y) {
+			rows[y] = FirstPercentage([=](int p) { return y % blind_size >= blind_size - blind_size * p / 100; });
+		}
+		break;
+	case BlindClose:
+		for (int y = 0; y < h; ++y) {
+			rows[y] = FirstPercentage([=](int p) { return y % blind_size < blind_size * p / 100; });
+		}
+		break;
+	case VerticalStripes: {
+		int const count = (h + vertical_stripe_size - 1) / vertical_stripe_size;
+		for (int y = 0; y < h; ++y) {
+			int const order = StripeOrder(y / vertical_stripe_size, count);
+			rows[y] = FirstPercentage([=](int p) { return order < (count + 1) / 2 * p / 100; });
+		}
+		break;
+	}
+	case HorizontalStripes: {
+		int const count = (w + horizontal_stripe_size - 1) / horizontal_stripe_size;
+		for (int x = 0; x < w; ++x) {
+			int const order = StripeOrder(x / horizontal_stripe_size, count);
+			cols[x] = FirstPercentage([=](int p) { return order < (count + 1) / 2 * p / 100; });
+		}
+		break;
+	}
+	case BorderToCenter:
+		// The border grows by half of the screen
+		for (int y = 0; y < h; ++y) {
+			rows[y] = FirstPercentage([=](int p) { int const i = (h + 1) / 2 * p / 100; return y < i || y >= h - i; });
+		}
+		for (int x = 0; x < w; ++x) {
+			cols[x] = FirstPercentage([=](int p) { int const i = (w + 1) / 2 * p / 100; return x < i || x >= w - i; });
+		}
+		break;
+	case CenterToBorder:
+		for (int y = 0; y < h; ++y) {
+			rows[y] = FirstPercentage([=](int p) { int const i = (h + 1) / 2 - (h + 1) / 2 * p / 100; return y >= i && y < h - i; });
+		}
+		for (int x = 0; x < w; ++x) {
+			cols[x] = FirstPercentage([=](int p) { int const i = (w + 1) / 2 - (w + 1) / 2 * p / 100; return x >= i && x < w - i; });
+		}
+		for (int y = 0; y < h; ++y) {
+			for (int x = 0; x < w; ++x) {
+				thresholds[y * w + x] = std::max(rows[y], cols[x]);
+			}
+		}
+		return;
+	default:
+		break;
+	}
+
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			thresholds[y * w + x] = std::min(rows[y], cols[x]);
+		}
+	}
+}
+
+void TransitionRenderer::Render(Region const& dst, Region const& screen1, Region const& screen2, int percentage) {
+	percentage = std::max(0, std::min(100, percentage));
+
+	if (IsMasked(type)) {
+		RenderMask(dst, screen1, screen2, percentage);
+		return;
+	}
+
+	switch (type) {
+	case Fade:
+		RenderFade(dst, screen1, screen2, percentage);
+		break;
+	case Wave: {
+		int const max_amplitude = width / 8;
+		if (percentage < 50)
+			RenderWave(dst, screen1, max_amplitude * percentage / 50, percentage);
+		else
+			RenderWave(dst, screen2, max_amplitude * (100 - percentage) / 50, percentage);
+		break;
+	}
+	default:
+		SetupLayers(screen1, screen2, percentage);
+		RenderLayers(dst);
+		break;
+	}
+}
+
+void TransitionRenderer::RenderFade(Region const& dst, Region const& screen1, Region const& screen2, int percentage) {
+	// Same result as blitting screen2 with the opacity over screen1
+	uint32_t const opacity = 255 * percentage / 100;
+
+	for (int y = 0; y < height; ++y) {
+		uint32_t* out = Row(dst, y);
+		const uint32_t* s1 = Row(screen1, y);
+		const uint32_t* s2 = Row(screen2, y);
+
+		if (opacity == 0) {
+			memcpy(out, s1, width * 4);
+		} else if (opacity == 255) {
+			memcpy(out, s2, width * 4);
+		} else {
+			for (int x = 0; x < width; ++x) {
+				out[x] = FadePixel(s1[x], s2[x], opacity);
+			}
+		}
+	}
+}
+
+void TransitionRenderer::RenderMask(Region const& dst, Region const& screen1, Region const& screen2, int percentage) {
+	// The rows revealed by opening blinds fade in
+	uint32_t const opacity = type == BlindOpen ? 255 * percentage / 100 : 255;
+
+	for (int y = 0; y < height; ++y) {
+		uint32_t* out = Row(dst, y);
+		const uint32_t* s1 = Row(screen1, y);
+		const uint32_t* s2 = Row(screen2, y);
+		const uint8_t* threshold = &thresholds[y * width];
+
+		if (opacity == 255) {
+			for (int x = 0; x < width; ++x) {
+				out[x] = threshold[x] <= percentage ? s2[x] : s1[x];
+			}
+		} else {
+			for (int x = 0; x < width; ++x) {
+				out[x] = threshold[x] <= percentage ? FadePixel(s1[x], s2[x], opacity) : s1[x];
+			}
+		}
+	}
+}
+
+void TransitionRenderer::RenderWave(Region const& dst, Region const& screen, int amplitude, int percentage) {
+	static const std::vector<int> sine = MakeSine();
+
+	for (int y = 0; y < height; ++y) {
+		int const angle = (wave_phases[y] + percentage * 6) & 0xFF;
+		int offset = amplitude * sine[angle] / 1024;
+		offset = ((offset % width) + width) % width;
+
+		// Rows wrap around horizontally
+		uint32_t* out = Row(dst, y);
+		const uint32_t* src = Row(screen, y);
+		memcpy(out, src + offset, (width - offset) * 4);
+		memcpy(out + width - offset, src, offset * 4);
+	}
+}
+
+void TransitionRenderer::SetupLayers(Region const& screen1, Region const& screen2, int percentage) {
+	int const w = width;
+	int const h = height;
+
+	// Most effects put one screen over the other one, which stays in place
+	Layer* moving = &top;
+	Layer* fixed = &bottom;
+	bool screen2_moves = true;
+
+	switch (type) {
+	case ScrollUp:
+	case ScrollDown: {
+		int const offset = h * percentage / 100;
+		bool const up = type == ScrollUp;
+		Shift(top.rows, h, up ? offset : -offset);
+		Shift(top.cols, w, 0);
+		Shift(bottom.rows, h, up ? offset - h : h - offset);
+		Shift(bottom.cols, w, 0);
+		top.screen = &screen1;
+		bottom.screen = &screen2;
+		return;
+	}
+	case ScrollLeft:
+	case ScrollRight: {
+		int const offset = w * percentage / 100;
+		bool const left = type == ScrollLeft;
+		Shift(top.rows, h, 0);
+		Shift(top.cols, w, left ? offset : -offset);
+		Shift(bottom.rows, h, 0);
+		Shift(bottom.cols, w, left ? offset - w : w - offset);
+		top.screen = &screen1;
+		bottom.screen = &screen2;
+		return;
+	}
+	case VerticalCombine:
+		Combine(moving->rows, h, percentage);
+		Shift(moving->cols, w, 0);
+		break;
+	case VerticalDivision:
+		Divide(moving->rows, h, percentage);
+		Shift(moving->cols, w, 0);
+		screen2_moves = false;
+		break;
+	case HorizontalCombine:
+		Shift(moving->rows, h, 0);
+		Combine(moving->cols, w, percentage);
+		break;
+	case HorizontalDivision:
+		Shift(moving->rows, h, 0);
+		Divide(moving->cols, w, percentage);
+		screen2_moves = false;
+		break;
+	case CrossCombine:
+		Combine(moving->rows, h, percentage);
+		Combine(moving->cols, w, percentage);
+		break;
+	case CrossDivision:
+		Divide(moving->rows, h, percentage);
+		Divide(moving->cols, w, percentage);
+		screen2_moves = false;
+		break;
+	case ZoomIn:
+		Scale(moving->rows, h, h * percentage / 100);
+		Scale(moving->cols, w, w * percentage / 100);
+		break;
+	case ZoomOut:
+		Scale(moving->rows, h, h * (100 - percentage) / 100);
+		Scale(moving->cols, w, w * (100 - percentage) / 100);
+		screen2_moves = false;
+		break;
+	case Mosaic: {
+		// screen1 gets coarser in the first half, screen2 finer in the second
+		bool const second_half = percentage >= 50;
+		int const cell = 1 + (mosaic_max_cell - 1) * (second_half ? 100 - percentage : percentage) / 50;
+		Cells(top.rows, h, cell);
+		Cells(top.cols, w, cell);
+		top.screen = second_half ? &screen2 : &screen1;
+		bottom.screen = NULL;
+		return;
+	}
+	default:
+		return;
+	}
+
+	Shift(fixed->rows, h, 0);
+	Shift(fixed->cols, w, 0);
+	moving->screen = screen2_moves ? &screen2 : &screen1;
+	fixed->screen = screen2_moves ? &screen1 : &screen2;
+}
+
+void TransitionRenderer::RenderLayers(Region const& dst) {
+	for (int y = 0; y < height; ++y) {
+		uint32_t* out = Row(dst, y);
+		int const top_row = top.rows[y];
+		int const bottom_row = bottom.screen ? bottom.rows[y] : -1;
+		const uint32_t* top_src = top_row >= 0 ? Row(*top.screen, top_row) : NULL;
+		const uint32_t* bottom_src = bottom_row >= 0 ? Row(*bottom.screen, bottom_row) : NULL;
+
+		for (int x = 0; x < width; ++x) {
+			int const top_col = top_src ? top.cols[x] : -1;
+			if (top_col >= 0) {
+				out[x] = top_src[top_col];
+				continue;
+			}
+			int const bottom_col = bottom_src ? bottom.cols[x] : -1;
+			out[x] = bottom_col >= 0 ? bottom_src[bottom_col] : 0;
+		}
+	}
+}
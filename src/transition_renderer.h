@@ -0,0 +1,133 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_TRANSITION_RENDERER_H_
+#define _EASYRPG_TRANSITION_RENDERER_H_
+
+// Headers
+#include <vector>
+#include <stdint.h>
+#include "bitmap_kernels.h"
+
+/**
+ * TransitionRenderer class.
+ * Composites one frame of a screen transition from the old screen (screen1)
+ * and the new screen (screen2) into the display in a single pass.
+ * Everything that only depends on the transition and the screen size (the
+ * reveal order of the masked transitions, the wave shape) is computed once
+ * in the constructor, every frame then only looks up tables.
+ * The three regions must be 32-bit and have the same pixel layout.
+ */
+class TransitionRenderer {
+public:
+	/** Transition effects, In and Out variants share one effect. */
+	enum Type {
+		Fade,
+		RandomBlocks,
+		RandomBlocksUp,
+		RandomBlocksDown,
+		BlindOpen,
+		BlindClose,
+		VerticalStripes,
+		HorizontalStripes,
+		BorderToCenter,
+		CenterToBorder,
+		ScrollUp,
+		ScrollDown,
+		ScrollLeft,
+		ScrollRight,
+		VerticalCombine,
+		VerticalDivision,
+		HorizontalCombine,
+		HorizontalDivision,
+		CrossCombine,
+		CrossDivision,
+		ZoomIn,
+		ZoomOut,
+		Mosaic,
+		Wave,
+		TypeCount
+	};
+
+	/**
+	 * Constructor.
+	 *
+	 * @param type transition effect.
+	 * @param width screen width.
+	 * @param height screen height.
+	 * @param seed seed of the random block order.
+	 */
+	TransitionRenderer(Type type, int width, int height, uint32_t seed);
+
+	/**
+	 * @return transition effect.
+	 */
+	Type GetType() const;
+
+	/**
+	 * Renders one frame. 0 percent shows screen1, 100 percent screen2.
+	 *
+	 * @param dst display pixels.
+	 * @param screen1 old screen.
+	 * @param screen2 new screen.
+	 * @param percentage progress (0-100).
+	 */
+	void Render(BitmapKernels::Region const& dst, BitmapKernels::Region const& screen1,
+		BitmapKernels::Region const& screen2, int percentage);
+
+	/**
+	 * @param type transition effect.
+	 * @return whether the effect is drawn with a reveal mask.
+	 */
+	static bool IsMasked(Type type);
+
+private:
+	/** Screen a layer shows and the source row/column of every display row/column, -1 where it is not visible. */
+	struct Layer {
+		BitmapKernels::Region const* screen;
+		std::vector<int> rows;
+		std::vector<int> cols;
+	};
+
+	void ComputeThresholds(uint32_t seed);
+	void ComputeBlockRanks(uint32_t seed);
+
+	void RenderFade(BitmapKernels::Region const& dst, BitmapKernels::Region const& screen1,
+		BitmapKernels::Region const& screen2, int percentage);
+	void RenderMask(BitmapKernels::Region const& dst, BitmapKernels::Region const& screen1,
+		BitmapKernels::Region const& screen2, int percentage);
+	void RenderWave(BitmapKernels::Region const& dst, BitmapKernels::Region const& screen, int amplitude, int percentage);
+	void SetupLayers(BitmapKernels::Region const& screen1, BitmapKernels::Region const& screen2, int percentage);
+	void RenderLayers(BitmapKernels::Region const& dst);
+
+	Type type;
+	int width;
+	int height;
+
+	/** First percentage at which a pixel shows screen2, masked effects only. */
+	std::vector<uint8_t> thresholds;
+	/** Reveal order of the 4x4 blocks, random block effects only. */
+	std::vector<int> block_ranks;
+	/** Phase of every row, wave only. */
+	std::vector<uint8_t> wave_phases;
+
+	/** Layer drawn on top and the one below, geometric effects only. */
+	Layer top;
+	Layer bottom;
+};
+
+#endif
@@ -26,13 +26,61 @@
 #include "main_data.h"
 #include "weather.h"
 
+namespace {
+	// Palette images of the particles, 0 is transparent
+
+	const uint8_t rain_image[8 * 16] = {
+		0, 0, 0, 0, 0, 0, 0, 1,
+		0, 0, 0, 0, 0, 0, 0, 1,
+		0, 0, 0, 0, 0, 0, 1, 0,
+		0, 0, 0, 0, 0, 0, 1, 0,
+		0, 0, 0, 0, 0, 1, 0, 0,
+		0, 0, 0, 0, 0, 1, 0, 0,
+		0, 0, 0, 0, 1, 0, 0, 0,
+		0, 0, 0, 0, 1, 0, 0, 0,
+		0, 0, 0, 1, 0, 0, 0, 0,
+		0, 0, 0, 1, 0, 0, 0, 0,
+		0, 0, 1, 0, 0, 0, 0, 0,
+		0, 0, 1, 0, 0, 0, 0, 0,
+		0, 1, 0, 0, 0, 0, 0, 0,
+		0, 1, 0, 0, 0, 0, 0, 0,
+		1, 0, 0, 0, 0, 0, 0, 0,
+		1, 0, 0, 0, 0, 0, 0, 0
+	};
+
+	const uint8_t snow_image[4 * 4] = {
+		0, 1, 1, 0,
+		1, 2, 2, 1,
+		1, 2, 2, 1,
+		0, 1, 1, 0
+	};
+
+	const uint8_t sand_image[3 * 2] = {
+		1, 2, 1,
+		0, 1, 0
+	};
+
+	const int rain_opacity = 96;
+	const int snow_opacity = 192;
+	const int sand_opacity = 160;
+
+	const int particle_visible = 150;
+
+	const int weather_opacities[3] = {128, 160, 192};
+}
+
 Weather::Weather() :
-	dirty(false) {
+	damage_type(Game_Screen::Weather_None),
+	damage_strength(0),
+	plotted(false) {
 
 	Graphics::RegisterDrawable(this);
 }
 
 Weather::~Weather() {
+	if (damage_type != Game_Screen::Weather_None) {
+		Graphics::InvalidateAll();
+	}
 	Graphics::RemoveDrawable(this);
 }
 
@@ -47,136 +95,180 @@ DrawableType Weather::GetType() const {
 void Weather::Update() {
 }
 
+bool Weather::ReportDamage() {
+	int type = Main_Data::game_screen->GetWeatherType();
+	int strength = Main_Data::game_screen->GetWeatherStrength();
+
+	if (type != damage_type || strength != damage_strength) {
+		Graphics::InvalidateAll();
+	} else if (type == Game_Screen::Weather_Rain ||
+		type == Game_Screen::Weather_Snow ||
+		type == Game_Screen::Weather_Sandstorm) {
+		// Particles are erased where they were drawn last frame and drawn
+		// where they are now, fog is a static overlay
+		if (!plotted) {
+			Plot(type);
+		}
+		renderer->GetTouchedAreas(touched_areas);
+		Invalidate(drawn_areas);
+		Invalidate(touched_areas);
+	}
+
+	damage_type = type;
+	damage_strength = strength;
+
+	return true;
+}
+
+void Weather::Invalidate(std::vector<ParticleRenderer::Area> const& areas) {
+	for (std::vector<ParticleRenderer::Area>::const_iterator it = areas.begin(); it != areas.end(); ++it) {
+		Graphics::InvalidateRect(Rect(it->x, it->y, it->width, it->height));
+	}
+}
+
+void Weather::CreateSprites() {
+	BitmapKernels::Channels const channels = Bitmap::GetKernelChannels();
+
+	const uint32_t rain_palette[2] = {
+		0, ParticleRenderer::GetPixel(channels, 192, 192, 192, rain_opacity)
+	};
+	rain_sprite = ParticleRenderer::CreateSprite(rain_image, 8, 16, rain_palette);
+
+	const uint32_t snow_palette[3] = {
+		0,
+		ParticleRenderer::GetPixel(channels, 192, 192, 192, snow_opacity),
+		ParticleRenderer::GetPixel(channels, 255, 255, 255, snow_opacity)
+	};
+	snow_sprite = ParticleRenderer::CreateSprite(snow_image, 4, 4, snow_palette);
+
+	const uint32_t sand_palette[3] = {
+		0,
+		ParticleRenderer::GetPixel(channels, 192, 160, 96, sand_opacity),
+		ParticleRenderer::GetPixel(channels, 224, 192, 128, sand_opacity)
+	};
+	sand_sprite = ParticleRenderer::CreateSprite(sand_image, 3, 2, sand_palette);
+}
+
+uint32_t Weather::GetBackground(int red, int green, int blue) const {
+	int opacity = weather_opacities[Main_Data::game_screen->GetWeatherStrength()];
+	return ParticleRenderer::GetPixel(Bitmap::GetKernelChannels(), red, green, blue, opacity);
+}
+
 void Weather::Draw() {
-	if (Main_Data::game_screen->GetWeatherType() != Game_Screen::Weather_None) {
+	int type = Main_Data::game_screen->GetWeatherType();
+	if (type == Game_Screen::Weather_None) {
+		drawn_areas.clear();
+		return;
+	}
+
+	if (!plotted) {
+		Plot(type);
+	}
+	plotted = false;
+	renderer->GetTouchedAreas(drawn_areas);
+
+	uint32_t background = 0;
+	if (type == Game_Screen::Weather_Fog) {
+		background = GetBackground(128, 128, 128);
+	} else if (type == Game_Screen::Weather_Sandstorm) {
+		background = GetBackground(192, 160, 128);
+	}
+
+	Rect rect(0, 0, SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT);
+	BitmapRef dst = DisplayUi->GetDisplaySurface();
+
+	if (dst->HasKernelChannels() && dst->width() >= rect.width && dst->height() >= rect.height) {
+		// Only the damaged parts were drawn again, blending the fog over
+		// the rest would darken it every frame
+		std::vector<Rect> const& clip_rects = dst->GetClipRects();
+		clip_areas.clear();
+		for (std::vector<Rect>::const_iterator it = clip_rects.begin(); it != clip_rects.end(); ++it) {
+			ParticleRenderer::Area const area = { it->x, it->y, it->width, it->height };
+			clip_areas.push_back(area);
+		}
+		renderer->Composite(dst->GetKernelRegion(rect), background, clip_areas);
+	} else {
 		if (!weather_surface) {
-			weather_surface = Bitmap::Create(SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT);
+			weather_surface = Bitmap::Create(rect.width, rect.height);
 		}
+		weather_surface->Clear();
+		renderer->Composite(weather_surface->GetKernelRegion(rect), background);
+		dst->Blit(0, 0, *weather_surface, rect, 255);
 	}
+}
 
-	if (dirty && weather_surface) {
-		weather_surface->Clear();
-		dirty = false;
+void Weather::Plot(int type) {
+	if (!renderer) {
+		renderer.reset(new ParticleRenderer(SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT, Bitmap::GetKernelChannels()));
+		CreateSprites();
 	}
 
-	switch (Main_Data::game_screen->GetWeatherType()) {
-		case Game_Screen::Weather_None:
-			break;
+	switch (type) {
 		case Game_Screen::Weather_Rain:
-			DrawRain();
+			PlotRain();
 			break;
 		case Game_Screen::Weather_Snow:
-			DrawSnow();
-			break;
-		case Game_Screen::Weather_Fog:
-			DrawFog();
+			PlotSnow();
 			break;
 		case Game_Screen::Weather_Sandstorm:
-			DrawSandstorm();
+			PlotSandstorm();
 			break;
 	}
-
-	if (dirty && weather_surface) {
-		BitmapRef dst = DisplayUi->GetDisplaySurface();
-		dst->Blit(0, 0, *weather_surface, weather_surface->GetRect(), 255);
-	}
+	plotted = true;
 }
 
-static const uint8_t snow_image[] = {
-	0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00,
-	0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
-	0x00, 0x04, 0x02, 0x03, 0x00, 0x00, 0x00, 0xd4, 0x9f, 0x76, 0xed,
-	0x00, 0x00, 0x00, 0x09, 0x50, 0x4c, 0x54, 0x45, 0x00, 0x00, 0x00,
-	0xc0, 0xc0, 0xc0, 0xff, 0xff, 0xff, 0x0d, 0x6d, 0xd7, 0xbb, 0x00,
-	0x00, 0x00, 0x01, 0x74, 0x52, 0x4e, 0x53, 0x00, 0x40, 0xe6, 0xd8,
-	0x66, 0x00, 0x00, 0x00, 0x0e, 0x49, 0x44, 0x41, 0x54, 0x08, 0xd7,
-	0x63, 0x10, 0x61, 0xc8, 0x04, 0x42, 0x11, 0x00, 0x03, 0xf0, 0x00,
-	0xfb, 0xb6, 0xa8, 0xf1, 0xda, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45,
-	0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
-};
-
-static const uint8_t rain_image[] = {
-	0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00,
-	0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00,
-	0x00, 0x10, 0x01, 0x03, 0x00, 0x00, 0x00, 0x11, 0x44, 0xac, 0x3e,
-	0x00, 0x00, 0x00, 0x06, 0x50, 0x4c, 0x54, 0x45, 0x00, 0x00, 0x00,
-	0xc0, 0xc0, 0xc0, 0x64, 0x56, 0x3a, 0x71, 0x00, 0x00, 0x00, 0x01,
-	0x74, 0x52, 0x4e, 0x53, 0x00, 0x40, 0xe6, 0xd8, 0x66, 0x00, 0x00,
-	0x00, 0x1f, 0x49, 0x44, 0x41, 0x54, 0x08, 0xd7, 0x63, 0x60, 0x64,
-	0x60, 0x64, 0x60, 0x02, 0x42, 0x16, 0x20, 0xe4, 0x00, 0x42, 0x01,
-	0x20, 0x54, 0x00, 0x42, 0x07, 0x20, 0x6c, 0x60, 0x68, 0x00, 0x00,
-	0x0b, 0xd4, 0x01, 0xff, 0xed, 0x11, 0x33, 0x32, 0x00, 0x00, 0x00,
-	0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
-};
-
-static const int snowflake_visible = 150;
-
-void Weather::DrawRain() {
-	if (!rain_bitmap) {
-		rain_bitmap = Bitmap::Create(rain_image, sizeof(rain_image));
-	}
-
-	Rect rect = rain_bitmap->GetRect();
-
-	const std::vector<Game_Screen::Snowflake>& snowflakes = Main_Data::game_screen->GetSnowflakes();
+void Weather::PlotRain() {
+	const Game_Screen::Particles& particles = Main_Data::game_screen->GetParticles();
+	size_t const count = particles.size();
 
-	std::vector<Game_Screen::Snowflake>::const_iterator it;
-	for (it = snowflakes.begin(); it != snowflakes.end(); ++it) {
-		const Game_Screen::Snowflake& f = *it;
-		if (f.life > snowflake_visible)
+	particle_x.clear();
+	particle_y.clear();
+	for (size_t i = 0; i < count; ++i) {
+		if (particles.life[i] > particle_visible)
 			continue;
-		weather_surface->Blit(f.x - f.y/2, f.y, *rain_bitmap, rect, 96);
+		particle_x.push_back(particles.x[i] - particles.y[i] / 2);
+		particle_y.push_back(particles.y[i]);
 	}
 
-	dirty = true;
+	renderer->Plot(particle_x.data(), particle_y.data(), particle_x.size(), rain_sprite);
 }
 
-void Weather::DrawSnow() {
-	if (!snow_bitmap) {
-		snow_bitmap = Bitmap::Create(snow_image, sizeof(snow_image));
-	}
-
+void Weather::PlotSnow() {
 	static const int wobble[2][18] = {
 		{-1,-1, 0, 1, 0, 1, 1, 0,-1,-1, 0, 1, 0, 1, 1, 0,-1, 0},
 		{-1,-1, 0, 0, 1, 1, 0,-1,-1, 0, 1, 0, 1, 1, 0,-1, 0, 0}
 	};
 
-	Rect rect = snow_bitmap->GetRect();
-
-	const std::vector<Game_Screen::Snowflake>& snowflakes = Main_Data::game_screen->GetSnowflakes();
+	const Game_Screen::Particles& particles = Main_Data::game_screen->GetParticles();
+	size_t const count = particles.size();
 
-	std::vector<Game_Screen::Snowflake>::const_iterator it;
-	for (it = snowflakes.begin(); it != snowflakes.end(); ++it) {
-		const Game_Screen::Snowflake& f = *it;
-		if (f.life > snowflake_visible)
+	particle_x.clear();
+	particle_y.clear();
+	for (size_t i = 0; i < count; ++i) {
+		if (particles.life[i] > particle_visible)
 			continue;
-		int x = f.x - f.y/2;
-		int y = f.y;
-		int i = (y / 2) % 18;
-		x += wobble[0][i];
-		y += wobble[1][i];
-		weather_surface->Blit(x, y, *snow_bitmap, rect, 192);
+		int y = particles.y[i];
+		int w = (y / 2) % 18;
+		particle_x.push_back(particles.x[i] - y / 2 + wobble[0][w]);
+		particle_y.push_back(y + wobble[1][w]);
 	}
 
-	dirty = true;
+	renderer->Plot(particle_x.data(), particle_y.data(), particle_x.size(), snow_sprite);
 }
 
-void Weather::DrawFog() {
-	static const int opacities[3] = {128, 160, 192};
-	int opacity = opacities[Main_Data::game_screen->GetWeatherStrength()];
+void Weather::PlotSandstorm() {
+	const Game_Screen::Particles& particles = Main_Data::game_screen->GetParticles();
+	size_t const count = particles.size();
 
-	weather_surface->Fill(Color(128, 128, 128, opacity));
-
-	dirty = true;
-}
-
-void Weather::DrawSandstorm() {
-	static const int opacities[3] = {128, 160, 192};
-	int opacity = opacities[Main_Data::game_screen->GetWeatherStrength()];
-
-	weather_surface->Fill(Color(192, 160, 128, opacity));
-
-	// TODO
+	// Sand covers the screen plus a margin on both sides
+	particle_x.clear();
+	particle_y.clear();
+	for (size_t i = 0; i < count; ++i) {
+		if (particles.life[i] > particle_visible)
+			continue;
+		particle_x.push_back(particles.x[i] - 60);
+		particle_y.push_back(particles.y[i]);
+	}
 
-	dirty = true;
+	renderer->Plot(particle_x.data(), particle_y.data(), particle_x.size(), sand_sprite);
 }
@@ -20,7 +20,9 @@
 
 // Headers
 #include <string>
+#include <vector>
 #include "drawable.h"
+#include "particle_renderer.h"
 #include "system.h"
 
 /**
@@ -34,24 +36,47 @@ public:
 	void Draw();
 	void Update();
 
+	bool ReportDamage();
+
 	int GetZ() const;
 	DrawableType GetType() const;
 
 private:
-	void DrawRain();
-	void DrawSnow();
-	void DrawFog();
-	void DrawSandstorm();
+	void CreateSprites();
+	void Plot(int type);
+	void Invalidate(std::vector<ParticleRenderer::Area> const& areas);
+	void PlotRain();
+	void PlotSnow();
+	void PlotSandstorm();
+	uint32_t GetBackground(int red, int green, int blue) const;
 
 	static const int z = 1001;
 	static const DrawableType type = TypeWeather;
 
-	//boost::scoped_ptr<Plane> weather_plane;
+	EASYRPG_SHARED_PTR<ParticleRenderer> renderer;
+	ParticleRenderer::Sprite rain_sprite;
+	ParticleRenderer::Sprite snow_sprite;
+	ParticleRenderer::Sprite sand_sprite;
+
+	/** Screen positions of the visible particles of this frame. */
+	std::vector<int> particle_x;
+	std::vector<int> particle_y;
+
+	/** Damaged parts of the display in this frame. */
+	std::vector<ParticleRenderer::Area> clip_areas;
+
+	/** Parts of the display the particles were drawn to last frame. */
+	std::vector<ParticleRenderer::Area> drawn_areas;
+	/** Parts of the renderer layer plotted in this frame. */
+	std::vector<ParticleRenderer::Area> touched_areas;
+	/** Particles of this frame are plotted but not drawn yet. */
+	bool plotted;
+
+	/** Used instead of the display when it has another pixel format. */
 	BitmapRef weather_surface;
-	BitmapRef snow_bitmap;
-	BitmapRef rain_bitmap;
 
-	bool dirty;
+	int damage_type;
+	int damage_strength;
 };
 
 #endif
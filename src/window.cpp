@@ -50,7 +50,9 @@ Window::Window():
 	pause_frame(0),
 	animation_frames(0),
 	animation_count(0.0),
-	animation_increment(0.0) {
+	animation_increment(0.0),
+	damage_revision(0),
+	damaged(true) {
 
 	Graphics::RegisterDrawable(this);
 
@@ -64,12 +66,29 @@ Window::Window():
 }
 
 Window::~Window() {
+	Graphics::InvalidateRect(damage_rect);
 	Graphics::RemoveDrawable(this);
 }
 
+bool Window::ReportDamage() {
+	Rect rect = visible ? Rect(x, y, width, height) : Rect();
+	unsigned revision = contents ? contents->GetRevision() : 0;
+
+	if (damaged || rect != damage_rect || revision != damage_revision) {
+		Graphics::InvalidateRect(damage_rect);
+		Graphics::InvalidateRect(rect);
+		damage_rect = rect;
+		damage_revision = revision;
+		damaged = false;
+	}
+
+	return true;
+}
+
 void Window::SetOpenAnimation(int frames) {
 	closing = false;
 	visible = true;
+	damaged = true;
 
 	if (frames > 0) {
 		animation_frames = frames;
@@ -90,6 +109,7 @@ void Window::SetCloseAnimation(int frames) {
 	} else {
 		visible = false;
 	}
+	damaged = true;
 }
 
 void Window::Draw() {
@@ -334,14 +354,19 @@ void Window::Update() {
 	if (active) {
 		cursor_frame += 1;
 		if (cursor_frame > 20) cursor_frame = 0;
+		// Cursor graphic changes
+		if (cursor_frame == 0 || cursor_frame == 11) damaged = true;
 		if (pause) {
 			pause_frame += 1;
 			if (pause_frame == 40) pause_frame = 0;
+			// Pause arrow blinks
+			if (pause_frame == 0 || pause_frame == 17) damaged = true;
 		}
 	}
 
 	if (animation_frames > 0) {
 		// Open/Close Animation
+		damaged = true;
 		animation_frames -= 1;
 		animation_count += animation_increment;
 		if (closing && animation_frames <= 0) {
@@ -358,6 +383,7 @@ void Window::SetWindowskin(BitmapRef const& nwindowskin) {
 	background_needs_refresh = true;
 	frame_needs_refresh = true;
 	cursor_needs_refresh = true;
+	damaged = true;
 	windowskin = nwindowskin;
 }
 
@@ -365,6 +391,7 @@ BitmapRef Window::GetContents() const {
 	return contents;
 }
 void Window::SetContents(BitmapRef const& ncontents) {
+	if (contents != ncontents) damaged = true;
 	contents = ncontents;
 }
 
@@ -372,7 +399,10 @@ bool Window::GetStretch() const {
 	return stretch;
 }
 void Window::SetStretch(bool nstretch) {
-	if (stretch != nstretch) background_needs_refresh = true;
+	if (stretch != nstretch) {
+		background_needs_refresh = true;
+		damaged = true;
+	}
 	stretch = nstretch;
 }
 
@@ -381,6 +411,7 @@ Rect const& Window::GetCursorRect() const {
 }
 void Window::SetCursorRect(Rect const& ncursor_rect) {
 	if (cursor_rect.width != ncursor_rect.width || cursor_rect.height != ncursor_rect.height) cursor_needs_refresh = true;
+	if (cursor_rect != ncursor_rect) damaged = true;
 	cursor_rect = ncursor_rect;
 }
 
@@ -388,6 +419,7 @@ bool Window::GetActive() const {
 	return active;
 }
 void Window::SetActive(bool nactive) {
+	if (active != nactive) damaged = true;
 	active = nactive;
 }
 
@@ -395,6 +427,7 @@ bool Window::GetVisible() const {
 	return visible;
 }
 void Window::SetVisible(bool nvisible) {
+	if (visible != nvisible) damaged = true;
 	visible = nvisible;
 }
 
@@ -402,6 +435,7 @@ bool Window::GetPause() const {
 	return pause;
 }
 void Window::SetPause(bool npause) {
+	if (pause != npause) damaged = true;
 	pause = npause;
 }
 
@@ -409,6 +443,7 @@ bool Window::GetUpArrow() const {
 	return up_arrow;
 }
 void Window::SetUpArrow(bool nup_arrow) {
+	if (up_arrow != nup_arrow) damaged = true;
 	up_arrow = nup_arrow;
 }
 
@@ -416,6 +451,7 @@ bool Window::GetDownArrow() const {
 	return down_arrow;
 }
 void Window::SetDownArrow(bool ndown_arrow) {
+	if (down_arrow != ndown_arrow) damaged = true;
 	down_arrow = ndown_arrow;
 }
 
@@ -423,6 +459,7 @@ int Window::GetX() const {
 	return x;
 }
 void Window::SetX(int nx) {
+	if (x != nx) damaged = true;
 	x = nx;
 }
 
@@ -430,6 +467,7 @@ int Window::GetY() const {
 	return y;
 }
 void Window::SetY(int ny) {
+	if (y != ny) damaged = true;
 	y = ny;
 }
 
@@ -440,6 +478,7 @@ void Window::SetWidth(int nwidth) {
 	if (width != nwidth) {
 		background_needs_refresh = true;
 		frame_needs_refresh = true;
+		damaged = true;
 	}
 	width = nwidth;
 }
@@ -451,6 +490,7 @@ void Window::SetHeight(int nheight) {
 	if (height != nheight) {
 		background_needs_refresh = true;
 		frame_needs_refresh = true;
+		damaged = true;
 	}
 	height = nheight;
 }
@@ -459,7 +499,10 @@ int Window::GetZ() const {
 	return z;
 }
 void Window::SetZ(int nz) {
-	if (z != nz) Graphics::UpdateZCallback();
+	if (z != nz) {
+		Graphics::UpdateZCallback(this);
+		damaged = true;
+	}
 	z = nz;
 }
 
@@ -467,6 +510,7 @@ int Window::GetOx() const {
 	return ox;
 }
 void Window::SetOx(int nox) {
+	if (ox != nox) damaged = true;
 	ox = nox;
 }
 
@@ -474,6 +518,7 @@ int Window::GetOy() const {
 	return oy;
 }
 void Window::SetOy(int noy) {
+	if (oy != noy) damaged = true;
 	oy = noy;
 }
 
@@ -481,6 +526,7 @@ int Window::GetBorderX() const {
 	return border_x;
 }
 void Window::SetBorderX(int x) {
+	if (border_x != x) damaged = true;
 	border_x = x;
 }
 
@@ -488,6 +534,7 @@ int Window::GetBorderY() const {
 	return border_y;
 }
 void Window::SetBorderY(int y) {
+	if (border_y != y) damaged = true;
 	border_y = y;
 }
 
@@ -495,6 +542,7 @@ int Window::GetOpacity() const {
 	return opacity;
 }
 void Window::SetOpacity(int nopacity) {
+	if (opacity != nopacity) damaged = true;
 	opacity = nopacity;
 }
 
@@ -502,6 +550,7 @@ int Window::GetBackOpacity() const {
 	return back_opacity;
 }
 void Window::SetBackOpacity(int nback_opacity) {
+	if (back_opacity != nback_opacity) damaged = true;
 	back_opacity = nback_opacity;
 }
 
@@ -509,6 +558,7 @@ int Window::GetContentsOpacity() const {
 	return contents_opacity;
 }
 void Window::SetContentsOpacity(int ncontents_opacity) {
+	if (contents_opacity != ncontents_opacity) damaged = true;
 	contents_opacity = ncontents_opacity;
 }
 
@@ -81,6 +81,8 @@ public:
 
 	DrawableType GetType() const;
 
+	bool ReportDamage();
+
 protected:
 	DrawableType type;
 	unsigned long ID;
@@ -124,6 +126,10 @@ private:
 	int animation_frames;
 	double animation_count;
 	double animation_increment;
+
+	Rect damage_rect;
+	unsigned damage_revision;
+	bool damaged;
 };
 
 #endif
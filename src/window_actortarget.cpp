@@ -52,11 +52,11 @@ void Window_ActorTarget::Refresh() {
 
 void Window_ActorTarget::UpdateCursorRect() {
 	if (index < -10) { // Entire Party
-		cursor_rect.Set(48 + 4, 0, 120, item_max * (48 + 10) - 10);
+		SetCursorRect(Rect(48 + 4, 0, 120, item_max * (48 + 10) - 10));
 	} else if (index < 0) { // Fixed to one
-		cursor_rect.Set(48 + 4, -index * (48 + 10), 120, 48);
+		SetCursorRect(Rect(48 + 4, -index * (48 + 10), 120, 48));
 	} else {
-		cursor_rect.Set(48 + 4, index * (48 + 10), 120, 48);
+		SetCursorRect(Rect(48 + 4, index * (48 + 10), 120, 48));
 	}
 }
 
@@ -66,7 +66,7 @@ Window_Message::Window_Message(int ix, int iy, int iwidth, int iheight) :
 	escape_char = (Player::escape_symbol == "\xC2\xA5" ? L'\u00A5' :
 		      (Player::escape_symbol == "\xE2\x82\xA9" ? L'\u20A9' :
 		      L'\\'));
-	active = false;
+	SetActive(false);
 	index = -1;
 	text_color = Font::ColorDefault;
 
@@ -106,7 +106,7 @@ void Window_Message::FinishMessageProcessing() {
 	} else if (kill_message) {
 		TerminateMessage();
 	} else {
-		pause = true;
+		SetPause(true);
 	}
 
 	text.clear();
@@ -115,7 +115,7 @@ void Window_Message::FinishMessageProcessing() {
 }
 
 void Window_Message::StartChoiceProcessing() {
-	active = true;
+	SetActive(true);
 	index = 0;
 }
 
@@ -207,8 +207,8 @@ void Window_Message::InsertNewLine() {
 }
 
 void Window_Message::TerminateMessage() {
-	active = false;
-	pause = false;
+	SetActive(false);
+	SetPause(false);
 	kill_message = false;
 	index = -1;
 
@@ -316,7 +316,7 @@ void Window_Message::UpdateMessage() {
 			FinishMessageProcessing();
 			break;
 		} else if (line_count == 4) {
-			pause = true;
+			SetPause(true);
 			new_page_after_pause = true;
 			break;
 		} else if (pause) {
@@ -333,7 +333,7 @@ void Window_Message::UpdateMessage() {
 				++text_index;
 			}
 			if (text_index != end) {
-				pause = true;
+				SetPause(true);
 				new_page_after_pause = true;
 			}
 			break;
@@ -363,7 +363,7 @@ void Window_Message::UpdateMessage() {
 				break;
 			case '!':
 				// Text pause
-				pause = true;
+				SetPause(true);
 				break;
 			case '^':
 				// Force message close
@@ -586,18 +586,18 @@ void Window_Message::UpdateCursorRect() {
 			width = width - LeftMargin - FaceSize - RightFaceMargin - 4;
 		}
 
-		cursor_rect.Set(x_pos, y_pos, width, 16);
+		SetCursorRect(Rect(x_pos, y_pos, width, 16));
 	} else {
-		cursor_rect.Set(0, 0, 0, 0);
+		SetCursorRect(Rect());
 	}
 }
 
 void Window_Message::WaitForInput() {
-	active = true; // Enables the Pause arrow
+	SetActive(true); // Enables the Pause arrow
 	if (Input::IsTriggered(Input::DECISION) ||
 		Input::IsTriggered(Input::CANCEL)) {
-		active = false;
-		pause = false;
+		SetActive(false);
+		SetPause(false);
 
 		if (text.empty()) {
 			TerminateMessage();
@@ -630,8 +630,7 @@ void Window_Message::InputChoice() {
 void Window_Message::InputNumber() {
 	if (Input::IsTriggered(Input::DECISION)) {
 		Game_System::SePlay(Game_System::GetSystemSE(Game_System::SFX_Decision));
-		Game_Variables[Game_Message::num_input_variable_id] = number_input_window->GetNumber();
-		Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+		Game_Variables.Set(Game_Message::num_input_variable_id, number_input_window->GetNumber());
 		TerminateMessage();
 		number_input_window->SetNumber(0);
 	}
@@ -49,6 +49,19 @@ void Window_VarList::Refresh() {
 	}
 }
 
+void Window_VarList::Update() {
+	Window_Command::Update();
+
+	const ChangeJournal& journal = show_switch ? Game_Switches.GetJournal() : Game_Variables.GetJournal();
+	const std::vector<int>& changed = journal.GetChanged();
+	for (std::vector<int>::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+		if (*it >= first_var && *it < first_var + 10) {
+			Refresh();
+			break;
+		}
+	}
+}
+
 void Window_VarList::DrawItemValue(int index){
 	if (show_switch){
 		if (!Game_Switches.IsValid(first_var+index))
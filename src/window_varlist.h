@@ -49,6 +49,12 @@ public:
 	 */
 	void  Refresh();
 
+	/**
+	 * Updates the window, the values are drawn again when a displayed
+	 * switch or variable changed in this frame.
+	 */
+	void Update();
+
 	/**
 	 * Indicate if item value displayed on the window correspond to switches or variables.
 	 *
@@ -0,0 +1,172 @@
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "audio_ringbuffer.h"
+
+// Streams a synthetic 16-bit stereo track through the AudioRingBuffer like
+// the 3DS BGM path does: a decoder thread that only wakes up when the sink
+// consumed a block, and a null audio sink that pulls fixed blocks at a
+// steady rate and splits them into channel buffers.
+
+namespace {
+	const size_t block_frames = 2048;
+	const size_t block_bytes = block_frames * 4;
+	const int blocks = 1000;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	bool wake_pending = false;
+	bool quit = false;
+
+	// Sample value of a frame, left and right differ
+	int16_t Sample(uint32_t frame, int channel) {
+		return (int16_t)((frame * 7 + channel * 1000) & 0x7FFF);
+	}
+
+	void Decoder(AudioRingBuffer* ring) {
+		uint32_t frame = 0;
+		// Odd chunk sizes like ov_read returns them
+		const size_t chunk_frames[] = { 512, 300, 17, 1024, 77 };
+		int chunk = 0;
+
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(wake_mutex);
+				wake.wait(lock, [] { return wake_pending || quit; });
+				wake_pending = false;
+				if (quit) {
+					return;
+				}
+			}
+
+			for (;;) {
+				size_t const frames = chunk_frames[chunk];
+				if (ring->GetFree() < frames * 4) {
+					break;
+				}
+				chunk = (chunk + 1) % 5;
+
+				std::vector<int16_t> pcm(frames * 2);
+				for (size_t i = 0; i < frames; ++i, ++frame) {
+					pcm[i * 2] = Sample(frame, 0);
+					pcm[i * 2 + 1] = Sample(frame, 1);
+				}
+
+				// Alternate between the zero copy region and plain writes
+				size_t region;
+				uint8_t* dst = ring->GetWriteRegion(region);
+				if (frame % 2 == 0 && region >= pcm.size() * 2) {
+					memcpy(dst, &pcm.front(), pcm.size() * 2);
+					ring->CommitWrite(pcm.size() * 2);
+				} else {
+					size_t const written = ring->Write(&pcm.front(), pcm.size() * 2);
+					assert(written == pcm.size() * 2);
+					(void)written;
+				}
+			}
+		}
+	}
+
+	void Wake() {
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		wake_pending = true;
+		wake.notify_one();
+	}
+}
+
+static void Deinterleave() {
+	const uint8_t src[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	uint8_t left[4];
+	uint8_t right[4];
+
+	AudioRingBuffer::Deinterleave(src, left, right, 2, 2);
+	assert(left[0] == 1 && left[1] == 2 && left[2] == 5 && left[3] == 6);
+	assert(right[0] == 3 && right[1] == 4 && right[2] == 7 && right[3] == 8);
+
+	AudioRingBuffer::Deinterleave(src, left, right, 4, 1);
+	assert(left[0] == 1 && left[1] == 3 && left[2] == 5 && left[3] == 7);
+	assert(right[0] == 2 && right[1] == 4 && right[2] == 6 && right[3] == 8);
+}
+
+static void Wraparound() {
+	AudioRingBuffer ring(10);
+	assert(ring.GetCapacity() == 16);
+
+	uint8_t data[16];
+	for (int i = 0; i < 16; ++i) {
+		data[i] = (uint8_t)i;
+	}
+
+	assert(ring.Write(data, 12) == 12);
+	uint8_t out[16];
+	assert(ring.Read(out, 8) == 8);
+	assert(ring.Write(data, 16) == 12);
+	assert(ring.GetFree() == 0);
+	assert(ring.GetAvailable() == 16);
+
+	assert(ring.Read(out, 4) == 4);
+	assert(out[0] == 8 && out[3] == 11);
+	assert(ring.Read(out, 16) == 12);
+	assert(out[0] == 0 && out[11] == 11);
+	assert(ring.Read(out, 1) == 0);
+}
+
+static void Stream() {
+	AudioRingBuffer ring(block_bytes * 4);
+	std::thread decoder(Decoder, &ring);
+
+	std::vector<int16_t> left(block_frames);
+	std::vector<int16_t> right(block_frames);
+	uint32_t frame = 0;
+	int underruns = 0;
+
+	Wake();
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+	for (int b = 0; b < blocks; ++b) {
+		size_t const got = ring.ReadDeinterleaved(reinterpret_cast<uint8_t*>(&left.front()),
+			reinterpret_cast<uint8_t*>(&right.front()), block_frames, 2);
+		if (got < block_frames) {
+			++underruns;
+		}
+
+		for (size_t i = 0; i < got; ++i, ++frame) {
+			assert(left[i] == Sample(frame, 0));
+			assert(right[i] == Sample(frame, 1));
+		}
+
+		Wake();
+
+		// The sink plays a block every millisecond, about 45 times faster
+		// than real time at 44.1 kHz
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::chrono::steady_clock::time_point const end = std::chrono::steady_clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		quit = true;
+		wake.notify_one();
+	}
+	decoder.join();
+
+	printf("streamed %u frames in %lld ms, %d underruns\n", (unsigned)frame,
+		(long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), underruns);
+	assert(underruns == 0);
+}
+
+extern "C" int main(int, char**) {
+	Deinterleave();
+	Wraparound();
+	Stream();
+
+	return EXIT_SUCCESS;
+}
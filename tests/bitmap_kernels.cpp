@@ -0,0 +1,248 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+#include "bitmap_kernels.h"
+#include "bitmap_hslrgb.h"
+
+// Checks that the BitmapKernels give the same pixels as the per-pixel code
+// Bitmap used before, that the vector path is bit-identical to the scalar
+// one and prints how long both take.
+
+namespace {
+	const BitmapKernels::Channels argb = { 16, 8, 0, 24 };
+	const BitmapKernels::Channels rgba = { 24, 16, 8, 0 };
+
+	// Odd width so the vector loops have a scalar tail
+	const int width = 317;
+	const int height = 211;
+	const int pitch = (width + 3) * 4;
+
+	uint32_t Random() {
+		static uint32_t state = 12345;
+		state = state * 1103515245 + 12345;
+		return (state >> 16) | ((state * 1103515245 + 12345) & 0xFFFF0000);
+	}
+
+	struct Image {
+		std::vector<uint8_t> data;
+		BitmapKernels::Region region;
+
+		Image() : data(pitch * height) {
+			Init();
+		}
+
+		Image(Image const& other) : data(other.data) {
+			Init();
+		}
+
+		void Init() {
+			region.pixels = &data.front();
+			region.pitch = pitch;
+			region.width = width;
+			region.height = height;
+		}
+
+		uint32_t& At(int x, int y) {
+			return reinterpret_cast<uint32_t*>(&data[y * pitch])[x];
+		}
+	};
+
+	// Random colors, a few fully transparent pixels and every channel value
+	void Fill(Image& image, BitmapKernels::Channels const& ch) {
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				uint32_t pixel = Random();
+				if (y == 0 && x < 256) {
+					pixel = ((uint32_t)x << ch.r) | ((uint32_t)(255 - x) << ch.g) | ((uint32_t)(x * 7 & 0xFF) << ch.b) | (0xFFu << ch.a);
+				}
+				if (x % 13 == 0) {
+					pixel &= ~(0xFFu << ch.a);
+				}
+				image.At(x, y) = pixel;
+			}
+		}
+	}
+
+	bool Same(Image const& a, Image const& b) {
+		return a.data == b.data;
+	}
+
+	// The code Bitmap::ToneBlit used before the kernels
+	void ReferenceTone(Image& image, BitmapKernels::Channels const& ch, int gray, int red, int green, int blue) {
+		static uint8_t hard_light_lookup[256][256];
+		for (int i = 0; i < 256; ++i) {
+			for (int j = 0; j < 256; ++j) {
+				int res = 0;
+				if (i <= 128)
+					res = (2 * i * j) / 255;
+				else
+					res = 255 - 2 * (255 - i) * (255 - j) / 255;
+				hard_light_lookup[i][j] = res > 255 ? 255 : res < 0 ? 0 : res;
+			}
+		}
+
+		int sat = gray > 128 ? 1024 + (gray - 128) * 16 : gray * 8;
+
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				uint32_t pixel = image.At(x, y);
+				uint8_t a = (pixel >> ch.a) & 0xFF;
+				if (a == 0) {
+					continue;
+				}
+				uint8_t r = (pixel >> ch.r) & 0xFF;
+				uint8_t g = (pixel >> ch.g) & 0xFF;
+				uint8_t b = (pixel >> ch.b) & 0xFF;
+				if (gray != 128) {
+					uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
+					int nr = ((lum * 1024 + (r - lum) * sat) >> 10);
+					int ng = ((lum * 1024 + (g - lum) * sat) >> 10);
+					int nb = ((lum * 1024 + (b - lum) * sat) >> 10);
+					r = nr > 255 ? 255 : nr < 0 ? 0 : nr;
+					g = ng > 255 ? 255 : ng < 0 ? 0 : ng;
+					b = nb > 255 ? 255 : nb < 0 ? 0 : nb;
+				}
+				r = hard_light_lookup[red][r];
+				g = hard_light_lookup[green][g];
+				b = hard_light_lookup[blue][b];
+				image.At(x, y) = ((uint32_t)r << ch.r) | ((uint32_t)g << ch.g) | ((uint32_t)b << ch.b) | ((uint32_t)a << ch.a);
+			}
+		}
+	}
+
+	void Tone(Image& image, BitmapKernels::Channels const& ch, int gray, int red, int green, int blue, bool scalar) {
+		int sat = gray > 128 ? 1024 + (gray - 128) * 16 : gray * 8;
+		if (scalar) {
+			if (gray != 128)
+				BitmapKernels::Scalar::ToneGray(image.region, ch, sat);
+			BitmapKernels::Scalar::ToneColor(image.region, ch, red, green, blue);
+		} else {
+			if (gray != 128)
+				BitmapKernels::ToneGray(image.region, ch, sat);
+			BitmapKernels::ToneColor(image.region, ch, red, green, blue);
+		}
+	}
+
+	double Milliseconds(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+static void ToneMatches() {
+	Image source;
+	for (int t = 0; t < 256; ++t) {
+		BitmapKernels::Channels const& ch = t % 2 ? argb : rgba;
+		Fill(source, ch);
+		Image reference = source, scalar = source, vector = source;
+
+		int const gray = t;
+		int const red = (t * 37) & 0xFF;
+		int const green = 255 - t;
+		int const blue = t < 128 ? 128 : (t * 7) & 0xFF;
+
+		ReferenceTone(reference, ch, gray, red, green, blue);
+		Tone(scalar, ch, gray, red, green, blue, true);
+		Tone(vector, ch, gray, red, green, blue, false);
+
+		assert(Same(reference, scalar));
+		assert(Same(scalar, vector));
+	}
+}
+
+static void FlashMatches() {
+	Image source;
+	Fill(source, argb);
+	for (int level = 0; level < 256; level += 3) {
+		Image scalar = source, vector = source;
+		int const red = (level * 11) & 0xFF;
+		int const alpha = level % 2 ? 255 : (level * 5) & 0xFF;
+
+		BitmapKernels::Scalar::Flash(scalar.region, argb, red * alpha / 255, 255 * alpha / 255, 0, alpha, level);
+		BitmapKernels::Flash(vector.region, argb, red * alpha / 255, 255 * alpha / 255, 0, alpha, level);
+		assert(Same(scalar, vector));
+	}
+
+	// A full flash replaces an opaque color
+	Image full = source;
+	BitmapKernels::Flash(full.region, argb, 10, 20, 30, 255, 255);
+	assert(full.At(1, 1) == 0xFF0A141Eu);
+}
+
+static void HueMatches() {
+	// Every color once, in rows of 4096 pixels
+	std::vector<uint32_t> colors(1 << 24);
+	for (uint32_t c = 0; c < colors.size(); ++c) {
+		colors[c] = (c << 8) | (c % 251 == 0 ? 0 : 0xFF);
+	}
+	BitmapKernels::Region region = { reinterpret_cast<uint8_t*>(&colors.front()), 4096 * 4, 4096, 4096 };
+
+	const int hues[] = { 0, 1, 0x80, 0x100, 0x2AB, 0x400, 0x5FF, 0x600 };
+	for (size_t i = 0; i < sizeof(hues) / sizeof(hues[0]); ++i) {
+		std::vector<uint32_t> scalar = colors;
+		std::vector<uint32_t> vector = colors;
+		region.pixels = reinterpret_cast<uint8_t*>(&scalar.front());
+		BitmapKernels::Scalar::HueRotate(region, rgba, hues[i]);
+		region.pixels = reinterpret_cast<uint8_t*>(&vector.front());
+		BitmapKernels::HueRotate(region, rgba, hues[i]);
+
+		for (uint32_t c = 0; c < colors.size(); ++c) {
+			uint32_t expected = colors[c];
+			if (expected & 0xFF) {
+				uint8_t r = c >> 16, g = c >> 8, b = c;
+				RGB_adjust_HSL(r, g, b, hues[i]);
+				expected = ((uint32_t)r << 24) | ((uint32_t)g << 16) | ((uint32_t)b << 8) | 0xFF;
+			}
+			assert(scalar[c] == expected);
+			assert(vector[c] == expected);
+		}
+	}
+}
+
+static void Benchmark() {
+	Image source;
+	Fill(source, argb);
+	const int rounds = 200;
+
+	for (int scalar = 1; scalar >= 0; --scalar) {
+		Image image = source;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i = 0; i < rounds; ++i) {
+			Tone(image, argb, 200, 60, 128, 200, scalar != 0);
+		}
+		double const tone = Milliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < rounds; ++i) {
+			if (scalar)
+				BitmapKernels::Scalar::Flash(image.region, argb, 255, 0, 0, 255, 100);
+			else
+				BitmapKernels::Flash(image.region, argb, 255, 0, 0, 255, 100);
+		}
+		double const flash = Milliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < rounds; ++i) {
+			if (scalar)
+				BitmapKernels::Scalar::HueRotate(image.region, argb, 0x123);
+			else
+				BitmapKernels::HueRotate(image.region, argb, 0x123);
+		}
+		double const hue = Milliseconds(start);
+
+		printf("%-6s tone %.2f ms, flash %.2f ms, hue %.2f ms per %dx%d frame\n",
+			scalar ? "scalar" : BitmapKernels::GetVectorPath(), tone / rounds, flash / rounds, hue / rounds, width, height);
+	}
+}
+
+extern "C" int main(int, char**) {
+	ToneMatches();
+	FlashMatches();
+	HueMatches();
+	Benchmark();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include <pixman.h>
+#include "bitmap_waver.h"
+
+// Checks that BitmapWaver gives the same pixels as the per-row pixman
+// composite Bitmap::WaverBlit falls back to, for zoomed, offset and split
+// opacity blits and with a partial clip.
+
+namespace {
+	const int alpha_shift = 24;
+
+	uint32_t Random() {
+		static uint32_t state = 777;
+		state = state * 1103515245 + 12345;
+		return (state >> 16) | ((state * 1103515245 + 12345) & 0xFFFF0000);
+	}
+
+	// Premultiplied ARGB, with fully transparent and opaque pixels
+	uint32_t RandomPixel() {
+		uint32_t const r = Random();
+		uint32_t a = r >> 24;
+		if ((r & 7) == 0)
+			return 0;
+		if ((r & 7) == 1)
+			a = 255;
+		uint32_t const red = (r & 0xFF) * a / 255;
+		uint32_t const green = ((r >> 8) & 0xFF) * a / 255;
+		uint32_t const blue = ((r >> 16) & 0xFF) * a / 255;
+		return (a << 24) | (red << 16) | (green << 8) | blue;
+	}
+
+	struct Image {
+		int width;
+		int height;
+		std::vector<uint32_t> data;
+
+		Image(int w, int h) : width(w), height(h), data(w * h) {
+			for (size_t i = 0; i < data.size(); ++i) {
+				data[i] = RandomPixel() | 0xFF000000;
+			}
+		}
+
+		BitmapKernels::Region Region() {
+			BitmapKernels::Region region = { reinterpret_cast<uint8_t*>(&data.front()), width * 4, width, height };
+			return region;
+		}
+
+		pixman_image_t* Pixman() {
+			return pixman_image_create_bits(PIXMAN_a8r8g8b8, width, height, &data.front(), width * 4);
+		}
+	};
+
+	struct Clip {
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	// CreateMask of bitmap.cpp
+	pixman_image_t* CreateMask(BitmapWaver::Params const& p, pixman_transform_t const* pxform) {
+		if (p.opacity_top >= 255 && (p.split == 0 || p.opacity_bottom >= 255))
+			return NULL;
+
+		if (p.split == 0) {
+			pixman_color_t tcolor = {0, 0, 0, static_cast<uint16_t>(p.opacity_top << 8)};
+			return pixman_image_create_solid_fill(&tcolor);
+		}
+
+		pixman_image_t* mask = pixman_image_create_bits(PIXMAN_a8, 1, 2, (uint32_t*) NULL, 4);
+		uint32_t* pixels = pixman_image_get_data(mask);
+		*reinterpret_cast<uint8_t*>(&pixels[0]) = (p.opacity_top & 0xFF);
+		*reinterpret_cast<uint8_t*>(&pixels[1]) = (p.opacity_bottom & 0xFF);
+
+		pixman_transform_t xform;
+		pixman_transform_init_identity(&xform);
+		pixman_transform_scale(NULL, &xform, pixman_int_to_fixed(p.src_width), pixman_int_to_fixed(p.src_height));
+		pixman_transform_translate(NULL, &xform, pixman_int_to_fixed(0), pixman_int_to_fixed(-p.split));
+		pixman_transform_multiply(&xform, &xform, pxform);
+		pixman_image_set_transform(mask, &xform);
+
+		return mask;
+	}
+
+	// Pixman path of Bitmap::WaverBlit
+	void PixmanBlit(Image& dst, std::vector<Clip> const& clips, Image& src, BitmapWaver::Params const& p) {
+		pixman_image_t* dst_image = dst.Pixman();
+		pixman_image_t* src_image = src.Pixman();
+
+		if (!clips.empty()) {
+			std::vector<pixman_box32_t> boxes;
+			for (size_t i = 0; i < clips.size(); ++i) {
+				pixman_box32_t box = { clips[i].x, clips[i].y, clips[i].x + clips[i].width, clips[i].y + clips[i].height };
+				boxes.push_back(box);
+			}
+			pixman_region32_t region;
+			pixman_region32_init_rects(&region, &boxes.front(), boxes.size());
+			pixman_image_set_clip_region32(dst_image, &region);
+			pixman_region32_fini(&region);
+		}
+
+		pixman_transform_t xform;
+		pixman_transform_init_scale(&xform, pixman_double_to_fixed(1.0 / p.zoom_x), pixman_double_to_fixed(1.0 / p.zoom_y));
+		pixman_image_set_transform(src_image, &xform);
+
+		pixman_image_t* mask = p.copy ? NULL : CreateMask(p, &xform);
+		pixman_op_t const op = p.copy ? PIXMAN_OP_SRC : PIXMAN_OP_OVER;
+
+		int height = static_cast<int>(std::floor(p.src_height * p.zoom_y));
+		int width  = static_cast<int>(std::floor(p.src_width * p.zoom_x));
+		for (int i = 0; i < height; i++) {
+			int dy = p.y + i;
+			if (dy < 0)
+				continue;
+			if (dy >= dst.height)
+				break;
+			int sy = static_cast<int>(std::floor((i+0.5) / p.zoom_y));
+			int offset = (int) (2 * p.zoom_x * p.depth * sin((p.phase + (p.src_y + sy) * 11.2) * 3.14159 / 180));
+
+			pixman_image_composite32(op, src_image, mask, dst_image,
+				p.src_x, i, p.src_x, i, p.x + offset, dy, width, 1);
+		}
+
+		if (mask)
+			pixman_image_unref(mask);
+		pixman_image_unref(src_image);
+		pixman_image_unref(dst_image);
+	}
+
+	void Check(const char* name, BitmapWaver::Params const& p, std::vector<Clip> const& clips) {
+		Image src(64, 48);
+		// The source must be able to blend
+		for (size_t i = 0; i < src.data.size(); ++i) {
+			src.data[i] = RandomPixel();
+		}
+		Image reference(160, 120);
+		Image direct = reference;
+
+		PixmanBlit(reference, clips, src, p);
+
+		if (clips.empty()) {
+			BitmapWaver::Blit(direct.Region(), 0, 0, direct.width, direct.height, src.Region(), p);
+		} else {
+			for (size_t i = 0; i < clips.size(); ++i) {
+				BitmapWaver::Blit(direct.Region(), clips[i].x, clips[i].y, clips[i].width, clips[i].height, src.Region(), p);
+			}
+		}
+
+		for (int y = 0; y < reference.height; ++y) {
+			for (int x = 0; x < reference.width; ++x) {
+				uint32_t const a = reference.data[y * reference.width + x];
+				uint32_t const b = direct.data[y * direct.width + x];
+				if (a != b) {
+					printf("%s: pixel %d,%d is %08X, pixman %08X\n", name, x, y, b, a);
+					assert(false);
+				}
+			}
+		}
+	}
+
+	BitmapWaver::Params Blit(int src_x, int src_y, double zoom, int depth) {
+		BitmapWaver::Params p;
+		p.x = 20;
+		p.y = 10;
+		p.zoom_x = zoom;
+		p.zoom_y = zoom;
+		p.src_x = src_x;
+		p.src_y = src_y;
+		p.src_width = 24;
+		p.src_height = 32;
+		p.depth = depth;
+		p.phase = 33.0;
+		p.opacity_top = 255;
+		p.opacity_bottom = 255;
+		p.split = 0;
+		p.copy = false;
+		p.alpha_shift = alpha_shift;
+		return p;
+	}
+}
+
+extern "C" int main(int, char**) {
+	const double zooms[] = { 1.0, 0.5, 1.5, 2.0, 2.75 };
+	const int offsets[][2] = { { 0, 0 }, { 8, 0 }, { 13, 5 }, { 40, 16 } };
+
+	std::vector<Clip> full;
+	std::vector<Clip> partial;
+	Clip a = { 0, 20, 50, 30 };
+	Clip b = { 35, 0, 40, 120 };
+	partial.push_back(a);
+	partial.push_back(b);
+
+	for (size_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); ++z) {
+		for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); ++o) {
+			for (int clip = 0; clip < 2; ++clip) {
+				std::vector<Clip> const& clips = clip ? partial : full;
+				BitmapWaver::Params p = Blit(offsets[o][0], offsets[o][1], zooms[z], z % 2 ? 4 : 0);
+
+				Check("over", p, clips);
+
+				p.opacity_top = p.opacity_bottom = 128;
+				Check("opacity", p, clips);
+
+				p.opacity_top = 200;
+				p.opacity_bottom = 60;
+				p.split = 10;
+				Check("split", p, clips);
+
+				p.opacity_top = 0;
+				Check("split transparent top", p, clips);
+
+				p = Blit(offsets[o][0], offsets[o][1], zooms[z], 3);
+				p.copy = true;
+				Check("copy", p, clips);
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include <cassert>
+#include <cstdlib>
+#include <stdint.h>
+#include <vector>
+#include "change_journal.h"
+
+// Records writes like Game_Switches::Set over several frames and checks
+// the changed IDs against the writes and the listener calls.
+
+namespace {
+	std::vector<int> heard;
+
+	void Listen(int id) {
+		heard.push_back(id);
+	}
+
+	uint32_t Random() {
+		static uint32_t state = 4711;
+		state = state * 1103515245 + 12345;
+		return state >> 8;
+	}
+}
+
+static void RecordsChangesOfAFrame() {
+	ChangeJournal journal;
+	assert(journal.GetChanged().empty());
+	assert(!journal.IsChanged(3));
+	assert(!journal.IsChanged(-1));
+
+	journal.SetListener(Listen);
+	journal.Record(7);
+	journal.Record(3);
+	journal.Record(7);
+	journal.Record(0);
+
+	// Listed once in the order of the first change, heard every time
+	std::vector<int> const& changed = journal.GetChanged();
+	assert(changed.size() == 3 && changed[0] == 7 && changed[1] == 3 && changed[2] == 0);
+	assert(heard.size() == 4 && heard[2] == 7);
+	assert(journal.IsChanged(3) && journal.IsChanged(0) && !journal.IsChanged(4));
+	assert(!journal.IsChanged(1000));
+
+	journal.Clear();
+	assert(journal.GetChanged().empty());
+	assert(!journal.IsChanged(7) && !journal.IsChanged(3));
+
+	journal.SetListener(NULL);
+	journal.Record(3);
+	assert(heard.size() == 4);
+	assert(journal.GetChanged().size() == 1 && journal.IsChanged(3));
+}
+
+static void MatchesWrites() {
+	const int ids = 5000;
+	std::vector<int> values(ids + 1, 0);
+	ChangeJournal journal;
+
+	for (int frame = 0; frame < 500; ++frame) {
+		std::vector<int> before = values;
+
+		int const writes = (int)(Random() % 40);
+		for (int w = 0; w < writes; ++w) {
+			int const id = 1 + (int)(Random() % ids);
+			int const value = (int)(Random() % 3);
+			if (values[id] != value) {
+				values[id] = value;
+				journal.Record(id);
+			}
+		}
+
+		// Every entry that differs from the previous frame was recorded,
+		// set back values may be recorded as well
+		std::vector<bool> listed(ids + 1, false);
+		for (int id : journal.GetChanged()) {
+			assert(!listed[id]);
+			listed[id] = true;
+		}
+		for (int id = 1; id <= ids; ++id) {
+			assert(listed[id] == journal.IsChanged(id));
+			if (values[id] != before[id]) {
+				assert(listed[id]);
+			}
+		}
+
+		journal.Clear();
+	}
+}
+
+extern "C" int main(int, char**) {
+	RecordsChangesOfAFrame();
+	MatchesWrites();
+
+	return EXIT_SUCCESS;
+}
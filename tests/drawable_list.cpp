@@ -0,0 +1,169 @@
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "drawable_list.h"
+
+namespace {
+	class TestDrawable : public Drawable {
+	public:
+		TestDrawable(char name, int z) : name(name), z(z) {}
+
+		void Draw() {}
+		int GetZ() const { return z; }
+		DrawableType GetType() const { return TypeSprite; }
+
+		void SetZ(int nz) {
+			if (z != nz) {
+				DrawableList::MarkDirty(this);
+			}
+			z = nz;
+		}
+
+		char name;
+		int z;
+	};
+
+	// Names of the drawables in draw order
+	std::string Order(DrawableList& list) {
+		list.Sort();
+		std::string order;
+		for (Drawable* drawable : list) {
+			order += static_cast<TestDrawable*>(drawable)->name;
+		}
+		return order;
+	}
+}
+
+static void SortsByZ() {
+	TestDrawable a('a', 3), b('b', 1), c('c', 2);
+	DrawableList list;
+	list.Add(&a);
+	list.Add(&b);
+	list.Add(&c);
+	assert(Order(list) == "bca");
+	assert(!list.IsDirty());
+}
+
+static void EqualZKeepsRegistrationOrder() {
+	TestDrawable a('a', 0), b('b', 0), c('c', 0), d('d', 0);
+	DrawableList list;
+	list.Add(&a);
+	list.Add(&b);
+	list.Add(&c);
+	list.Add(&d);
+	assert(Order(list) == "abcd");
+
+	// Leaving and rejoining a z goes back to the registration order
+	c.SetZ(5);
+	assert(list.IsDirty());
+	assert(Order(list) == "abdc");
+	c.SetZ(0);
+	b.SetZ(-1);
+	assert(Order(list) == "bacd");
+	b.SetZ(0);
+	assert(Order(list) == "abcd");
+}
+
+static void ZChangesMoveTheDrawable() {
+	TestDrawable a('a', 1), b('b', 2), c('c', 3), d('d', 4), e('e', 5);
+	DrawableList list;
+	list.Add(&a);
+	list.Add(&b);
+	list.Add(&c);
+	list.Add(&d);
+	list.Add(&e);
+
+	// A character walks a row down, then jumps across all others
+	b.SetZ(3);
+	assert(Order(list) == "abcde");
+	b.SetZ(4);
+	assert(Order(list) == "acbde");
+	e.SetZ(0);
+	a.SetZ(9);
+	assert(Order(list) == "ecbda");
+
+	// Setting the same z doesn't dirty the list
+	c.SetZ(3);
+	assert(!list.IsDirty());
+}
+
+static void ReorderingEverything() {
+	std::vector<TestDrawable> storage;
+	for (int i = 0; i < 26; ++i) {
+		storage.push_back(TestDrawable('a' + i, i));
+	}
+	DrawableList list;
+	for (TestDrawable& drawable : storage) {
+		list.Add(&drawable);
+	}
+	assert(Order(list) == "abcdefghijklmnopqrstuvwxyz");
+
+	// Too many moves for the insertion sort, pairs keep their order
+	for (int i = 0; i < 26; ++i) {
+		storage[i].SetZ((25 - i) / 2);
+	}
+	assert(Order(list) == "yzwxuvstqropmnklijghefcdab");
+}
+
+static void RemovedDrawablesAreSkipped() {
+	TestDrawable a('a', 1), b('b', 2), c('c', 3);
+	DrawableList list;
+	list.Add(&a);
+	list.Add(&b);
+	list.Add(&c);
+	list.Sort();
+
+	// Before the gaps are closed
+	list.Remove(&a);
+	list.Remove(&c);
+	assert(list.IsDirty());
+	assert(list.size() == 1);
+	int count = 0;
+	for (Drawable* drawable : list) {
+		assert(drawable == &b);
+		++count;
+	}
+	assert(count == 1);
+
+	// Removing twice and z changes of removed drawables do nothing
+	list.Remove(&a);
+	a.SetZ(0);
+	assert(Order(list) == "b");
+
+	// Destroying the list unregisters the rest
+	{
+		DrawableList other;
+		other.Add(&b);
+		assert(list.size() == 0);
+	}
+	list.Remove(&b);
+	assert(list.size() == 0);
+}
+
+static void AddedAgainGoesLast() {
+	TestDrawable a('a', 0), b('b', 0), c('c', 0);
+	DrawableList list;
+	list.Add(&a);
+	list.Add(&b);
+	list.Add(&c);
+
+	list.Remove(&a);
+	list.Add(&a);
+	assert(Order(list) == "bca");
+
+	list.Clear();
+	assert(list.size() == 0);
+	assert(Order(list) == "");
+}
+
+extern "C" int main(int, char**) {
+	SortsByZ();
+	EqualZKeepsRegistrationOrder();
+	ZChangesMoveTheDrawable();
+	ReorderingEverything();
+	RemovedDrawablesAreSkipped();
+	AddedAgainGoesLast();
+
+	return EXIT_SUCCESS;
+}
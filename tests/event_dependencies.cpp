@@ -0,0 +1,194 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include "event_dependencies.h"
+
+// Events choose the last page whose switch and variable conditions are met,
+// like Game_Event::Refresh. After random changes every event whose page
+// changed has to be marked, and refreshing only the marked events is
+// compared with refreshing all of them.
+
+namespace {
+	uint32_t Random() {
+		static uint32_t state = 4711;
+		state = state * 1103515245 + 12345;
+		return state >> 8;
+	}
+
+	struct Page {
+		int switch_id;
+		int variable_id;
+		int variable_value;
+	};
+
+	struct Event {
+		std::vector<Page> pages;
+		int page;
+	};
+
+	std::vector<bool> switches;
+	std::vector<int> variables;
+
+	int ChoosePage(Event const& ev) {
+		for (int i = (int)ev.pages.size() - 1; i >= 0; --i) {
+			Page const& page = ev.pages[i];
+			if (page.switch_id >= 0 && !switches[page.switch_id])
+				continue;
+			if (page.variable_id >= 0 && variables[page.variable_id] < page.variable_value)
+				continue;
+			return i;
+		}
+		return -1;
+	}
+
+	std::vector<Event> RandomEvents(int count, int ids) {
+		std::vector<Event> events(count);
+		for (int i = 0; i < count; ++i) {
+			int const pages = 1 + (int)(Random() % 4);
+			for (int p = 0; p < pages; ++p) {
+				Page page;
+				page.switch_id = Random() % 2 ? (int)(Random() % ids) : -1;
+				page.variable_id = Random() % 3 == 0 ? (int)(Random() % ids) : -1;
+				page.variable_value = (int)(Random() % 5);
+				events[i].pages.push_back(page);
+			}
+			events[i].page = -1;
+		}
+		return events;
+	}
+
+	void Index(EventDependencies& dependencies, std::vector<Event> const& events) {
+		dependencies.Reset(events.size());
+		for (size_t i = 0; i < events.size(); ++i) {
+			for (size_t p = 0; p < events[i].pages.size(); ++p) {
+				Page const& page = events[i].pages[p];
+				dependencies.Add(i, EventDependencies::Switch, page.switch_id);
+				dependencies.Add(i, EventDependencies::Variable, page.variable_id);
+			}
+		}
+	}
+}
+
+static void MarksChangedEvents() {
+	const int ids = 60;
+	switches.assign(ids, false);
+	variables.assign(ids, 0);
+
+	std::vector<Event> events = RandomEvents(300, ids);
+	EventDependencies dependencies;
+	Index(dependencies, events);
+	assert(dependencies.size() == events.size());
+	assert(!dependencies.IsDirty());
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		events[i].page = ChoosePage(events[i]);
+	}
+
+	for (int round = 0; round < 1000; ++round) {
+		int const changes = 1 + (int)(Random() % 5);
+		for (int c = 0; c < changes; ++c) {
+			int const id = (int)(Random() % ids);
+			if (Random() % 2) {
+				switches[id] = !switches[id];
+				dependencies.Mark(EventDependencies::Switch, id);
+			} else {
+				variables[id] = (int)(Random() % 6);
+				dependencies.Mark(EventDependencies::Variable, id);
+			}
+		}
+
+		std::vector<int> dirty;
+		dependencies.TakeDirty(dirty);
+		assert(!dependencies.IsDirty());
+
+		for (size_t i = 0; i < dirty.size(); ++i) {
+			assert(i == 0 || dirty[i - 1] < dirty[i]);
+			events[dirty[i]].page = ChoosePage(events[dirty[i]]);
+		}
+
+		// Events which were not refreshed still show the right page
+		for (size_t i = 0; i < events.size(); ++i) {
+			assert(events[i].page == ChoosePage(events[i]));
+		}
+	}
+}
+
+static void IgnoresUnknownValues() {
+	EventDependencies dependencies;
+	dependencies.Reset(3);
+	dependencies.Add(0, EventDependencies::Item, 5);
+	dependencies.Add(0, EventDependencies::Item, 5);
+	dependencies.Add(2, EventDependencies::Timer, 1);
+	dependencies.Add(1, EventDependencies::Actor, -1);
+
+	dependencies.Mark(EventDependencies::Item, 4);
+	dependencies.Mark(EventDependencies::Item, 500);
+	dependencies.Mark(EventDependencies::Actor, -1);
+	dependencies.Mark(EventDependencies::Switch, 5);
+	assert(!dependencies.IsDirty());
+
+	dependencies.Mark(EventDependencies::Timer, 1);
+	dependencies.Mark(EventDependencies::Item, 5);
+	dependencies.Mark(EventDependencies::Item, 5);
+	std::vector<int> dirty;
+	dependencies.TakeDirty(dirty);
+	assert(dirty.size() == 2 && dirty[0] == 0 && dirty[1] == 2);
+
+	dependencies.Reset(1);
+	dependencies.Mark(EventDependencies::Item, 5);
+	assert(!dependencies.IsDirty());
+}
+
+static void Benchmark() {
+	// A parallel event toggling a switch every frame on a map with many
+	// events, each refresh checks the pages of an event
+	const int ids = 500;
+	const int frames = 2000;
+	switches.assign(ids, false);
+	variables.assign(ids, 0);
+
+	std::vector<Event> events = RandomEvents(400, ids);
+	EventDependencies dependencies;
+	Index(dependencies, events);
+
+	int pages = 0;
+	std::vector<int> dirty;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame) {
+		int const id = frame % 7;
+		switches[id] = !switches[id];
+		dependencies.Mark(EventDependencies::Switch, id);
+
+		dirty.clear();
+		dependencies.TakeDirty(dirty);
+		for (size_t i = 0; i < dirty.size(); ++i) {
+			pages += events[dirty[i]].page = ChoosePage(events[dirty[i]]);
+		}
+	}
+	double const dependent = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame) {
+		int const id = frame % 7;
+		switches[id] = !switches[id];
+
+		for (size_t i = 0; i < events.size(); ++i) {
+			pages += events[i].page = ChoosePage(events[i]);
+		}
+	}
+	double const all = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%d events: dependent %.3f us, all %.3f us per switch change (%d)\n",
+		(int)events.size(), dependent / frames, all / frames, pages);
+}
+
+extern "C" int main(int, char**) {
+	MarksChangedEvents();
+	IgnoresUnknownValues();
+	Benchmark();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "frame_stats.h"
+
+namespace {
+	FrameStats Stats() {
+		std::vector<std::string> names;
+		names.push_back("update");
+		names.push_back("draw");
+		return FrameStats(names);
+	}
+}
+
+static void SummaryUsesNearestRank() {
+	FrameStats stats = Stats();
+	assert(stats.GetFrameCount() == 0);
+	assert(stats.GetSummary(0).p99 == 0.0);
+
+	// 1..100 ms, added in two parts and out of order
+	for (int i = 100; i >= 1; --i) {
+		stats.Add(0, i - 0.5);
+		stats.Add(0, 0.5);
+		stats.Add(1, 2.0);
+		stats.EndFrame();
+	}
+	assert(stats.GetFrameCount() == 100);
+
+	FrameStats::Summary const update = stats.GetSummary(0);
+	assert(update.mean == 50.5);
+	assert(update.p50 == 50.0);
+	assert(update.p99 == 99.0);
+	assert(update.max == 100.0);
+
+	FrameStats::Summary const draw = stats.GetSummary(1);
+	assert(draw.mean == 2.0 && draw.p50 == 2.0 && draw.p99 == 2.0);
+}
+
+static void ScopeAddsElapsedTime() {
+	FrameStats stats = Stats();
+	{
+		FrameStats::Scope scope(&stats, 1);
+		double const end = FrameStats::Now() + 2.0;
+		while (FrameStats::Now() < end) {}
+	}
+	{
+		// Disabled
+		FrameStats::Scope scope(NULL, 1);
+	}
+	stats.EndFrame();
+	assert(stats.GetSummary(0).max == 0.0);
+	assert(stats.GetSummary(1).max >= 2.0);
+}
+
+static void WritesJson() {
+	FrameStats stats = Stats();
+	stats.Add(0, 1.0);
+	stats.Add(1, 0.25);
+	stats.EndFrame();
+	stats.SetInfo("game", "Quote \" and\nnewline");
+	stats.SetInfo("seed", "1");
+	stats.SetInfo("seed", "42");
+
+	std::ostringstream json;
+	stats.WriteJson(json);
+	assert(json.str() ==
+		"{\n"
+		"  \"frames\": 1,\n"
+		"  \"info\": {\n"
+		"    \"game\": \"Quote \\\" and\\u000anewline\",\n"
+		"    \"seed\": \"42\"\n"
+		"  },\n"
+		"  \"sections\": {\n"
+		"    \"update\": { \"mean\": 1.0000, \"p50\": 1.0000, \"p99\": 1.0000, \"max\": 1.0000 },\n"
+		"    \"draw\": { \"mean\": 0.2500, \"p50\": 0.2500, \"p99\": 0.2500, \"max\": 0.2500 }\n"
+		"  }\n"
+		"}\n");
+}
+
+extern "C" int main(int, char**) {
+	SummaryUsesNearestRank();
+	ScopeAddsElapsedTime();
+	WritesJson();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include "input_script.h"
+
+namespace {
+	InputScript::KeyMap Keys() {
+		InputScript::KeyMap keys;
+		keys["UP"] = 1;
+		keys["DOWN"] = 2;
+		keys["Z"] = 3;
+		keys["X"] = 4;
+		return keys;
+	}
+
+	bool Load(InputScript& script, const char* text) {
+		std::istringstream stream(text);
+		return script.Load(stream);
+	}
+
+	std::vector<int> Held(InputScript& script, int frame) {
+		std::vector<int> held;
+		script.GetHeld(frame, held);
+		return held;
+	}
+
+	std::vector<int> List(int a = -1, int b = -1) {
+		std::vector<int> list;
+		if (a >= 0) list.push_back(a);
+		if (b >= 0) list.push_back(b);
+		return list;
+	}
+}
+
+static void PressesAreHeldForTheirDuration() {
+	InputScript script(Keys());
+	assert(Load(script,
+		"# frame duration keys\n"
+		"\n"
+		"20 3 DOWN\n"
+		"10 1 Z\n"
+		"21 1 X UP\n"));
+	assert(script.GetLength() == 23);
+
+	assert(Held(script, 0) == List());
+	assert(Held(script, 10) == List(3));
+	assert(Held(script, 11) == List());
+	assert(Held(script, 20) == List(2));
+	int const both[] = { 2, 4, 1 };
+	assert(Held(script, 21) == std::vector<int>(both, both + 3));
+	assert(Held(script, 22) == List(2));
+
+	// Skipped frames still release the presses
+	assert(Held(script, 30) == List());
+
+	script.Rewind();
+	assert(Held(script, 10) == List(3));
+}
+
+static void ErrorsNameTheLine() {
+	InputScript script(Keys());
+	assert(!Load(script, "10 1 Z\n11 1 START\n"));
+	assert(script.GetError() == "line 2: unknown key START");
+	assert(script.GetLength() == 0);
+
+	assert(!Load(script, "10 Z\n"));
+	assert(script.GetError() == "line 1: expected frame and duration");
+
+	assert(!Load(script, "10 2\n"));
+	assert(script.GetError() == "line 1: no keys");
+
+	assert(!Load(script, "-1 2 Z\n"));
+}
+
+static void RecordingReplays() {
+	InputScript recorder(Keys());
+	std::vector<std::vector<int> > frames(40);
+	for (int frame = 5; frame < 40; ++frame) {
+		if (frame % 7 < 3) frames[frame].push_back(3);
+		if (frame >= 10 && frame < 20) frames[frame].push_back(2);
+		if (frame >= 30) frames[frame].push_back(1);
+		recorder.Record(frame, frames[frame]);
+	}
+
+	std::stringstream stream;
+	recorder.Save(stream);
+
+	InputScript script(Keys());
+	assert(script.Load(stream));
+	assert(script.GetLength() == 40);
+	for (int frame = 0; frame < 40; ++frame) {
+		std::vector<int> held = Held(script, frame);
+		std::sort(held.begin(), held.end());
+		std::vector<int> expected = frames[frame];
+		std::sort(expected.begin(), expected.end());
+		assert(held == expected);
+	}
+}
+
+static void FrameLists() {
+	std::vector<int> frames;
+	assert(InputScript::ParseFrameList("60,10,30-33,100-120:10,31", frames));
+	int const expected[] = { 10, 30, 31, 32, 33, 60, 100, 110, 120 };
+	assert(frames == std::vector<int>(expected, expected + 9));
+
+	assert(InputScript::ParseFrameList("", frames));
+	assert(frames.empty());
+
+	assert(!InputScript::ParseFrameList("5-3", frames));
+	assert(!InputScript::ParseFrameList("5:2", frames));
+	assert(!InputScript::ParseFrameList("1-9:0", frames));
+	assert(!InputScript::ParseFrameList("a", frames));
+}
+
+extern "C" int main(int, char**) {
+	PressesAreHeldForTheirDuration();
+	ErrorsNameTheLine();
+	RecordingReplays();
+	FrameLists();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,279 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+#include <stdint.h>
+#include "particle_renderer.h"
+
+// Compares the ParticleRenderer with the way the weather was drawn before:
+// every sprite blitted into a cleared full screen surface that is then
+// blitted over the screen.
+
+namespace {
+	const int width = 320;
+	const int height = 240;
+	const BitmapKernels::Channels argb = { 16, 8, 0, 24 };
+
+	const uint8_t drop_image[4 * 6] = {
+		0, 0, 0, 1,
+		0, 0, 1, 0,
+		0, 0, 1, 0,
+		0, 1, 2, 0,
+		0, 1, 0, 0,
+		1, 0, 0, 0
+	};
+
+	uint32_t Random() {
+		static uint32_t state = 777;
+		state = state * 1103515245 + 12345;
+		return state >> 8;
+	}
+
+	std::vector<uint32_t> Screen() {
+		std::vector<uint32_t> screen(width * height);
+		for (size_t i = 0; i < screen.size(); ++i) {
+			screen[i] = 0xFF000000u | (Random() & 0xFFFFFF);
+		}
+		return screen;
+	}
+
+	BitmapKernels::Region GetRegion(std::vector<uint32_t>& pixels) {
+		BitmapKernels::Region region = { reinterpret_cast<uint8_t*>(&pixels.front()), width * 4, width, height };
+		return region;
+	}
+
+	ParticleRenderer::Sprite Drop() {
+		const uint32_t palette[3] = {
+			0,
+			ParticleRenderer::GetPixel(argb, 192, 192, 192, 96),
+			ParticleRenderer::GetPixel(argb, 255, 255, 255, 200)
+		};
+		return ParticleRenderer::CreateSprite(drop_image, 4, 6, palette);
+	}
+
+	// Positions partly outside of the screen
+	void Positions(std::vector<int>& x, std::vector<int>& y, size_t count) {
+		x.resize(count);
+		y.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			x[i] = (int)(Random() % (width + 20)) - 10;
+			y[i] = (int)(Random() % (height + 20)) - 10;
+		}
+	}
+
+	// Full surface like the old Weather::weather_surface
+	void Reference(std::vector<uint32_t>& screen, std::vector<int> const& x, std::vector<int> const& y,
+			ParticleRenderer::Sprite const& sprite, uint32_t background) {
+		std::vector<uint32_t> surface(width * height, background);
+		for (size_t i = 0; i < x.size(); ++i) {
+			for (size_t p = 0; p < sprite.size(); ++p) {
+				int const px = x[i] + sprite[p].x;
+				int const py = y[i] + sprite[p].y;
+				if (px < 0 || px >= width || py < 0 || py >= height)
+					continue;
+				uint32_t& dst = surface[py * width + px];
+				dst = BitmapKernels::OverUn8x4(sprite[p].pixel, dst, argb.a);
+			}
+		}
+		for (size_t i = 0; i < screen.size(); ++i) {
+			screen[i] = BitmapKernels::OverUn8x4(surface[i], screen[i], argb.a);
+		}
+	}
+
+	int MaxDifference(uint32_t a, uint32_t b) {
+		int diff = 0;
+		for (int shift = 0; shift < 32; shift += 8) {
+			diff = std::max(diff, abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)));
+		}
+		return diff;
+	}
+}
+
+static void SpriteSkipsTransparentPixels() {
+	ParticleRenderer::Sprite const sprite = Drop();
+	assert(sprite.size() == 7);
+	assert(sprite[0].x == 3 && sprite[0].y == 0);
+	assert(sprite[4].x == 2 && sprite[4].y == 3);
+	assert(sprite[4].pixel == ParticleRenderer::GetPixel(argb, 255, 255, 255, 200));
+}
+
+static void MatchesFullSurface() {
+	ParticleRenderer renderer(width, height, argb);
+	ParticleRenderer::Sprite const sprite = Drop();
+	std::vector<int> x, y;
+
+	for (int frame = 0; frame < 10; ++frame) {
+		Positions(x, y, 300);
+		std::vector<uint32_t> screen = Screen();
+		std::vector<uint32_t> expected = screen;
+
+		renderer.Plot(&x.front(), &y.front(), x.size(), sprite);
+
+		std::set<int> rows;
+		for (size_t i = 0; i < x.size(); ++i) {
+			for (size_t p = 0; p < sprite.size(); ++p) {
+				int const px = x[i] + sprite[p].x;
+				int const py = y[i] + sprite[p].y;
+				if (px >= 0 && px < width && py >= 0 && py < height)
+					rows.insert(py);
+			}
+		}
+		assert(renderer.GetTouchedRows() == (int)rows.size());
+
+		Reference(expected, x, y, sprite, 0);
+		renderer.Composite(GetRegion(screen), 0);
+		assert(screen == expected);
+		assert(renderer.GetTouchedRows() == 0);
+	}
+
+	// The layer was cleared, nothing is drawn any more
+	std::vector<uint32_t> screen = Screen();
+	std::vector<uint32_t> const before = screen;
+	renderer.Composite(GetRegion(screen), 0);
+	assert(screen == before);
+}
+
+static void BackgroundMatchesFill() {
+	ParticleRenderer renderer(width, height, argb);
+	ParticleRenderer::Sprite const sprite = Drop();
+	uint32_t const background = ParticleRenderer::GetPixel(argb, 192, 160, 128, 160);
+	std::vector<int> x, y;
+	Positions(x, y, 200);
+
+	std::vector<uint32_t> screen = Screen();
+	std::vector<uint32_t> expected = screen;
+
+	renderer.Plot(&x.front(), &y.front(), x.size(), sprite);
+	renderer.Composite(GetRegion(screen), background);
+	Reference(expected, x, y, sprite, background);
+
+	// Blending the background first rounds differently
+	for (size_t i = 0; i < screen.size(); ++i) {
+		assert(MaxDifference(screen[i], expected[i]) <= 2);
+	}
+}
+
+static void PartialClipKeepsUndamagedPixels() {
+	ParticleRenderer renderer(width, height, argb);
+	ParticleRenderer::Sprite const sprite = Drop();
+	uint32_t const fog = ParticleRenderer::GetPixel(argb, 128, 128, 128, 160);
+
+	// Overlapping damage, the overlap must not be blended twice
+	std::vector<ParticleRenderer::Area> areas;
+	ParticleRenderer::Area const a = { 10, 20, 100, 50 };
+	ParticleRenderer::Area const b = { 60, 40, 100, 80 };
+	ParticleRenderer::Area const c = { 300, 230, 50, 50 };
+	areas.push_back(a);
+	areas.push_back(b);
+	areas.push_back(c);
+
+	std::vector<uint32_t> const original = Screen();
+	std::vector<uint32_t> screen = original;
+	std::vector<int> x, y;
+
+	// The first frame draws everything
+	Positions(x, y, 200);
+	renderer.Plot(&x.front(), &y.front(), x.size(), sprite);
+	renderer.Composite(GetRegion(screen), fog);
+	std::vector<uint32_t> const fogged = screen;
+
+	for (int frame = 0; frame < 5; ++frame) {
+		// The damaged parts were drawn again by the drawables below
+		for (int py = 0; py < height; ++py) {
+			for (int px = 0; px < width; ++px) {
+				for (size_t i = 0; i < areas.size(); ++i) {
+					if (px >= areas[i].x && px < areas[i].x + areas[i].width &&
+						py >= areas[i].y && py < areas[i].y + areas[i].height) {
+						screen[py * width + px] = original[py * width + px];
+					}
+				}
+			}
+		}
+
+		Positions(x, y, 200);
+		renderer.Plot(&x.front(), &y.front(), x.size(), sprite);
+		std::vector<uint32_t> expected = screen;
+		renderer.Composite(GetRegion(screen), fog, areas);
+		Reference(expected, x, y, sprite, fog);
+
+		for (int py = 0; py < height; ++py) {
+			for (int px = 0; px < width; ++px) {
+				bool inside = false;
+				for (size_t i = 0; i < areas.size(); ++i) {
+					inside = inside || (px >= areas[i].x && px < areas[i].x + areas[i].width &&
+						py >= areas[i].y && py < areas[i].y + areas[i].height);
+				}
+				int const p = py * width + px;
+				if (inside) {
+					assert(MaxDifference(screen[p], expected[p]) <= 2);
+				} else {
+					// Not fogged again
+					assert(screen[p] == fogged[p]);
+				}
+			}
+		}
+		assert(renderer.GetTouchedRows() == 0);
+	}
+}
+
+static void TouchedAreasCoverTheRuns() {
+	ParticleRenderer renderer(width, height, argb);
+	ParticleRenderer::Sprite const sprite = Drop();
+	std::vector<ParticleRenderer::Area> areas;
+	renderer.GetTouchedAreas(areas);
+	assert(areas.empty());
+
+	// Two overlapping runs of rows, one apart and one cut by the border
+	int const x[4] = { 10, 100, 50, -2 };
+	int const y[4] = { 10, 13, 100, 200 };
+	renderer.Plot(x, y, 4, sprite);
+	renderer.GetTouchedAreas(areas);
+
+	assert(areas.size() == 3);
+	assert(areas[0].x == 10 && areas[0].y == 10 && areas[0].width == 94 && areas[0].height == 9);
+	assert(areas[1].x == 50 && areas[1].y == 100 && areas[1].width == 4 && areas[1].height == 6);
+	assert(areas[2].x == 0 && areas[2].y == 200 && areas[2].width == 2 && areas[2].height == 4);
+
+	std::vector<uint32_t> screen = Screen();
+	renderer.Composite(GetRegion(screen), 0);
+	renderer.GetTouchedAreas(areas);
+	assert(areas.empty());
+}
+
+static void Benchmark() {
+	ParticleRenderer renderer(width, height, argb);
+	ParticleRenderer::Sprite const sprite = Drop();
+	std::vector<int> x, y;
+	Positions(x, y, 300);
+	std::vector<uint32_t> screen = Screen();
+	const int rounds = 200;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		renderer.Plot(&x.front(), &y.front(), x.size(), sprite);
+		renderer.Composite(GetRegion(screen), 0);
+	}
+	double const batched = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		Reference(screen, x, y, sprite, 0);
+	}
+	double const surface = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	printf("300 particles: batched %.3f ms, full surface %.3f ms per frame\n", batched / rounds, surface / rounds);
+}
+
+extern "C" int main(int, char**) {
+	SpriteSkipsTransparentPixels();
+	MatchesFullSurface();
+	BackgroundMatchesFill();
+	PartialClipKeepsUndamagedPixels();
+	TouchedAreasCoverTheRuns();
+	Benchmark();
+
+	return EXIT_SUCCESS;
+}
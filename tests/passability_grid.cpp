@@ -0,0 +1,225 @@
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include "map_data.h"
+#include "passability_grid.h"
+
+namespace {
+	const int All = Passable::Down | Passable::Left | Passable::Right | Passable::Up;
+
+	// A chipset where every chip can be passed and has no terrain flags,
+	// on a map of lower chip 0 below a star tile
+	struct Map {
+		int width;
+		int height;
+		std::vector<int16_t> lower_layer;
+		std::vector<int16_t> upper_layer;
+		std::vector<unsigned char> passages_down;
+		std::vector<unsigned char> passages_up;
+		std::vector<uint8_t> lower_tiles;
+		std::vector<uint8_t> upper_tiles;
+		std::vector<uint8_t> terrain_flags;
+
+		Map(int w, int h) : width(w), height(h),
+			lower_layer(w * h, 0), upper_layer(w * h, BLOCK_F),
+			passages_down(162, All), passages_up(144, All),
+			terrain_flags(162, 0) {
+			passages_up[0] |= Passable::Above;
+			for (int i = 0; i < 144; ++i) {
+				lower_tiles.push_back((uint8_t)i);
+				upper_tiles.push_back((uint8_t)i);
+			}
+		}
+
+		void Build(PassabilityGrid& grid) const {
+			grid.Build(width, height, lower_layer, upper_layer,
+				passages_down, passages_up, lower_tiles, upper_tiles,
+				terrain_flags);
+		}
+	};
+
+	int Passes(PassabilityGrid const& grid, int tile_index) {
+		int result = 0;
+		for (int bit = Passable::Down; bit <= Passable::Up; bit <<= 1) {
+			if (grid.IsPassable(tile_index, bit))
+				result |= bit;
+		}
+		return result;
+	}
+}
+
+static void UpperTileDecides() {
+	Map map(3, 1);
+	// Lower chip 1 only passes down, upper chip 1 only left
+	map.passages_down[1] = Passable::Down;
+	map.passages_up[1] = Passable::Left;
+	map.passages_up[2] = Passable::Left | Passable::Down | Passable::Above;
+	map.lower_layer.assign(3, 1000);
+	map.upper_layer[1] = BLOCK_F + 1;
+	map.upper_layer[2] = BLOCK_F + 2;
+
+	PassabilityGrid grid;
+	map.Build(grid);
+
+	// Below a star tile the lower tile decides
+	assert(Passes(grid, 0) == Passable::Down);
+	assert(Passes(grid, 1) == Passable::Left);
+	// A star tile still blocks its own directions
+	assert(Passes(grid, 2) == Passable::Down);
+	assert((grid.GetFlags(1) & PassabilityGrid::Above) == 0);
+	assert((grid.GetFlags(2) & PassabilityGrid::Above) != 0);
+}
+
+static void WallAutotiles() {
+	Map map(3, 1);
+	// Autotile chip 6 is a wall that can't be passed
+	map.passages_down[6] = Passable::Wall;
+	map.lower_layer[0] = BLOCK_D + 20;
+	map.lower_layer[1] = BLOCK_D + 46;
+	map.lower_layer[2] = BLOCK_D + 19;
+
+	PassabilityGrid grid;
+	map.Build(grid);
+
+	// The wall parts of the autotile can be passed below star tiles
+	assert(Passes(grid, 0) == All);
+	assert(Passes(grid, 1) == All);
+	assert(Passes(grid, 2) == 0);
+
+	// Not without the wall flag
+	map.passages_down[6] = 0;
+	map.Build(grid);
+	assert(Passes(grid, 0) == 0);
+}
+
+static void MapEdgesAndWrap() {
+	Map map(4, 3);
+	map.passages_down[18] = 0;
+	map.passages_down[19] = Passable::Right;
+	map.passages_down[20] = Passable::Left;
+
+	// Blocked right border of the middle row, one-way tiles at the
+	// left and right border of the last row
+	map.lower_layer[3 + 1 * 4] = BLOCK_E;
+	map.lower_layer[0 + 2 * 4] = BLOCK_E + 2;
+	map.lower_layer[3 + 2 * 4] = BLOCK_E + 1;
+
+	PassabilityGrid grid;
+	map.Build(grid);
+
+	// Tiles of the border don't bleed into the next row, or into the
+	// other side of the row that a loop map wraps to
+	assert(Passes(grid, 3 + 1 * 4) == 0);
+	assert(Passes(grid, 0 + 2 * 4) == Passable::Left);
+	assert(Passes(grid, 0 + 1 * 4) == All);
+	assert(Passes(grid, 2 + 1 * 4) == All);
+	assert(Passes(grid, 3 + 0 * 4) == All);
+	assert(Passes(grid, 3 + 2 * 4) == Passable::Right);
+	assert(Passes(grid, 0) == All);
+
+	// Layers shorter than the map are filled with chip 0 and star tiles
+	map.lower_layer.resize(5);
+	map.upper_layer.resize(5);
+	map.passages_down[0] = Passable::Up;
+	map.Build(grid);
+	assert(Passes(grid, 4) == Passable::Up);
+	assert(Passes(grid, 3 + 2 * 4) == Passable::Up);
+	assert((grid.GetFlags(3 + 2 * 4) & PassabilityGrid::Above) != 0);
+}
+
+static void Substitutions() {
+	Map map(4, 1);
+	map.passages_down[18 + 1] = 0;
+	map.passages_down[18 + 2] = Passable::Up;
+	map.passages_down[18 + 3] = Passable::Down;
+	map.passages_up[4] = Passable::Right;
+	map.lower_layer[0] = BLOCK_E + 1;
+	map.lower_layer[1] = BLOCK_E + 2;
+	map.lower_layer[2] = BLOCK_E + 1;
+	map.upper_layer[3] = BLOCK_F + 5;
+
+	PassabilityGrid grid;
+	map.Build(grid);
+	assert(Passes(grid, 0) == 0);
+	assert(Passes(grid, 1) == Passable::Up);
+	assert(Passes(grid, 2) == 0);
+	assert(Passes(grid, 3) == All);
+
+	// Both tiles of the chip change
+	grid.SubstituteDown(1, 2);
+	assert(Passes(grid, 0) == Passable::Up);
+	assert(Passes(grid, 1) == Passable::Up);
+	assert(Passes(grid, 2) == Passable::Up);
+
+	// Replacing the new chip also replaces the earlier substitution
+	grid.SubstituteDown(2, 3);
+	assert(Passes(grid, 0) == Passable::Down);
+	assert(Passes(grid, 1) == Passable::Down);
+	assert(Passes(grid, 2) == Passable::Down);
+	assert(Passes(grid, 3) == All);
+
+	grid.SubstituteUp(5, 4);
+	assert(Passes(grid, 3) == Passable::Right);
+	assert(Passes(grid, 0) == Passable::Down);
+
+	// A new build starts without the substitutions
+	map.Build(grid);
+	assert(Passes(grid, 0) == 0);
+	assert(Passes(grid, 3) == All);
+}
+
+static void TerrainAndCounter() {
+	Map map(4, 1);
+	map.terrain_flags[0] = PassabilityGrid::TerrainBoat;
+	map.terrain_flags[18 + 7] = PassabilityGrid::TerrainShip | PassabilityGrid::TerrainAirship;
+	map.terrain_flags[18 + 8] = PassabilityGrid::TerrainAirshipLand;
+	map.passages_up[3] = All | Passable::Counter;
+	map.lower_layer[1] = BLOCK_E + 7;
+	map.upper_layer[2] = BLOCK_F + 3;
+
+	PassabilityGrid grid;
+	map.Build(grid);
+
+	int const vehicles = PassabilityGrid::Boat | PassabilityGrid::Ship |
+		PassabilityGrid::Airship | PassabilityGrid::AirshipLand;
+	assert((grid.GetFlags(0) & vehicles) == PassabilityGrid::Boat);
+	assert((grid.GetFlags(1) & vehicles) == (PassabilityGrid::Ship | PassabilityGrid::Airship));
+	assert((grid.GetFlags(2) & PassabilityGrid::Counter) != 0);
+	assert((grid.GetFlags(1) & PassabilityGrid::Counter) == 0);
+
+	// The terrain follows the substituted chip
+	grid.SubstituteDown(7, 8);
+	assert((grid.GetFlags(1) & vehicles) == PassabilityGrid::AirshipLand);
+	assert((grid.GetFlags(0) & vehicles) == PassabilityGrid::Boat);
+
+	// Chipsets without terrain data can be flown over and landed on
+	map.terrain_flags.clear();
+	map.Build(grid);
+	assert((grid.GetFlags(0) & vehicles) == (PassabilityGrid::Airship | PassabilityGrid::AirshipLand));
+}
+
+static void ClearedGrid() {
+	Map map(2, 2);
+	PassabilityGrid grid;
+	map.Build(grid);
+	grid.Clear();
+
+	// Substitutions without a map don't touch any tile
+	grid.SubstituteDown(0, 1);
+	grid.SubstituteUp(0, 1);
+
+	map.Build(grid);
+	assert(Passes(grid, 3) == All);
+}
+
+extern "C" int main(int, char**) {
+	UpperTileDecides();
+	WallAutotiles();
+	MapEdgesAndWrap();
+	Substitutions();
+	TerrainAndCounter();
+	ClearedGrid();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+// The profiler is off in default builds
+#define ENABLE_PROFILER
+
+#include <cassert>
+#include <cstdlib>
+#include "profiler.h"
+
+// Checks the ring buffers and that nested scopes of one section are only
+// counted once.
+
+namespace {
+	void Spin(double ms) {
+		double const end = Profiler::Now() + ms;
+		while (Profiler::Now() < end) {}
+	}
+
+	void Recurse(int depth) {
+		PROFILE_SCOPE(Profiler::SectionInterpreter);
+		Spin(1.0);
+		if (depth > 0)
+			Recurse(depth - 1);
+	}
+}
+
+static void DisabledDoesNotMeasure() {
+	Profiler::SetEnabled(false);
+	{
+		PROFILE_SCOPE(Profiler::SectionScene);
+		Spin(1.0);
+	}
+	Profiler::EndFrame();
+	assert(Profiler::GetMax(Profiler::SectionScene) == 0.0);
+	assert(Profiler::GetMean(Profiler::SectionScene) == 0.0);
+}
+
+static void HistoryKeepsTheLastFrames() {
+	Profiler::SetEnabled(true);
+	for (int frame = 1; frame <= Profiler::history_size + 10; ++frame) {
+		Profiler::Add(Profiler::SectionAudio, frame);
+		Profiler::Add(Profiler::SectionAudio, 0.5);
+		Profiler::EndFrame();
+	}
+
+	assert(Profiler::GetTime(Profiler::SectionAudio, 0) == Profiler::history_size + 10.5);
+	assert(Profiler::GetTime(Profiler::SectionAudio, Profiler::history_size - 1) == 11.5);
+	assert(Profiler::GetMax(Profiler::SectionAudio) == Profiler::history_size + 10.5);
+	assert(Profiler::GetMean(Profiler::SectionAudio) == 11.5 + (Profiler::history_size - 1) / 2.0);
+
+	// Only the finished frames count
+	Profiler::SetEnabled(true);
+	Profiler::Add(Profiler::SectionAudio, 4.0);
+	Profiler::EndFrame();
+	Profiler::Add(Profiler::SectionAudio, 2.0);
+	Profiler::EndFrame();
+	Profiler::Add(Profiler::SectionAudio, 100.0);
+	assert(Profiler::GetMean(Profiler::SectionAudio) == 3.0);
+	assert(Profiler::GetTime(Profiler::SectionAudio, 0) == 2.0);
+}
+
+static void NestedScopesCountOnce() {
+	Profiler::SetEnabled(true);
+	double const begin = Profiler::Now();
+	{
+		PROFILE_SCOPE(Profiler::SectionMap);
+		Recurse(3);
+	}
+	double const elapsed = Profiler::Now() - begin;
+	Profiler::EndFrame();
+
+	double const map = Profiler::GetTime(Profiler::SectionMap, 0);
+	double const interpreter = Profiler::GetTime(Profiler::SectionInterpreter, 0);
+	assert(interpreter >= 4.0 && interpreter <= elapsed);
+	assert(map >= interpreter && map <= elapsed);
+}
+
+static void DrawSectionsFollowTheTypes() {
+	assert(Profiler::GetDrawSection(TypeWindow) == Profiler::SectionDraw);
+	assert(Profiler::GetDrawSection(TypeDefault) == Profiler::SectionCount - 1);
+	for (int i = 0; i < Profiler::SectionCount; ++i) {
+		assert(Profiler::GetName(i) != NULL);
+	}
+}
+
+extern "C" int main(int, char**) {
+	DisabledDoesNotMeasure();
+	HistoryKeepsTheLastFrames();
+	NestedScopesCountOnce();
+	DrawSectionsFollowTheTypes();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include "sound_cache.h"
+
+// Replays a synthetic sound effect trace against the SoundCache.
+// A few effects (cursor, decision) are played all the time, a long tail
+// of battle and map effects rarely. Voices pin their entry until they
+// finished playing, the pinned buffers must never be overwritten.
+
+namespace {
+	const size_t arena_size = 6291456;
+	const size_t max_entries = 256;
+	const int sound_count = 160;
+	const int trace_length = 50000;
+	const int max_voices = 8;
+
+	struct Voice {
+		int id;
+		int sound;
+		int end;
+	};
+
+	unsigned rand_state = 12345;
+
+	unsigned Random() {
+		rand_state = rand_state * 1103515245 + 12345;
+		return (rand_state >> 16) & 0x7FFF;
+	}
+
+	std::string SoundName(int sound) {
+		char name[32];
+		sprintf(name, "se_%03d", sound);
+		return name;
+	}
+
+	size_t SoundSize(int sound) {
+		// 8 KiB up to 512 KiB, bigger ones further down the tail
+		return 8192 + (sound * 7919 % 64) * 8192;
+	}
+
+	// Picks sounds with a Zipf like distribution
+	int PickSound(const std::vector<double>& weights, double total) {
+		double r = Random() / 32768.0 * total;
+		for (int i = 0; i < sound_count; ++i) {
+			r -= weights[i];
+			if (r <= 0) {
+				return i;
+			}
+		}
+		return sound_count - 1;
+	}
+
+	void Fill(SoundCache& cache, int id, int sound) {
+		uint8_t* buffer = cache.GetBuffer(id);
+		size_t const size = cache.GetSize(id);
+		buffer[0] = (uint8_t)sound;
+		buffer[size / 2] = (uint8_t)sound;
+		buffer[size - 1] = (uint8_t)sound;
+	}
+
+	void Verify(const SoundCache& cache, int id, int sound) {
+		const uint8_t* buffer = cache.GetBuffer(id);
+		size_t const size = cache.GetSize(id);
+		assert(size == SoundSize(sound));
+		assert(buffer[0] == (uint8_t)sound);
+		assert(buffer[size / 2] == (uint8_t)sound);
+		assert(buffer[size - 1] == (uint8_t)sound);
+		(void)buffer;
+		(void)size;
+	}
+}
+
+static void Trace() {
+	std::vector<uint8_t> arena(arena_size);
+	SoundCache cache(&arena.front(), arena.size(), max_entries);
+
+	std::vector<double> weights(sound_count);
+	double total = 0.0;
+	for (int i = 0; i < sound_count; ++i) {
+		weights[i] = 1.0 / (i + 1);
+		total += weights[i];
+	}
+
+	std::deque<Voice> voices;
+
+	for (int t = 0; t < trace_length; ++t) {
+		// Voices which finished release their pin
+		for (std::deque<Voice>::iterator it = voices.begin(); it != voices.end();) {
+			if (it->end <= t) {
+				Verify(cache, it->id, it->sound);
+				cache.Unpin(it->id);
+				it = voices.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		if (voices.size() >= (size_t)max_voices) {
+			continue;
+		}
+
+		int const sound = PickSound(weights, total);
+		std::string const name = SoundName(sound);
+
+		int id = cache.Find(name);
+		if (id < 0) {
+			id = cache.Allocate(SoundSize(sound));
+			assert(id >= 0);
+			Fill(cache, id, sound);
+			cache.Publish(id, name);
+		} else {
+			Verify(cache, id, sound);
+		}
+
+		cache.Pin(id);
+		Voice voice = { id, sound, t + 1 + (int)(SoundSize(sound) / 16384) };
+		voices.push_back(voice);
+	}
+
+	for (size_t i = 0; i < voices.size(); ++i) {
+		Verify(cache, voices[i].id, voices[i].sound);
+		cache.Unpin(voices[i].id);
+	}
+
+	SoundCache::Stats const stats = cache.GetStats();
+	assert(stats.hits + stats.misses > 0);
+	assert(stats.failures == 0);
+	assert(stats.bytes <= arena_size);
+
+	printf("SE trace: %u lookups, %u hits, %u misses, %u evictions\n",
+		stats.hits + stats.misses, stats.hits, stats.misses, stats.evictions);
+	printf("hit rate: %.1f %%, %u entries, %u bytes used\n",
+		100.0 * stats.hits / (stats.hits + stats.misses),
+		(unsigned)stats.entries, (unsigned)stats.bytes);
+
+	cache.Clear();
+	assert(cache.GetStats().bytes == 0);
+	assert(cache.GetStats().entries == 0);
+}
+
+static void Accounting() {
+	std::vector<uint8_t> arena(4096);
+	SoundCache cache(&arena.front(), arena.size(), 4);
+
+	// Buffers are aligned and freed blocks merge again
+	int a = cache.Allocate(100);
+	int b = cache.Allocate(1000);
+	int c = cache.Allocate(1000);
+	assert(a >= 0 && b >= 0 && c >= 0);
+	assert(cache.GetBuffer(b) - cache.GetBuffer(a) == (int)SoundCache::alignment);
+	cache.Publish(a, "a");
+	cache.Publish(b, "b");
+	cache.Publish(c, "c");
+	assert(cache.GetStats().bytes == 128 + 1024 + 1024);
+
+	// Too big for the arena
+	assert(cache.Allocate(8192) < 0);
+	assert(cache.GetStats().failures == 1);
+
+	// Pinned entries survive, the least recently used ones are evicted
+	// until the freed blocks merged into a big enough one
+	cache.Pin(a);
+	assert(cache.Find("c") == c);
+	int d = cache.Allocate(2048);
+	assert(d >= 0);
+	assert(cache.GetStats().evictions == 2);
+	assert(cache.GetBuffer(d) == cache.GetBuffer(a) + SoundCache::alignment);
+	assert(cache.Find("b") < 0);
+	assert(cache.Find("c") < 0);
+	assert(cache.Find("a") == a);
+
+	// Replacing a pinned entry keeps its buffer until it is unpinned
+	cache.Publish(d, "a");
+	assert(cache.Find("a") == d);
+	assert(cache.GetStats().entries == 2);
+	cache.Unpin(a);
+	assert(cache.GetStats().entries == 1);
+	assert(cache.GetStats().bytes == 2048);
+}
+
+extern "C" int main(int, char**) {
+	Accounting();
+	Trace();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include "texture_swizzle.h"
+
+// Compares TextureSwizzle with the per-pixel tiling that sf2d does for
+// sf2d_fill_texture_from_RGBA8 and measures a full and a partial upload.
+
+namespace {
+	uint32_t Random() {
+		static uint32_t state = 99;
+		state = state * 1103515245 + 12345;
+		return (state >> 16) | (state << 16);
+	}
+
+	struct Surface {
+		int width;
+		int height;
+		std::vector<uint32_t> pixels;
+		TextureSwizzle::Image image;
+
+		Surface(int width, int height) : width(width), height(height), pixels(width * height) {
+			for (size_t i = 0; i < pixels.size(); ++i) {
+				pixels[i] = Random();
+			}
+			TextureSwizzle::Image i = { reinterpret_cast<const uint8_t*>(&pixels.front()), width * 4, width, height };
+			image = i;
+		}
+	};
+
+	struct Tiled {
+		std::vector<uint32_t> pixels;
+		TextureSwizzle::Texture texture;
+
+		Tiled(int width, int height, uint32_t fill) : pixels(width * height, fill) {
+			TextureSwizzle::Texture t = { &pixels.front(), width, height };
+			texture = t;
+		}
+	};
+
+	// Like get_morton_offset and sf2d_texture_tile32 in sf2d
+	uint32_t MortonInterleave(uint32_t x, uint32_t y) {
+		static const uint32_t xlut[] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15 };
+		static const uint32_t ylut[] = { 0x00, 0x02, 0x08, 0x0a, 0x20, 0x22, 0x28, 0x2a };
+		return xlut[x % 8] + ylut[y % 8];
+	}
+
+	std::vector<uint32_t> Reference(Surface const& surface, int tex_width, int tex_height) {
+		std::vector<uint32_t> linear(tex_width * tex_height, 0);
+		for (int y = 0; y < surface.height; ++y) {
+			for (int x = 0; x < surface.width; ++x) {
+				linear[y * tex_width + x] = __builtin_bswap32(surface.pixels[y * surface.width + x]);
+			}
+		}
+
+		std::vector<uint32_t> tiled(tex_width * tex_height);
+		for (int j = 0; j < tex_height; ++j) {
+			for (int i = 0; i < tex_width; ++i) {
+				uint32_t coarse_y = j & ~7;
+				uint32_t offset = MortonInterleave(i & 7, j & 7) + (i & ~7) * 8 + coarse_y * tex_width;
+				tiled[offset] = linear[i + (tex_height - 1 - j) * tex_width];
+			}
+		}
+		return tiled;
+	}
+}
+
+static void FullImageMatches(int width, int height, int tex_width, int tex_height) {
+	Surface surface(width, height);
+	std::vector<uint32_t> const expected = Reference(surface, tex_width, tex_height);
+	Tiled tiled(tex_width, tex_height, 0);
+
+	TextureSwizzle::SwizzleImage(tiled.texture, surface.image);
+	assert(tiled.pixels == expected);
+
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			uint32_t const offset = TextureSwizzle::GetTiledOffset(tiled.texture, x, y);
+			assert(tiled.pixels[offset] == __builtin_bswap32(surface.pixels[y * width + x]));
+		}
+	}
+}
+
+// Only the tiles covering the rectangle change and they get their final
+// content
+static void RectsOnlyTouchTheirTiles() {
+	const int width = 320, height = 240, tex_width = 512, tex_height = 256;
+	const uint32_t sentinel = 0xDEADBEEF;
+	Surface surface(width, height);
+	std::vector<uint32_t> const expected = Reference(surface, tex_width, tex_height);
+
+	for (int i = 0; i < 500; ++i) {
+		int const x = (int)(Random() % (width + 40)) - 20;
+		int const y = (int)(Random() % (height + 40)) - 20;
+		int const w = (int)(Random() % 100);
+		int const h = (int)(Random() % 100);
+
+		Tiled tiled(tex_width, tex_height, sentinel);
+		int const converted = TextureSwizzle::SwizzleRect(tiled.texture, surface.image, x, y, w, h);
+
+		int count = 0;
+		for (int py = 0; py < height; ++py) {
+			for (int px = 0; px < width; ++px) {
+				uint32_t const offset = TextureSwizzle::GetTiledOffset(tiled.texture, px, py);
+				bool const inside = w > 0 && h > 0 &&
+					px >= (std::max(x, 0) & ~7) && px < x + w + 7 - ((x + w + 7) & 7) &&
+					py >= (std::max(y, 0) & ~7) && py < y + h + 7 - ((y + h + 7) & 7);
+				if (inside) {
+					assert(tiled.pixels[offset] == expected[offset]);
+					++count;
+				} else {
+					assert(tiled.pixels[offset] == sentinel);
+				}
+			}
+		}
+		assert(count == converted);
+
+		// The byte range of the rows holds every converted pixel
+		uint32_t first, size;
+		TextureSwizzle::GetRowBytes(tiled.texture, y, h, first, size);
+		for (size_t p = 0; p < tiled.pixels.size(); ++p) {
+			if (tiled.pixels[p] != sentinel) {
+				assert(p * 4 >= first && p * 4 < first + size);
+			}
+		}
+	}
+}
+
+static void Benchmark() {
+	const int width = 320, height = 240;
+	Surface surface(width, height);
+	Tiled tiled(512, 256, 0);
+	const int rounds = 1000;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		TextureSwizzle::SwizzleImage(tiled.texture, surface.image);
+	}
+	double const full = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// A message window
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		TextureSwizzle::SwizzleRect(tiled.texture, surface.image, 0, 160, 320, 80);
+	}
+	double const window = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	printf("swizzle full frame %.3f ms, message window %.3f ms\n", full / rounds, window / rounds);
+}
+
+extern "C" int main(int, char**) {
+	FullImageMatches(320, 240, 512, 256);
+	FullImageMatches(100, 50, 128, 64);
+	FullImageMatches(8, 8, 8, 8);
+	RectsOnlyTouchTheirTiles();
+	Benchmark();
+
+	return EXIT_SUCCESS;
+}
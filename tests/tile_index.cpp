@@ -0,0 +1,174 @@
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include "tile_index.h"
+
+namespace {
+	std::vector<int> Items(TileIndex const& index, int x, int y) {
+		std::vector<int> items;
+		index.Get(x, y, items);
+		return items;
+	}
+
+	std::vector<int> List(int a, int b = -1, int c = -1) {
+		std::vector<int> list;
+		list.push_back(a);
+		if (b >= 0) list.push_back(b);
+		if (c >= 0) list.push_back(c);
+		return list;
+	}
+}
+
+static void ItemsOfATileAreSorted() {
+	TileIndex index;
+	index.Reset(10, 8, 10);
+	assert(index.size() == 10);
+
+	index.Place(5, 2, 3);
+	index.Place(9, 2, 3);
+	index.Place(2, 2, 3);
+	index.Place(7, 3, 3);
+	assert(Items(index, 2, 3) == List(2, 5, 9));
+	assert(index.GetFirst(2, 3) == 2);
+	assert(Items(index, 3, 3) == List(7));
+	assert(Items(index, 3, 2).empty());
+	assert(index.GetFirst(3, 2) == -1);
+}
+
+static void MovesKeepTheOrder() {
+	TileIndex index;
+	index.Reset(10, 8, 10);
+	index.Place(2, 2, 3);
+	index.Place(5, 2, 3);
+	index.Place(9, 2, 3);
+
+	// The first, middle and last item walk away and come back
+	index.Place(2, 2, 4);
+	assert(Items(index, 2, 3) == List(5, 9));
+	assert(index.GetFirst(2, 3) == 5);
+	index.Place(5, 2, 4);
+	index.Place(9, 1, 3);
+	assert(Items(index, 2, 3).empty());
+	assert(Items(index, 2, 4) == List(2, 5));
+	assert(Items(index, 1, 3) == List(9));
+
+	index.Place(9, 2, 3);
+	index.Place(5, 2, 3);
+	index.Place(2, 2, 3);
+	assert(Items(index, 2, 3) == List(2, 5, 9));
+	assert(Items(index, 2, 4).empty());
+
+	// Placing on the same tile again changes nothing
+	index.Place(5, 2, 3);
+	assert(Items(index, 2, 3) == List(2, 5, 9));
+}
+
+static void ItemsOutsideOfTheMap() {
+	TileIndex index;
+	index.Reset(10, 8, 10);
+
+	// Each side of the map, the outside tiles are told apart
+	index.Place(4, -1, 0);
+	index.Place(1, 10, 7);
+	index.Place(3, 0, -1);
+	index.Place(8, 9, 8);
+	index.Place(6, -1, 0);
+	assert(Items(index, -1, 0) == List(4, 6));
+	assert(index.GetFirst(-1, 0) == 4);
+	assert(Items(index, 10, 7) == List(1));
+	assert(Items(index, 0, -1) == List(3));
+	assert(Items(index, 9, 8) == List(8));
+	assert(Items(index, -2, 0).empty());
+	assert(index.GetFirst(10, 6) == -1);
+
+	// The map borders themselves are inside
+	assert(Items(index, 0, 0).empty());
+	assert(Items(index, 9, 7).empty());
+
+	// Walking onto the map and off it again
+	index.Place(4, 0, 0);
+	assert(Items(index, -1, 0) == List(6));
+	assert(Items(index, 0, 0) == List(4));
+	index.Place(4, -1, 0);
+	assert(Items(index, 0, 0).empty());
+	assert(Items(index, -1, 0) == List(4, 6));
+}
+
+static void RemovedItemsAreNotFound() {
+	TileIndex index;
+	index.Reset(10, 8, 10);
+	index.Place(1, 5, 5);
+	index.Place(2, 5, 5);
+	index.Place(3, -1, 5);
+
+	index.Remove(1);
+	index.Remove(3);
+	assert(Items(index, 5, 5) == List(2));
+	assert(Items(index, -1, 5).empty());
+
+	// Removing twice and removing unplaced items does nothing
+	index.Remove(1);
+	index.Remove(7);
+	assert(Items(index, 5, 5) == List(2));
+	assert(index.size() == 10);
+
+	// Placed again at the old position
+	index.Place(1, 5, 5);
+	assert(Items(index, 5, 5) == List(1, 2));
+
+	// Starting over forgets everything
+	index.Reset(10, 8, 2);
+	assert(index.size() == 2);
+	assert(Items(index, 5, 5).empty());
+	index.Place(1, 3, 4);
+	index.Place(0, 3, 4);
+	assert(Items(index, 3, 4) == List(0, 1));
+}
+
+static void ManyWalkingItems() {
+	const int width = 20;
+	const int height = 15;
+	const int count = 500;
+
+	TileIndex index;
+	index.Reset(width, height, count);
+
+	// Items walk in rows and columns across the map and off it, so tiles
+	// are shared and left all the time
+	for (int step = 0; step < 60; ++step) {
+		std::vector<int> seen(count, 0);
+		for (int i = 0; i < count; ++i) {
+			int x = (i % 7 + (i % 3 == 0 ? step : 0)) % (width + 4) - 2;
+			int y = (i % 5 + (i % 3 == 1 ? step : 0)) % (height + 4) - 2;
+			if (i % 50 == step % 50) {
+				index.Remove(i);
+			} else {
+				index.Place(i, x, y);
+				assert(index.GetFirst(x, y) <= i);
+			}
+		}
+
+		for (int y = -2; y < height + 2; ++y) {
+			for (int x = -2; x < width + 2; ++x) {
+				std::vector<int> items = Items(index, x, y);
+				for (size_t k = 0; k < items.size(); ++k) {
+					assert(k == 0 || items[k - 1] < items[k]);
+					++seen[items[k]];
+				}
+			}
+		}
+		for (int i = 0; i < count; ++i) {
+			assert(seen[i] == (i % 50 == step % 50 ? 0 : 1));
+		}
+	}
+}
+
+extern "C" int main(int, char**) {
+	ItemsOfATileAreSorted();
+	MovesKeepTheOrder();
+	ItemsOutsideOfTheMap();
+	RemovedItemsAreNotFound();
+	ManyWalkingItems();
+
+	return EXIT_SUCCESS;
+}
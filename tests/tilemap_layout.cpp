@@ -0,0 +1,192 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include "tilemap_layout.h"
+#include "options.h"
+
+// Checks that walking TilemapLayout::TileData in the spans of GetTileSpans
+// visits the same tiles as the old per-tile wraparound of TilemapLayer::Draw,
+// for scroll positions inside and outside of the map and maps smaller than
+// the screen. Then times both walks over a large map, the old one on the
+// nested [x][y] vectors it used to read.
+
+namespace {
+	const int chunk_tiles = 16;
+	const int tiles_x = 320 / TILE_SIZE + 1;
+	const int tiles_y = 240 / TILE_SIZE + 1;
+	const int frames = 2000;
+
+	struct OldTile {
+		short ID;
+		int z;
+	};
+
+	typedef TilemapLayout::TileData TileData;
+	typedef TilemapLayout::TileSpan TileSpan;
+
+	short TileId(int x, int y) {
+		return (short)((x * 7 + y * 13) % 5000);
+	}
+
+	struct Map {
+		int width;
+		int height;
+		std::vector<std::vector<OldTile> > nested;
+		std::vector<TileData> flat;
+
+		Map(int w, int h) : width(w), height(h), nested(w, std::vector<OldTile>(h)), flat(w * h) {
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					short id = TileId(x, y);
+					OldTile& old_tile = nested[x][y];
+					old_tile.ID = id;
+					old_tile.z = (x + y) % 3 == 0 ? 98 : -2;
+
+					TileData& tile = flat[x + y * width];
+					tile.ID = id;
+					tile.z = (int8_t)old_tile.z;
+					tile.source = id < 3000 ? 1 : 2;
+					tile.row[0] = (uint8_t)(id < 3000 ? id / 50 : 0);
+					tile.col[0] = (uint8_t)(id < 3000 ? 0 : (id - 3000) % 6);
+				}
+			}
+		}
+	};
+
+	// Tile the old Draw read at a screen tile, NULL if it skipped it
+	const OldTile* OldTileAt(const Map& map, int ox, int oy, int x, int y) {
+		int map_x = (ox / TILE_SIZE + x + map.width) % map.width;
+		int map_y = (oy / TILE_SIZE + y + map.height) % map.height;
+		if (map_x < 0 || map_y < 0)
+			return NULL;
+		return &map.nested[map_x][map_y];
+	}
+
+	void CheckSpans(const std::vector<TileSpan>& spans, int tiles) {
+		int last = -1;
+		for (size_t i = 0; i < spans.size(); ++i) {
+			const TileSpan& span = spans[i];
+			assert(span.count > 0);
+			assert(span.screen > last && span.screen + span.count <= tiles);
+			// A span never crosses a chunk border
+			assert(span.map / chunk_tiles == (span.map + span.count - 1) / chunk_tiles);
+			last = span.screen + span.count - 1;
+		}
+	}
+
+	void CheckWalk(const Map& map, int ox, int oy) {
+		std::vector<TileSpan> spans_x;
+		std::vector<TileSpan> spans_y;
+		TilemapLayout::GetTileSpans(ox, tiles_x, map.width, chunk_tiles, spans_x);
+		TilemapLayout::GetTileSpans(oy, tiles_y, map.height, chunk_tiles, spans_y);
+		CheckSpans(spans_x, tiles_x);
+		CheckSpans(spans_y, tiles_y);
+
+		std::vector<const TileData*> visited(tiles_x * tiles_y);
+		for (size_t sy = 0; sy < spans_y.size(); ++sy) {
+			const TileSpan& span_y = spans_y[sy];
+			for (int y = 0; y < span_y.count; y++) {
+				const TileData* row = &map.flat[(span_y.map + y) * map.width];
+				for (size_t sx = 0; sx < spans_x.size(); ++sx) {
+					const TileSpan& span_x = spans_x[sx];
+					const TileData* tile = row + span_x.map;
+					for (int x = 0; x < span_x.count; x++, tile++) {
+						visited[span_x.screen + x + (span_y.screen + y) * tiles_x] = tile;
+					}
+				}
+			}
+		}
+
+		for (int y = 0; y < tiles_y; y++) {
+			for (int x = 0; x < tiles_x; x++) {
+				const OldTile* old_tile = OldTileAt(map, ox, oy, x, y);
+				const TileData* tile = visited[x + y * tiles_x];
+				if ((old_tile == NULL) != (tile == NULL) || (tile && (tile->ID != old_tile->ID || tile->z != old_tile->z))) {
+					printf("%dx%d map at %d,%d: screen tile %d,%d differs\n", map.width, map.height, ox, oy, x, y);
+					assert(false);
+				}
+			}
+		}
+	}
+
+	// Mimics the per-tile work of the old Draw: wraparound and ID decoding
+	long WalkNested(const Map& map, int ox, int oy) {
+		long sum = 0;
+		for (int x = 0; x < tiles_x; x++) {
+			for (int y = 0; y < tiles_y; y++) {
+				int map_x = (ox / TILE_SIZE + x + map.width) % map.width;
+				int map_y = (oy / TILE_SIZE + y + map.height) % map.height;
+				const OldTile& tile = map.nested[map_x][map_y];
+				if (tile.z == -2) {
+					sum += tile.ID < 3000 ? tile.ID / 50 : (tile.ID - 3000) % 6;
+				}
+			}
+		}
+		return sum;
+	}
+
+	// The walk of TilemapLayer: contiguous rows and precomputed coordinates
+	long WalkFlat(const Map& map, int ox, int oy, std::vector<TileSpan>& spans_x, std::vector<TileSpan>& spans_y) {
+		long sum = 0;
+		TilemapLayout::GetTileSpans(ox, tiles_x, map.width, chunk_tiles, spans_x);
+		TilemapLayout::GetTileSpans(oy, tiles_y, map.height, chunk_tiles, spans_y);
+		for (const TileSpan& span_y : spans_y) {
+			for (int y = 0; y < span_y.count; y++) {
+				const TileData* row = &map.flat[(span_y.map + y) * map.width];
+				for (const TileSpan& span_x : spans_x) {
+					const TileData* tile = row + span_x.map;
+					for (int x = 0; x < span_x.count; x++, tile++) {
+						if (tile->z == -2) {
+							sum += tile->source == 1 ? tile->row[0] : tile->col[0];
+						}
+					}
+				}
+			}
+		}
+		return sum;
+	}
+}
+
+int main(int, char**) {
+	// Maps larger and smaller than the screen, chunk aligned and not
+	const int sizes[][2] = { { 20, 15 }, { 21, 16 }, { 40, 33 }, { 12, 9 }, { 5, 3 }, { 1, 1 } };
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		Map map(sizes[s][0], sizes[s][1]);
+		int const w = map.width * TILE_SIZE;
+		int const h = map.height * TILE_SIZE;
+		for (int oy = -h - 40; oy <= 2 * h; oy += 7) {
+			for (int ox = -w - 40; ox <= 2 * w; ox += 5) {
+				CheckWalk(map, ox, oy);
+			}
+		}
+	}
+
+	Map map(500, 500);
+	int const w = map.width * TILE_SIZE;
+	int const h = map.height * TILE_SIZE;
+	std::vector<TileSpan> spans_x;
+	std::vector<TileSpan> spans_y;
+
+	// Scroll diagonally across the whole map, including the wraparound
+	long sum_nested = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; i++) {
+		sum_nested += WalkNested(map, i * 37 % w, i * 23 % h);
+	}
+	std::chrono::steady_clock::time_point mid = std::chrono::steady_clock::now();
+	long sum_flat = 0;
+	for (int i = 0; i < frames; i++) {
+		sum_flat += WalkFlat(map, i * 37 % w, i * 23 % h, spans_x, spans_y);
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	assert(sum_nested == sum_flat);
+
+	printf("nested [x][y]: %lld us\n", (long long)std::chrono::duration_cast<std::chrono::microseconds>(mid - start).count());
+	printf("flat row-major: %lld us\n", (long long)std::chrono::duration_cast<std::chrono::microseconds>(end - mid).count());
+
+	return EXIT_SUCCESS;
+}
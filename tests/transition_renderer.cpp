@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "transition_renderer.h"
+
+// Renders every transition at fixed percentages and compares the frames
+// with golden hashes. Pass a directory to also write the frames as PPM
+// images, e.g. to look at them after a change that updates the hashes.
+
+namespace {
+	const int width = 320;
+	const int height = 240;
+	const uint32_t seed = 4242;
+	const int percentages[] = { 25, 50, 75 };
+
+	const char* names[TransitionRenderer::TypeCount] = {
+		"fade", "random_blocks", "random_blocks_up", "random_blocks_down",
+		"blind_open", "blind_close", "vertical_stripes", "horizontal_stripes",
+		"border_to_center", "center_to_border", "scroll_up", "scroll_down",
+		"scroll_left", "scroll_right", "vertical_combine", "vertical_division",
+		"horizontal_combine", "horizontal_division", "cross_combine",
+		"cross_division", "zoom_in", "zoom_out", "mosaic", "wave"
+	};
+
+	// FNV-1a of the frames at 25, 50 and 75 percent
+	const uint32_t golden[TransitionRenderer::TypeCount][3] = {
+		{ 0x7C9E1395, 0x198181C5, 0x55A0DFC5 }, // fade
+		{ 0xB88987C5, 0x0FE09445, 0x674F5765 }, // random_blocks
+		{ 0x6E86EFE5, 0x7BBF2125, 0xA1794D25 }, // random_blocks_up
+		{ 0x9FF9A9C5, 0xD07FCA25, 0xC1DDF7E5 }, // random_blocks_down
+		{ 0x3AC22595, 0x59F8B245, 0x68CE7FC5 }, // blind_open
+		{ 0x433912C5, 0xE7188945, 0x0463CAC5 }, // blind_close
+		{ 0x73360DC5, 0x34EFE345, 0x4874AF45 }, // vertical_stripes
+		{ 0x5E9FF005, 0xA199D8C5, 0xA159DF05 }, // horizontal_stripes
+		{ 0x01C59E45, 0xD97ED805, 0x0FB4D405 }, // border_to_center
+		{ 0x0DEBA405, 0x5483A485, 0x221A93C5 }, // center_to_border
+		{ 0x7A4125C5, 0xF378CEC5, 0x10A73945 }, // scroll_up
+		{ 0x8385F045, 0x4C6D68C5, 0x6B1179C5 }, // scroll_down
+		{ 0xE66FF3C5, 0x4287BEC5, 0x8A45FFC5 }, // scroll_left
+		{ 0xCC4EB2C5, 0x1E6F8DC5, 0x6D53DAC5 }, // scroll_right
+		{ 0x7BF2CF45, 0xCCBBE945, 0xC3B04945 }, // vertical_combine
+		{ 0x6A463B45, 0xE0031545, 0x9E2F9D45 }, // vertical_division
+		{ 0x86F19985, 0x791F1AC5, 0xC21EF305 }, // horizontal_combine
+		{ 0x1F03B305, 0xB1F5C5C5, 0x336C0005 }, // horizontal_division
+		{ 0x7518B385, 0xAE735485, 0xDA6F7645 }, // cross_combine
+		{ 0xD7C4B5C5, 0x78DDEF85, 0x7DC0CE85 }, // cross_division
+		{ 0x21449AE5, 0x055DBD05, 0xD1EF8665 }, // zoom_in
+		{ 0xDD426365, 0x63C10EC5, 0xF8F59125 }, // zoom_out
+		{ 0x1E7509C5, 0x99607DC5, 0x53ABCDC5 }, // mosaic
+		{ 0xAD5E4A05, 0xD5C71C45, 0x16C610C5 }  // wave
+	};
+
+	struct Screen {
+		int width;
+		int height;
+		std::vector<uint32_t> data;
+		BitmapKernels::Region region;
+
+		Screen(int width, int height) : width(width), height(height), data(width * height) {
+			Init();
+		}
+
+		Screen(Screen const& other) : width(other.width), height(other.height), data(other.data) {
+			Init();
+		}
+
+		void Init() {
+			region.pixels = reinterpret_cast<uint8_t*>(&data.front());
+			region.pitch = width * 4;
+			region.width = width;
+			region.height = height;
+		}
+
+		uint32_t At(int x, int y) const {
+			return data[y * width + x];
+		}
+	};
+
+	// Every pixel of both screens is unique and never 0
+	Screen OldScreen(int w, int h) {
+		Screen screen(w, h);
+		for (int y = 0; y < h; ++y) {
+			for (int x = 0; x < w; ++x) {
+				screen.data[y * w + x] = 0xFF000000u | ((uint32_t)x << 12) | (uint32_t)y;
+			}
+		}
+		return screen;
+	}
+
+	Screen NewScreen(int w, int h) {
+		Screen screen = OldScreen(w, h);
+		for (size_t i = 0; i < screen.data.size(); ++i) {
+			screen.data[i] ^= 0x00FFFFFFu;
+		}
+		return screen;
+	}
+
+	uint32_t Hash(Screen const& screen) {
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < screen.data.size(); ++i) {
+			for (int b = 0; b < 32; b += 8) {
+				hash = (hash ^ ((screen.data[i] >> b) & 0xFF)) * 16777619u;
+			}
+		}
+		return hash;
+	}
+
+	void WritePpm(std::string const& path, Screen const& screen) {
+		FILE* file = fopen(path.c_str(), "wb");
+		assert(file);
+		fprintf(file, "P6\n%d %d\n255\n", screen.width, screen.height);
+		for (size_t i = 0; i < screen.data.size(); ++i) {
+			uint32_t const pixel = screen.data[i];
+			fputc((pixel >> 16) & 0xFF, file);
+			fputc((pixel >> 8) & 0xFF, file);
+			fputc(pixel & 0xFF, file);
+		}
+		fclose(file);
+	}
+
+	TransitionRenderer::Type TypeAt(int i) {
+		return static_cast<TransitionRenderer::Type>(i);
+	}
+}
+
+// At 0 percent the old screen is shown, at 100 percent the new one, and
+// every frame in between only contains pixels of the two screens.
+static void EndsMatch(int w, int h) {
+	Screen const screen1 = OldScreen(w, h);
+	Screen const screen2 = NewScreen(w, h);
+	Screen frame(w, h);
+
+	for (int t = 0; t < TransitionRenderer::TypeCount; ++t) {
+		TransitionRenderer renderer(TypeAt(t), w, h, seed);
+
+		renderer.Render(frame.region, screen1.region, screen2.region, 0);
+		assert(frame.data == screen1.data);
+		renderer.Render(frame.region, screen1.region, screen2.region, 100);
+		assert(frame.data == screen2.data);
+
+		for (int p = 1; p < 100; ++p) {
+			renderer.Render(frame.region, screen1.region, screen2.region, p);
+			for (size_t i = 0; i < frame.data.size(); ++i) {
+				assert(frame.data[i] != 0);
+			}
+		}
+	}
+}
+
+// A pixel of a masked transition shows its own position of one of the
+// screens and, once revealed, stays revealed.
+static void MasksAreMonotone() {
+	Screen const screen1 = OldScreen(width, height);
+	Screen const screen2 = NewScreen(width, height);
+	Screen frame(width, height);
+
+	for (int t = 0; t < TransitionRenderer::TypeCount; ++t) {
+		// Opening blinds fade in, see BlindOpenFadesIn
+		if (!TransitionRenderer::IsMasked(TypeAt(t)) || TypeAt(t) == TransitionRenderer::BlindOpen)
+			continue;
+
+		TransitionRenderer renderer(TypeAt(t), width, height, seed);
+		std::vector<bool> revealed(width * height, false);
+		size_t last_count = 0;
+		for (int p = 0; p <= 100; ++p) {
+			renderer.Render(frame.region, screen1.region, screen2.region, p);
+			size_t count = 0;
+			for (size_t i = 0; i < frame.data.size(); ++i) {
+				bool const is_new = frame.data[i] == screen2.data[i];
+				assert(is_new || frame.data[i] == screen1.data[i]);
+				assert(is_new || !revealed[i]);
+				revealed[i] = is_new;
+				count += is_new;
+			}
+			assert(count >= last_count);
+			last_count = count;
+		}
+	}
+}
+
+// Pixman's rounded 8-bit multiply
+static uint32_t Mul(uint32_t a, uint32_t b) {
+	uint32_t const t = a * b + 0x80;
+	return (t + (t >> 8)) >> 8;
+}
+
+// Like the blits it replaces: the revealed 8 - 8 * p / 100 lower rows of
+// every blind show the new screen with an opacity of 255 * p / 100 over the
+// old one.
+static void BlindOpenFadesIn() {
+	Screen const screen1 = OldScreen(width, height);
+	Screen const screen2 = NewScreen(width, height);
+	Screen frame(width, height);
+	TransitionRenderer renderer(TransitionRenderer::BlindOpen, width, height, seed);
+
+	for (int p = 1; p < 100; ++p) {
+		renderer.Render(frame.region, screen1.region, screen2.region, p);
+		uint32_t const opacity = 255 * p / 100;
+
+		for (int y = 0; y < height; ++y) {
+			bool const revealed = y % 8 >= 8 - 8 * p / 100;
+			for (int x = 0; x < width; ++x) {
+				uint32_t expected = screen1.At(x, y);
+				if (revealed) {
+					expected = 0;
+					for (int c = 0; c < 32; c += 8) {
+						uint32_t const v = Mul((screen2.At(x, y) >> c) & 0xFF, opacity) +
+							Mul((screen1.At(x, y) >> c) & 0xFF, 255 - opacity);
+						expected |= std::min(v, 255u) << c;
+					}
+				}
+				assert(frame.At(x, y) == expected);
+			}
+		}
+	}
+}
+
+static void GoldenFrames(const char* dump_dir) {
+	Screen const screen1 = OldScreen(width, height);
+	Screen const screen2 = NewScreen(width, height);
+	Screen frame(width, height);
+	bool match = true;
+
+	for (int t = 0; t < TransitionRenderer::TypeCount; ++t) {
+		TransitionRenderer renderer(TypeAt(t), width, height, seed);
+		uint32_t hashes[3];
+
+		for (int i = 0; i < 3; ++i) {
+			renderer.Render(frame.region, screen1.region, screen2.region, percentages[i]);
+			hashes[i] = Hash(frame);
+			match = match && hashes[i] == golden[t][i];
+
+			if (dump_dir) {
+				char file[64];
+				sprintf(file, "/%s_%03d.ppm", names[t], percentages[i]);
+				WritePpm(dump_dir + std::string(file), frame);
+			}
+		}
+
+		if (!match || dump_dir) {
+			printf("\t\t{ 0x%08X, 0x%08X, 0x%08X }, // %s\n", hashes[0], hashes[1], hashes[2], names[t]);
+		}
+	}
+
+	fflush(stdout);
+	assert(match);
+}
+
+static void Benchmark() {
+	Screen const screen1 = OldScreen(width, height);
+	Screen const screen2 = NewScreen(width, height);
+	Screen frame(width, height);
+
+	for (int t = 0; t < TransitionRenderer::TypeCount; ++t) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		TransitionRenderer renderer(TypeAt(t), width, height, seed);
+		double const setup = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for (int p = 0; p <= 100; ++p) {
+			renderer.Render(frame.region, screen1.region, screen2.region, p);
+		}
+		double const frames = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		printf("%-20s setup %.2f ms, %.3f ms per frame\n", names[t], setup, frames / 101);
+	}
+}
+
+extern "C" int main(int argc, char** argv) {
+	EndsMatch(width, height);
+	EndsMatch(33, 17);
+	MasksAreMonotone();
+	BlindOpenFadesIn();
+	GoldenFrames(argc > 1 ? argv[1] : NULL);
+	Benchmark();
+
+	return EXIT_SUCCESS;
+}